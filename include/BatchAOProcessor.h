@@ -0,0 +1,91 @@
+#pragma once
+#include "GBufferSequence.h"
+#include "SSAOEngine.h"
+#include "SeparableBlur.h"
+#include "TaskPool.h"
+
+#include "cinder/Thread.h"
+
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+struct BatchSettings
+{
+	BatchSettings()
+	: aoScale( 0.5f ), blur( true ), queueDepth( 2 ), firstFrame( 0 ), frameCount( -1 )
+	{}
+
+	float		aoScale;		//AO size relative to the G-buffer, the app renders mSSAOMap at half size
+	bool		blur;			//run pingPongBlurH() -> pingPongBlurV() on it, what mPingPongBlurV holds
+	BlurParams	blurParams;
+	int			queueDepth;		//frames that may wait between two stages
+	int			firstFrame;
+	int			frameCount;		//-1 for every frame from firstFrame on
+};
+
+//what the last run did, stage times are summed over frames ( each stage runs on its own thread )
+struct BatchStats
+{
+	BatchStats() : frames( 0 ), readMs( 0.0 ), computeMs( 0.0 ), writeMs( 0.0 ), wallMs( 0.0 ) {}
+
+	//how many stages were busy at once on average, 1 means nothing overlapped
+	double	getOverlap() const			{ return wallMs > 0.0 ? ( readMs + computeMs + writeMs ) / wallMs : 0.0; }
+	double	getFramesPerSecond() const	{ return wallMs > 0.0 ? frames * 1000.0 / wallMs : 0.0; }
+
+	int		frames;			//written
+	double	readMs, computeMs, writeMs;
+	double	wallMs;
+};
+
+/*
+ * The SSAO part of Base_ThreeD_ProjectApp::draw() ( renderSSAOToFBO(), then the blur ) for G-buffer sequences,
+ * no window or GL involved. Three stages overlap: a reader thread fills frame N + 1 from the input while the
+ * calling thread computes AO for frame N on the pool and a writer thread appends frame N - 1 to the output.
+ * Frames move through bounded queues from a fixed set of buffers, so memory stays at a few frames however long
+ * the sequence is and a slow stage holds the others back instead of piling frames up.
+ */
+class BatchAOProcessor
+{
+public:
+	//pool and engine are borrowed, the engine's params are used as they are ( set the projection for AO_HORIZON )
+	BatchAOProcessor( TaskPool *pool, const SSAOEngine *engine );
+
+	void					setSettings( const BatchSettings &settings )	{ mSettings = settings; }
+	const BatchSettings&	getSettings() const								{ return mSettings; }
+
+	//what the output of input looks like: AO sized, 1 channel, same projection
+	GBufferSequenceInfo		getOutputInfo( const GBufferSequenceInfo &input ) const;
+
+	//opens both files and processes them, false on any error ( getError() says what )
+	bool	run( const std::string &inputPath, const std::string &outputPath );
+	//output has to be open with getOutputInfo( input.getInfo() ), it is left open
+	bool	process( GBufferSequenceReader &input, GBufferSequenceWriter &output );
+
+	const BatchStats&	getStats() const	{ return mStats; }
+	const std::string&	getError() const	{ return mError; }
+
+private:
+	BatchAOProcessor( const BatchAOProcessor& );
+	BatchAOProcessor& operator=( const BatchAOProcessor& );
+
+	class RowJob;
+	struct Pipeline;
+
+	void	readLoop( Pipeline *pipeline );
+	void	writeLoop( Pipeline *pipeline );
+	void	computeFrame( const FloatImage &normalDepth, FloatImage *ao );
+	void	setError( const std::string &error );
+
+	TaskPool			*mPool;
+	const SSAOEngine	*mEngine;
+	SeparableBlur		mBlur;
+	BatchSettings		mSettings;
+	FloatImage			mRawAO;		//before the blur
+	BatchStats			mStats;
+	std::string			mError;
+	std::mutex			mErrorMutex;
+};
+
+} // namespace ssao
@@ -0,0 +1,76 @@
+#pragma once
+#include "FloatImage.h"
+#include "SSAOEngine.h"
+#include "TaskPool.h"
+
+namespace ssao {
+
+struct UpsampleParams
+{
+	UpsampleParams()
+	: depthSigma( 0.05f ), normalPower( 8 )
+	{}
+
+	float	depthSigma;		//relative depth difference at which a low res texel's weight halves ( 1 / ( 1 + ( diff / sigma )^2 ) )
+	int		normalPower;	//exponent on dot( normal, lowResNormal ), higher keeps creases sharper
+};
+
+//what measure() found for one AO divisor
+struct UpsampleReport
+{
+	int		divisor;
+	double	fullResMs;			//SSAO at output resolution ( the reference )
+	double	lowResMs;			//SSAO at output / divisor
+	double	upsampleMs;			//joint bilateral upsample of the low res AO
+	double	bilinearError;		//mean |ao - reference| with plain bilinear upsampling ( what BasicBlender_frag.glsl does )
+	double	bilateralError;		//same with the bilateral upsampler
+	double	bilinearEdgeError;	//the two errors above over depth edge pixels only, where the halos are
+	double	bilateralEdgeError;
+	int		edgePixels;
+};
+
+/*
+ * CPU version of BilateralBlender_frag.glsl: low res AO ( half, quarter, ... of the output ) brought back to
+ * full res guided by the full res normal/depth buffer. Every output pixel looks at the 2x2 low res texels
+ * around it, each weighted by bilinear weight * depth similarity * normal similarity, where the low res
+ * normal/depth is the G-buffer sampled at the low res texel center ( exactly what the SSAO pass saw ).
+ * Texels on the other side of a depth edge get no weight so AO does not bleed across silhouettes.
+ */
+class BilateralUpsampler
+{
+public:
+	//the pool is borrowed, not owned
+	explicit BilateralUpsampler( TaskPool *pool );
+
+	void					setParams( const UpsampleParams &params )	{ mParams = params; }
+	const UpsampleParams&	getParams() const							{ return mParams; }
+
+	//normalDepth: full res 4 channel G-buffer, ao: 1 channel at any lower size, result: 1 channel at the normalDepth size
+	void upsample( const FloatImage &normalDepth, const FloatImage &ao, FloatImage *result );
+
+	//plain bilinear ( clamp to edge ) for comparison
+	static void upsampleBilinear( const FloatImage &ao, int width, int height, FloatImage *result );
+
+	//runs SSAO at full res and at 1 / divisor, upsamples both ways and reports time and error against full res
+	UpsampleReport measure( const SSAOEngine &engine, const FloatImage &normalDepth, int divisor );
+
+private:
+	BilateralUpsampler( const BilateralUpsampler& );
+	BilateralUpsampler& operator=( const BilateralUpsampler& );
+
+	class RowJob;
+	friend class RowJob;
+
+	void upsampleRow( int y );
+
+	TaskPool			*mPool;
+	UpsampleParams		mParams;
+
+	//state for the job in flight
+	const FloatImage	*mNormalDepth;
+	const FloatImage	*mAO;
+	FloatImage			*mResult;
+	FloatImage			mGuide;		//normal/depth at the low res texel centers
+};
+
+} // namespace ssao
@@ -0,0 +1,38 @@
+#pragma once
+#include "FloatImage.h"
+
+#include <vector>
+
+namespace ssao {
+
+static const int BLUE_NOISE_SIZE = 64;
+
+/*
+ * void-and-cluster ranks of a BLUE_NOISE_SIZE^2 tile scaled to 0..255 ( row 0 at the bottom like FloatImage ).
+ * Generated ahead of time by tools/BlueNoiseGen.cpp into src/BlueNoiseTile.cpp, so nothing is decoded or
+ * computed at startup. Neighbouring texels always differ a lot and the tile repeats without seams, which is
+ * what lets a few samples per pixel average out under the blur instead of leaving blotches.
+ */
+extern const unsigned char BLUE_NOISE_TILE[BLUE_NOISE_SIZE * BLUE_NOISE_SIZE];
+
+/*
+ * void-and-cluster ( Ulichney 93 ) on a size x size torus: ranks[y * size + x] is the order texel ( x, y )
+ * was switched on, each one placed in the biggest gap ( gaussian energy of sigma texels ) left by the ones before
+ */
+void	generateBlueNoise( int size, float sigma, std::vector<int> *ranks );
+
+//a xorshift tile with the same layout, the white noise baseline
+void	generateWhiteNoise( int size, std::vector<unsigned char> *values );
+
+/*
+ * rnm for SSAOL_frag.glsl from 0..255 values: rgb = ( cos a, sin a, 0 ) * 0.5 + 0.5 with a = 2 pi * ( value + 0.5 ) / 256, 8 bits a channel.
+ * The shader reflects its kernel about that in-plane normal, so the value picks how the kernel is turned at the pixel
+ */
+void	buildRotationTile( const unsigned char *values, int size, std::vector<unsigned char> *rgb );
+//the same as 3 channel floats ( byte / 255, what the GL texture reads )
+void	buildRotationTile( const unsigned char *values, int size, FloatImage *tile );
+
+//the old random.png lookup's stand-in: random rgb in [0,1], 3 channels
+void	buildRandomNormalTile( int size, FloatImage *tile );
+
+} // namespace ssao
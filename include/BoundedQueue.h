@@ -0,0 +1,91 @@
+#pragma once
+#include "cinder/Thread.h"
+
+#include <deque>
+
+namespace ssao {
+
+/*
+ * FIFO between threads holding at most capacity items: push() blocks while it is full, pop() while it is empty.
+ * close() ends it, pushes fail from then on and pops drain what is left, then fail, so a stage can just loop
+ * on pop() and the one feeding it close() when done ( or giving up ).
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue( size_t capacity ) : mCapacity( capacity > 0 ? capacity : 1 ), mClosed( false ) {}
+
+	//false if the queue was closed ( before or while waiting for room )
+	bool push( const T &item )
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		while ( mItems.size() >= mCapacity && !mClosed )
+			mNotFull.wait( lock );
+		if ( mClosed )
+			return false;
+		mItems.push_back( item );
+		mNotEmpty.notify_one();
+		return true;
+	}
+
+	//never waits: false if the queue is full or closed ( a render loop drops the item instead of stalling )
+	bool tryPush( const T &item )
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if ( mItems.size() >= mCapacity || mClosed )
+			return false;
+		mItems.push_back( item );
+		mNotEmpty.notify_one();
+		return true;
+	}
+
+	//false once the queue is closed and empty
+	bool pop( T *item )
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		while ( mItems.empty() && !mClosed )
+			mNotEmpty.wait( lock );
+		if ( mItems.empty() )
+			return false;
+		*item = mItems.front();
+		mItems.pop_front();
+		mNotFull.notify_one();
+		return true;
+	}
+
+	//never waits: false if there is nothing in the queue right now
+	bool tryPop( T *item )
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if ( mItems.empty() )
+			return false;
+		*item = mItems.front();
+		mItems.pop_front();
+		mNotFull.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mClosed = true;
+		mNotEmpty.notify_all();
+		mNotFull.notify_all();
+	}
+
+	size_t	getCapacity() const	{ return mCapacity; }
+	size_t	size()				{ std::lock_guard<std::mutex> lock( mMutex ); return mItems.size(); }
+
+private:
+	BoundedQueue( const BoundedQueue& );
+	BoundedQueue& operator=( const BoundedQueue& );
+
+	size_t						mCapacity;
+	std::deque<T>				mItems;
+	std::mutex					mMutex;
+	std::condition_variable		mNotEmpty, mNotFull;
+	bool						mClosed;
+};
+
+} // namespace ssao
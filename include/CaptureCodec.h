@@ -0,0 +1,45 @@
+#pragma once
+#include "FloatImage.h"
+
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+//one render target as it is read back: rows bottom-up ( glGetTexImage order, like FloatImage ), channels interleaved
+struct CaptureTarget
+{
+	CaptureTarget() : width( 0 ), height( 0 ), channels( 4 ), bytesPerChannel( 1 ) {}
+	CaptureTarget( const std::string &name, int width, int height, int channels, int bytesPerChannel )
+	: name( name ), width( width ), height( height ), channels( channels ), bytesPerChannel( bytesPerChannel ) {}
+
+	size_t	getBytes() const	{ return (size_t)width * height * channels * bytesPerChannel; }
+
+	std::string	name;				//file name prefix
+	int			width, height;
+	int			channels;
+	int			bytesPerChannel;	//1 unsigned byte ( RGBA8 targets ), 4 float ( what a half float target is read back as )
+};
+
+/*
+ * Lossless, cheap enough to keep up with a frame on one core: every byte of every channel becomes its own plane
+ * ( so float exponents and the slowly changing high bytes line up ), each plane is delta coded along the pixels
+ * and the result is PackBits run length coded. Flat areas ( background, cleared AO ) collapse to a few bytes, noise
+ * grows by at most 1 byte in 128.
+ */
+void	encodeCapture( const unsigned char *pixels, const CaptureTarget &target, std::vector<unsigned char> *encoded );
+//false if encoded doesn't decode to exactly target.getBytes()
+bool	decodeCapture( const unsigned char *encoded, size_t size, const CaptureTarget &target, std::vector<unsigned char> *pixels );
+
+/*
+ * .cap files: a 32 byte header ( magic "FCAP", version, width, height, channels, bytes per channel, frame, encoded
+ * size, all uint32 ) then the encoded pixels. readCaptureFile() decodes, target->name is left alone
+ */
+bool	writeCaptureFile( const std::string &path, const CaptureTarget &target, int frame, const std::vector<unsigned char> &encoded );
+bool	readCaptureFile( const std::string &path, CaptureTarget *target, int *frame, std::vector<unsigned char> *pixels );
+
+//decoded pixels as a FloatImage for the CPU passes / ImageFile.h, bytes map to [0,1]. A packed normal/depth target
+//is still packed ( GBufferPacking.h ), floats are copied as they are
+void	captureToFloatImage( const CaptureTarget &target, const std::vector<unsigned char> &pixels, FloatImage *image );
+
+} // namespace ssao
@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+/*
+ * Per frame dirty tracking. Every frame the app feeds in what the image depends on, grouped in channels
+ * ( camera, light, objects, settings ... ). Each channel is hashed ( FNV-1a, see ShaderCache.h ) and compared
+ * with the previous frame, so nothing has to remember to set a flag when it changes something.
+ *
+ * The frame is dirty when any channel changed, after invalidate(), and for getSettleFrames() frames after
+ * the last change ( accumulating effects like temporal AO need a few frames to converge before they can be
+ * frozen ). A clean frame can reuse everything it rendered last time.
+ */
+class ChangeTracker
+{
+public:
+	ChangeTracker();
+
+	//channels stay for the tracker's lifetime, the returned index is what add() takes
+	int		addChannel( const std::string &name );
+
+	void	beginFrame();
+	void	add( int channel, const void *data, size_t size );
+	template<typename T>
+	void	add( int channel, const T &value )	{ add( channel, &value, sizeof( T ) ); }
+	//compares with last frame, returns isDirty()
+	bool	endFrame();
+
+	//next endFrame() is dirty whatever the channels say ( targets reallocated, graph rebuilt ... )
+	void	invalidate()						{ mInvalid = true; }
+
+	void	setSettleFrames( int frames )		{ mSettleFrames = frames; }
+	int		getSettleFrames() const				{ return mSettleFrames; }
+
+	//results of the last endFrame()
+	bool	isDirty() const						{ return mDirty; }
+	bool	hasChanged( int channel ) const		{ return mChannels[channel].changed; }
+	int		getCleanFrames() const				{ return mCleanFrames; }	//clean frames in a row
+	//names of the channels that changed, comma separated
+	std::string	getChangedNames() const;
+
+	int					getNumChannels() const				{ return (int)mChannels.size(); }
+	const std::string&	getChannelName( int channel ) const	{ return mChannels[channel].name; }
+
+private:
+	struct Channel
+	{
+		std::string		name;
+		uint64_t		hash, lastHash;
+		bool			changed;
+	};
+
+	std::vector<Channel>	mChannels;
+	bool					mHasPrevious;
+	bool					mInvalid;
+	bool					mDirty;
+	int						mSettleFrames;
+	int						mSettleLeft;
+	int						mCleanFrames;
+};
+
+} // namespace ssao
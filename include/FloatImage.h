@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace ssao {
+
+/*
+ * Plain interleaved float image used by all of the CPU ( headless ) passes.
+ * Rows are stored bottom-up so ( u, v ) lookups use the same convention as
+ * texture2D() in the shaders ( uv ( 0, 0 ) is the lower left corner ).
+ *
+ * A normal/depth buffer is 4 channels laid out like mNormalDepthMap ( rgb = view space normal, a = depth ),
+ * an AO buffer is 1 channel like the .r of mSSAOMap.
+ */
+class FloatImage
+{
+public:
+	FloatImage() : mWidth( 0 ), mHeight( 0 ), mChannels( 0 ) {}
+	FloatImage( int width, int height, int channels ) { allocate( width, height, channels ); }
+
+	void allocate( int width, int height, int channels )
+	{
+		mWidth		= width;
+		mHeight		= height;
+		mChannels	= channels;
+		mData.assign( (size_t)width * height * channels, 0.0f );
+	}
+
+	void fill( const float *value )
+	{
+		for ( size_t i = 0; i < mData.size(); i += mChannels )
+			std::copy( value, value + mChannels, &mData[i] );
+	}
+
+	bool	isEmpty() const		{ return mData.empty(); }
+	int		getWidth() const	{ return mWidth; }
+	int		getHeight() const	{ return mHeight; }
+	int		getChannels() const	{ return mChannels; }
+	size_t	getRowStride() const { return (size_t)mWidth * mChannels; }
+
+	float*			getData()					{ return mData.empty() ? 0 : &mData[0]; }
+	const float*	getData() const				{ return mData.empty() ? 0 : &mData[0]; }
+	float*			getPixel( int x, int y )		{ return &mData[ ( (size_t)y * mWidth + x ) * mChannels ]; }
+	const float*	getPixel( int x, int y ) const	{ return &mData[ ( (size_t)y * mWidth + x ) * mChannels ]; }
+
+	/*
+	 * bilinear lookup with clamp-to-edge addressing ( what GL_LINEAR + GL_CLAMP_TO_EDGE gives the shaders )
+	 * writes getChannels() floats into result
+	 */
+	void sampleBilinear( float u, float v, float *result ) const
+	{
+		float fx	= u * mWidth - 0.5f;
+		float fy	= v * mHeight - 0.5f;
+		float x0f	= std::floor( fx );
+		float y0f	= std::floor( fy );
+		float tx	= fx - x0f;
+		float ty	= fy - y0f;
+
+		int x0 = clampX( (int)x0f ),		x1 = clampX( (int)x0f + 1 );
+		int y0 = clampY( (int)y0f ),		y1 = clampY( (int)y0f + 1 );
+
+		const float *p00 = getPixel( x0, y0 );
+		const float *p10 = getPixel( x1, y0 );
+		const float *p01 = getPixel( x0, y1 );
+		const float *p11 = getPixel( x1, y1 );
+
+		for ( int c = 0; c < mChannels; ++c ) {
+			float bottom	= p00[c] + ( p10[c] - p00[c] ) * tx;
+			float top		= p01[c] + ( p11[c] - p01[c] ) * tx;
+			result[c]		= bottom + ( top - bottom ) * ty;
+		}
+	}
+
+	int clampX( int x ) const { return std::min( std::max( x, 0 ), mWidth - 1 ); }
+	int clampY( int y ) const { return std::min( std::max( y, 0 ), mHeight - 1 ); }
+
+private:
+	int					mWidth, mHeight, mChannels;
+	std::vector<float>	mData;
+};
+
+} // namespace ssao
@@ -0,0 +1,150 @@
+#pragma once
+#include "BoundedQueue.h"
+#include "CaptureCodec.h"
+
+#include "cinder/Thread.h"
+
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+/*
+ * GPU side of FrameCapture: copies targets into the buffers of a ring slot without waiting for them ( pixel buffer
+ * objects in GlReadback.h ) and hands the pixels over once they are there. Slots are numbered 0 .. slots - 1 of the
+ * CaptureRing, every slot has one buffer per target.
+ */
+class ReadbackDevice
+{
+public:
+	virtual ~ReadbackDevice() {}
+	//start copying every target into slot's buffers, must not wait for the GPU
+	virtual void	startReadback( int slot, const std::vector<CaptureTarget> &targets ) = 0;
+	//false while the copies of slot are still running, never waits
+	virtual bool	isReadbackDone( int slot ) = 0;
+	//the pixels of target in slot ( targets[target].getBytes() of what startReadback() got ) into dst, waits if they aren't done
+	virtual bool	finishReadback( int slot, int target, unsigned char *dst ) = 0;
+};
+
+/*
+ * Which slot a frame's readbacks go to and when they can be read. A slot is read latency frames after it was started
+ * ( by then the GPU has long finished it ), oldest first. With latency + 1 slots a slot is free again just in time,
+ * more slots absorb frames whose readback is late. No GL, so the scheduling runs in tests as is.
+ */
+class CaptureRing
+{
+public:
+	//latency is clamped to [0, slots - 1]
+	CaptureRing( int slots = 4, int latency = 2 );
+
+	int		getNumSlots() const		{ return (int)mSlotFrames.size(); }
+	int		getLatency() const		{ return mLatency; }
+	int		getNumInFlight() const	{ return mInFlight; }
+
+	//slot for frame's readbacks, -1 if every slot is still in flight ( the frame is dropped )
+	int		acquire( int frame );
+	//oldest slot in flight if it was started at least latency frames before frame, -1 otherwise. flush = ignore the latency
+	int		getReady( int frame, bool flush = false ) const;
+	//the slot was read ( or given up ), it can take a new frame
+	void	release( int slot );
+	//frame the slot was acquired for, -1 when it is free
+	int		getSlotFrame( int slot ) const	{ return mSlotFrames[slot]; }
+
+	//everything in flight is forgotten
+	void	reset();
+
+private:
+	std::vector<int>	mSlotFrames;
+	int					mLatency;
+	int					mOldest;	//slots are used in order, this one was acquired first
+	int					mInFlight;
+};
+
+//what a FrameCapture run did so far
+struct CaptureStats
+{
+	CaptureStats()
+	: started( 0 ), written( 0 ), droppedRing( 0 ), droppedBacklog( 0 ), failed( 0 ), rawBytes( 0 ), encodedBytes( 0 ), encodeMs( 0.0 ), writeMs( 0.0 ), readbackMs( 0.0 )
+	{}
+
+	double	getRatio() const	{ return encodedBytes ? (double)rawBytes / encodedBytes : 0.0; }
+
+	int		started;			//frames whose readbacks were started
+	int		written;			//frames whose files are all on disk
+	int		droppedRing;		//no free ring slot, readbacks came back too late
+	int		droppedBacklog;		//read back but the writers were too far behind
+	int		failed;				//frames with a file that couldn't be written
+	size_t	rawBytes, encodedBytes;
+	double	encodeMs, writeMs;	//summed over the writer threads
+	double	readbackMs;			//render thread: starting readbacks and copying finished ones out
+};
+
+/*
+ * Dumps a set of targets to disk every frame without stalling the render loop. captureFrame() runs on the render
+ * thread after the targets are drawn: it copies out the slots the ring says are ready ( frames from latency frames
+ * ago ) and starts this frame's readbacks. The copies go to a bounded queue, writer threads encode them
+ * ( CaptureCodec.h ) and write <directory><target name>_<frame>.cap. Nothing on the render thread ever waits on the
+ * GPU or the disk: if a readback isn't back yet or the writers are behind the frame is dropped and counted.
+ *
+ * The device does the GPU part ( GlReadback.h ), anything else ( synthetic frames in a test ) works the same way.
+ */
+class FrameCapture
+{
+public:
+	//device is borrowed. maxQueued frames may wait for the writers ( each holds a copy of every target )
+	FrameCapture( ReadbackDevice *device, int slots = 4, int latency = 2, int writerThreads = 2, int maxQueued = 8 );
+	~FrameCapture();
+
+	//targets of the next frames, a changed size only affects frames started from then on
+	void	setTargets( const std::vector<CaptureTarget> &targets )	{ mTargets = targets; }
+	const std::vector<CaptureTarget>&	getTargets() const				{ return mTargets; }
+
+	//directory ends with a separator ( or is empty for the working directory ), frames count from 0
+	void	start( const std::string &directory );
+	//reads back what is still in flight ( this may wait ), then waits for the writers
+	void	stop();
+	bool	isCapturing() const		{ return mCapturing; }
+
+	void	captureFrame();
+
+	//locks, the writers update it
+	CaptureStats	getStats();
+	int				getFrame() const	{ return mFrame; }
+
+private:
+	FrameCapture( const FrameCapture& );
+	FrameCapture& operator=( const FrameCapture& );
+
+	//a frame's copies on their way to the writers
+	struct Frame
+	{
+		int									frame;
+		std::vector<CaptureTarget>			targets;
+		std::vector< std::vector<unsigned char> >	pixels;
+	};
+
+	//wait = block for a free frame instead of dropping ( stop() )
+	void	collect( int slot, bool wait );
+	void	writerLoop();
+	void	writeFrame( Frame *frame, std::vector<unsigned char> *encoded );
+
+	ReadbackDevice				*mDevice;
+	CaptureRing					mRing;
+	std::vector<CaptureTarget>	mTargets;
+	std::vector< std::vector<CaptureTarget> >	mSlotTargets;	//what each slot was started with
+	int							mNumWriters;
+	int							mMaxQueued;
+	int							mFrame;
+	bool						mCapturing;
+	std::string					mDirectory;
+
+	std::vector<Frame>			mFrames;
+	BoundedQueue<Frame*>		*mFree;
+	BoundedQueue<Frame*>		*mQueue;
+	std::vector<std::thread*>	mWriters;
+
+	std::mutex					mStatsMutex;
+	CaptureStats				mStats;
+};
+
+} // namespace ssao
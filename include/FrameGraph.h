@@ -0,0 +1,162 @@
+#pragma once
+#include "cinder/Cinder.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace ssao {
+
+//what a render target looks like, two targets can share memory only if these match
+struct TextureDesc
+{
+	enum Format { FORMAT_RGBA8, FORMAT_RGBA16F, FORMAT_RGBA32F };
+
+	TextureDesc() : width( 0 ), height( 0 ), format( FORMAT_RGBA16F ), samples( 0 ), attachments( 1 ), depth( true ) {}
+	TextureDesc( int w, int h, Format f, int s = 0, int a = 1, bool d = true ) : width( w ), height( h ), format( f ), samples( s ), attachments( a ), depth( d ) {}
+
+	bool operator==( const TextureDesc &rhs ) const { return width == rhs.width && height == rhs.height && format == rhs.format && samples == rhs.samples && attachments == rhs.attachments && depth == rhs.depth; }
+	bool operator!=( const TextureDesc &rhs ) const { return !( *this == rhs ); }
+
+	int		width, height;
+	Format	format;			//precision of every color attachment
+	int		samples;		//> 0 renders into multisampled storage that is resolved ( blitted ) into the texture when it is read, 0 renders straight into the texture
+	int		attachments;	//color attachments ( > 1 for MRT )
+	bool	depth;			//depth buffer, only passes that draw geometry need one ( full screen passes don't )
+};
+
+/*
+ * Declarative list of the passes in a frame. Every pass says which resources it reads and writes, compile() then
+ *  - culls passes whose outputs nobody reads ( working back from the resources marked as outputs ),
+ *  - works out the lifetime of every transient resource over the surviving passes,
+ *  - assigns transient resources to physical targets, reusing a target once the previous occupant is dead.
+ * None of this touches GL, the caller maps physical indices onto whatever it allocates ( see getPhysicalIndex() ).
+ *
+ * Passes run in the order they were added, so add them in a valid order ( compile() reports reads before writes ).
+ *
+ * Cacheable passes can be skipped by execute( true ) when the caller knows their inputs did not change ( see
+ * ChangeTracker.h ), whatever they wrote last frame is reused. Resources going from a cacheable pass to one
+ * that always runs are kept out of aliasing so nothing overwrites them in between.
+ */
+class FrameGraph
+{
+public:
+	typedef int ResourceId;
+	typedef int PassId;
+
+	class Executor
+	{
+	public:
+		virtual ~Executor() {}
+		virtual void execute( const FrameGraph &graph, PassId pass ) = 0;
+	};
+	typedef std::shared_ptr<Executor> ExecutorRef;
+
+	//calls ( obj->*fn )() so app render functions can be passes as is
+	template<typename T>
+	class MemberExecutor : public Executor
+	{
+	public:
+		MemberExecutor( T *obj, void ( T::*fn )() ) : mObj( obj ), mFn( fn ) {}
+		void execute( const FrameGraph&, PassId ) { ( mObj->*mFn )(); }
+	private:
+		T		*mObj;
+		void	( T::*mFn )();
+	};
+
+	template<typename T>
+	static ExecutorRef makeExecutor( T *obj, void ( T::*fn )() ) { return ExecutorRef( new MemberExecutor<T>( obj, fn ) ); }
+
+	//told around every pass execute() runs ( profiling, debug markers ), skipped and culled passes are not reported
+	class Observer
+	{
+	public:
+		virtual ~Observer() {}
+		virtual void passBegin( const FrameGraph &graph, PassId pass ) = 0;
+		virtual void passEnd( const FrameGraph &graph, PassId pass ) = 0;
+	};
+
+	FrameGraph();
+
+	//throw everything away and start declaring a new frame
+	void		clear();
+
+	//transient resources can be aliased, imported ones ( the window, persistent history ) never are
+	ResourceId	createTexture( const std::string &name, const TextureDesc &desc );
+	ResourceId	importTexture( const std::string &name, const TextureDesc &desc );
+
+	PassId		addPass( const std::string &name, const ExecutorRef &executor = ExecutorRef() );
+	void		read( PassId pass, ResourceId resource );
+	void		write( PassId pass, ResourceId resource );
+	//passes with side effects ( UI, readbacks ) are never culled
+	void		setSideEffect( PassId pass, bool sideEffect = true );
+	void		setCacheable( PassId pass, bool cacheable = true );
+	//resources that must be produced this frame, culling starts from these
+	void		markOutput( ResourceId resource );
+
+	//returns false and fills getErrors() if the declaration is inconsistent
+	bool		compile();
+	//runs the executors of the surviving passes in order, reuseCached skips the cacheable ones
+	void		execute( bool reuseCached = false );
+	//not owned, 0 to stop reporting
+	void		setObserver( Observer *observer )				{ mObserver = observer; }
+
+	//results of compile()
+	bool		isCompiled() const								{ return mCompiled; }
+	bool		isPassCulled( PassId pass ) const				{ return mPasses[pass].culled; }
+	bool		isPassCacheable( PassId pass ) const			{ return mPasses[pass].cacheable; }
+	//written by a cacheable pass and read by one that always runs, never aliased
+	bool		isPersistent( ResourceId resource ) const		{ return mResources[resource].persistent; }
+	const std::vector<PassId>& getExecutionOrder() const		{ return mOrder; }
+	int			getPhysicalIndex( ResourceId resource ) const	{ return mResources[resource].physical; }
+	int			getNumPhysical() const							{ return (int)mPhysical.size(); }
+	const TextureDesc& getPhysicalDesc( int physical ) const	{ return mPhysical[physical]; }
+	//resources declared but not read by any surviving pass ( and not outputs ), i.e. wasted allocations
+	std::vector<ResourceId> getUnusedResources() const;
+	const std::vector<std::string>& getErrors() const			{ return mErrors; }
+
+	int					getNumPasses() const					{ return (int)mPasses.size(); }
+	int					getNumResources() const					{ return (int)mResources.size(); }
+	const std::string&	getPassName( PassId pass ) const		{ return mPasses[pass].name; }
+	const std::string&	getResourceName( ResourceId res ) const	{ return mResources[res].name; }
+	const TextureDesc&	getResourceDesc( ResourceId res ) const	{ return mResources[res].desc; }
+	bool				isImported( ResourceId res ) const		{ return mResources[res].imported; }
+	//first / last position in getExecutionOrder() that touches the resource, -1 if never
+	int					getFirstUse( ResourceId res ) const		{ return mResources[res].firstUse; }
+	int					getLastUse( ResourceId res ) const		{ return mResources[res].lastUse; }
+
+	//human readable summary of the compiled graph
+	void		dump( std::ostream &os ) const;
+
+private:
+	struct Pass
+	{
+		std::string					name;
+		ExecutorRef					executor;
+		std::vector<ResourceId>		reads, writes;
+		bool						sideEffect;
+		bool						cacheable;
+		bool						culled;
+	};
+
+	struct Resource
+	{
+		std::string		name;
+		TextureDesc		desc;
+		bool			imported;
+		bool			output;
+		bool			persistent;
+		int				firstUse, lastUse;
+		int				physical;		//-1 for imported or unused
+	};
+
+	std::vector<Pass>			mPasses;
+	std::vector<Resource>		mResources;
+	std::vector<PassId>			mOrder;
+	std::vector<TextureDesc>	mPhysical;
+	std::vector<std::string>	mErrors;
+	bool						mCompiled;
+	Observer					*mObserver;
+};
+
+} // namespace ssao
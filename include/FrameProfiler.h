@@ -0,0 +1,157 @@
+#pragma once
+#include "FrameGraph.h"
+
+#include "cinder/Timer.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+//the last capacity samples of one timer, oldest overwritten first
+class SampleHistory
+{
+public:
+	explicit SampleHistory( size_t capacity = 240 );
+
+	void	push( float value );
+	void	clear();
+
+	size_t	size() const			{ return mCount; }
+	size_t	capacity() const		{ return mSamples.size(); }
+	//every push() since the last clear(), not just the ones still held
+	size_t	getTotal() const		{ return mTotal; }
+	float	getLast() const;
+	//held samples oldest first
+	void	getSamples( std::vector<float> *samples ) const;
+
+private:
+	std::vector<float>	mSamples;
+	size_t				mNext;
+	size_t				mCount;
+	size_t				mTotal;
+};
+
+//summary of a SampleHistory, all in ms. Percentiles are nearest rank ( always one of the samples ), all 0 when empty
+struct ProfileStats
+{
+	ProfileStats() : count( 0 ), last( 0.0f ), mean( 0.0f ), min( 0.0f ), max( 0.0f ), p50( 0.0f ), p95( 0.0f ), p99( 0.0f ) {}
+
+	int		count;
+	float	last, mean, min, max;
+	float	p50, p95, p99;
+};
+
+ProfileStats	computeStats( const std::vector<float> &samples );
+//nearest rank percentile ( 0 - 100 ) of sorted samples
+float			percentile( const std::vector<float> &sorted, float p );
+
+class FrameProfiler;
+
+/*
+ * GPU side of a FrameProfiler scope, implemented with timer queries in GlGpuTimer.h. Queries can't nest, the
+ * profiler only starts one while no other GPU scope is open. Results arrive frames later, collect() hands the
+ * finished ones to FrameProfiler::addSample()
+ */
+class GpuTimer
+{
+public:
+	virtual ~GpuTimer() {}
+	virtual void	begin( int scope ) = 0;
+	virtual void	end() = 0;
+	virtual void	collect( FrameProfiler *profiler ) = 0;
+};
+
+/*
+ * Named timing scopes with a ring buffered history per clock. The CPU side is a ci::Timer read at every
+ * beginScope() / endScope(), so it runs headless. As a FrameGraph::Observer every pass becomes a scope of
+ * the same name, beginFrame() / endFrame() time the whole frame as the "frame" scope ( CPU only ).
+ *
+ * Scopes nest ( a stack ) and are never removed, so indices stay valid. Passes skipped on clean frames just
+ * add no sample, getStats().count tells how many frames a number is based on.
+ */
+class FrameProfiler : public FrameGraph::Observer
+{
+public:
+	enum Clock { CLOCK_CPU, CLOCK_GPU, NUM_CLOCKS };
+
+	explicit FrameProfiler( size_t historySize = 240 );
+
+	//not owned, 0 for CPU timing only
+	void		setGpuTimer( GpuTimer *timer )	{ mGpuTimer = timer; }
+	GpuTimer*	getGpuTimer() const				{ return mGpuTimer; }
+
+	//index of the scope with that name, created on first use
+	int			getScope( const std::string &name );
+	//-1 if there is none
+	int			findScope( const std::string &name ) const;
+
+	void		beginFrame();
+	//closes the frame scope and collects finished GPU results
+	void		endFrame();
+
+	//gpu = false times the CPU only ( scopes around work that issues no GL )
+	void		beginScope( int scope, bool gpu = true );
+	//closes the innermost open scope
+	void		endScope();
+	void		addSample( int scope, Clock clock, float ms );
+
+	//drops every sample, scopes stay ( settings changed, start a new measurement )
+	void		clear();
+
+	ProfileStats			getStats( int scope, Clock clock ) const;
+	const SampleHistory&	getHistory( int scope, Clock clock ) const	{ return mScopes[scope].history[clock]; }
+	int						getNumScopes() const						{ return (int)mScopes.size(); }
+	const std::string&		getScopeName( int scope ) const				{ return mScopes[scope].name; }
+	int						getFrameCount() const						{ return mFrameCount; }
+	size_t					getHistorySize() const						{ return mHistorySize; }
+
+	//one row per scope and clock with samples: scope,clock,count,last,mean,min,p50,p95,p99,max ( ms )
+	void		writeCsv( std::ostream &os ) const;
+	//{ "frames", "historySize", "scopes": [ { "name", "cpu": { stats, "samples" }, "gpu": ... } ] }, a clock without samples is null
+	void		writeJson( std::ostream &os, bool withSamples = true ) const;
+
+	//FrameGraph::Observer
+	void		passBegin( const FrameGraph &graph, FrameGraph::PassId pass );
+	void		passEnd( const FrameGraph &graph, FrameGraph::PassId pass );
+
+	//times its own lifetime as one scope
+	class Scoped
+	{
+	public:
+		Scoped( FrameProfiler &profiler, int scope, bool gpu = true ) : mProfiler( profiler )	{ mProfiler.beginScope( scope, gpu ); }
+		~Scoped()																			{ mProfiler.endScope(); }
+	private:
+		Scoped( const Scoped& );
+		Scoped& operator=( const Scoped& );
+
+		FrameProfiler	&mProfiler;
+	};
+
+private:
+	struct Scope
+	{
+		std::string		name;
+		SampleHistory	history[NUM_CLOCKS];
+	};
+
+	struct OpenScope
+	{
+		int		scope;
+		double	start;
+		bool	gpu;
+	};
+
+	size_t						mHistorySize;
+	std::vector<Scope>			mScopes;
+	std::map<std::string, int>	mScopeIndices;
+	std::vector<OpenScope>		mStack;
+	ci::Timer					mClock;
+	GpuTimer					*mGpuTimer;
+	int							mFrameScope;
+	int							mFrameCount;
+};
+
+} // namespace ssao
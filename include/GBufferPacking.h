@@ -0,0 +1,82 @@
+#pragma once
+#include "FloatImage.h"
+
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+
+namespace ssao {
+
+//unpacked depth is linear view depth -viewPos.z / DEPTH_UNIT, the scale the AO / temporal constants were tuned in ( the old -viewPos.z/10.0 )
+static const float DEPTH_UNIT = 10.0f;
+
+//near / far of the camera that wrote the G-buffer ( the app's CameraPersp uses 1 / 50 )
+struct ClipPlanes
+{
+	ClipPlanes( float nearClip = 1.0f, float farClip = 50.0f ) : nearClip( nearClip ), farClip( farClip ) {}
+
+	float	nearClip;
+	float	farClip;
+};
+
+//octahedral mapping of a unit vector to [-1,1]^2 and back ( keeps the sign of z, view normals of visible surfaces can point away )
+inline void encodeOctahedral( const float *n, float *e )
+{
+	float l1 = std::fabs( n[0] ) + std::fabs( n[1] ) + std::fabs( n[2] );
+	float inv = l1 > 0.0f ? 1.0f / l1 : 0.0f;
+	float x = n[0] * inv, y = n[1] * inv;
+	if ( n[2] < 0.0f ) {
+		float fx = ( 1.0f - std::fabs( y ) ) * ( x >= 0.0f ? 1.0f : -1.0f );
+		float fy = ( 1.0f - std::fabs( x ) ) * ( y >= 0.0f ? 1.0f : -1.0f );
+		x = fx;
+		y = fy;
+	}
+	e[0] = x;
+	e[1] = y;
+}
+
+inline void decodeOctahedral( const float *e, float *n )
+{
+	float x = e[0], y = e[1];
+	float z = 1.0f - std::fabs( x ) - std::fabs( y );
+	if ( z < 0.0f ) {
+		float fx = ( 1.0f - std::fabs( y ) ) * ( x >= 0.0f ? 1.0f : -1.0f );
+		float fy = ( 1.0f - std::fabs( x ) ) * ( y >= 0.0f ? 1.0f : -1.0f );
+		x = fx;
+		y = fy;
+	}
+	float len = std::sqrt( x * x + y * y + z * z );
+	float inv = len > 0.0f ? 1.0f / len : 0.0f;
+	n[0] = x * inv;
+	n[1] = y * inv;
+	n[2] = z * inv;
+}
+
+/*
+ * The RGBA8 normal/depth format of GBufferPacking.glsl, one uint32_t per texel with r in the low byte:
+ * rg = octahedral normal ( unorm ), ba = depth between the clip planes as 16 bits ( b high byte, a low byte ).
+ * Half the size of the RGBA16F layout it replaces. Unpacking gives that layout back ( rgb = normal, a = linear view
+ * depth -viewPos.z / DEPTH_UNIT ) so everything downstream keeps working on FloatImages as before.
+ *
+ * packTexel() / unpackTexel() are the scalar reference, the image versions run simd::WIDTH texels at a time.
+ */
+uint32_t	packTexel( const float *normalDepth, const ClipPlanes &clip );
+void		unpackTexel( uint32_t packed, const ClipPlanes &clip, float *normalDepth );
+
+void		packNormalDepth( const FloatImage &normalDepth, const ClipPlanes &clip, std::vector<uint32_t> *packed );
+void		unpackNormalDepth( const std::vector<uint32_t> &packed, int width, int height, const ClipPlanes &clip, FloatImage *normalDepth );
+
+//what a round trip through the packed format costs ( unit length normals only, the clear color is left out )
+struct PackingReport
+{
+	int		texels;
+	double	meanNormalDegrees, maxNormalDegrees;
+	double	meanDepthError, maxDepthError;	//view units
+	int		simdMismatches;					//texels where the simd and scalar versions disagree ( pack or unpack )
+	size_t	unpackedBytes, packedBytes;		//RGBA16F vs RGBA8 for the whole buffer
+	double	packMs, unpackMs;
+};
+
+PackingReport measurePacking( const FloatImage &normalDepth, const ClipPlanes &clip );
+
+} // namespace ssao
@@ -0,0 +1,98 @@
+#pragma once
+#include "FloatImage.h"
+
+#include <fstream>
+#include <string>
+
+namespace ssao {
+
+/*
+ * .gbseq: a run of same sized frames for the offline tools, laid out so a reader can map the file and use it in
+ * place. A GBUFFER_SEQUENCE_HEADER_SIZE header ( magic "GBSQ", version, width, height, channels, frame count, all
+ * uint32, then the projection as 2 floats, zero padded to one page ) and frame i at header size + i * getFrameBytes(),
+ * width x height x channels native endian floats, rows bottom-up like FloatImage.
+ *
+ * G-buffer input is 4 channels in the mNormalDepthMap layout ( rgb = view space normal, a = depth ), AO output
+ * 1 channel like the .r of mSSAOMap. A frame count of 0 means the writer never got to close(), the reader then
+ * counts the whole frames the file holds.
+ */
+static const size_t GBUFFER_SEQUENCE_HEADER_SIZE = 4096;
+
+struct GBufferSequenceInfo
+{
+	GBufferSequenceInfo() : width( 0 ), height( 0 ), channels( 0 ), frameCount( 0 )
+	{
+		projection[0] = projection[1] = 0.0f;
+	}
+
+	size_t	getFrameBytes() const	{ return (size_t)width * height * channels * sizeof( float ); }
+
+	int		width, height, channels;
+	int		frameCount;
+	float	projection[2];		//( 0, 0 ) and ( 1, 1 ) of the projection the frames were rendered with, 0 if unknown
+};
+
+/*
+ * Memory maps the file ( POSIX mmap, read in order so the kernel reads ahead ), frames are then pointers into the
+ * mapping. Where there is no mmap every frame is read through a stream instead, getFrame() is 0 then.
+ */
+class GBufferSequenceReader
+{
+public:
+	GBufferSequenceReader();
+	~GBufferSequenceReader();
+
+	//false if the file can't be opened or isn't a sequence
+	bool	open( const std::string &path );
+	void	close();
+	bool	isOpen() const							{ return mOpen; }
+
+	const GBufferSequenceInfo&	getInfo() const		{ return mInfo; }
+	int		getFrameCount() const					{ return mInfo.frameCount; }
+	bool	isMapped() const						{ return mMapping != 0; }
+
+	//frame index in the mapping, 0 if the file isn't mapped or index is out of range
+	const float*	getFrame( int index ) const;
+	//copies frame index into image ( reallocated only if its size differs ), false if it's out of range or the read fails
+	bool			readFrame( int index, FloatImage *image );
+
+private:
+	GBufferSequenceReader( const GBufferSequenceReader& );
+	GBufferSequenceReader& operator=( const GBufferSequenceReader& );
+
+	GBufferSequenceInfo	mInfo;
+	bool				mOpen;
+	void				*mMapping;
+	size_t				mMappingSize;
+	std::ifstream		mStream;
+};
+
+//appends frames in order, the header's frame count is filled in by close()
+class GBufferSequenceWriter
+{
+public:
+	GBufferSequenceWriter();
+	~GBufferSequenceWriter();
+
+	//info.frameCount is ignored
+	bool	open( const std::string &path, const GBufferSequenceInfo &info );
+	bool	close();
+	bool	isOpen() const							{ return mStream.is_open(); }
+
+	const GBufferSequenceInfo&	getInfo() const		{ return mInfo; }
+	int		getFrameCount() const					{ return mInfo.frameCount; }
+
+	//false if image isn't width x height x channels or the write fails
+	bool	append( const FloatImage &image );
+
+private:
+	GBufferSequenceWriter( const GBufferSequenceWriter& );
+	GBufferSequenceWriter& operator=( const GBufferSequenceWriter& );
+
+	bool	writeHeader();
+
+	GBufferSequenceInfo	mInfo;
+	std::ofstream		mStream;
+};
+
+} // namespace ssao
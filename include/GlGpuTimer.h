@@ -0,0 +1,47 @@
+#pragma once
+#include "FrameProfiler.h"
+
+#include "cinder/gl/gl.h"
+
+#include <deque>
+#include <vector>
+
+namespace ssao {
+
+/*
+ * FrameProfiler GPU clock on GL_EXT_timer_query: every GPU scope is a GL_TIME_ELAPSED_EXT query. Results are
+ * read back only once GL_QUERY_RESULT_AVAILABLE says so ( usually a frame or two later ), never waited for, and
+ * the queries are recycled. Without the extension begin() / end() do nothing and the profiler is CPU only.
+ */
+class GlGpuTimer : public GpuTimer
+{
+public:
+	//needs a GL context
+	GlGpuTimer();
+	~GlGpuTimer();
+
+	bool	isSupported() const		{ return mSupported; }
+	//queries issued but not read back yet
+	int		getNumPending() const	{ return (int)mPending.size(); }
+
+	void	begin( int scope );
+	void	end();
+	void	collect( FrameProfiler *profiler );
+
+private:
+	GlGpuTimer( const GlGpuTimer& );
+	GlGpuTimer& operator=( const GlGpuTimer& );
+
+	struct Query
+	{
+		GLuint	id;
+		int		scope;
+	};
+
+	bool				mSupported;
+	bool				mActive;	//begin() started a query that end() has to close
+	std::deque<Query>	mPending;	//oldest first, they finish in order
+	std::vector<GLuint>	mFree;
+};
+
+} // namespace ssao
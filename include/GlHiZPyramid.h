@@ -0,0 +1,54 @@
+#pragma once
+#include "HiZPyramid.h"
+#include "TargetPool.h"
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Texture.h"
+
+#include <vector>
+
+namespace ssao {
+
+/*
+ * GPU side of HiZPyramid.h: one mipmapped RGBA16F texture, every level rendered with HiZReduce_frag.glsl from the
+ * level below ( level 0 from the normal/depth buffer ). While a level is written the texture's base / max level
+ * are clamped to the level being read, so it never samples what it renders to. Sample it with texture2DLod()
+ * and GL_NEAREST_MIPMAP_NEAREST ( min / max must not be filtered ).
+ *
+ * With a pool set, a texture of the wrong size goes back to it and a new one comes out of it when one of that size
+ * and level count was released before, so the pyramid follows the AO scale around without reallocating.
+ */
+class GlHiZPyramid
+{
+public:
+	GlHiZPyramid();
+	~GlHiZPyramid();
+
+	//borrowed, 0 = textures are just dropped
+	void	setPool( TargetPool<ci::gl::Texture> *pool )	{ mPool = pool; }
+
+	//reallocates when the normal/depth size or the level count changes, leaves the window framebuffer bound
+	void	build( const ci::gl::Texture &normalDepth, ci::gl::GlslProg &reduceShader, const HiZParams &params );
+	//the texture goes back to the pool ( Hi-Z turned off ), the next build() allocates again
+	void	release();
+
+	const ci::gl::Texture&	getTexture() const		{ return mTexture; }
+	int						getNumLevels() const	{ return (int)mLevelSizes.size(); }
+	ci::Vec2i				getSize() const			{ return mLevelSizes.empty() ? ci::Vec2i::zero() : mLevelSizes[0]; }
+
+private:
+	GlHiZPyramid( const GlHiZPyramid& );
+	GlHiZPyramid& operator=( const GlHiZPyramid& );
+
+	void	allocate( int width, int height, int maxLevels );
+	TextureDesc	getDesc() const;
+
+	TargetPool<ci::gl::Texture>	*mPool;
+	ci::gl::Texture			mTexture;
+	GLuint					mFramebuffer;
+	int						mMaxLevels;		//what the levels were allocated for
+	std::vector<ci::Vec2i>	mLevelSizes;
+};
+
+} // namespace ssao
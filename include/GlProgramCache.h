@@ -0,0 +1,48 @@
+#pragma once
+#include "ShaderCache.h"
+
+#include "cinder/gl/GlslProg.h"
+
+namespace ssao {
+
+/*
+ * Driver binary layer on top of ShaderCache ( GL_ARB_get_program_binary ). getProgram() returns a linked
+ * program: from the cached binary when there is one and the driver still takes it, otherwise compiled from
+ * source and its binary saved for next time. Programs it compiles are linked by hand with
+ * GL_PROGRAM_BINARY_RETRIEVABLE_HINT set, some drivers have no binary for a program linked without it.
+ * Without the extension it only compiles.
+ */
+class GlProgramCache
+{
+public:
+	//directory must exist, empty disables caching
+	explicit GlProgramCache( const std::string &directory );
+
+	ci::gl::GlslProg	getProgram( const std::string &vertexSource, const std::string &fragmentSource );
+
+	//drop the least recently used binaries over maxBytes, the programs of this run stay ( call once all programs are loaded )
+	void				trim( size_t maxBytes )		{ mStore.trim( maxBytes ); }
+
+	bool				isBinarySupported() const	{ return mBinarySupported; }
+	const std::string&	getDriverTag() const		{ return mDriverTag; }
+	ShaderCache&		getStore()					{ return mStore; }
+
+	//time spent in getProgram(), and how the programs got there
+	double				getSeconds() const			{ return mSeconds; }
+	int					getNumLoaded() const		{ return mLoaded; }
+	int					getNumCompiled() const		{ return mCompiled; }
+
+private:
+	class AdoptedProgram;
+
+	//0 if either stage doesn't compile or the program doesn't link
+	GLuint					linkRetrievable( const std::string &vertexSource, const std::string &fragmentSource );
+
+	ShaderCache				mStore;
+	std::string				mDriverTag;
+	bool					mBinarySupported;
+	double					mSeconds;
+	int						mLoaded, mCompiled;
+};
+
+} // namespace ssao
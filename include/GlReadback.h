@@ -0,0 +1,57 @@
+#pragma once
+#include "FrameCapture.h"
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Texture.h"
+
+#include <vector>
+
+namespace ssao {
+
+/*
+ * FrameCapture's ReadbackDevice on pixel buffer objects: startReadback() has glGetTexImage() write into one PBO per
+ * slot and target ( the call returns at once, the copy runs on the GPU ) and fences the slot if GL_ARB_sync is
+ * there. finishReadback() maps the PBO frames later, when the copy is long done, so mapping doesn't wait either.
+ * Without PBOs nothing is read back and every frame counts as failed.
+ */
+class GlReadback : public ReadbackDevice
+{
+public:
+	//needs a GL context, slots like the CaptureRing
+	explicit GlReadback( int slots );
+	~GlReadback();
+
+	bool	isSupported() const		{ return mSupported; }
+
+	//texture read for target from the next startReadback() on. Set them every frame, targets move when the graph is rebuilt
+	void	setSource( int target, const ci::gl::Texture &texture );
+
+	void	startReadback( int slot, const std::vector<CaptureTarget> &targets );
+	bool	isReadbackDone( int slot );
+	bool	finishReadback( int slot, int target, unsigned char *dst );
+
+private:
+	GlReadback( const GlReadback& );
+	GlReadback& operator=( const GlReadback& );
+
+	struct Buffer
+	{
+		Buffer() : pbo( 0 ), bytes( 0 ), started( false ) {}
+
+		GLuint	pbo;
+		size_t	bytes;		//glBufferData() size
+		bool	started;	//the last startReadback() of the slot copied into it
+	};
+
+	void	deleteFence( int slot );
+
+	bool								mSupported;
+	bool								mSyncSupported;
+	std::vector< std::vector<Buffer> >	mBuffers;	//[slot][target]
+	std::vector<ci::gl::Texture>		mSources;
+#if defined( GL_ARB_sync )
+	std::vector<GLsync>					mFences;
+#endif
+};
+
+} // namespace ssao
@@ -0,0 +1,69 @@
+#pragma once
+#include "SceneContainer.h"
+#include "MeshOptimizer.h"
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Material.h"
+
+#include <vector>
+
+namespace ssao {
+
+/*
+ * GPU side of SceneContainer.h: one interleaved vertex VBO ( see MeshOptimizer.h ) and one index VBO per mesh,
+ * and one instance buffer holding the model matrix rows ( 3 vec4 ) of every visible instance, grouped per mesh. With GL_ARB_instanced_arrays and
+ * GL_ARB_draw_instanced each mesh is a single glDrawElementsInstancedARB() reading the rows as the attributes
+ * instanceRow0..2 ( the INSTANCED path of GBuffer_vert.glsl / NormalDepthTexCreate_vert.glsl ), without them or
+ * without a program ( fixed function ) every instance is its own draw with its matrix on the modelview stack.
+ */
+class GlSceneRenderer
+{
+public:
+	GlSceneRenderer();
+	~GlSceneRenderer();
+
+	//(re)creates the mesh VBOs, call after the container's meshes or the normal format change ( instances don't matter )
+	void	upload( const SceneContainer &scene );
+	//NORMAL_BYTE takes a third less vertex memory / bandwidth, takes effect at the next upload()
+	void			setNormalFormat( NormalFormat format )	{ mNormalFormat = format; }
+	NormalFormat	getNormalFormat() const					{ return mNormalFormat; }
+	size_t			getUploadedBytes() const				{ return mUploadedBytes; }	//vertices + indices of every mesh
+	//gl::Material applied before each mesh's draws
+	void	setMaterial( int mesh, const ci::gl::Material &material );
+
+	//copies the rows of the visible instances into the instance buffer, once per frame after culling
+	void	prepare( const SceneContainer &scene, const CullResult &visible );
+	//draws what prepare() got, instanced when program ( bound, built with INSTANCED ) is given and supported. returns the draw calls issued
+	int		draw( const SceneContainer &scene, const CullResult &visible, const ci::gl::GlslProg *instancedProgram = 0 );
+
+	bool	isInstancingSupported() const	{ return mInstancingSupported; }
+
+private:
+	GlSceneRenderer( const GlSceneRenderer& );
+	GlSceneRenderer& operator=( const GlSceneRenderer& );
+
+	struct MeshBuffers
+	{
+		GLuint				vertices, indices;
+		GLsizei				numIndices;
+		GLenum				indexType;
+		GLsizei				stride;
+		GLenum				normalType;		//what the mesh was uploaded with, setNormalFormat() may have changed since
+		bool				hasMaterial;
+		ci::gl::Material	material;
+	};
+
+	void	release();
+	void	bindMesh( const MeshBuffers &mesh );
+
+	std::vector<MeshBuffers>	mMeshes;
+	GLuint						mInstanceBuffer;
+	std::vector<float>			mInstanceRows;		//12 floats per visible instance, batches back to back
+	std::vector<int>			mBatchOffsets;		//[mesh] -> first instance of its batch in mInstanceRows
+	bool						mInstancingSupported;
+	NormalFormat				mNormalFormat;
+	size_t						mUploadedBytes;
+};
+
+} // namespace ssao
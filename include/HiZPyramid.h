@@ -0,0 +1,91 @@
+#pragma once
+#include "FloatImage.h"
+#include "GBufferPacking.h"
+#include "TaskPool.h"
+
+#include <vector>
+
+namespace ssao {
+
+class SSAOEngine;
+
+struct HiZParams
+{
+	HiZParams()
+	: maxLevels( 8 ), lodOffset( 3 )
+	{}
+
+	int		maxLevels;	//level 0 included
+	int		lodOffset;	//a tap d texels away reads level floor( log2( d ) ) - lodOffset, so taps closer than 2^( lodOffset + 1 ) stay at full detail
+};
+
+//what measure() found for one wide radius
+struct HiZReport
+{
+	int		levels;
+	double	buildMs;		//building the pyramid from the normal/depth buffer
+	double	smallMs;		//SSAO at the engine's own radius, full detail lookups ( what we run today )
+	double	wideMs;			//SSAO at the wide radius, full detail lookups
+	double	wideHiZMs;		//SSAO at the wide radius through the pyramid ( build not included )
+	double	wideHiZError;	//mean |ao - wide full detail ao| over geometry ( background pixels left out )
+};
+
+/*
+ * Min / max depth mip chain of a normal/depth buffer ( the mNormalDepthMap layout ), the CPU side of
+ * HiZReduce_frag.glsl. Every level is 4 channels: r = min depth, g = max depth, ba = average view normal
+ * ( octahedral encoded, view normals of visible surfaces still point away from the camera at grazing angles ). Level 0 has the size of the source,
+ * every level after that halves it ( rounding down ). On odd sizes the last column / row of a level also takes
+ * in the third source texel so min / max stay conservative.
+ *
+ * Levels are built one after the other, each one in blocks of rows: a task reads two ( or three ) neighbouring
+ * rows of the level below and writes one row, everything it touches is contiguous.
+ */
+class HiZPyramid
+{
+public:
+	//the pool is borrowed, not owned ( 0 builds on the calling thread )
+	explicit HiZPyramid( TaskPool *pool = 0 );
+
+	void				setParams( const HiZParams &params )	{ mParams = params; }
+	const HiZParams&	getParams() const						{ return mParams; }
+
+	void	build( const FloatImage &normalDepth );
+
+	int					getNumLevels() const		{ return (int)mLevels.size(); }
+	const FloatImage&	getLevel( int level ) const	{ return mLevels[level]; }
+
+	//level for a tap offsetTexels ( level 0 texels ) away from the pixel being shaded, the squared version saves the sqrt per tap
+	int		selectLevel( float offsetTexels ) const		{ return selectLevelSquared( offsetTexels * offsetTexels ); }
+	int		selectLevelSquared( float offsetTexelsSquared ) const
+	{
+		int level = 0;
+		while ( level + 1 < (int)mThresholds.size() && offsetTexelsSquared >= mThresholds[level + 1] )
+			++level;
+		return level;
+	}
+
+	//nearest texel of a level ( clamp to edge ), writes 4 floats
+	void	sample( float u, float v, int level, float *texel ) const;
+
+	//runs the engine at its radius and at wideRadius with and without the pyramid, reports time and error
+	HiZReport measure( const SSAOEngine &engine, const FloatImage &normalDepth, float wideRadius );
+
+private:
+	HiZPyramid( const HiZPyramid& );
+	HiZPyramid& operator=( const HiZPyramid& );
+
+	class RowJob;
+	friend class RowJob;
+
+	void	buildBaseRow( int y );
+	void	reduceRow( int level, int y );
+	void	runRows( int level, int rows );
+
+	TaskPool				*mPool;
+	HiZParams				mParams;
+	std::vector<FloatImage>	mLevels;
+	std::vector<float>		mThresholds;	//squared tap distance from which each level is used
+	const FloatImage		*mSource;
+};
+
+} // namespace ssao
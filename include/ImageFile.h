@@ -0,0 +1,36 @@
+#pragma once
+#include "FloatImage.h"
+
+#include <string>
+
+namespace ssao {
+
+/*
+ * Files for the headless tools. A .fimg is a FloatImage as is: a 20 byte header ( magic "FIMG", version, width,
+ * height, channels, all uint32 ) then width x height x channels native endian floats, rows bottom-up like
+ * FloatImage. Captured G-buffers ( 4 channel mNormalDepthMap layout ) travel as .fimg.
+ *
+ * The PGM functions write / read one channel as 16 bit binary PGM, [0,1] mapped to 0..65535 and rows top-down
+ * ( so any viewer shows it the right way up ), which is what the golden images of tools/AOBench.cpp are.
+ */
+bool	writeFloatImage( const std::string &path, const FloatImage &image );
+bool	readFloatImage( const std::string &path, FloatImage *image );
+
+bool	writePgm16( const std::string &path, const FloatImage &image, int channel = 0 );
+//image becomes 1 channel
+bool	readPgm16( const std::string &path, FloatImage *image );
+
+//how far one channel of two same sized images is apart
+struct ImageDiff
+{
+	ImageDiff() : rms( 0.0f ), maxError( 0.0f ), badFraction( 0.0f ), sizeMismatch( false ) {}
+
+	float	rms;
+	float	maxError;
+	float	badFraction;	//share of pixels off by more than the threshold compareImages() was given
+	bool	sizeMismatch;	//nothing else is filled in
+};
+
+ImageDiff	compareImages( const FloatImage &a, int channelA, const FloatImage &b, int channelB, float badThreshold );
+
+} // namespace ssao
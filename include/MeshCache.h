@@ -0,0 +1,71 @@
+#pragma once
+#include "MeshOptimizer.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+struct MeshOptions
+{
+	MeshOptions() : optimize( true ), cacheSize( 32 ) {}
+
+	bool	optimize;		//optimizeMesh() every mesh on the way in
+	int		cacheSize;		//post transform cache entries to optimize for
+};
+
+/*
+ * Owns the meshes of a scene, each built and optimized once. getTorus() / getCube() / getSphere() are keyed on
+ * their parameters ( a repeated request doesn't even tessellate ), acquire() on the mesh's content, both keys
+ * 64 bit FNV-1a like ShaderCache.h. Identical requests get the same pointer back, valid for the cache's
+ * lifetime, so the scene can share one VBO between them.
+ */
+class MeshCache
+{
+public:
+	explicit MeshCache( const MeshOptions &options = MeshOptions() );
+	~MeshCache();
+
+	//the cache's copy of mesh ( optimized )
+	const MeshData*	acquire( const MeshData &mesh, const std::string &name = "mesh" );
+
+	//same parameters as buildTorus() / buildCube() / buildSphere()
+	const MeshData*	getTorus( float outerRadius, float innerRadius, int longitudeSegments, int latitudeSegments );
+	const MeshData*	getCube( const ci::Vec3f &center, const ci::Vec3f &size );
+	const MeshData*	getSphere( const ci::Vec3f &center, float radius, int segments );
+
+	int					getNumMeshes() const			{ return (int)mEntries.size(); }
+	const MeshData*		getMesh( int index ) const		{ return mEntries[index]->mesh; }
+	const std::string&	getName( int index ) const		{ return mEntries[index]->name; }
+	//ACMR as built and after optimizing ( the same when optimize is off )
+	const MeshStats&	getSourceStats( int index ) const	{ return mEntries[index]->source; }
+	const MeshStats&	getStats( int index ) const			{ return mEntries[index]->optimized; }
+	int					getNumRequests() const			{ return mRequests; }
+	int					getNumHits() const				{ return mHits; }
+
+	//one line per mesh: triangles, vertices, ACMR / ATVR before and after
+	void	dump( std::ostream &os ) const;
+
+private:
+	MeshCache( const MeshCache& );
+	MeshCache& operator=( const MeshCache& );
+
+	struct Entry
+	{
+		std::string	name;
+		uint64_t	key;
+		MeshData	*mesh;
+		MeshStats	source, optimized;
+	};
+
+	const MeshData*	find( uint64_t key );
+	const MeshData*	insert( uint64_t key, MeshData *mesh, const std::string &name );
+
+	MeshOptions				mOptions;
+	std::vector<Entry*>		mEntries;
+	int						mRequests;
+	int						mHits;
+};
+
+} // namespace ssao
@@ -0,0 +1,57 @@
+#pragma once
+#include "SceneGeometry.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ssao {
+
+//post transform cache behaviour of an index buffer
+struct MeshStats
+{
+	size_t	vertices;
+	size_t	triangles;
+	float	acmr;		//vertices transformed per triangle ( 3 = no reuse, ~0.5 is the limit for a large regular grid )
+	float	atvr;		//vertices transformed per vertex ( 1 = every vertex transformed exactly once )
+};
+
+//FIFO cache of cacheSize entries, the usual model for the hardware's post transform cache
+MeshStats	measureMesh( const std::vector<uint32_t> &indices, size_t vertexCount, int cacheSize = 32 );
+inline MeshStats measureMesh( const MeshData &mesh, int cacheSize = 32 ) { return measureMesh( mesh.indices, mesh.positions.size(), cacheSize ); }
+
+//reorders the triangles ( not the vertices ) for a cacheSize entry cache, Forsyth's linear speed algorithm
+void	optimizeVertexCache( std::vector<uint32_t> *indices, size_t vertexCount, int cacheSize = 32 );
+//renumbers the vertices in the order the indices first use them so fetches walk the buffer front to back, unused vertices are dropped
+void	optimizeVertexFetch( MeshData *mesh );
+//both, triangles first
+void	optimizeMesh( MeshData *mesh, int cacheSize = 32 );
+
+enum NormalFormat
+{
+	NORMAL_FLOAT,	//3 floats, 24 byte vertices
+	NORMAL_BYTE		//3 signed normalized bytes + 1 padding, 16 byte vertices ( glNormalPointer( GL_BYTE ) )
+};
+
+/*
+ * position and normal interleaved in one buffer ( one fetch stream instead of two ), indices 16 bit when
+ * every vertex fits. Layout: position at 0, normal at getNormalOffset(), getStride() bytes per vertex.
+ */
+struct InterleavedMesh
+{
+	NormalFormat			normalFormat;
+	size_t					numVertices;
+	size_t					numIndices;
+	bool					shortIndices;
+	std::vector<uint8_t>	vertices;
+	std::vector<uint8_t>	indices;	//uint16_t or uint32_t each
+
+	int		getStride() const		{ return normalFormat == NORMAL_BYTE ? 16 : 24; }
+	int		getNormalOffset() const	{ return 12; }
+	int		getIndexSize() const	{ return shortIndices ? 2 : 4; }
+};
+
+void	interleaveMesh( const MeshData &mesh, NormalFormat normalFormat, InterleavedMesh *result );
+//back to MeshData ( quantized normals decoded and renormalized ), what the GPU ends up seeing
+void	deinterleaveMesh( const InterleavedMesh &mesh, MeshData *result );
+
+} // namespace ssao
@@ -0,0 +1,120 @@
+#pragma once
+#include "FloatImage.h"
+#include "SSAOEngine.h"
+#include "TaskPool.h"
+
+#include <vector>
+
+namespace ssao {
+
+/*
+ * CPU version of renderSSAOToFBO() -> pingPongBlur() -> BasicBlender_frag.glsl.
+ *
+ * runFused() walks the AO target in tiles: each tile computes SSAO for itself plus the blur apron, blurs
+ * horizontally then vertically and composites straight into the output, all inside per thread scratch
+ * buffers small enough to stay in L2. Nothing full frame is written except the final image.
+ *
+ * runUnfused() is the pass-by-pass version with the three full frame intermediates ( mSSAOMap,
+ * mPingPongBlurH, mPingPongBlurV ) for comparison, both produce the same pixels.
+ *
+ * runFusedComposite() is what the GL path does with "Fused Blur Composite" on: pass by pass, but the
+ * vertical blur happens inside the composite ( BlurComposite_frag.glsl ), so mPingPongBlurV is never
+ * written or read. getTraffic() tells what each version moved through memory.
+ */
+
+//full frame buffer traffic of one run, in bytes. each buffer counts once per pass touching it ( taps re-reading texels are cache hits )
+struct ChainTraffic
+{
+	ChainTraffic() : intermediateWritten( 0 ), intermediateRead( 0 ), frameRead( 0 ), frameWritten( 0 ) {}
+
+	size_t	intermediateWritten, intermediateRead;	//mSSAOMap, mPingPongBlurH, mPingPongBlurV
+	size_t	frameRead, frameWritten;				//normal/depth + base in, result out ( the same for every version )
+
+	size_t	getTotal() const	{ return intermediateWritten + intermediateRead + frameRead + frameWritten; }
+};
+
+//wall clock ms of each pass of one run ( 0 for passes it didn't run ), runFused() has no passes, only the total
+struct ChainTimings
+{
+	ChainTimings() : ssao( 0.0 ), blurH( 0.0 ), blurV( 0.0 ), composite( 0.0 ), total( 0.0 ) {}
+
+	double	ssao, blurH, blurV;
+	double	composite;		//blur V included for runFusedComposite()
+	double	total;
+};
+class PostChain
+{
+public:
+	//the default BlurParams of SeparableBlur.h ( 9 tap gaussian, what Blur_h/v_frag.glsl run unless changed )
+	static const int	BLUR_RADIUS = 4;
+
+	//pool and engine are borrowed, not owned
+	PostChain( TaskPool *pool, const SSAOEngine *engine );
+
+	//tile edge in AO texels
+	void	setTileSize( int size )		{ mTileSize = size; }
+	int		getTileSize() const			{ return mTileSize; }
+
+	/*
+	 * normalDepth: 4 channel G-buffer, base: 4 channel lit scene ( mScreenSpace1 ), AO is evaluated at
+	 * aoWidth x aoHeight ( the mSSAOMap size ), result is allocated at the base size
+	 */
+	void runFused( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result );
+	void runUnfused( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result );
+	void runFusedComposite( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result );
+
+	//of the last run
+	const ChainTraffic&	getTraffic() const	{ return mTraffic; }
+	const ChainTimings&	getTimings() const	{ return mTimings; }
+
+	//the full frame buffers from the last runUnfused() ( runFusedComposite() leaves out mPingPongBlurV )
+	const FloatImage&	getSSAOMap() const	{ return mSSAOMap; }
+	const FloatImage&	getBlurH() const	{ return mBlurH; }
+	const FloatImage&	getBlurV() const	{ return mBlurV; }
+
+private:
+	class FusedJob;
+	class PassJob;
+	friend class FusedJob;
+	friend class PassJob;
+
+	//per thread tile memory
+	struct Scratch
+	{
+		FloatImage	ssao, blurH, blurV;
+		FloatImage	blurRows;		//the two vertically blurred AO rows runFusedComposite() interpolates between
+	};
+
+	void	runFusedTile( int tile, int threadIndex );
+	void	blurComposite( int rowBegin, int rowEnd, int threadIndex );
+	void	begin( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result );
+	void	runPasses( bool fuseComposite );
+
+	TaskPool				*mPool;
+	const SSAOEngine		*mEngine;
+	int						mTileSize;
+	std::vector<Scratch>	mScratch;
+	std::vector<float>		mBlurWeights;	//[ -BLUR_RADIUS, BLUR_RADIUS ]
+
+	//state for the job in flight
+	const FloatImage		*mNormalDepth;
+	const FloatImage		*mBase;
+	FloatImage				*mResult;
+	int						mAOWidth, mAOHeight, mTilesX, mTilesY;
+
+	FloatImage				mSSAOMap, mBlurH, mBlurV;
+	ChainTraffic			mTraffic;
+	ChainTimings			mTimings;
+};
+
+//result = base - ( 1.0 - ao ) on every channel, BasicBlender_frag.glsl
+inline void compositeAO( const float *base, float ao, float *out )
+{
+	float redVal = 1.0f - ao;
+	out[0] = base[0] - redVal;
+	out[1] = base[1] - redVal;
+	out[2] = base[2] - redVal;
+	out[3] = base[3] - redVal;
+}
+
+} // namespace ssao
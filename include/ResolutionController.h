@@ -0,0 +1,98 @@
+#pragma once
+#include "FrameProfiler.h"
+#include "ShaderVariants.h"
+
+#include <vector>
+
+namespace ssao {
+
+//what ResolutionController aims for and how far it may go
+struct ResolutionParams
+{
+	ResolutionParams()
+	: budgetMs( 8.0f ), minScale( 0.25f ), maxScale( 1.0f ), scaleStep( 0.125f ), minTier( QUALITY_LOW ), maxTier( QUALITY_ULTRA ),
+	  percentile( 90.0f ), headroom( 0.75f ), windowFrames( 20 ), settleFrames( 4 ), cooldownFrames( 30 ), maxCooldownFrames( 960 )
+	{}
+
+	float		budgetMs;			//frame time to hold
+	float		minScale, maxScale;	//AO targets are window size * scale
+	float		scaleStep;
+	QualityTier	minTier, maxTier;	//sample counts the controller may pick from
+	float		percentile;			//of the frames since the last change, compared against the budget
+	float		headroom;			//only step up below budgetMs * headroom
+	int			windowFrames;		//frames measured before a decision
+	int			settleFrames;		//frames ignored after a change ( new targets, shaders warming up )
+	int			cooldownFrames;		//after stepping down, frames before stepping up again
+	int			maxCooldownFrames;	//cooldown doubles every time a step up had to be taken back soon after, up to this
+};
+
+/*
+ * Picks the AO resolution scale and quality tier that keep the frame time inside a budget. The ( scale, tier )
+ * pairs form a ladder from cheapest to dearest, built once from the params: every rung raises either the scale
+ * or the tier by one notch, whichever is further behind, so both climb together. Cost is scale^2 * samples
+ * ( the AO pass is per pixel per sample ).
+ *
+ * update() gets one frame time per frame. After a change the first settleFrames are ignored, then windowFrames
+ * are collected and their percentile decides: over budget steps down ( straight to the rung the cost model says
+ * fits, at least one ), under budget * headroom steps up one rung. A step up that is taken back before it held
+ * for a cooldown doubles the cooldown before the next try, so a rung right at the budget doesn't flip every second.
+ *
+ * No GL and no clock, feed it recorded timings to test it.
+ */
+class ResolutionController
+{
+public:
+	explicit ResolutionController( const ResolutionParams &params = ResolutionParams() );
+
+	//rebuilds the ladder, stays on the rung nearest the current scale / tier
+	void				setParams( const ResolutionParams &params );
+	const ResolutionParams&	getParams() const	{ return mParams; }
+	//only the budget, the measurements so far stay
+	void				setBudget( float ms )	{ mParams.budgetMs = ms; }
+
+	//start over from the dearest rung that costs no more than scale / tier
+	void				reset( float scale, QualityTier tier );
+
+	//one frame's time in ms, true if the scale or tier changed
+	bool				update( float frameMs );
+
+	float				getScale() const				{ return mRungs[mRung].scale; }
+	QualityTier			getTier() const					{ return mRungs[mRung].tier; }
+	int					getRung() const					{ return mRung; }
+	int					getNumRungs() const				{ return (int)mRungs.size(); }
+	float				getRungScale( int rung ) const	{ return mRungs[rung].scale; }
+	QualityTier			getRungTier( int rung ) const	{ return mRungs[rung].tier; }
+	//the percentile the last decision was made on, 0 before the first
+	float				getMeasuredMs() const			{ return mMeasuredMs; }
+	int					getNumChanges() const			{ return mNumChanges; }
+	int					getCooldown() const				{ return mCooldown; }
+
+	//scale^2 * samples
+	static float		getCost( float scale, QualityTier tier );
+
+private:
+	struct Rung
+	{
+		float		scale;
+		QualityTier	tier;
+		float		cost;
+	};
+
+	void				buildLadder();
+	int					findRung( float scale, QualityTier tier ) const;
+	void				setRung( int rung );
+
+	ResolutionParams	mParams;
+	std::vector<Rung>	mRungs;		//cheapest first
+	int					mRung;
+	SampleHistory		mSamples;
+	std::vector<float>	mSorted;
+	int					mSettle;	//frames left to ignore
+	int					mCooldown;	//frames left before a step up is allowed
+	int					mBackoff;	//cooldown the next step down starts
+	int					mProbation;	//frames a step up has to hold before the cooldown is reset
+	float				mMeasuredMs;
+	int					mNumChanges;
+};
+
+} // namespace ssao
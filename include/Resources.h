@@ -1,9 +1,6 @@
 #pragma once
 #include "cinder/CinderResources.h"
 
-//images
-#define NOISE_SAMPLER	CINDER_RESOURCE( textures/, random.png, 99, IMAGE )
-
 //shaders
 #define SSAO_VERT			CINDER_RESOURCE( shaders/, SSAO_vert.glsl, 100, GLSL )
 #define SSAO_FRAG			CINDER_RESOURCE( shaders/, SSAO_frag.glsl, 101, GLSL )
@@ -18,7 +15,14 @@
 #define BLUR_H_VERT			CINDER_RESOURCE( shaders/, Blur_h_vert.glsl, 107, GLSL )
 #define BLUR_H_FRAG			CINDER_RESOURCE( shaders/, Blur_h_frag.glsl, 108, GLSL )
 
-#define BLUR_V_VERT			CINDER_RESOURCE( shaders/, Blur_v_vert.glsl, 108, GLSL )
+#define BLUR_V_VERT			CINDER_RESOURCE( shaders/, Blur_v_vert.glsl, 116, GLSL )
 #define BLUR_V_FRAG			CINDER_RESOURCE( shaders/, Blur_v_frag.glsl, 109, GLSL )
 
-
+#define GBUFFER_VERT		CINDER_RESOURCE( shaders/, GBuffer_vert.glsl, 110, GLSL )
+#define GBUFFER_FRAG		CINDER_RESOURCE( shaders/, GBuffer_frag.glsl, 111, GLSL )
+#define TEMPORAL_AO_FRAG	CINDER_RESOURCE( shaders/, TemporalAO_frag.glsl, 112, GLSL )
+#define BILATERAL_BLENDER_FRAG	CINDER_RESOURCE( shaders/, BilateralBlender_frag.glsl, 113, GLSL )
+#define HIZ_REDUCE_FRAG		CINDER_RESOURCE( shaders/, HiZReduce_frag.glsl, 114, GLSL )
+#define GBUFFER_PACKING_GLSL	CINDER_RESOURCE( shaders/, GBufferPacking.glsl, 115, GLSL )
+#define BLUR_COMPOSITE_FRAG	CINDER_RESOURCE( shaders/, BlurComposite_frag.glsl, 117, GLSL )
+#define HORIZON_AO_FRAG		CINDER_RESOURCE( shaders/, HorizonAO_frag.glsl, 118, GLSL )
@@ -0,0 +1,156 @@
+#pragma once
+#include "FloatImage.h"
+#include "SampleKernel.h"
+
+#include <vector>
+
+namespace ssao {
+
+class HiZPyramid;
+
+enum AOMethod
+{
+	AO_SSAO,		//SSAOL_frag.glsl: samples point taps around the pixel, each compared against the pixel's depth
+	AO_HORIZON,		//HorizonAO_frag.glsl: GTAO style, directions slices through the pixel marched steps taps each way for the horizon
+	NUM_AO_METHODS
+};
+
+const char*	getAOMethodName( AOMethod method );
+
+//the same scene-dependent constants SSAOL_frag.glsl hard codes
+struct SSAOParams
+{
+	SSAOParams()
+	: totStrength( 0.38f ), strength( 0.3f ), offset( 0.002f ), falloff( 0.0f ), rad( 0.03f ), samples( 10 ), rotation( 0.0f ),
+	  method( AO_SSAO ), directions( 2 ), steps( 3 ), horizonRadius( 0.05f )
+	{
+		//the app's camera: 45 degree fov, 720 x 486
+		projection[0] = 1.62959f;
+		projection[1] = 2.41421356f;
+	}
+
+	float	totStrength;	//declared but unused by the shader, kept so the two stay in step
+	float	strength;
+	float	offset;			//only the NOISE_LEGACY lookup uses it now
+	float	falloff;
+	float	rad;
+	int		samples;		//at most SSAO_KERNEL_SIZE, 4 / 8 / 10 / 16 / 32 run specialized kernels ( see ShaderVariants.h )
+	float	rotation;		//radians, spins the reflection normal about view z ( frameRotation, changed every frame for temporal AO )
+	KernelParams	kernel;	//pSphere[], generated for exactly samples taps ( SampleKernel.h )
+
+	AOMethod	method;
+	int			directions;		//AO_HORIZON: slices per pixel, each marched both ways ( directions * steps * 2 taps )
+	int			steps;			//AO_HORIZON: taps per side of a slice, spaced quadratically so most are close to the pixel
+	float		horizonRadius;	//AO_HORIZON: how far out occluders count, in the depth channel's units ( -viewPos.z / DEPTH_UNIT )
+	float		projection[2];	//AO_HORIZON: ( 0, 0 ) and ( 1, 1 ) of the projection normalDepth was rendered with, to rebuild view positions
+};
+
+static const int MAX_HORIZON_DIRECTIONS	= 8;
+static const int MAX_HORIZON_STEPS		= 8;
+
+/*
+ * CPU mirror of SSAOL_frag.glsl. Takes a 4 channel normal/depth FloatImage ( the mNormalDepthMap layout )
+ * and writes a 1 channel AO FloatImage ( the .r of mSSAOMap ). The output may be any size, lookups are done
+ * in uv space exactly like the full screen quad in renderSSAOToFBO().
+ */
+class SSAOEngine
+{
+public:
+	enum KernelPath
+	{
+		PATH_SCALAR,	//straight transliteration of the shader, one pixel at a time
+		PATH_SIMD		//simd::WIDTH pixels per iteration ( AVX2 / SSE4.1, falls back to scalar )
+	};
+
+	SSAOEngine();
+
+	//regenerates the kernel when params.kernel or params.samples changed
+	void				setParams( const SSAOParams &params );
+	const SSAOParams&	getParams() const						{ return mParams; }
+	const std::vector<float>&	getKernel() const				{ return mKernel; }
+
+	enum NoiseLookup
+	{
+		NOISE_TILE,		//texel ( x, y ) mod the tile size at AO pixel ( x, y ), like the shader's gl_FragCoord lookup
+		NOISE_LEGACY	//texture2D( rnm, rand( uv ) * offset * uv ), what the shader did with random.png
+	};
+
+	//rnm texture, 3 or 4 channels in [0,1]. The blue noise rotation tile of BlueNoise.h until one is set
+	void				setNoise( const FloatImage &noise, NoiseLookup lookup = NOISE_TILE );
+	const FloatImage&	getNoise() const						{ return mNoise; }
+	NoiseLookup			getNoiseLookup() const					{ return mNoiseLookup; }
+
+	void compute( const FloatImage &normalDepth, FloatImage *ao, KernelPath path = PATH_SIMD ) const;
+
+	//computes the rows [rowBegin, rowEnd) and columns [colBegin, colEnd) of ao, which must already be allocated
+	void computeRegion( const FloatImage &normalDepth, FloatImage *ao, int colBegin, int colEnd, int rowBegin, int rowEnd, KernelPath path = PATH_SIMD ) const;
+
+	//AO for the texels [colBegin, colEnd) of row y of an aoWidth x aoHeight target, written to out[0 .. colEnd - colBegin)
+	void computeSpan( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out, KernelPath path = PATH_SIMD ) const;
+
+	/*
+	 * wide radius version: the pixel itself still comes from normalDepth, every tap reads the pyramid level its
+	 * distance asks for ( HiZPyramid::selectLevel() ) and counts as much as the texel's min / max depth range says
+	 * lies in front of the pixel. Scalar only, the lookups are what it saves on. Same as SSAOL_frag.glsl with SSAO_HIZ
+	 */
+	void computeHiZ( const FloatImage &normalDepth, const HiZPyramid &pyramid, FloatImage *ao ) const;
+	void computeRegionHiZ( const FloatImage &normalDepth, const HiZPyramid &pyramid, FloatImage *ao, int colBegin, int colEnd, int rowBegin, int rowEnd ) const;
+
+	static const char*	getSimdPathName();
+	static int			getSimdWidth();
+
+protected:
+	//SAMPLES is the sample count fixed at compile time, 0 reads mParams.samples
+	template<int SAMPLES>
+	void computeSpanVariant( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out, KernelPath path ) const;
+	template<int SAMPLES>
+	void computeSpanScalar( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const;
+	void computeSpanHiZ( const FloatImage &normalDepth, const HiZPyramid &pyramid, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const;
+	template<int SAMPLES>
+	void computeSpanSimd( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const;
+	/*
+	 * AO_HORIZON ( computeSpan() switches to it ): per slice the highest horizon each way and the cosine weighted
+	 * visible arc between them, around the normal projected into the slice, integrated exactly. Occluders fade out
+	 * over the last 60% of horizonRadius. Scalar only, same as HorizonAO_frag.glsl
+	 */
+	void computeSpanHorizon( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const;
+
+	//normalize( texture2D( rnm, ... ).xyz * 2.0 - 1.0 ) for AO pixel ( x, y ) at ( u, v ), rotated by mParams.rotation
+	void fetchReflectionNormal( int x, int y, float u, float v, float *fres ) const;
+
+	SSAOParams			mParams;
+	std::vector<float>	mKernel;		//generateKernel( mParams.kernel, samples ), 3 floats per tap
+	FloatImage			mNoise;
+	NoiseLookup			mNoiseLookup;
+};
+
+//what measureAO() found for one set of params
+struct AOReport
+{
+	int		taps;			//normal/depth lookups per pixel besides its own
+	double	ms;				//one frame, calling thread
+	float	noise;			//RMS of one blurred frame against the converged AO ( the mean of frames frames )
+	float	error;			//mean absolute difference of the converged AO from the reference
+};
+
+//mean of frames frames of engine's AO ( rotation from TemporalAO::getFrameRotation() ), 1 channel aoWidth x aoHeight
+void		computeConvergedAO( const SSAOEngine &engine, const FloatImage &normalDepth, int aoWidth, int aoHeight, int frames, FloatImage *result );
+//cost, noise and accuracy of engine's params against reference ( computeConvergedAO() of something trusted, like many horizon slices )
+AOReport	measureAO( const SSAOEngine &engine, const FloatImage &normalDepth, const FloatImage &reference, int frames );
+
+//what measureNoise() found: RMS error of each rnm against the AO it converges to ( its own mean over many kernel rotations )
+struct NoiseReport
+{
+	enum Noise { LEGACY, WHITE_TILE, BLUE_TILE, NUM_NOISES };	//random normals via rand( uv ), per pixel white noise, per pixel blue noise
+	static const char*	getName( int noise );
+
+	int		samples, frames;
+	float	raw[NUM_NOISES];			//one frame
+	float	blurred[NUM_NOISES];		//one frame after the default blur ( SeparableBlur.h ), where blue noise pays off
+	float	accumulated[NUM_NOISES];	//mean of frames frames turned by TemporalAO::getFrameRotation()
+};
+
+//engine's params ( samples ... ) with each rnm in turn, AO at aoWidth x aoHeight
+NoiseReport measureNoise( const SSAOEngine &engine, const FloatImage &normalDepth, int aoWidth, int aoHeight, int frames );
+
+} // namespace ssao
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+static const int SSAO_KERNEL_SIZE = 32;
+
+//pSphere[] from SSAOL_frag.glsl ( random vectors inside a unit sphere ), the first 10 are the original ones. KERNEL_ORIGINAL
+extern const float SSAO_KERNEL[SSAO_KERNEL_SIZE][3];
+
+//how the pSphere[] vectors of SSAOL_frag.glsl are laid out
+enum KernelType
+{
+	KERNEL_ORIGINAL,	//the fixed SSAO_KERNEL table ( the first samples rows ), what the shader always used
+	KERNEL_POISSON,		//best candidate darts in the unit hemisphere, no two samples close together
+	KERNEL_HAMMERSLEY,	//Hammersley directions ( uniform over the hemisphere ), radical inverse base 3 lengths
+	KERNEL_COSINE,		//the same points with cosine weighted directions, more of them near the normal where occlusion counts most
+	NUM_KERNEL_TYPES
+};
+
+const char*	getKernelTypeName( KernelType type );
+
+struct KernelParams
+{
+	KernelParams() : type( KERNEL_ORIGINAL ), towardCenter( true ), minScale( 0.1f ), seed( 1 ) {}
+
+	KernelType		type;
+	//remaps the lengths from uniform in the volume to minScale + ( 1 - minScale ) * t^2 ( t the volume fraction ), so
+	//most taps land close to the pixel where the occluders that matter are. Not applied to KERNEL_ORIGINAL
+	bool			towardCenter;
+	float			minScale;
+	unsigned int	seed;			//KERNEL_POISSON only, the others are deterministic
+};
+
+/*
+ * size samples, 3 floats each, into kernel. Generated kernels lie in the z >= 0 hemisphere with lengths in
+ * ( 0, 1 ], the shader flips every tap into the hemisphere around the surface normal anyway ( sign( dot( ray, norm ) ) ).
+ * Each size is its own point set, not a prefix of a bigger one, so 4 samples are as well spread as 32
+ */
+void	generateKernel( const KernelParams &params, int size, std::vector<float> *kernel );
+
+//how well a kernel covers what it integrates, the smaller the better for all but minDistance
+struct KernelMetrics
+{
+	int		size;
+	/*
+	 * spherical cap discrepancy of the directions: the worst difference, over a fixed set of caps, between the
+	 * fraction of taps inside and the cap's share of the sphere ( taps counted with their mirror image, the
+	 * shader's sign flip makes +d and -d the same tap ). Measured against uniform, cosine kernels score higher by design
+	 */
+	float	discrepancy;
+	/*
+	 * variance of the occluded fraction of the taps under a half space occluder ( plane at 0, 0.25, 0.5 from the
+	 * pixel ) over random orientations of the kernel, i.e. what a random rnm rotation leaves as noise per pixel
+	 */
+	float	occlusionVariance;
+	float	minDistance;		//closest pair of taps
+	float	meanLength;			//average tap length ( 1 = the full radius )
+};
+
+KernelMetrics	measureKernel( const std::vector<float> &kernel );
+
+//"#define SSAO_KERNEL pSphere[0] = vec3(...); ..." on one line ( GLSL 1.20 has no line continuation ), newline terminated
+std::string		buildKernelGlsl( const std::vector<float> &kernel );
+//"{ x, y, z }," rows for a C++ float[][3] table like SSAO_KERNEL, one per line
+std::string		buildKernelCpp( const std::vector<float> &kernel );
+
+} // namespace ssao
@@ -0,0 +1,112 @@
+#pragma once
+#include "SceneGeometry.h"
+#include "TaskPool.h"
+
+#include "cinder/Matrix.h"
+#include "cinder/Vector.h"
+
+#include <vector>
+
+namespace ssao {
+
+//the 6 planes of a view frustum, ax + by + cz + d >= 0 inside ( normalized, so d is a distance )
+struct Frustum
+{
+	float	planes[6][4];
+
+	//Gribb / Hartmann extraction from projection * view ( world -> clip )
+	static Frustum fromViewProjection( const ci::Matrix44f &viewProjection );
+};
+
+//visible instances of one frame, grouped per mesh so each group is one instanced draw
+struct CullResult
+{
+	std::vector< std::vector<int> >	batches;	//[mesh] -> instance indices, ascending
+	int								visible;
+};
+
+//what measureCulling() found
+struct CullReport
+{
+	int		instances;
+	int		visible;
+	double	scalarMs;		//one thread, one instance at a time
+	double	simdMs;			//one thread, simd::WIDTH instances at a time
+	double	parallelMs;		//simd on every thread of the pool, batching included
+	double	scalarPerMs, simdPerMs, parallelPerMs;	//instances per millisecond
+	int		mismatches;		//instances where the paths disagree
+};
+
+/*
+ * Instances of a handful of meshes, stored structure of arrays: the model matrix as 12 float arrays ( the
+ * affine 3x4 rows ) and the world bounding sphere as 4 ( center x / y / z, radius ), so culling streams through
+ * exactly the 4 arrays it reads, simd::WIDTH instances per load.
+ *
+ * cull() tests the spheres against a frustum in blocks of BLOCK_SIZE instances spread over the TaskPool and
+ * groups the survivors per mesh ( see GlSceneRenderer.h for the instanced draws ). No GL here, it runs headless.
+ */
+class SceneContainer
+{
+public:
+	enum CullPath
+	{
+		CULL_SCALAR,	//reference, one instance at a time
+		CULL_SIMD,		//simd::WIDTH instances per iteration, calling thread only
+		CULL_PARALLEL	//CULL_SIMD blocks on every thread of the pool
+	};
+
+	static const int BLOCK_SIZE = 1024;
+
+	//the pool is borrowed, not owned ( may be 0, CULL_PARALLEL then runs on the calling thread )
+	explicit SceneContainer( TaskPool *pool = 0 );
+
+	void	clear();
+
+	//mesh is borrowed and has to outlive the container, its local bounding sphere is computed here
+	int		addMesh( const MeshData *mesh );
+	int		addInstance( int mesh, const ci::Matrix44f &transform );
+	void	setTransform( int instance, const ci::Matrix44f &transform );
+	//drops every instance past count ( meshes stay )
+	void	truncate( int count );
+
+	int					getNumMeshes() const			{ return (int)mMeshes.size(); }
+	const MeshData*		getMesh( int mesh ) const		{ return mMeshes[mesh].data; }
+	int					getNumInstances() const			{ return (int)mMeshIds.size(); }
+	int					getMeshId( int instance ) const	{ return mMeshIds[instance]; }
+	ci::Matrix44f		getTransform( int instance ) const;
+	//bumped by every change, what ChangeTracker hashes for the objects
+	unsigned int		getRevision() const				{ return mRevision; }
+
+	//the 3x4 model matrix rows of the instances listed, 12 floats each, ready for an instance attribute buffer
+	void	gatherRows( const std::vector<int> &instances, float *rows ) const;
+
+	void		cull( const Frustum &frustum, CullResult *result, CullPath path = CULL_PARALLEL ) const;
+	CullReport	measureCulling( const Frustum &frustum, int iterations ) const;
+
+private:
+	SceneContainer( const SceneContainer& );
+	SceneContainer& operator=( const SceneContainer& );
+
+	class CullJob;
+	friend class CullJob;
+
+	struct Mesh
+	{
+		const MeshData	*data;
+		ci::Vec3f		center;		//local bounding sphere
+		float			radius;
+	};
+
+	//marks visible[i - begin] for the instances [begin, end)
+	void	cullRange( const Frustum &frustum, int begin, int end, unsigned char *visible, CullPath path ) const;
+	void	updateBounds( int instance );
+
+	TaskPool				*mPool;
+	std::vector<Mesh>		mMeshes;
+	std::vector<int>		mMeshIds;
+	std::vector<float>		mRows[12];		//row r, column c of the model matrix in mRows[r * 4 + c]
+	std::vector<float>		mCenterX, mCenterY, mCenterZ, mRadius;
+	unsigned int			mRevision;
+};
+
+} // namespace ssao
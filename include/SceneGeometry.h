@@ -0,0 +1,60 @@
+#pragma once
+#include "cinder/Vector.h"
+#include "cinder/Matrix.h"
+#include <vector>
+#include <stdint.h>
+
+namespace ssao {
+
+//indexed triangle list, one normal per position
+struct MeshData
+{
+	std::vector<ci::Vec3f>	positions;
+	std::vector<ci::Vec3f>	normals;
+	std::vector<uint32_t>	indices;
+
+	size_t getNumTriangles() const { return indices.size() / 3; }
+};
+
+//CPU tessellations of the gl::draw*() primitives used in setup()
+void buildTorus( MeshData *mesh, float outerRadius, float innerRadius, int longitudeSegments, int latitudeSegments );
+void buildCube( MeshData *mesh, const ci::Vec3f &center, const ci::Vec3f &size );
+void buildSphere( MeshData *mesh, const ci::Vec3f &center, float radius, int segments );
+
+struct SceneObject
+{
+	SceneObject() : mesh( 0 ) {}
+	SceneObject( const MeshData *m, const ci::Matrix44f &t ) : mesh( m ), transform( t ) {}
+
+	const MeshData	*mesh;
+	ci::Matrix44f	transform;	//model matrix
+};
+
+class MeshCache;
+struct MeshOptions;
+
+/*
+ * The torus, board, box and sphere from drawTestObjects() with the same transforms.
+ * The meshes come from a MeshCache ( optimized, shared when identical ) the scene owns, getObjects() points into it.
+ */
+class TestScene
+{
+public:
+	TestScene();
+	explicit TestScene( const MeshOptions &options );
+	~TestScene();
+
+	const std::vector<SceneObject>&	getObjects() const		{ return mObjects; }
+	const MeshCache&				getMeshCache() const	{ return *mMeshCache; }
+
+private:
+	TestScene( const TestScene& );
+	TestScene& operator=( const TestScene& );
+
+	void	build( const MeshOptions &options );
+
+	MeshCache					*mMeshCache;
+	std::vector<SceneObject>	mObjects;
+};
+
+} // namespace ssao
@@ -0,0 +1,97 @@
+#pragma once
+#include "FloatImage.h"
+#include "TaskPool.h"
+
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+static const int MAX_BLUR_RADIUS = 8;
+
+struct BlurParams
+{
+	BlurParams() : radius( 4 ), depthAware( false ), depthSigma( 0.05f ) {}
+
+	int		radius;			//texels each side, 1 - MAX_BLUR_RADIUS ( sigma is ( radius + 1 ) / 2 )
+	bool	depthAware;		//taps across a depth edge fade out, so AO doesn't bleed from the foreground onto the background
+	float	depthSigma;		//depth difference, relative to the pixel's own depth, that costs a tap ~60% of its weight
+};
+
+//the gaussian's weights for offsets 0..radius ( normalized so weights[0] + 2 * the rest = 1 )
+void	computeBlurWeights( const BlurParams &params, std::vector<float> *weights );
+
+/*
+ * the same kernel for a bilinear filtered texture: neighbouring tap pairs ( 1, 2 ), ( 3, 4 ) ... merged into one
+ * fetch between them weighted so the filter mixes them in the right ratio. offsets[0] = 0 is the center, every
+ * other entry is fetched at + and - its offset, so radius 4 ( 9 taps ) is 5 fetches
+ */
+void	computeLinearTaps( const std::vector<float> &weights, std::vector<float> *offsets, std::vector<float> *linearWeights );
+
+/*
+ * the #defines Blur_h/v_frag.glsl are specialized with ( BLUR_TAPS, the offsets / weights, BLUR_DEPTH_AWARE ).
+ * linearTaps = false keeps one fetch per texel, for shaders sampling between texel centers ( BlurComposite_frag.glsl )
+ * where a merged fetch would mix in a third texel
+ */
+std::string	buildBlurDefines( const BlurParams &params, bool linearTaps = true );
+
+/*
+ * one row along x: dst[x] for x in [begin, end), taps clamped to [0, width) like GL_CLAMP_TO_EDGE.
+ * the interior is simd::WIDTH texels per iteration, only the clamped ends are scalar
+ */
+void	blurRow( const float *src, int width, float *dst, int begin, int end, const float *weights, int radius );
+//along y: dst[x] = sum of rows[k][x] * weight( k - radius ), rows holds the 2 * radius + 1 ( already clamped ) rows around dst's
+void	blurColumns( const float *const *rows, float *dst, int begin, int end, const float *weights, int radius );
+
+//what SeparableBlur::measure() found
+struct BlurReport
+{
+	int		width, height, radius;
+	double	naiveMs;		//one texel, one tap at a time, both passes
+	double	simdMs;			//blurRow() / blurColumns(), calling thread only
+	double	parallelMs;		//the same with the rows spread over the pool
+	double	linearTapsMs;	//bilinear merged taps emulated on the CPU ( what the shader fetches )
+	float	maxSimdError;		//against naive
+	float	maxLinearTapsError;	//against naive
+};
+
+/*
+ * CPU version of pingPongBlurH() -> pingPongBlurV() on 1 channel AO images. blurNaive() is the 9 tap loop the
+ * shaders used to be ( per tap clamping, per texel weights ), blur() the simd kernels above, blurDepthAware()
+ * the BLUR_DEPTH_AWARE shaders ( scalar, per tap depth weights don't vectorize as simply ).
+ */
+class SeparableBlur
+{
+public:
+	//pool is borrowed, may be 0 ( everything on the calling thread )
+	explicit SeparableBlur( TaskPool *pool = 0 );
+
+	void	setParams( const BlurParams &params );
+	const BlurParams&	getParams() const	{ return mParams; }
+
+	void	blurNaive( const FloatImage &src, FloatImage *dst );
+	void	blur( const FloatImage &src, FloatImage *dst, bool parallel = true );
+	//bilinear lookups at computeLinearTaps() offsets, equal to blurNaive() up to rounding
+	void	blurLinearTaps( const FloatImage &src, FloatImage *dst );
+	//normalDepth is 4 channel ( a = linear depth ), any size: looked up at the AO texel's center like the shader does
+	void	blurDepthAware( const FloatImage &src, const FloatImage &normalDepth, FloatImage *dst );
+
+	BlurReport	measure( const FloatImage &src, int iterations );
+
+	const FloatImage&	getIntermediate() const	{ return mTemp; }	//the horizontal pass of the last blur
+
+private:
+	class RowJob;
+	friend class RowJob;
+
+	void	blurRows( const FloatImage &src, FloatImage *dst, int rowBegin, int rowEnd ) const;
+	void	blurCols( const FloatImage &src, FloatImage *dst, int rowBegin, int rowEnd ) const;
+
+	TaskPool			*mPool;
+	BlurParams			mParams;
+	std::vector<float>	mWeights;			//[ -radius, radius ]
+	std::vector<float>	mOffsets, mLinearWeights;
+	FloatImage			mTemp;
+};
+
+} // namespace ssao
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ssao {
+
+//source as the cache sees it: CRLF -> LF, comments and blank lines gone, trailing whitespace trimmed
+std::string	preprocessShader( const std::string &source );
+
+//64 bit FNV-1a ( constants spelled out in 32 bit halves, no long long literals in C++03 )
+static const uint64_t FNV_OFFSET_BASIS	= ( (uint64_t)0xcbf29ce4u << 32 ) | 0x84222325u;
+static const uint64_t FNV_PRIME			= ( (uint64_t)0x00000100u << 32 ) | 0x000001b3u;
+
+uint64_t	hashFnv1a( const void *data, size_t size, uint64_t seed = FNV_OFFSET_BASIS );
+uint64_t	hashFnv1a( const std::string &str, uint64_t seed = FNV_OFFSET_BASIS );
+
+/*
+ * cache key of a program: the preprocessed sources ( defines included, so every variant gets its own key ) plus
+ * a driver tag ( GL_VENDOR / GL_RENDERER / GL_VERSION ), a driver update then simply misses instead of
+ * loading a binary the new driver would reject
+ */
+uint64_t	makeShaderKey( const std::string &vertexSource, const std::string &fragmentSource, const std::string &driverTag );
+
+std::string	keyToHex( uint64_t key );
+
+/*
+ * On disk store of opaque program blobs, one <key>.bin file per entry plus an index of the keys it wrote.
+ * Every file carries a header ( magic, cache version, binary format, size, checksum of the payload ),
+ * anything that does not check out on load is deleted and reported as a miss. Knows nothing about GL,
+ * see GlProgramCache.h for the driver binary side.
+ *
+ * Every construction is a new session, the index remembers the last session each entry was stored or loaded
+ * in. trim() drops the least recently used entries over a size budget, never one used in this session, so
+ * variants that aren't built at every startup ( other kernels, blur radii ) stay cached until they go stale.
+ */
+class ShaderCache
+{
+public:
+	static const uint32_t	VERSION = 1;
+
+	//directory must exist, an empty string disables the cache ( every lookup misses, stores are dropped )
+	explicit ShaderCache( const std::string &directory );
+	//writes the index if loads moved entries up
+	~ShaderCache();
+
+	bool	isEnabled() const	{ return !mDirectory.empty(); }
+
+	//false on a miss or a corrupt / stale entry ( which is removed )
+	bool	load( uint64_t key, uint32_t *format, std::vector<uint8_t> *blob );
+	bool	store( uint64_t key, uint32_t format, const std::vector<uint8_t> &blob );
+
+	//drop one entry, drop everything
+	void	invalidate( uint64_t key );
+	void	clear();
+	//drop the least recently used entries until the rest fit maxBytes and maxEntries ( 0 = no limit ), this session's stay
+	void	trim( size_t maxBytes, size_t maxEntries = 0 );
+	//write the index now ( the destructor does it too )
+	void	flush();
+
+	std::vector<uint64_t>	getKeys() const;
+	bool					contains( uint64_t key ) const	{ return findEntry( key ) >= 0; }
+	//bytes on disk ( headers included ) of every entry
+	size_t					getBytes() const;
+	uint32_t				getSession() const		{ return mSession; }
+	//session the entry was last stored or loaded in, 0 if there is no such entry
+	uint32_t				getLastUsed( uint64_t key ) const;
+	int						getNumHits() const		{ return mHits; }
+	int						getNumMisses() const	{ return mMisses; }
+	int						getNumRejected() const	{ return mRejected; }
+
+private:
+	struct Entry
+	{
+		uint64_t	key;
+		uint32_t	lastUsed;	//session
+		size_t		bytes;
+	};
+
+	std::string	getPath( uint64_t key ) const;
+	std::string	getIndexPath() const;
+	int			findEntry( uint64_t key ) const;
+	void		readIndex();
+	void		writeIndex();
+	void		removeKey( uint64_t key );
+
+	std::string			mDirectory;
+	std::vector<Entry>	mEntries;
+	uint32_t			mSession;
+	bool				mDirty;		//lastUsed changed since the index was written
+	int					mHits, mMisses, mRejected;
+};
+
+} // namespace ssao
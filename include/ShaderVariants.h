@@ -0,0 +1,46 @@
+#pragma once
+#include "SSAOEngine.h"
+
+#include <string>
+
+namespace ssao {
+
+//what the SSAO pass costs, picked once and baked into a specialized shader ( no uniforms, no loop )
+enum QualityTier
+{
+	QUALITY_LOW,		//4 samples ( horizon: 1 direction, 2 steps )
+	QUALITY_MEDIUM,		//8 samples ( 2 directions, 2 steps )
+	QUALITY_ORIGINAL,	//10 samples, the shader as it always was ( 2 directions, 3 steps )
+	QUALITY_HIGH,		//16 samples ( 2 directions, 4 steps )
+	QUALITY_ULTRA,		//32 samples ( 4 directions, 4 steps )
+	NUM_QUALITY_TIERS
+};
+
+int			getTierSamples( QualityTier tier );
+const char*	getTierName( QualityTier tier );
+
+//base with the sample count and horizon directions / steps of the tier ( radius, strength etc. are left alone )
+SSAOParams	getTierParams( QualityTier tier, const SSAOParams &base = SSAOParams() );
+
+/*
+ * Load time specialization of SSAOL_frag.glsl. The shader reads everything scene dependent from macros
+ * ( SAMPLES, SSAO_RAD, SSAO_KERNEL ... ) and only falls back to its own defaults when SSAO_VARIANT is not
+ * defined. These build the #define block for a set of params and paste it in after the #version line.
+ * With unroll the sample loop is replaced by SAMPLES copies of SSAO_TAP( i ). With hiZ the taps read the
+ * Hi-Z pyramid ( SSAO_HIZ, see HiZPyramid.h ) instead of the full res normal/depth.
+ * SSAO_KERNEL is generateKernel( params.kernel, SAMPLES ) like the CPU engine's, so a tier looks the same on both.
+ */
+std::string	buildSSAOVariantDefines( const SSAOParams &params, bool unroll = true, bool hiZ = false );
+std::string	buildSSAOVariant( const std::string &source, const SSAOParams &params, bool unroll = true, bool hiZ = false );
+
+//the same for HorizonAO_frag.glsl ( DIRECTIONS, STEPS, HORIZON_RADIUS ), its loops have constant trip counts the compiler unrolls
+std::string	buildHorizonVariantDefines( const SSAOParams &params );
+std::string	buildHorizonVariant( const std::string &source, const SSAOParams &params );
+
+//GLSL 1.20 wants a float literal, always prints the decimal point
+std::string	glslFloat( float value );
+
+//source with defines inserted right after the #version line ( or at the top if there is none )
+std::string	insertDefines( const std::string &source, const std::string &defines );
+
+} // namespace ssao
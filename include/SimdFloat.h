@@ -0,0 +1,187 @@
+#pragma once
+
+/*
+ * Tiny wrapper over the vector units so the CPU kernels are written once and compiled
+ * for whatever the target supports: AVX2 ( 8 lanes ), SSE4.1 ( 4 lanes ) or plain scalar ( 1 lane ).
+ * The path is picked at compile time ( -mavx2 / -msse4.1 ), define SSAO_DISABLE_SIMD to force scalar.
+ */
+
+#if !defined( SSAO_DISABLE_SIMD ) && defined( __AVX2__ )
+	#define SSAO_SIMD_AVX2 1
+	#include <immintrin.h>
+#elif !defined( SSAO_DISABLE_SIMD ) && defined( __SSE4_1__ )
+	#define SSAO_SIMD_SSE4 1
+	#include <smmintrin.h>
+#endif
+
+#include <cmath>
+
+namespace ssao { namespace simd {
+
+#if defined( SSAO_SIMD_AVX2 )
+
+static const int WIDTH = 8;
+inline const char* getPathName() { return "AVX2"; }
+
+struct Float	{ __m256 v;		Float() {}	Float( __m256 x ) : v( x ) {}	explicit Float( float s ) : v( _mm256_set1_ps( s ) ) {} };
+struct Int		{ __m256i v;	Int() {}	Int( __m256i x ) : v( x ) {}	explicit Int( int s ) : v( _mm256_set1_epi32( s ) ) {} };
+
+inline Float	load( const float *p )				{ return _mm256_loadu_ps( p ); }
+inline void		store( float *p, Float a )			{ _mm256_storeu_ps( p, a.v ); }
+inline Float	iota()								{ return _mm256_set_ps( 7, 6, 5, 4, 3, 2, 1, 0 ); }
+
+inline Float	operator+( Float a, Float b )		{ return _mm256_add_ps( a.v, b.v ); }
+inline Float	operator-( Float a, Float b )		{ return _mm256_sub_ps( a.v, b.v ); }
+inline Float	operator*( Float a, Float b )		{ return _mm256_mul_ps( a.v, b.v ); }
+inline Float	operator/( Float a, Float b )		{ return _mm256_div_ps( a.v, b.v ); }
+inline Float	min( Float a, Float b )				{ return _mm256_min_ps( a.v, b.v ); }
+inline Float	max( Float a, Float b )				{ return _mm256_max_ps( a.v, b.v ); }
+inline Float	floor( Float a )					{ return _mm256_floor_ps( a.v ); }
+inline Float	sqrt( Float a )						{ return _mm256_sqrt_ps( a.v ); }
+inline Float	abs( Float a )						{ return _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a.v ); }
+
+//comparisons return a lane mask usable by select()
+inline Float	cmpGe( Float a, Float b )			{ return _mm256_cmp_ps( a.v, b.v, _CMP_GE_OQ ); }
+inline Float	cmpGt( Float a, Float b )			{ return _mm256_cmp_ps( a.v, b.v, _CMP_GT_OQ ); }
+inline Float	cmpLt( Float a, Float b )			{ return _mm256_cmp_ps( a.v, b.v, _CMP_LT_OQ ); }
+inline Float	select( Float mask, Float a, Float b ) { return _mm256_blendv_ps( b.v, a.v, mask.v ); }
+inline int		moveMask( Float mask )				{ return _mm256_movemask_ps( mask.v ); }
+
+inline Int		toInt( Float a )					{ return _mm256_cvttps_epi32( a.v ); }
+inline Float	toFloat( Int a )					{ return _mm256_cvtepi32_ps( a.v ); }
+inline Int		operator+( Int a, Int b )			{ return _mm256_add_epi32( a.v, b.v ); }
+inline Int		operator*( Int a, Int b )			{ return _mm256_mullo_epi32( a.v, b.v ); }
+inline Int		min( Int a, Int b )					{ return _mm256_min_epi32( a.v, b.v ); }
+inline Int		max( Int a, Int b )					{ return _mm256_max_epi32( a.v, b.v ); }
+inline Float	gather( const float *base, Int idx ) { return _mm256_i32gather_ps( base, idx.v, 4 ); }
+
+//bit twiddling for packed formats ( shifts are logical )
+inline Int		load( const int *p )				{ return _mm256_loadu_si256( (const __m256i*)p ); }
+inline void		store( int *p, Int a )				{ _mm256_storeu_si256( (__m256i*)p, a.v ); }
+inline Int		operator|( Int a, Int b )			{ return _mm256_or_si256( a.v, b.v ); }
+inline Int		operator&( Int a, Int b )			{ return _mm256_and_si256( a.v, b.v ); }
+inline Int		shiftLeft( Int a, int n )			{ return _mm256_slli_epi32( a.v, n ); }
+inline Int		shiftRight( Int a, int n )			{ return _mm256_srli_epi32( a.v, n ); }
+
+#elif defined( SSAO_SIMD_SSE4 )
+
+static const int WIDTH = 4;
+inline const char* getPathName() { return "SSE4.1"; }
+
+struct Float	{ __m128 v;		Float() {}	Float( __m128 x ) : v( x ) {}	explicit Float( float s ) : v( _mm_set1_ps( s ) ) {} };
+struct Int		{ __m128i v;	Int() {}	Int( __m128i x ) : v( x ) {}	explicit Int( int s ) : v( _mm_set1_epi32( s ) ) {} };
+
+inline Float	load( const float *p )				{ return _mm_loadu_ps( p ); }
+inline void		store( float *p, Float a )			{ _mm_storeu_ps( p, a.v ); }
+inline Float	iota()								{ return _mm_set_ps( 3, 2, 1, 0 ); }
+
+inline Float	operator+( Float a, Float b )		{ return _mm_add_ps( a.v, b.v ); }
+inline Float	operator-( Float a, Float b )		{ return _mm_sub_ps( a.v, b.v ); }
+inline Float	operator*( Float a, Float b )		{ return _mm_mul_ps( a.v, b.v ); }
+inline Float	operator/( Float a, Float b )		{ return _mm_div_ps( a.v, b.v ); }
+inline Float	min( Float a, Float b )				{ return _mm_min_ps( a.v, b.v ); }
+inline Float	max( Float a, Float b )				{ return _mm_max_ps( a.v, b.v ); }
+inline Float	floor( Float a )					{ return _mm_floor_ps( a.v ); }
+inline Float	sqrt( Float a )						{ return _mm_sqrt_ps( a.v ); }
+inline Float	abs( Float a )						{ return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.v ); }
+
+inline Float	cmpGe( Float a, Float b )			{ return _mm_cmpge_ps( a.v, b.v ); }
+inline Float	cmpGt( Float a, Float b )			{ return _mm_cmpgt_ps( a.v, b.v ); }
+inline Float	cmpLt( Float a, Float b )			{ return _mm_cmplt_ps( a.v, b.v ); }
+inline Float	select( Float mask, Float a, Float b ) { return _mm_blendv_ps( b.v, a.v, mask.v ); }
+inline int		moveMask( Float mask )				{ return _mm_movemask_ps( mask.v ); }
+
+inline Int		toInt( Float a )					{ return _mm_cvttps_epi32( a.v ); }
+inline Float	toFloat( Int a )					{ return _mm_cvtepi32_ps( a.v ); }
+inline Int		operator+( Int a, Int b )			{ return _mm_add_epi32( a.v, b.v ); }
+inline Int		operator*( Int a, Int b )			{ return _mm_mullo_epi32( a.v, b.v ); }
+inline Int		min( Int a, Int b )					{ return _mm_min_epi32( a.v, b.v ); }
+inline Int		max( Int a, Int b )					{ return _mm_max_epi32( a.v, b.v ); }
+
+//no hardware gather before AVX2 so spill the indices and load lane by lane
+inline Float gather( const float *base, Int idx )
+{
+	int i[4];
+	_mm_storeu_si128( (__m128i*)i, idx.v );
+	return _mm_set_ps( base[i[3]], base[i[2]], base[i[1]], base[i[0]] );
+}
+
+//bit twiddling for packed formats ( shifts are logical )
+inline Int		load( const int *p )				{ return _mm_loadu_si128( (const __m128i*)p ); }
+inline void		store( int *p, Int a )				{ _mm_storeu_si128( (__m128i*)p, a.v ); }
+inline Int		operator|( Int a, Int b )			{ return _mm_or_si128( a.v, b.v ); }
+inline Int		operator&( Int a, Int b )			{ return _mm_and_si128( a.v, b.v ); }
+inline Int		shiftLeft( Int a, int n )			{ return _mm_slli_epi32( a.v, n ); }
+inline Int		shiftRight( Int a, int n )			{ return _mm_srli_epi32( a.v, n ); }
+
+#else
+
+static const int WIDTH = 1;
+inline const char* getPathName() { return "scalar"; }
+
+struct Float	{ float v;	Float() {}	Float( float x ) : v( x ) {} };
+struct Int		{ int v;	Int() {}	Int( int x ) : v( x ) {} };
+
+inline Float	load( const float *p )				{ return *p; }
+inline void		store( float *p, Float a )			{ *p = a.v; }
+inline Float	iota()								{ return 0.0f; }
+
+inline Float	operator+( Float a, Float b )		{ return a.v + b.v; }
+inline Float	operator-( Float a, Float b )		{ return a.v - b.v; }
+inline Float	operator*( Float a, Float b )		{ return a.v * b.v; }
+inline Float	operator/( Float a, Float b )		{ return a.v / b.v; }
+inline Float	min( Float a, Float b )				{ return a.v < b.v ? a.v : b.v; }
+inline Float	max( Float a, Float b )				{ return a.v > b.v ? a.v : b.v; }
+inline Float	floor( Float a )					{ return std::floor( a.v ); }
+inline Float	sqrt( Float a )						{ return std::sqrt( a.v ); }
+inline Float	abs( Float a )						{ return std::fabs( a.v ); }
+
+//masks are 1.0 / 0.0 in scalar mode
+inline Float	cmpGe( Float a, Float b )			{ return a.v >= b.v ? 1.0f : 0.0f; }
+inline Float	cmpGt( Float a, Float b )			{ return a.v > b.v ? 1.0f : 0.0f; }
+inline Float	cmpLt( Float a, Float b )			{ return a.v < b.v ? 1.0f : 0.0f; }
+inline Float	select( Float mask, Float a, Float b ) { return mask.v != 0.0f ? a : b; }
+inline int		moveMask( Float mask )				{ return mask.v != 0.0f ? 1 : 0; }
+
+inline Int		toInt( Float a )					{ return (int)a.v; }
+inline Float	toFloat( Int a )					{ return (float)a.v; }
+inline Int		operator+( Int a, Int b )			{ return a.v + b.v; }
+inline Int		operator*( Int a, Int b )			{ return a.v * b.v; }
+inline Int		min( Int a, Int b )					{ return a.v < b.v ? a.v : b.v; }
+inline Int		max( Int a, Int b )					{ return a.v > b.v ? a.v : b.v; }
+inline Float	gather( const float *base, Int idx ) { return base[idx.v]; }
+
+inline Int		load( const int *p )				{ return *p; }
+inline void		store( int *p, Int a )				{ *p = a.v; }
+inline Int		operator|( Int a, Int b )			{ return a.v | b.v; }
+inline Int		operator&( Int a, Int b )			{ return a.v & b.v; }
+inline Int		shiftLeft( Int a, int n )			{ return (int)( (unsigned int)a.v << n ); }
+inline Int		shiftRight( Int a, int n )			{ return (int)( (unsigned int)a.v >> n ); }
+
+#endif
+
+//helpers shared by every path
+inline Float clamp( Float a, Float lo, Float hi )	{ return min( max( a, lo ), hi ); }
+inline Int	 clamp( Int a, Int lo, Int hi )			{ return min( max( a, lo ), hi ); }
+
+//GLSL sign(): -1, 0 or 1
+inline Float sign( Float a )
+{
+	Float zero( 0.0f );
+	return select( cmpGt( a, zero ), Float( 1.0f ), select( cmpLt( a, zero ), Float( -1.0f ), zero ) );
+}
+
+//GLSL smoothstep()
+inline Float smoothstep( Float edge0, Float edge1, Float x )
+{
+	Float t = clamp( ( x - edge0 ) / ( edge1 - edge0 ), Float( 0.0f ), Float( 1.0f ) );
+	return t * t * ( Float( 3.0f ) - Float( 2.0f ) * t );
+}
+
+//GLSL step()
+inline Float step( Float edge, Float x )
+{
+	return select( cmpGe( x, edge ), Float( 1.0f ), Float( 0.0f ) );
+}
+
+} } // namespace ssao::simd
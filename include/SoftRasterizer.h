@@ -0,0 +1,87 @@
+#pragma once
+#include "FloatImage.h"
+#include "SceneGeometry.h"
+#include "TaskPool.h"
+
+#include "cinder/Matrix.h"
+#include <vector>
+
+namespace ssao {
+
+/*
+ * CPU version of renderNormalsDepthToFBO() + NormalDepthTexCreate_vert/frag.glsl.
+ *
+ * Vertices are transformed in parallel, triangles are set up and binned into TILE_SIZE screen tiles per
+ * chunk, and then every tile is rasterized independently ( one task per tile ) with its own depth buffer.
+ * Output is rgb = normalize( view space normal ), a = -viewPos.z / 10.0 exactly like the shader,
+ * cleared to normal ( 0, 0, 1 ) at the far plane of the projection, what the FBO's packed clear unpacks to.
+ */
+class SoftRasterizer
+{
+public:
+	static const int TILE_SIZE			= 32;
+	static const int TRIANGLES_PER_CHUNK = 2048;
+
+	//the pool is borrowed, not owned
+	explicit SoftRasterizer( TaskPool *pool );
+
+	//normalDepth must already be allocated with 4 channels, its size is the viewport
+	void render( const std::vector<SceneObject> &objects, const ci::Matrix44f &view, const ci::Matrix44f &projection, FloatImage *normalDepth );
+
+	size_t getNumTrianglesSubmitted() const	{ return mTrianglesSubmitted; }
+	size_t getNumTrianglesBinned() const	{ return mTrianglesBinned; }
+
+	//projected triangle ready for tile rasterization, attributes are pre-divided by w for perspective correction
+	struct ScreenTriangle
+	{
+		float	x[3], y[3], z[3];		//window coords, z in [0,1]
+		float	invW[3];
+		float	attr[3][4];				//view normal xyz / w, depth / w
+		int		minX, minY, maxX, maxY;	//pixel bounds, inclusive
+	};
+
+	//post-transform vertex
+	struct ClipVertex
+	{
+		float	clip[4];
+		float	attr[4];
+	};
+
+private:
+	SoftRasterizer( const SoftRasterizer& );
+	SoftRasterizer& operator=( const SoftRasterizer& );
+
+	struct Chunk
+	{
+		int								object;
+		size_t							firstTriangle, lastTriangle;
+		std::vector<ScreenTriangle>		triangles;
+		std::vector< std::vector<uint32_t> > bins;	//per tile, indices into triangles
+	};
+
+	class VertexJob;
+	class BinJob;
+	class RasterJob;
+	friend class VertexJob;
+	friend class BinJob;
+	friend class RasterJob;
+
+	void	setupTriangle( const ClipVertex *v0, const ClipVertex *v1, const ClipVertex *v2, Chunk *chunk );
+	void	emitTriangle( const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Chunk *chunk );
+	void	rasterizeTile( int tile, FloatImage *normalDepth );
+
+	TaskPool							*mPool;
+
+	const std::vector<SceneObject>		*mObjects;
+	std::vector<ci::Matrix44f>			mModelView, mModelViewProjection;
+
+	int									mWidth, mHeight, mTilesX, mTilesY;
+	float								mFarDepth;	//background depth, far / DEPTH_UNIT
+	std::vector< std::vector<ClipVertex> > mVertices;	//per object
+	std::vector<Chunk>					mChunks;
+
+	size_t								mTrianglesSubmitted;
+	size_t								mTrianglesBinned;
+};
+
+} // namespace ssao
@@ -0,0 +1,78 @@
+#pragma once
+#include "FrameGraph.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace ssao {
+
+//VRAM of one render target, split the way gl::Fbo allocates it
+struct TargetFootprint
+{
+	std::string		name;				//resources sharing the target, '/' separated
+	TextureDesc		desc;
+	int				copies;				//ping-pong pairs count 2
+	int				mipLevels;			//1 = no mip chain
+	size_t			textureBytes;		//color textures shaders sample ( the resolve target when multisampled ), mips included
+	size_t			multisampleBytes;	//multisampled color + depth renderbuffers, 0 when samples == 0
+	size_t			depthBytes;			//single sample depth buffer
+
+	size_t			getTotalBytes() const	{ return textureBytes + multisampleBytes + depthBytes; }
+};
+
+//every target of a frame at one resolution
+struct TargetPlan
+{
+	int								width, height;
+	std::vector<TargetFootprint>	targets;
+	size_t							totalBytes;
+	size_t							multisampleBytes;	//of totalBytes, what MSAA storage costs
+};
+
+size_t			getBytesPerTexel( TextureDesc::Format format );
+//depth is GL_DEPTH_COMPONENT24, which drivers store in 32 bits
+size_t			getDepthBytesPerSample();
+TargetFootprint	measureTarget( const std::string &name, const TextureDesc &desc, int copies = 1, int mipLevels = 1 );
+
+/*
+ * Memory accounting for the render targets of a frame. Targets are declared at a reference size ( the window )
+ * and plan() rescales every one of them to another output resolution, so the footprint of the current set of
+ * passes can be read off for 1080p, 4K, ... without allocating anything. No GL here, it runs headless.
+ *
+ * A multisampled target costs samples x its texture in renderbuffers plus the single sample texture it resolves
+ * into, plus a depth buffer at both sample counts when it has one.
+ */
+class TargetPlanner
+{
+public:
+	TargetPlanner( int referenceWidth = 0, int referenceHeight = 0 );
+
+	//forget every target, later ones are declared relative to this size
+	void		clear( int referenceWidth, int referenceHeight );
+
+	void		addTarget( const std::string &name, const TextureDesc &desc, int copies = 1, int mipLevels = 1 );
+	//every physical target of a compiled graph ( aliased resources counted once ), imported resources are left to the caller
+	void		addFrameGraph( const FrameGraph &graph );
+
+	int			getNumTargets() const	{ return (int)mTargets.size(); }
+
+	TargetPlan	plan() const			{ return plan( mReferenceWidth, mReferenceHeight ); }
+	TargetPlan	plan( int width, int height ) const;
+
+	static void	dump( const TargetPlan &plan, std::ostream &os );
+
+private:
+	struct Target
+	{
+		std::string		name;
+		TextureDesc		desc;
+		int				copies;
+		int				mipLevels;
+	};
+
+	int						mReferenceWidth, mReferenceHeight;
+	std::vector<Target>		mTargets;
+};
+
+} // namespace ssao
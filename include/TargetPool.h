@@ -0,0 +1,101 @@
+#pragma once
+#include "FrameGraph.h"
+#include "TargetPlanner.h"
+
+#include <vector>
+
+namespace ssao {
+
+/*
+ * Render targets that are no longer used, kept by TextureDesc for a while in case the same size comes back. With
+ * the resolution changing at runtime ( a resized window, ResolutionController.h ) the AO targets go back and forth
+ * between a few sizes, acquire() hands the one from last time back instead of allocating it again.
+ *
+ * T is whatever a target is ( gl::Fbo, gl::Texture, anything copyable that owns its storage ): releasing puts a copy
+ * in the pool, dropping it from the pool frees it. A mipmapped target ( the Hi-Z pyramid ) only comes back for the
+ * same level count. endFrame() drops what sat unused for maxAge frames and, oldest first, whatever is over maxBytes
+ * ( 0 = no limit ). No GL here.
+ */
+template<typename T>
+class TargetPool
+{
+public:
+	explicit TargetPool( int maxAge = 300, size_t maxBytes = 0 ) : mMaxAge( maxAge ), mMaxBytes( maxBytes ), mFrame( 0 ), mBytes( 0 ), mHits( 0 ), mMisses( 0 ) {}
+
+	//false if there is no target with exactly that desc ( and level count ), the caller creates one then
+	bool acquire( const TextureDesc &desc, T *target, int mipLevels = 1 )
+	{
+		//newest first, it is the likeliest to still be warm
+		for ( size_t i = mEntries.size(); i-- > 0; ) {
+			if ( mEntries[i].desc != desc || mEntries[i].mipLevels != mipLevels )
+				continue;
+			*target	= mEntries[i].target;
+			remove( i );
+			++mHits;
+			return true;
+		}
+		++mMisses;
+		return false;
+	}
+
+	void release( const TextureDesc &desc, const T &target, int mipLevels = 1 )
+	{
+		Entry entry;
+		entry.desc		= desc;
+		entry.target	= target;
+		entry.mipLevels	= mipLevels;
+		entry.frame		= mFrame;
+		entry.bytes		= measureTarget( "", desc, 1, mipLevels ).getTotalBytes();
+		mEntries.push_back( entry );
+		mBytes += entry.bytes;
+	}
+
+	//once per frame, ages the entries and drops the old ones
+	void endFrame()
+	{
+		++mFrame;
+		//entries are in release order, so the oldest are in front
+		while ( !mEntries.empty() && ( mFrame - mEntries.front().frame > mMaxAge || ( mMaxBytes && mBytes > mMaxBytes ) ) )
+			remove( 0 );
+	}
+
+	void clear()
+	{
+		mEntries.clear();
+		mBytes = 0;
+	}
+
+	void	setMaxAge( int frames )		{ mMaxAge = frames; }
+	void	setMaxBytes( size_t bytes )	{ mMaxBytes = bytes; }
+
+	int		size() const				{ return (int)mEntries.size(); }
+	//VRAM held by the pool ( TargetPlanner.h's accounting )
+	size_t	getBytes() const			{ return mBytes; }
+	int		getHits() const				{ return mHits; }
+	int		getMisses() const			{ return mMisses; }
+
+private:
+	struct Entry
+	{
+		TextureDesc	desc;
+		T			target;
+		int			mipLevels;
+		int			frame;	//released in
+		size_t		bytes;
+	};
+
+	void remove( size_t i )
+	{
+		mBytes -= mEntries[i].bytes;
+		mEntries.erase( mEntries.begin() + i );
+	}
+
+	std::vector<Entry>	mEntries;
+	int					mMaxAge;
+	size_t				mMaxBytes;
+	int					mFrame;
+	size_t				mBytes;
+	int					mHits, mMisses;
+};
+
+} // namespace ssao
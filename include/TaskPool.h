@@ -0,0 +1,62 @@
+#pragma once
+#include "cinder/Thread.h"
+#include <vector>
+
+namespace ssao {
+
+/*
+ * Fixed set of worker threads for the CPU passes. parallelFor() splits the indices [0, count) into one
+ * contiguous range per thread ( the calling thread included ), each thread walks its own range front to back
+ * and, once it runs dry, steals the back half of another thread's range. Neighbouring indices ( tiles ) stay
+ * on the same core and uneven tiles still balance out, returns once every index has run.
+ */
+class TaskPool
+{
+public:
+	class Job
+	{
+	public:
+		virtual ~Job() {}
+		//index is the work item, threadIndex in [0, getNumThreads()) can be used for per thread scratch memory
+		virtual void run( int index, int threadIndex ) = 0;
+	};
+
+	//numThreads counts the calling thread, 0 means one per hardware thread
+	explicit TaskPool( int numThreads = 0 );
+	~TaskPool();
+
+	int		getNumThreads() const { return (int)mWorkers.size() + 1; }
+	void	parallelFor( int count, Job *job );
+
+	static int getHardwareThreads();
+
+private:
+	TaskPool( const TaskPool& );
+	TaskPool& operator=( const TaskPool& );
+
+	//what is left of one thread's share of the indices
+	struct WorkRange
+	{
+		WorkRange() : begin( 0 ), end( 0 ) {}
+		std::mutex	mutex;
+		int			begin, end;
+	};
+
+	void	workerLoop( int threadIndex );
+	void	drain( int threadIndex );
+	bool	pop( int threadIndex, int *index );
+	bool	steal( int threadIndex );
+
+	std::vector<std::thread*>	mWorkers;
+	std::vector<WorkRange*>		mRanges;
+	std::mutex					mMutex;
+	std::condition_variable		mWorkReady;
+	std::condition_variable		mWorkDone;
+
+	Job							*mJob;
+	int							mBusy;
+	unsigned int				mGeneration;
+	bool						mQuit;
+};
+
+} // namespace ssao
@@ -0,0 +1,69 @@
+#pragma once
+#include "FloatImage.h"
+
+#include "cinder/Matrix.h"
+
+namespace ssao {
+
+struct TemporalParams
+{
+	TemporalParams()
+	: maxHistory( 16 ), depthTolerance( 0.02f )
+	{}
+
+	int		maxHistory;		//frames averaged at most, the blend weight never drops below 1 / maxHistory
+	float	depthTolerance;	//history is rejected when its depth is off by more than this fraction of the expected depth
+};
+
+/*
+ * CPU mirror of TemporalAO_frag.glsl. Every frame the fresh AO ( computed with SSAOParams::rotation =
+ * getFrameRotation( frame ) so each frame sees different samples ) is blended into a history buffer:
+ *  - every AO texel is reconstructed to view space from the linear depth in the normal/depth buffer,
+ *  - moved into last frame's view with the previous camera matrices and projected to find its old uv,
+ *  - the history there is kept if its stored depth agrees with where the point should be, otherwise
+ *    ( disocclusion, off screen ) the history restarts from the fresh value.
+ * History is 3 channels: ao, linear depth ( same units as normal/depth .a ), number of frames accumulated.
+ */
+class TemporalAO
+{
+public:
+	TemporalAO();
+
+	void					setParams( const TemporalParams &params )	{ mParams = params; }
+	const TemporalParams&	getParams() const							{ return mParams; }
+
+	//forget the history ( camera cut, resize, mode change )
+	void	reset();
+
+	/*
+	 * normalDepth: this frame's G-buffer, currentAO: this frame's 1 channel AO, view / projection: this frame's
+	 * camera. result ( 1 channel, currentAO size ) gets the accumulated AO
+	 */
+	void	accumulate( const FloatImage &normalDepth, const FloatImage &currentAO, const ci::Matrix44f &view, const ci::Matrix44f &projection, FloatImage *result );
+
+	/*
+	 * where the surface at ( u, v ) with linear depth lands in the previous frame. projection is the current one,
+	 * viewToPrevView = prevView * view.inverted(). false if the point is behind the previous camera
+	 */
+	static bool	reproject( float u, float v, float depth, const ci::Matrix44f &projection, const ci::Matrix44f &viewToPrevView, const ci::Matrix44f &prevProjection,
+						   float *prevU, float *prevV, float *prevDepth );
+
+	//kernel rotation for a frame, golden angle steps so consecutive frames never line up
+	static float	getFrameRotation( int frameIndex );
+
+	const FloatImage&	getHistory() const		{ return mHistory[mCurrent]; }
+	int					getFrameIndex() const	{ return mFrameIndex; }
+	//texels that restarted their history in the last accumulate()
+	int					getNumRejected() const	{ return mRejected; }
+
+private:
+	TemporalParams	mParams;
+	FloatImage		mHistory[2];
+	int				mCurrent;
+	bool			mValid;
+	ci::Matrix44f	mPrevView, mPrevProjection;
+	int				mFrameIndex;
+	int				mRejected;
+};
+
+} // namespace ssao
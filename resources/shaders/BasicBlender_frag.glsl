@@ -1,15 +1,20 @@
 #version 120
 
-uniform sampler2D ssoaTex;
+uniform sampler2D ssaoTex;
 uniform sampler2D baseTex;
 
 void main()
 {
-	vec4 ssaoTex	= texture2D( ssoaTex, gl_TexCoord[0].st );
+#ifdef SHOW_NORMALS
+	//debug view of the normal/depth target ( bound as ssaoTex ): the packed texel decoded, normal mapped to 0..1
+	gl_FragColor = vec4( unpackNormalDepth( texture2D( ssaoTex, gl_TexCoord[0].st ) ).rgb*0.5 + 0.5, 1.0 );
+#else
+	vec4 ssaoTex	= texture2D( ssaoTex, gl_TexCoord[0].st );
 	vec4 baseTex	= texture2D( baseTex, gl_TexCoord[0].st );
 	float redVal	= 1.0 - ssaoTex.r;
 	
 	vec4 resultTex	= vec4( baseTex.r - redVal, baseTex.g - redVal, baseTex.b - redVal, baseTex.a - redVal );
 	
 	gl_FragColor = resultTex;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#version 120
+
+//BasicBlender_frag.glsl with a joint bilateral upsample of the low res AO ( CPU version in BilateralUpsampler.h )
+//the 2x2 AO texels around the pixel are weighted by how well the G-buffer at their centers matches this pixel's
+
+uniform sampler2D ssaoTex;
+uniform sampler2D baseTex;
+uniform sampler2D normalMap;	//full res normal/depth
+
+uniform vec2 aoSize;			//AO target size in texels
+uniform float depthSigma;
+uniform float normalPower;
+
+void main()
+{
+	vec2 st			= gl_TexCoord[0].st;
+	vec4 baseTex	= texture2D( baseTex, st );
+	vec4 nd			= unpackNormalDepth( texture2D( normalMap, st ) );
+
+	vec2 f		= st*aoSize - vec2(0.5);
+	vec2 base	= floor(f);
+	vec2 t		= f - base;
+	float invSigma = 1.0/( depthSigma*max(nd.a, 0.0001) );
+
+	float sum = 0.0;
+	float weightSum = 0.0;
+	float nearest = 0.0;
+	float nearestDiff = 1e30;
+
+	for ( int j = 0; j < 2; ++j )
+	{
+		for ( int i = 0; i < 2; ++i )
+		{
+			vec2 texel		= ( clamp(base + vec2(i, j), vec2(0.0), aoSize - vec2(1.0)) + vec2(0.5) )/aoSize;
+			float value		= texture2D( ssaoTex, texel ).r;
+			vec4 g			= unpackNormalDepth( texture2D( normalMap, texel ) );
+			float depthDiff	= abs(g.a - nd.a);
+			float k			= depthDiff*invSigma;
+			vec2 bw			= mix( vec2(1.0) - t, t, vec2(i, j) );
+
+			float weight	= bw.x*bw.y*pow(max(dot(g.xyz, nd.xyz), 0.0), normalPower)/( 1.0 + k*k );
+			sum			+= value*weight;
+			weightSum	+= weight;
+
+			if ( depthDiff < nearestDiff )
+			{
+				nearestDiff = depthDiff;
+				nearest = value;
+			}
+		}
+	}
+
+	float ao		= weightSum > 0.0001 ? sum/weightSum : nearest;
+	float redVal	= 1.0 - ao;
+
+	gl_FragColor = vec4( baseTex.r - redVal, baseTex.g - redVal, baseTex.b - redVal, baseTex.a - redVal );
+}
@@ -0,0 +1,48 @@
+#version 120
+
+//pingPongBlurV() and BasicBlender_frag.glsl in one pass ( CPU version is PostChain::runFusedComposite() ): the vertical blur of
+//mPingPongBlurH is evaluated at this pixel instead of being written to mPingPongBlurV and read back. Bilinear lookups commute
+//with the blur as long as every tap is a whole texel away, so ssao::buildBlurDefines( params, false ) ( no merged taps ) gives
+//the same AO the two pass version upsamples
+
+uniform sampler2D RTBlurH;
+uniform sampler2D baseTex;
+uniform vec2 texelSize;		//1 / RTBlurH's size ( the AO target, not the window )
+#ifdef BLUR_DEPTH_AWARE
+uniform sampler2D normalMap;
+uniform float depthSigma;
+#endif
+
+#ifndef BLUR_TAPS
+#define BLUR_TAPS BLUR_CENTER(0.17158222) BLUR_PAIR(1.0, 0.15839034) BLUR_PAIR(2.0, 0.12459426) BLUR_PAIR(3.0, 0.083518028) BLUR_PAIR(4.0, 0.047706258)
+#endif
+
+void main()
+{
+	vec2 uv		= gl_TexCoord[0].st;
+	vec2 dir	= vec2(0.0, 1.0)*texelSize;
+	vec4 sum	= vec4(0.0);
+
+#ifdef BLUR_DEPTH_AWARE
+	float center = unpackNormalDepth( texture2D( normalMap, uv ) ).a;
+	float invSigma = 1.0/( depthSigma*max(center, 0.0001) );
+	float weightSum = 0.0;
+	vec2 tapUV;
+	float k, weight;
+
+#define BLUR_CENTER(w) sum += texture2D(RTBlurH, uv)*w; weightSum += w;
+#define BLUR_SIDE(o, w) tapUV = uv + (o)*dir; k = ( unpackNormalDepth( texture2D( normalMap, tapUV ) ).a - center )*invSigma; weight = w*exp(-k*k); sum += texture2D(RTBlurH, tapUV)*weight; weightSum += weight;
+#define BLUR_PAIR(o, w) BLUR_SIDE(o, w) BLUR_SIDE(-o, w)
+	BLUR_TAPS
+	sum /= weightSum;
+#else
+#define BLUR_CENTER(w) sum += texture2D(RTBlurH, uv)*w;
+#define BLUR_PAIR(o, w) sum += ( texture2D(RTBlurH, uv + o*dir) + texture2D(RTBlurH, uv - o*dir) )*w;
+	BLUR_TAPS
+#endif
+
+	vec4 baseTex	= texture2D( baseTex, uv );
+	float redVal	= 1.0 - sum.r;
+	
+	gl_FragColor = vec4( baseTex.r - redVal, baseTex.g - redVal, baseTex.b - redVal, baseTex.a - redVal );
+}
\ No newline at end of file
@@ -1,23 +1,44 @@
-uniform sampler2D RTBlurH; // this should hold the texture rendered by the horizontal blur pass
-varying vec2 vTexCoord;
- 
-const float blurSize = 0.5/512.0;
- 
+#version 120
+
+//vertical half of the separable gaussian, ssao::buildBlurDefines() pastes in BLUR_TAPS ( CPU version in SeparableBlur.h )
+//BLUR_CENTER( weight ) is the texel itself, BLUR_PAIR( offset, weight ) one fetch on each side. Without BLUR_DEPTH_AWARE
+//neighbouring taps are merged into one bilinear fetch between them, so the 9 taps of radius 4 are 5 fetches
+
+uniform sampler2D RTBlurH; //this should hold the texture rendered by the horizontal blur pass
+uniform vec2 texelSize;		//1 / RTBlurH's size
+#ifdef BLUR_DEPTH_AWARE
+uniform sampler2D normalMap;	//normal/depth, any size
+uniform float depthSigma;
+#endif
+
+varying vec2 uv;
+
+#ifndef BLUR_TAPS
+#define BLUR_TAPS BLUR_CENTER(0.17158222) BLUR_PAIR(1.4402864, 0.28298461) BLUR_PAIR(3.3635476, 0.13122429)
+#endif
+
 void main(void)
 {
-   vec4 sum = vec4(0.0);
- 
-   // blur in y (vertical)
-   // take nine samples, with the distance blurSize between them
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y - 4.0*blurSize)) * 0.05;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y - 3.0*blurSize)) * 0.09;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y - 2.0*blurSize)) * 0.12;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y - blurSize)) * 0.15;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y)) * 0.16;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y + blurSize)) * 0.15;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y + 2.0*blurSize)) * 0.12;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y + 3.0*blurSize)) * 0.09;
-   sum += texture2D(RTBlurH, vec2(vTexCoord.x, vTexCoord.y + 4.0*blurSize)) * 0.05;
- 
-   gl_FragColor = sum;
+	vec2 dir = vec2(0.0, 1.0)*texelSize;
+	vec4 sum = vec4(0.0);
+
+#ifdef BLUR_DEPTH_AWARE
+	//one fetch per texel ( a merged fetch would mix depths across the edge ), each weighted down by its depth difference
+	float center = unpackNormalDepth( texture2D( normalMap, uv ) ).a;
+	float invSigma = 1.0/( depthSigma*max(center, 0.0001) );
+	float weightSum = 0.0;
+	vec2 tapUV;
+	float k, weight;
+
+#define BLUR_CENTER(w) sum += texture2D(RTBlurH, uv)*w; weightSum += w;
+#define BLUR_SIDE(o, w) tapUV = uv + (o)*dir; k = ( unpackNormalDepth( texture2D( normalMap, tapUV ) ).a - center )*invSigma; weight = w*exp(-k*k); sum += texture2D(RTBlurH, tapUV)*weight; weightSum += weight;
+#define BLUR_PAIR(o, w) BLUR_SIDE(o, w) BLUR_SIDE(-o, w)
+	BLUR_TAPS
+	gl_FragColor = sum/weightSum;
+#else
+#define BLUR_CENTER(w) sum += texture2D(RTBlurH, uv)*w;
+#define BLUR_PAIR(o, w) sum += ( texture2D(RTBlurH, uv + o*dir) + texture2D(RTBlurH, uv - o*dir) )*w;
+	BLUR_TAPS
+	gl_FragColor = sum;
+#endif
 }
\ No newline at end of file
@@ -1,15 +1,10 @@
-varying vec2 vTexCoord;
- 
-// remember that you should draw a screen aligned quad
+#version 120
+
+//screen aligned quad covering the target whatever rect is drawn, like SSAO_vert.glsl
+varying vec2 uv;
+
 void main(void)
 {
-   gl_Position = ftransform();;
-  
-   // Clean up inaccuracies
-   vec2 Pos;
-   Pos = sign(gl_Vertex.xy);
- 
-   gl_Position = vec4(Pos, 0.0, 1.0) - 0.5;
-   // Image-space
-   vTexCoord = Pos; //* 0.5 + 0.5;
+	gl_Position = sign( ftransform() );
+	uv = ( gl_Position.xy + vec2( 1.0 ) ) * 0.5;
 }
\ No newline at end of file
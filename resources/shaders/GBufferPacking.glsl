@@ -0,0 +1,44 @@
+//normal/depth packing, initShaders() pastes this in after the #version line ( and any variant defines ) of every shader, CPU version in GBufferPacking.h
+//mNormalDepthMap is RGBA8: rg = octahedral view normal, ba = depth between the camera's clip planes in 16 bits ( high byte, low byte )
+//unpackNormalDepth() hands back the old RGBA16F layout: rgb = normal, a = linear view depth -viewPos.z / DEPTH_UNIT ( the unit the AO constants were tuned in )
+
+uniform vec2 clipPlanes;	//near, far of the camera that wrote the G-buffer
+
+const float DEPTH_UNIT = 10.0;
+
+//-viewPos.z ( distance along the view axis, not to the eye ) -> 0..1 between the clip planes, what packNormalDepth() stores
+float normalizeViewDepth(float viewDepth)
+{
+	return clamp((viewDepth - clipPlanes.x)/(clipPlanes.y - clipPlanes.x), 0.0, 1.0);
+}
+
+vec2 encodeOctahedral(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 e = n.xy;
+	if ( n.z < 0.0 )
+		e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return e;
+}
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if ( n.z < 0.0 )
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+vec4 packNormalDepth(vec3 normal, float linearDepth)
+{
+	float d = floor(linearDepth*65535.0 + 0.5);
+	float high = floor(d/256.0);
+	return vec4(encodeOctahedral(normal)*0.5 + 0.5, high/255.0, (d - high*256.0)/255.0);
+}
+
+//depth is linear in the two bytes, so bilinear filtering and the MSAA resolve still give the right average ( give or take rounding of the high byte on silhouettes )
+vec4 unpackNormalDepth(vec4 packed)
+{
+	float linearDepth = dot(packed.ba, vec2(255.0*256.0, 255.0))/65535.0;
+	return vec4(decodeOctahedral(packed.rg*2.0 - 1.0), mix(clipPlanes.x, clipPlanes.y, linearDepth)/DEPTH_UNIT);
+}
@@ -0,0 +1,35 @@
+#version 120
+
+//writes the lit scene ( what renderSceneToFBO() gets from fixed function light 0 ) and the normal/depth target in one go
+
+uniform bool lightingOn;
+
+varying vec3 Normal;
+varying vec3 viewPos;
+varying float depth;	//0 at the near plane, 1 at the far plane
+
+void main( void )
+{
+	vec3 n = normalize(Normal);
+	vec4 color = gl_Color;
+	
+	if ( lightingOn )
+	{
+		//directional light 0, Blinn-Phong ( per pixel version of the fixed function model )
+		vec3 l = normalize(gl_LightSource[0].position.xyz);
+		vec3 v = normalize(-viewPos);
+		vec3 h = normalize(l + v);
+		float nDotL = max(dot(n, l), 0.0);
+		float spec = ( nDotL > 0.0 ) ? pow(max(dot(n, h), 0.0), gl_FrontMaterial.shininess) : 0.0;
+		
+		color = gl_FrontMaterial.emission
+			+ gl_LightModel.ambient * gl_FrontMaterial.ambient
+			+ gl_LightSource[0].ambient * gl_FrontMaterial.ambient
+			+ gl_LightSource[0].diffuse * gl_FrontMaterial.diffuse * nDotL
+			+ gl_LightSource[0].specular * gl_FrontMaterial.specular * spec;
+		color.a = gl_FrontMaterial.diffuse.a;
+	}
+	
+	gl_FragData[0] = color;
+	gl_FragData[1] = packNormalDepth(n, depth);
+}
@@ -0,0 +1,33 @@
+#version 120
+
+//single geometry pass G-buffer: everything NormalDepthTexCreate_vert.glsl outputs plus what the lighting needs
+
+varying vec3 Normal;
+varying vec3 viewPos;
+varying float depth; //in eye space
+
+#ifdef INSTANCED
+//model matrix rows per instance ( GlSceneRenderer ), the modelview matrix is then just the camera's view
+attribute vec4 instanceRow0;
+attribute vec4 instanceRow1;
+attribute vec4 instanceRow2;
+#endif
+
+void main( void )
+{
+#ifdef INSTANCED
+	vec4 worldPos = vec4( dot( instanceRow0, gl_Vertex ), dot( instanceRow1, gl_Vertex ), dot( instanceRow2, gl_Vertex ), 1.0 );
+	vec3 worldNormal = vec3( dot( instanceRow0.xyz, gl_Normal ), dot( instanceRow1.xyz, gl_Normal ), dot( instanceRow2.xyz, gl_Normal ) );
+	vec4 eyePos = gl_ModelViewMatrix * worldPos;
+	gl_Position = gl_ProjectionMatrix * eyePos;
+#else
+	vec4 eyePos = gl_ModelViewMatrix * gl_Vertex;
+	vec3 worldNormal = gl_Normal;
+	gl_Position = ftransform();
+#endif
+	viewPos = eyePos.xyz;
+	depth = normalizeViewDepth(-eyePos.z);
+
+	Normal      = normalize(( gl_ModelViewMatrix * vec4( worldNormal, 0.0 ) ).xyz);
+	gl_FrontColor = gl_Color;
+}
@@ -0,0 +1,46 @@
+#version 120
+
+//one level of the Hi-Z pyramid, see HiZPyramid.h for the CPU version
+//layout: r = min depth, g = max depth, ba = average view normal ( octahedral encoded )
+//level 0 unpacks the normal/depth buffer ( depth back in the DEPTH_UNIT scale ), every other level reduces the level below it ( the only level the sampler can see )
+//encodeOctahedral() / decodeOctahedral() come from GBufferPacking.glsl
+
+uniform sampler2D source;
+uniform vec2 sourceSize;	//texels of the level being read
+uniform bool fromNormalDepth;
+
+void main(void)
+{
+	if ( fromNormalDepth )
+	{
+		vec4 nd = unpackNormalDepth(texture2D(source, gl_FragCoord.xy/sourceSize));
+		gl_FragColor = vec4(nd.a, nd.a, encodeOctahedral(nd.xyz));
+		return;
+	}
+
+	//2x2 texels below, 3 wide / tall on the last column / row of an odd sized level so nothing is skipped
+	vec2 base = floor(gl_FragCoord.xy)*2.0;
+	vec2 count = vec2(abs(base.x + 2.0 - (sourceSize.x - 1.0)) < 0.5 ? 3.0 : 2.0,
+					  abs(base.y + 2.0 - (sourceSize.y - 1.0)) < 0.5 ? 3.0 : 2.0);
+
+	vec4 first = texture2D(source, (base + 0.5)/sourceSize);
+	float minDepth = first.r;
+	float maxDepth = first.g;
+	vec3 normal = vec3(0.0);
+
+	for ( float y = 0.0; y < 3.0; y += 1.0 )
+	{
+		for ( float x = 0.0; x < 3.0; x += 1.0 )
+		{
+			if ( x < count.x && y < count.y )
+			{
+				vec4 texel = texture2D(source, (base + vec2(x, y) + 0.5)/sourceSize);
+				minDepth = min(minDepth, texel.r);
+				maxDepth = max(maxDepth, texel.g);
+				normal += decodeOctahedral(texel.ba);
+			}
+		}
+	}
+
+	gl_FragColor = vec4(minDepth, maxDepth, encodeOctahedral(normal));
+}
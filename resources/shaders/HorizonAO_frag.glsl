@@ -0,0 +1,105 @@
+#version 120
+
+//horizon based AO ( GTAO style ), the alternative to SSAOL_frag.glsl. CPU version in SSAOEngine::computeSpanHorizon()
+//every pixel walks DIRECTIONS screen space slices through itself, STEPS taps each way, and keeps the highest horizon
+//on either side. The visible arc between the two horizons, cosine weighted around the normal projected into the slice,
+//has a closed form, so there is no depth threshold to leak through and few taps already give the right shape.
+//unpackNormalDepth() comes from GBufferPacking.glsl ( depth = -viewPos.z / DEPTH_UNIT, positions are in that unit too )
+
+uniform sampler2D rnm;		//blue noise rotation tile: picks the first slice, the same tile half a tile over how far along the taps go
+uniform sampler2D normalMap;
+uniform float frameRotation;	//radians, 0 unless temporal AO is on
+uniform float radiusScale;
+uniform vec2 projection;	//( 0, 0 ) and ( 1, 1 ) of the projection matrix, to rebuild view positions
+
+varying vec2 uv;
+
+//quality tier variants ( ShaderVariants.h ) define these ahead of this file, below are the standalone defaults
+#ifndef HORIZON_VARIANT
+#define DIRECTIONS 2
+#define STEPS 3
+#define HORIZON_RADIUS 0.05
+#endif
+
+const float PI = 3.14159265;
+const float noiseSize = 64.0; //BLUE_NOISE_SIZE
+
+vec3 viewPosition(vec2 coord, float depth)
+{
+	return vec3(depth*(coord*2.0 - 1.0)/projection, -depth);
+}
+
+float noiseAngle(vec2 fragCoord)
+{
+	vec3 n = normalize(texture2D(rnm, fragCoord/noiseSize).xyz*2.0 - vec3(1.0));
+	return atan(n.y, n.x) + frameRotation;
+}
+
+void main(void)
+{
+	vec4 current = unpackNormalDepth(texture2D(normalMap, uv));
+	vec3 pos = viewPosition(uv, current.a);
+	vec3 view = normalize(-pos);
+	vec3 normal = normalize(current.xyz);
+
+	float radius = HORIZON_RADIUS*radiusScale;
+	vec2 screenRadius = radius*projection*0.5/max(current.a, 1e-4);
+
+	float phi = noiseAngle(gl_FragCoord.xy);
+	float jitter = fract(noiseAngle(gl_FragCoord.xy + vec2(noiseSize*0.5))/(2.0*PI));
+
+	float visibility = 0.0;
+	for (int d = 0; d < DIRECTIONS; ++d)
+	{
+		float angle = phi + float(d)*PI/float(DIRECTIONS);
+		vec2 dir = vec2(cos(angle), sin(angle));
+
+		//the slice plane holds the view vector and the screen direction, the normal is projected into it
+		vec3 direction = vec3(dir, 0.0);
+		vec3 ortho = direction - dot(direction, view)*view;
+		vec3 axis = normalize(cross(ortho, view));
+		vec3 projected = normal - axis*dot(normal, axis);
+		float projectedLength = length(projected);
+		float cosN = clamp(dot(projected, view)/projectedLength, -1.0, 1.0);
+		float n = (dot(ortho, projected) < 0.0 ? -1.0 : 1.0)*acos(cosN);
+
+		//start at the tangent plane each way, taps can only raise the horizon
+		vec2 lowCos = vec2(cos(n + 0.5*PI), cos(n - 0.5*PI));
+		vec2 horizonCos = lowCos;
+		for (int i = 0; i < STEPS; ++i)
+		{
+			float t = (float(i) + jitter)/float(STEPS);
+			t *= t;
+			vec2 offset = dir*screenRadius*t;
+
+			vec2 tapUV = uv + offset;
+			vec3 delta = viewPosition(tapUV, unpackNormalDepth(texture2D(normalMap, tapUV)).a) - pos;
+			float dist = length(delta);
+			//occluders fade out over the last 60% of the radius
+			float weight = clamp((radius - dist)/(0.6*radius), 0.0, 1.0);
+			if (dist > 0.0)
+				horizonCos.x = max(horizonCos.x, mix(lowCos.x, dot(delta, view)/dist, weight));
+
+			tapUV = uv - offset;
+			delta = viewPosition(tapUV, unpackNormalDepth(texture2D(normalMap, tapUV)).a) - pos;
+			dist = length(delta);
+			weight = clamp((radius - dist)/(0.6*radius), 0.0, 1.0);
+			if (dist > 0.0)
+				horizonCos.y = max(horizonCos.y, mix(lowCos.y, dot(delta, view)/dist, weight));
+		}
+
+		//horizon angles from the view vector, clamped to the hemisphere around the projected normal
+		float h1 = acos(clamp(horizonCos.x, -1.0, 1.0));
+		float h0 = -acos(clamp(horizonCos.y, -1.0, 1.0));
+		h0 = n + max(h0 - n, -0.5*PI);
+		h1 = n + min(h1 - n, 0.5*PI);
+
+		float sinN = sin(n);
+		float arc0 = (cosN + 2.0*h0*sinN - cos(2.0*h0 - n))*0.25;
+		float arc1 = (cosN + 2.0*h1*sinN - cos(2.0*h1 - n))*0.25;
+		visibility += projectedLength*(arc0 + arc1);
+	}
+
+	//no clamp at 1: one slice can go over ( only the average over all directions is normalized ), mSSAOMap is float and blur / history average it back
+	gl_FragColor.r = max(visibility/float(DIRECTIONS), 0.0);
+}
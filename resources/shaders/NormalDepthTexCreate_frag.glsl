@@ -5,5 +5,5 @@ varying float depth;
 
 void main( void )
 {
-   gl_FragColor = vec4(normalize(Normal),depth);
+   gl_FragColor = packNormalDepth(normalize(Normal),depth);
 }
\ No newline at end of file
@@ -1,13 +1,28 @@
 #version 120
 
 varying vec3 Normal;
-varying float depth; //in eye space
+varying float depth; //0 at the near plane, 1 at the far plane ( GBufferPacking.glsl )
+
+#ifdef INSTANCED
+//model matrix rows per instance, same as GBuffer_vert.glsl
+attribute vec4 instanceRow0;
+attribute vec4 instanceRow1;
+attribute vec4 instanceRow2;
+#endif
 
 void main( void )
 {
+#ifdef INSTANCED
+	vec4 worldPos = vec4( dot( instanceRow0, gl_Vertex ), dot( instanceRow1, gl_Vertex ), dot( instanceRow2, gl_Vertex ), 1.0 );
+	vec3 worldNormal = vec3( dot( instanceRow0.xyz, gl_Normal ), dot( instanceRow1.xyz, gl_Normal ), dot( instanceRow2.xyz, gl_Normal ) );
+	vec4 viewPos = gl_ModelViewMatrix * worldPos;
+	gl_Position = gl_ProjectionMatrix * viewPos;
+#else
 	vec4 viewPos = gl_ModelViewMatrix * gl_Vertex;
-	depth = -viewPos.z/10.0;
-
+	vec3 worldNormal = gl_Normal;
 	gl_Position = ftransform();
-	Normal      = normalize(( gl_ModelViewMatrix * vec4( gl_Normal.xyz, 0.0 ) ).xyz);
+#endif
+	depth = normalizeViewDepth(-viewPos.z);
+
+	Normal      = normalize(( gl_ModelViewMatrix * vec4( worldNormal, 0.0 ) ).xyz);
 }
\ No newline at end of file
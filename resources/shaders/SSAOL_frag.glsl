@@ -1,28 +1,53 @@
 #version 120
 //original SSAO shader graciously written at: http://www.gamerendering.com/2009/01/14/ssao/
 
-uniform sampler2D rnm;
+uniform sampler2D rnm;      //blue noise rotation tile ( BlueNoise.h ), GL_REPEAT / GL_NEAREST, one texel per AO pixel
 uniform sampler2D normalMap;
+uniform float frameRotation; //radians, 0 unless temporal AO is on ( then it changes every frame so the history sees new samples )
+uniform float radiusScale; //multiplies rad, the Hi-Z variants keep wide radii about as cheap as the default one
+
+#ifdef SSAO_HIZ
+uniform sampler2D hiZ;      //r = min depth, g = max depth, ba = octahedral normal ( HiZReduce_frag.glsl )
+uniform vec2 hiZSize;       //level 0 texels
+uniform float hiZLodOffset; //a tap d texels out reads level floor( log2( d ) ) - hiZLodOffset
+uniform float hiZMaxLevel;
+#endif
 
 varying vec2 uv;
 
 //may have to change these as they are generally scene-dependent ( to get the look you want )
-const float totStrength = 0.38;
-const float strength = 0.3;
-const float offset = 0.002;
-const float falloff = 0.0;
-const float rad = 0.03;
-
+//quality tier variants ( ShaderVariants.h ) define all of these ahead of this file, below are the standalone defaults
+#ifndef SSAO_VARIANT
 #define SAMPLES 10 // 10 is good
-const float invSamples = -0.5/10.0;
+#define SSAO_TOT_STRENGTH 0.38
+#define SSAO_STRENGTH 0.3
+#define SSAO_OFFSET 0.002
+#define SSAO_FALLOFF 0.0
+#define SSAO_RAD 0.03
+// these are the random vectors inside a unit sphere ( must be defined this way as Apple doesn't support anything beyond GLSL 120 :( FFFFFFUUUUUUUUUUUUUU
+#define SSAO_KERNEL pSphere[0] = vec3(0.13790712, 0.24864247, 0.44301823); pSphere[1] = vec3(0.33715037, 0.56794053, -0.005789503); pSphere[2] = vec3(0.06896307, -0.15983082, -0.85477847); pSphere[3] = vec3(-0.014653638, 0.14027752, 0.0762037); pSphere[4] = vec3(0.010019933, -0.1924225, -0.034443386); pSphere[5] = vec3(-0.35775623, -0.5301969, -0.43581226); pSphere[6] = vec3(-0.3169221, 0.106360726, 0.015860917); pSphere[7] = vec3(0.010350345, -0.58698344, 0.0046293875); pSphere[8] = vec3(-0.053382345, 0.059675813, -0.5411899); pSphere[9] = vec3(0.035267662, -0.063188605, 0.54602677);
+#endif
+
+const float totStrength = SSAO_TOT_STRENGTH;
+const float strength = SSAO_STRENGTH;
+const float offset = SSAO_OFFSET;
+const float falloff = SSAO_FALLOFF;
+const float rad = SSAO_RAD;
+
+const float invSamples = -0.5/float(SAMPLES);
+const float noiseSize = 64.0; //BLUE_NOISE_SIZE
+
+//one iteration of the sample loop below, variants paste it SAMPLES times ( SSAO_TAPS ) so there is no loop at all
+//normalMap is packed ( GBufferPacking.glsl ), unpackNormalDepth() gives the normal in rgb and the depth in a like before
+#ifdef SSAO_HIZ
+//same tap through the pyramid ( the Hi-Z variants also enable GL_ARB_shader_texture_lod for texture2DLod, see ShaderVariants.cpp ), counted by how much of the texel's depth range is in front of us ( all of it when the texel is flat )
+#define SSAO_TAP(i) ray = radius*reflect(pSphere[i],fres); tapOffset = sign(dot(ray,norm))*ray.xy; lod = clamp(floor(log2(max(length(tapOffset*hiZSize),1.0))) - hiZLodOffset, 0.0, hiZMaxLevel); occluderFragment = texture2DLod(hiZ, ep.xy + tapOffset, lod); depthDifference = currentPixelDepth-occluderFragment.r; coverage = occluderFragment.g > occluderFragment.r ? min(depthDifference/(occluderFragment.g-occluderFragment.r), 1.0) : 1.0; bl += step(falloff,depthDifference)*coverage*(1.0-dot(decodeOctahedral(occluderFragment.ba),norm))*(1.0-smoothstep(falloff,strength,depthDifference));
+#else
+#define SSAO_TAP(i) ray = radius*reflect(pSphere[i],fres); occluderFragment = unpackNormalDepth(texture2D(normalMap, ep.xy + sign(dot(ray,norm))*ray.xy)); depthDifference = currentPixelDepth-occluderFragment.a; bl += step(falloff,depthDifference)*(1.0-dot(occluderFragment.xyz,norm))*(1.0-smoothstep(falloff,strength,depthDifference));
+#endif
 
 // NOTE: THIS ONE IS BRUTALLY OPTIMIZED!! SO IT*S REALLY HARD TO FOLLOW
 
-float rand(vec2 co)
-{
-    return fract(sin(dot(co.xy ,vec2(12.9898,78.233))) * 43758.5453);
-}
-
 int randInt(int start, int end)
 {
     return int(fract(sin(dot(vec2(start, end),vec2(12.9898,78.233))) * 43758.5453));
@@ -33,23 +58,17 @@ void main(void)
     // these are the random vectors inside a unit sphere
     //vec3 pSphere[10] = vec3[](vec3(-0.010735935, 0.01647018, 0.0062425877),vec3(-0.06533369, 0.3647007, -0.13746321),vec3(-0.6539235, -0.016726388, -0.53000957),vec3(0.40958285, 0.0052428036, -0.5591124),vec3(-0.1465366, 0.09899267, 0.15571679),vec3(-0.44122112, -0.5458797, 0.04912532),vec3(0.03755566, -0.10961345, -0.33040273),vec3(0.019100213, 0.29652783, 0.066237666),vec3(0.8765323, 0.011236004, 0.28265962),vec3(0.29264435, -0.40794238, 0.15964167));
 
-    // these are the random vectors inside a unit sphere ( must be defined this way as Apple doesn't support anything beyond GLSL 120 :( FFFFFFUUUUUUUUUUUUUU
-    vec3 pSphere[10];
-    pSphere[0] = vec3(0.13790712, 0.24864247, 0.44301823);
-    pSphere[1] = vec3(0.33715037, 0.56794053, -0.005789503);
-    pSphere[2] = vec3(0.06896307, -0.15983082, -0.85477847);
-    pSphere[3] = vec3(-0.014653638, 0.14027752, 0.0762037);
-    pSphere[4] = vec3(0.010019933, -0.1924225, -0.034443386);
-    pSphere[5] = vec3(-0.35775623, -0.5301969, -0.43581226);
-    pSphere[6] = vec3(-0.3169221, 0.106360726, 0.015860917);
-    pSphere[7] = vec3(0.010350345, -0.58698344, 0.0046293875);
-    pSphere[8] = vec3(-0.053382345, 0.059675813, -0.5411899);
-    pSphere[9] = vec3(0.035267662, -0.063188605, 0.54602677);
+    // these are the random vectors inside a unit sphere ( SSAO_KERNEL, see the top )
+    vec3 pSphere[SAMPLES];
+    SSAO_KERNEL
 
-    //grab a normal for reflecting the sample rays later on
-    vec3 fres = normalize((texture2D(rnm,rand(uv) * offset * uv).xyz*2.0) - vec3(1.0));
+    //grab a normal for reflecting the sample rays later on ( neighbouring pixels get very different ones, the blur averages them out )
+    vec3 fres = normalize((texture2D(rnm,gl_FragCoord.xy/noiseSize).xyz*2.0) - vec3(1.0));
+    float cr = cos(frameRotation);
+    float sr = sin(frameRotation);
+    fres.xy = vec2(cr*fres.x - sr*fres.y, sr*fres.x + cr*fres.y);
 
-    vec4 currentPixelSample = texture2D(normalMap, uv);
+    vec4 currentPixelSample = unpackNormalDepth(texture2D(normalMap, uv));
 
     float currentPixelDepth = currentPixelSample.a;
 
@@ -68,18 +87,31 @@ void main(void)
     float occluderDepth, depthDifference;
     vec4 occluderFragment;
     vec3 ray;
-
+    float radius = rad*radiusScale;
+#ifdef SSAO_HIZ
+    vec2 tapOffset;
+    float lod, coverage;
+#endif
+
+#ifdef SSAO_TAPS
+    SSAO_TAPS
+#elif defined(SSAO_HIZ)
+    for(int i=0; i<SAMPLES;++i)
+    {
+    SSAO_TAP(i)
+    }
+#else
     for(int i=0; i<SAMPLES;++i)
     {
     // get a vector (randomized inside of a sphere with radius 1.0) from a texture and reflect it
-    ray = rad*reflect(pSphere[i],fres);
+    ray = radius*reflect(pSphere[i],fres);
 
     // if the ray is outside the hemisphere then change direction
     //se = ep + sign(dot(ray,norm) )*rad*reflect(pSphere[i],fres).xy;
 
     // get the depth of the occluder fragment
     vec2 something = ep.xy + sign(dot(ray,norm) )*ray.xy;
-    occluderFragment = texture2D(normalMap, something );
+    occluderFragment = unpackNormalDepth(texture2D(normalMap, something ));
 
     // get the normal of the occluder fragment
     //occNorm = occluderFragment.xyz;
@@ -94,6 +126,7 @@ void main(void)
     // the falloff equation, starts at falloff and is kind of 1/x^2 falling 
     bl += step(falloff,depthDifference)*(1.0-dot(occluderFragment.xyz,norm))*(1.0-smoothstep(falloff,strength,depthDifference));
     }
+#endif
 
     // output the result
     gl_FragColor.r = 1.0+bl*invSamples;
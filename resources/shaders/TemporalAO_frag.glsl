@@ -0,0 +1,51 @@
+#version 120
+
+//blends this frame's SSAO into last frame's ( reprojected ) history, see TemporalAO.h for the CPU version
+//history layout: r = ao, g = linear depth ( same units as the normal/depth .a ), b = frames accumulated
+
+uniform sampler2D currentAO;
+uniform sampler2D history;
+uniform sampler2D normalMap;
+
+uniform mat4 viewToPrevView;	//prevView * inverse( view )
+uniform mat4 prevProjection;
+uniform vec4 projParams;		//current projection: [0][0], [1][1], [2][0], [2][1] ( column major )
+uniform bool historyValid;
+uniform float maxHistory;
+uniform float depthTolerance;
+
+varying vec2 uv;
+
+void main(void)
+{
+	float current	= texture2D(currentAO, uv).r;
+	float depth		= unpackNormalDepth(texture2D(normalMap, uv)).a;
+
+	float ao	= current;
+	float count	= 1.0;
+
+	if ( historyValid )
+	{
+		//back to view space ( depth is -viewPos.z/DEPTH_UNIT ), then into the previous frame
+		float z = -depth*DEPTH_UNIT;
+		vec2 ndc = uv*2.0 - vec2(1.0);
+		vec3 viewPos = vec3( -z*(ndc + projParams.zw)/projParams.xy, z );
+
+		vec4 prevPos = viewToPrevView * vec4(viewPos, 1.0);
+		vec4 clip = prevProjection * prevPos;
+		vec2 prevUV = (clip.xy/clip.w)*0.5 + vec2(0.5);
+		float expectedDepth = -prevPos.z/DEPTH_UNIT;
+
+		if ( clip.w > 0.0 && all(greaterThanEqual(prevUV, vec2(0.0))) && all(lessThanEqual(prevUV, vec2(1.0))) )
+		{
+			vec3 prev = texture2D(history, prevUV).rgb;
+			if ( abs(prev.g - expectedDepth) <= depthTolerance*expectedDepth )
+			{
+				count = min(prev.b + 1.0, maxHistory);
+				ao = prev.r + (current - prev.r)/count;
+			}
+		}
+	}
+
+	gl_FragColor = vec4(ao, depth, count, 1.0);
+}
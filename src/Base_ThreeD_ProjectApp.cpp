@@ -5,13 +5,38 @@
 #include "cinder/gl/GlslProg.h"
 #include "cinder/gl/Texture.h"
 #include "cinder/gl/Fbo.h"
-#include "cinder/gl/DisplayList.h"
 #include "cinder/gl/Material.h"
 #include "cinder/ImageIo.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
 
 #include "cinder/params/Params.h"
 
 #include "Resources.h"
+#include "FrameGraph.h"
+#include "TemporalAO.h"
+#include "BilateralUpsampler.h"
+#include "ShaderVariants.h"
+#include "GlProgramCache.h"
+#include "GlHiZPyramid.h"
+#include "TargetPlanner.h"
+#include "ChangeTracker.h"
+#include "SceneGeometry.h"
+#include "MeshCache.h"
+#include "SceneContainer.h"
+#include "GlSceneRenderer.h"
+#include "SeparableBlur.h"
+#include "BlueNoise.h"
+#include "FrameProfiler.h"
+#include "GlGpuTimer.h"
+#include "FrameCapture.h"
+#include "GlReadback.h"
+#include "ResolutionController.h"
+#include "TargetPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 
 using namespace ci;
 using namespace ci::app;
@@ -19,6 +44,12 @@ using namespace std;
 
 static const Vec3f	CAM_POSITION_INIT( 0.0f, 0.0f, -8.0f);
 static const Vec3f	LIGHT_POSITION_INIT( 0.0f, 4.0f, 0.0f );
+static const size_t	SHADER_CACHE_MAX_BYTES	= 32 * 1024 * 1024;	//program binaries kept in ~/.ssao_shader_cache
+static const int	CAPTURE_SLOTS	= 4;	//PBO sets in flight
+static const int	CAPTURE_LATENCY	= 2;	//frames between starting a readback and mapping it
+static const int	POOL_MAX_AGE	= 300;	//frames an unused target stays in mTargetPool / mTexturePool
+static const size_t	POOL_MAX_BYTES	= 64 * 1024 * 1024;	//dragging the window size around leaves a full G-buffer per size
+static const size_t	TEXTURE_POOL_MAX_BYTES	= 16 * 1024 * 1024;	//a few Hi-Z pyramids
 
 enum
 {
@@ -42,17 +73,48 @@ public:
     
     void mouseDown( MouseEvent event );	
     void keyDown( app::KeyEvent event ); 
+    void resize( ResizeEvent event );
 	
     //render functions ( when looking to optimize GPU look here ... )
-    void drawTestObjects();
+    void drawTestObjects( const gl::GlslProg *instancedProgram = 0 );
     void renderSceneToFBO();
     void renderNormalsDepthToFBO();
+    void renderGBufferToFBO();
+    void renderHiZ();
     void renderSSAOToFBO();	
-    void pingPongBlur();	
+    void renderTemporalAOToFBO();
+    void pingPongBlurH();
+    void pingPongBlurV();
+    void setBlurUniforms( gl::GlslProg &shader, const Vec2i &sourceSize, int normalMapUnit = 1 );
+    bool isCompositeFused() const	{ return mFusedComposite && !mBilateralOn && RENDER_MODE == SHOW_FINAL_SCENE; }
+    bool isHiZUsed() const			{ return mHiZOn && mAOMethod == ssao::AO_SSAO; }	//the horizon kernel always reads the full res normal/depth
+    float getAOScale() const		{ return mDynamicResolution ? mResolution.getScale() : 1.0f / mAODivisor; }
     void renderScreenSpace();
     
+    void updateCamera();
+    void updateScene();
+    void cullScene();
+    void measureCulling();
+    bool trackChanges();
+    Vec2f getClipPlanes() const	{ return Vec2f( mCam->getNearClip(), mCam->getFarClip() ); }	//"clipPlanes" of GBufferPacking.glsl
     void initShaders();
+    void initSSAOShaders();
+    void initBlurShaders();
+    gl::GlslProg loadProgram( DataSourceRef vertex, DataSourceRef fragment, const std::string &defines = "" );
     void initFBOs();
+    void buildFrameGraph();
+    void allocateTargets();
+    gl::Fbo acquireTarget( const ssao::TextureDesc &desc );
+    void planTargets();
+    void updateProfileRows();
+    void exportProfile();
+    void shutdown();
+    void toggleCapture();
+    void captureTargets();
+    void updateCaptureStatus();
+    float getFrameCostMs() const;
+    void updateResolution( bool dirty );
+    void updateResolutionStatus();
     
 protected:
 	
@@ -64,9 +126,61 @@ protected:
     float				mCurrFramerate;
     bool				mLightingOn;
     bool				mViewFromLight;
-	
-    //objects
-    gl::DisplayList		mTorus, mBoard, mBox, mSphere;
+    bool				mUseMRT;			//one geometry pass writing color + normal/depth instead of two
+    int					mDrawCalls;			//counted as they are issued, reset every frame
+    int					mFrameDrawCalls;	//last frame's total ( shown in params )
+    int					mGeometryPasses;	//drawTestObjects() calls last frame
+    int					mFrameGeometryPasses;
+    bool				mTemporalOn;		//rotate the kernel every frame and accumulate with reprojected history
+    int					mFrameIndex;
+    int					mAODivisor;			//SSAO / blur targets are window size / this ( 2 = half, 4 = quarter )
+    bool				mBilateralOn;		//upsample AO guided by the full res normal/depth instead of plain bilinear
+    ssao::UpsampleParams mUpsampleParams;
+    int					mAOMethod;			//ssao::AOMethod: SSAOL_frag.glsl or HorizonAO_frag.glsl ( same quality tiers )
+    bool				mHiZOn;				//SSAO taps read the min / max depth pyramid at a level picked by their distance
+    float				mRadiusScale;		//multiplies the SSAO radius ( cheap to raise with Hi-Z on )
+    ssao::HiZParams		mHiZParams;
+    ssao::BlurParams	mBlurParams;		//radius / depth aware are baked into the blur shaders, rebuilt when they change
+    ssao::BlurParams	mBlurShaderParams;	//what mHBlurShader / mVBlurShader were built with
+    int					mKernelType;		//ssao::KernelType of the SSAO variants, rebuilt when it changes
+    bool				mKernelTowardCenter;
+    ssao::KernelParams	mSSAOShaderKernel;	//what mSSAOVariants / mSSAOHiZVariants were built with
+    bool				mFusedComposite;	//vertical blur inside the composite, no mPingPongBlurV ( plain upsample only, bilateral needs the blurred texels )
+	
+    //objects: TestScene's meshes instanced from mScene, culled against mCam once per rendered frame
+    ssao::TestScene		mTestScene;
+    ssao::TaskPool		mTaskPool;
+    ssao::SceneContainer	mScene;
+    ssao::GlSceneRenderer	mSceneRenderer;
+    ssao::CullResult	mVisible;
+    int					mBoxMesh;
+    int					mExtraInstances;	//small boxes laid out in a grid around the test objects ( culling / instancing load )
+    int					mSceneExtraInstances;	//what mScene holds right now
+    int					mVisibleInstances;
+    float				mCullMs;
+    bool				mQuantizeNormals;	//upload normals as signed bytes ( 16 byte vertices instead of 24 )
+    float				mMeshKB;			//vertex + index buffers of every mesh
+	
+    //every frame graph pass is a profiler scope ( CPU, plus GPU timer queries when supported ), p50 / p95 / p99 shown in params
+    static const int	MAX_PROFILE_ROWS = 16;
+    ssao::FrameProfiler	mProfiler;
+    ssao::GlGpuTimer	*mGpuTimer;
+    int					mProfileCullScope, mProfileUIScope;
+    std::string			mProfileRows[MAX_PROFILE_ROWS];	//one per scope, params keeps pointers to these
+    int					mNumProfileRows;
+	
+    //key R dumps mScreenSpace1 / mNormalDepthMap / mSSAOMap every frame to ~/ssao_capture/, read back CAPTURE_LATENCY frames late and written in the background
+    enum { CAPTURE_SCENE, CAPTURE_NORMAL_DEPTH, CAPTURE_SSAO, NUM_CAPTURE_TARGETS };
+    ssao::GlReadback	*mReadback;
+    ssao::FrameCapture	*mCapture;
+    bool				mCaptureOn;
+    std::string			mCaptureStatus;
+	
+    //key Y: mResolution picks the AO scale ( instead of mAODivisor ) and mQualityTier every frame to hold mBudgetMs
+    ssao::ResolutionController	mResolution;
+    bool				mDynamicResolution;
+    float				mBudgetMs;
+    std::string			mResolutionStatus;
 	
     //camera
     CameraPersp			*mCam;
@@ -79,21 +193,79 @@ protected:
     gl::Light			*mLight;
     gl::Light			*mLightRef;
 	
+    //handles into mTargets, re-pointed every time the frame graph is compiled ( targets with disjoint lifetimes share one FBO )
     gl::Fbo				mScreenSpace1;
     gl::Fbo				mNormalDepthMap;
     gl::Fbo				mSSAOMap;
-    gl::Fbo				mFinalScreenTex;
 	
     gl::Fbo				mPingPongBlurH;
     gl::Fbo				mPingPongBlurV;
 	
+    //temporal AO history ( persistent so outside the graph's aliasing ), ping-pong between frames
+    gl::Fbo				mAOHistory[2];
+    ssao::TextureDesc	mAOHistoryDesc;		//what they were allocated for, they go back to mTargetPool by it
+    int					mHistoryIndex;
+    bool				mHistoryValid;
+    Matrix44f			mPrevView, mPrevProjection;
+    ssao::TemporalParams mTemporalParams;
+    gl::Fbo				mAOResult;			//what the blur / SSAO view read: mSSAOMap or the newest history
+	
+    //mipmapped, so it lives outside the graph's FBOs like the history
+    ssao::GlHiZPyramid	mHiZ;
+	
+    //frame graph ( which passes run this frame and which FBOs they share )
+    ssao::FrameGraph	mFrameGraph;
+    int					mGraphMode;
+    bool				mGraphMRT;
+    bool				mGraphTemporal;
+    float				mGraphAOScale;
+    Vec2i				mGraphWindowSize;
+    bool				mGraphBilateral;
+    bool				mGraphHiZ;
+    bool				mGraphBlurDepthAware;
+    bool				mGraphFusedComposite;
+    bool				mGraphCapture;
+    int					mNormalDepthAttachment;	//color attachment of mNormalDepthMap holding normal/depth ( 1 when it is the G-buffer )
+    std::vector<gl::Fbo>			mTargets;
+    std::vector<ssao::TextureDesc>	mTargetDescs;
+    ssao::TargetPool<gl::Fbo>		mTargetPool;	//targets of earlier graphs and histories, the AO ones come back when the scale does
+    ssao::TargetPool<gl::Texture>	mTexturePool;	//Hi-Z pyramids of earlier sizes
+    ssao::FrameGraph::ResourceId	mResScene, mResNormalDepth, mResSSAO, mResBlurH, mResBlurV, mResWindow, mResHistory, mResHiZ;
+    //what the cached passes depend on, hashed every frame ( see trackChanges() )
+    ssao::ChangeTracker	mChangeTracker;
+    int					mChannelCamera, mChannelLight, mChannelObjects, mChannelSettings;
+    bool				mSkipUnchanged;		//reuse last frame's AO / blur when nothing changed
+    int					mIdleFrames;		//frames in a row that only redrew the composite
+    ssao::TargetPlanner	mTargetPlanner;		//VRAM of the targets above, rescaled to other resolutions for the console report
+    float				mTargetMB;
+	
     gl::Texture			mRandomNoise;
 	
-    gl::GlslProg		mSSAOShader;
+    //compiled programs live on disk between runs ( key = hash of the preprocessed source + driver )
+    ssao::GlProgramCache	*mProgramCache;
+    Timer				mStartupTimer;		//setup() to the end of the first frame
+    bool				mFirstFrame;
+    float				mStartupMs;
+    float				mShaderLoadMs;
+    std::string			mGBufferPacking;	//GBufferPacking.glsl, pasted into every program ( normal/depth encode / decode )
+	
+    gl::GlslProg		mSSAOShader;		//the variant for mQualityTier
+    gl::GlslProg		mSSAOVariants[ssao::NUM_QUALITY_TIERS];
+    gl::GlslProg		mSSAOHiZVariants[ssao::NUM_QUALITY_TIERS];
+    gl::GlslProg		mHorizonVariants[ssao::NUM_QUALITY_TIERS];	//HorizonAO_frag.glsl, directions / steps of the tier
+    gl::GlslProg		mHiZReduceShader;
+    int					mQualityTier;
+    gl::GlslProg		mTemporalShader;
     gl::GlslProg		mNormalDepthShader;
+    gl::GlslProg		mGBufferShader;
+    gl::GlslProg		mNormalDepthInstancedShader;	//same with INSTANCED defined, model matrices come from the instance buffer
+    gl::GlslProg		mGBufferInstancedShader;
     gl::GlslProg		mBasicBlender;
+    gl::GlslProg		mNormalViewShader;		//mBasicBlender with SHOW_NORMALS, the packed normal/depth as normal * 0.5 + 0.5 ( view 3 )
+    gl::GlslProg		mBilateralBlender;
     gl::GlslProg		mHBlurShader;
     gl::GlslProg		mVBlurShader;
+    gl::GlslProg		mBlurCompositeShader;	//mVBlurShader + mBasicBlender
 };
 
 /* 
@@ -102,6 +274,7 @@ protected:
  * @return: none
  */
 Base_ThreeD_ProjectApp::Base_ThreeD_ProjectApp()
+: mScene( &mTaskPool )
 {}
 
 /* 
@@ -114,6 +287,20 @@ Base_ThreeD_ProjectApp::~Base_ThreeD_ProjectApp()
 	delete mCam;
 	delete mLight;
 	delete mLightRef;
+	delete mProgramCache;
+	delete mGpuTimer;
+	delete mCapture;
+	delete mReadback;
+}
+
+/* 
+ * @Description: still has a GL context, what is in flight gets read back and written before the app goes
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::shutdown()
+{
+	mCapture->stop();
 }
 
 /* 
@@ -125,7 +312,7 @@ void Base_ThreeD_ProjectApp::prepareSettings( Settings *settings )
 {
 	settings->setWindowSize( 720, 486 );		
 	settings->setFrameRate( 60.0f );			//the more the merrier!
-	settings->setResizable( false );			//this isn't going to be resizable
+	settings->setResizable( true );				//the graph's targets follow the window ( see resize() )
 	
 	//make sure secondary screen isn't blacked out as well when in fullscreen mode ( do wish it could accept keyboard focus though :(
 	//settings->enableSecondaryDisplayBlanking( false );
@@ -138,7 +325,50 @@ void Base_ThreeD_ProjectApp::prepareSettings( Settings *settings )
  */
 void Base_ThreeD_ProjectApp::setup()
 {
+	mStartupTimer.start();
+	mFirstFrame		= true;
+	mStartupMs		= 0.0f;
+	mShaderLoadMs	= 0.0f;
+	
 	RENDER_MODE = 3;
+	mGraphMode	= -1;
+	mGraphMRT	= false;
+	mGraphTemporal = false;
+	mGraphAOScale = 0.0f;
+	mGraphWindowSize = Vec2i::zero();
+	mGraphBilateral = false;
+	mGraphHiZ = false;
+	mGraphBlurDepthAware = false;
+	mGraphFusedComposite = false;
+	mGraphCapture = false;
+	mTargetMB = 0.0f;
+	mSkipUnchanged = false;	//every pass every frame like before, key U reuses the AO when nothing tracked changed
+	mIdleFrames = 0;
+	mChannelCamera		= mChangeTracker.addChannel( "camera" );
+	mChannelLight		= mChangeTracker.addChannel( "light" );
+	mChannelObjects		= mChangeTracker.addChannel( "objects" );
+	mChannelSettings	= mChangeTracker.addChannel( "settings" );
+	mHistoryIndex = 0;
+	mHistoryValid = false;
+	mFrameIndex = 0;
+	mNormalDepthAttachment = 0;
+	mGpuTimer = new ssao::GlGpuTimer();
+	mProfiler.setGpuTimer( mGpuTimer );
+	mFrameGraph.setObserver( &mProfiler );
+	mProfileCullScope	= mProfiler.getScope( "cull" );
+	mProfileUIScope		= mProfiler.getScope( "UI" );
+	mNumProfileRows		= 0;
+	mReadback	= new ssao::GlReadback( CAPTURE_SLOTS );
+	mCapture	= new ssao::FrameCapture( mReadback, CAPTURE_SLOTS, CAPTURE_LATENCY );
+	mCaptureOn	= false;
+	mTargetPool.setMaxAge( POOL_MAX_AGE );
+	mTargetPool.setMaxBytes( POOL_MAX_BYTES );
+	mTexturePool.setMaxAge( POOL_MAX_AGE );
+	mTexturePool.setMaxBytes( TEXTURE_POOL_MAX_BYTES );
+	mHiZ.setPool( &mTexturePool );
+	mDynamicResolution	= false;
+	mBudgetMs			= 8.0f;
+	mResolutionStatus	= "off";
 	
 	glEnable( GL_LIGHTING );
 	glEnable( GL_DEPTH_TEST );
@@ -146,16 +376,85 @@ void Base_ThreeD_ProjectApp::setup()
 	
 	mParams = params::InterfaceGl( "3D_Scene_Base", Vec2i( 225, 125 ) );
 	mParams.addParam( "Framerate", &mCurrFramerate, "", true );
+	mParams.addParam( "Startup ms", &mStartupMs, "", true );
+	mParams.addParam( "Shader Load ms", &mShaderLoadMs, "", true );
 	mParams.addParam( "Eye Distance", &mCameraDistance, "min=-100.0 max=-5.0 step=1.0 keyIncr== keyDecr=-");
 	mParams.addParam( "Lighting On", &mLightingOn, "key=l");
 	mParams.addParam( "Show/Hide Params", &mShowParams, "key=x");
 	mParams.addSeparator();
+	mParams.addParam( "MRT G-Buffer", &mUseMRT, "key=g");
+	mParams.addParam( "Draw Calls", &mFrameDrawCalls, "", true );
+	mParams.addParam( "Geometry Passes", &mFrameGeometryPasses, "", true );
+	mParams.addParam( "Extra Instances", &mExtraInstances, "min=0 max=200000 step=1000");
+	mParams.addParam( "Visible Instances", &mVisibleInstances, "", true );
+	mParams.addParam( "Cull ms", &mCullMs, "", true );
+	mParams.addParam( "Quantized Normals", &mQuantizeNormals, "key=n");
+	mParams.addParam( "Mesh KB", &mMeshKB, "", true );
+	mParams.addParam( "Target VRAM MB", &mTargetMB, "", true );
+	mParams.addParam( "Skip Unchanged Frames", &mSkipUnchanged, "key=u");
+	mParams.addParam( "Idle Frames", &mIdleFrames, "", true );
+	mParams.addParam( "Temporal AO", &mTemporalOn, "key=t");
+	mParams.addParam( "History Frames", &mTemporalParams.maxHistory, "min=1 max=64 step=1");
+	mParams.addParam( "History Depth Tolerance", &mTemporalParams.depthTolerance, "min=0.001 max=0.5 step=0.005");
+	mParams.addParam( "AO Divisor", &mAODivisor, "min=1 max=4 step=1");
+	mParams.addParam( "Dynamic Resolution", &mDynamicResolution, "key=y");
+	mParams.addParam( "Frame Budget ms", &mBudgetMs, "min=2.0 max=50.0 step=0.5");
+	mParams.addParam( "AO Resolution", &mResolutionStatus, "", true );
+	std::vector<std::string> tierNames;
+	for ( int i = 0; i < ssao::NUM_QUALITY_TIERS; ++i )
+		tierNames.push_back( ssao::getTierName( (ssao::QualityTier)i ) );
+	mParams.addParam( "SSAO Quality", tierNames, &mQualityTier, "key=q");
+	std::vector<std::string> kernelNames;
+	for ( int i = 0; i < ssao::NUM_KERNEL_TYPES; ++i )
+		kernelNames.push_back( ssao::getKernelTypeName( (ssao::KernelType)i ) );
+	std::vector<std::string> methodNames;
+	for ( int i = 0; i < ssao::NUM_AO_METHODS; ++i )
+		methodNames.push_back( ssao::getAOMethodName( (ssao::AOMethod)i ) );
+	mParams.addParam( "AO Method", methodNames, &mAOMethod, "key=h");
+	mParams.addParam( "Sample Kernel", kernelNames, &mKernelType, "key=k");
+	mParams.addParam( "Kernel Toward Center", &mKernelTowardCenter, "key=c");
+	mParams.addParam( "Bilateral Upsample", &mBilateralOn, "key=b");
+	mParams.addParam( "Upsample Depth Sigma", &mUpsampleParams.depthSigma, "min=0.005 max=1.0 step=0.005");
+	mParams.addParam( "Upsample Normal Power", &mUpsampleParams.normalPower, "min=0 max=64 step=1");
+	mParams.addParam( "Hi-Z AO", &mHiZOn, "key=z");
+	mParams.addParam( "AO Radius Scale", &mRadiusScale, "min=0.25 max=8.0 step=0.25");
+	mParams.addParam( "Hi-Z Lod Offset", &mHiZParams.lodOffset, "min=0 max=6 step=1");
+	mParams.addParam( "Blur Radius", &mBlurParams.radius, "min=1 max=8 step=1");
+	mParams.addParam( "Depth Aware Blur", &mBlurParams.depthAware, "key=e");
+	mParams.addParam( "Blur Depth Sigma", &mBlurParams.depthSigma, "min=0.005 max=1.0 step=0.005");
+	mParams.addParam( "Fused Blur Composite", &mFusedComposite, "key=f");
+	mParams.addParam( "Capture Frames", &mCaptureOn, "key=r");
+	mCaptureStatus = mReadback->isSupported() ? "off" : "off ( no pixel buffer objects )";
+	mParams.addParam( "Capture", &mCaptureStatus, "", true );
+	mParams.addSeparator();
+	mProfileRows[0] = mGpuTimer->isSupported() ? "p50 / p95 / p99 ms, cpu | gpu" : "p50 / p95 / p99 ms, cpu ( no GPU timers )";
+	mParams.addParam( "Profile", &mProfileRows[0], "", true );
+	mNumProfileRows = 1;
     
 	
 	mCurrFramerate = 0.0f;
 	mLightingOn = true;
 	mViewFromLight = false;
 	mShowParams = true;
+	mUseMRT = false;		//two geometry passes like before, key G for the MRT G-buffer
+	mTemporalOn = false;	//fresh AO every frame like before, key T accumulates ( and can ghost )
+	mAODivisor = 2;
+	mQualityTier = ssao::QUALITY_ORIGINAL;
+	mAOMethod = ssao::AO_SSAO;
+	mKernelType = ssao::KERNEL_ORIGINAL;
+	mKernelTowardCenter = true;
+	mBilateralOn = false;	//plain bilinear AO like before, key B for the depth aware upsample
+	mFusedComposite = false;
+	mHiZOn = false;
+	mRadiusScale = 1.0f;
+	mDrawCalls = mFrameDrawCalls = 0;
+	mGeometryPasses = mFrameGeometryPasses = 0;
+	mExtraInstances = 0;
+	mSceneExtraInstances = 0;
+	mVisibleInstances = 0;
+	mCullMs = 0.0f;
+	mQuantizeNormals = false;	//float normals like before, key N for signed bytes
+	mMeshKB = 0.0f;
 	
 	//create camera
 	mCameraDistance = CAM_POSITION_INIT.z;
@@ -213,33 +512,27 @@ void Base_ThreeD_ProjectApp::setup()
 	sphereMaterial.setDiffuse( orange ) ;	
 	sphereMaterial.setShininess( 35.0f );	
 	
-    //using DisplayLists for simplicity but highly recommend to use VBO's for serious work ( as DisplayLists will be deprecated soon ... and speed difference in now negligible )
-	mTorus = gl::DisplayList( GL_COMPILE );
-	mTorus.newList();
-	gl::drawTorus( 1.0f, 0.3f, 32, 64 );
-	mTorus.endList();
-	mTorus.setMaterial( torusMaterial );
-	
-	mBoard = gl::DisplayList( GL_COMPILE );
-	mBoard.newList();
-	gl::drawCube( Vec3f( 0.0f, 0.0f, 0.0f ), Vec3f( 10.0f, 0.1f, 10.0f ) );
-	mBoard.endList();
-	mBoard.setMaterial( boardMaterial );
-	
-	mBox = gl::DisplayList( GL_COMPILE );
-	mBox.newList();
-	gl::drawCube( Vec3f( 0.0f, 0.0f, 0.0f ), Vec3f( 1.0f, 1.0f, 1.0f ) );
-	mBox.endList();
-	mBox.setMaterial( boxMaterial );
-	
-	mSphere = gl::DisplayList( GL_COMPILE );
-	mSphere.newList();
-	gl::drawSphere( Vec3f::zero(), 0.8f, 30 );
-	mSphere.endList();
-	mSphere.setMaterial( sphereMaterial );
-	
-    //noise texture required for SSAO calculations
-	mRandomNoise = gl::Texture( loadImage( loadResource( NOISE_SAMPLER ) ) );
+	//one mesh per test object ( same order as TestScene::getObjects() ), extra instances reuse the box
+	gl::Material materials[4] = { torusMaterial, boardMaterial, boxMaterial, sphereMaterial };
+	const std::vector<ssao::SceneObject> &objects = mTestScene.getObjects();
+	for ( size_t i = 0; i < objects.size(); ++i )
+		mScene.addInstance( mScene.addMesh( objects[i].mesh ), objects[i].transform );
+	mBoxMesh = 2;	//torus, board, box, sphere
+	mSceneRenderer.setNormalFormat( mQuantizeNormals ? ssao::NORMAL_BYTE : ssao::NORMAL_FLOAT );
+	mSceneRenderer.upload( mScene );
+	mMeshKB = mSceneRenderer.getUploadedBytes() / 1024.0f;
+	for ( int m = 0; m < mScene.getNumMeshes(); ++m )
+		mSceneRenderer.setMaterial( m, materials[m] );
+	mTestScene.getMeshCache().dump( console() );
+	
+    //noise texture required for SSAO calculations ( the pre-generated blue noise tile, repeated one texel per pixel )
+	std::vector<unsigned char> rotations;
+	ssao::buildRotationTile( ssao::BLUE_NOISE_TILE, ssao::BLUE_NOISE_SIZE, &rotations );
+	gl::Texture::Format noiseFormat;
+	noiseFormat.setWrap( GL_REPEAT, GL_REPEAT );
+	noiseFormat.setMinFilter( GL_NEAREST );
+	noiseFormat.setMagFilter( GL_NEAREST );
+	mRandomNoise = gl::Texture( &rotations[0], GL_RGB, ssao::BLUE_NOISE_SIZE, ssao::BLUE_NOISE_SIZE, noiseFormat );
 	
 	initFBOs();
 	initShaders();
@@ -262,21 +555,72 @@ void Base_ThreeD_ProjectApp::update()
  */
 void Base_ThreeD_ProjectApp::draw()
 {
+	mProfiler.beginFrame();
+	
     //clear depth and color every frame
 	glClearColor( 0.5f, 0.5f, 0.5f, 1 );
 	glClearDepth(1.0f);
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     
-	renderSceneToFBO();
-	renderNormalsDepthToFBO();
-	renderSSAOToFBO();
+	//only rebuild the graph when what we show changes, passes nobody reads are culled
+	if ( mGraphMode != RENDER_MODE || mGraphMRT != mUseMRT || mGraphTemporal != mTemporalOn || mGraphAOScale != getAOScale() || mGraphBilateral != mBilateralOn || mGraphHiZ != isHiZUsed() || mGraphBlurDepthAware != mBlurParams.depthAware
+		 || mGraphFusedComposite != mFusedComposite || mGraphCapture != mCaptureOn || mGraphWindowSize != getWindowSize() )
+		buildFrameGraph();
+	if ( mCaptureOn != mCapture->isCapturing() )
+		toggleCapture();
+	if ( mBlurShaderParams.radius != mBlurParams.radius || mBlurShaderParams.depthAware != mBlurParams.depthAware )
+		initBlurShaders();
+	if ( mSSAOShaderKernel.type != mKernelType || mSSAOShaderKernel.towardCenter != mKernelTowardCenter )
+		initSSAOShaders();
+	
+	mDrawCalls		= 0;
+	mGeometryPasses	= 0;
+	
+	updateCamera();
+	updateScene();
+	bool dirty = trackChanges() || !mSkipUnchanged;
+	//timings from before a settings change would blur the percentiles of the new ones
+	if ( mChangeTracker.hasChanged( mChannelSettings ) )
+		mProfiler.clear();
+	//a clean frame draws no geometry, so it needs no culling either
+	if ( dirty ) {
+		ssao::FrameProfiler::Scoped scope( mProfiler, mProfileCullScope, false );
+		cullScene();
+	}
+	mFrameGraph.execute( !dirty );
+	mIdleFrames = dirty ? 0 : mIdleFrames + 1;
 	
-	renderScreenSpace();
+	mFrameDrawCalls			= mDrawCalls;
+	mFrameGeometryPasses	= mGeometryPasses;
+	++mFrameIndex;
 	
 	//glFinish(); //want to make sure everything is finished before jumping to UI ... slows down program big-time. Is totally unecessary ...
     
-	if (mShowParams)
+	if (mShowParams) {
+		ssao::FrameProfiler::Scoped scope( mProfiler, mProfileUIScope );
 		params::InterfaceGl::draw();
+	}
+	
+	mProfiler.endFrame();
+	mTargetPool.endFrame();
+	mTexturePool.endFrame();
+	updateResolution( dirty );
+	if ( mProfiler.getFrameCount() % 30 == 0 ) {
+		updateProfileRows();
+		updateCaptureStatus();
+		updateResolutionStatus();
+	}
+	
+	//cold start = everything up to and including the first frame ( shaders, FBOs, first graph run )
+	if ( mFirstFrame ) {
+		glFinish();
+		mStartupTimer.stop();
+		mStartupMs	= (float)( mStartupTimer.getSeconds() * 1000.0 );
+		mFirstFrame	= false;
+		console() << "startup: " << mStartupMs << " ms to first frame, shaders " << mShaderLoadMs << " ms ( "
+				  << mProgramCache->getNumLoaded() << " from cache, " << mProgramCache->getNumCompiled() << " compiled"
+				  << ( mProgramCache->isBinarySupported() ? "" : ", no program binary support" ) << " )" << std::endl;
+	}
 }
 
 /* 
@@ -296,22 +640,174 @@ void Base_ThreeD_ProjectApp::renderSceneToFBO()
 		glDisable(GL_LIGHTING);
 	glColor3f( 1.0f, 1.0f, 0.1f );
 	gl::drawFrustum( mLightRef->getShadowCamera() );
+	++mDrawCalls;
 	glColor3f( 1.0f, 1.0f, 1.0f );
 	if (mLightingOn)
 		glEnable(GL_LIGHTING);
 	
+	gl::setMatrices( *mCam );
+	mLight->update( *mCam );
+	
+	drawTestObjects();
+	
+	mScreenSpace1.unbindFramebuffer();
+	
+	glDisable(GL_LIGHTING);
+}
+
+/* 
+ * @Description: MRT version of renderSceneToFBO() + renderNormalsDepthToFBO(), the scene is only submitted once.
+ *				 attachment 0 gets the lit color, attachment 1 normal/depth ( lighting is done in GBuffer_frag.glsl )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::renderGBufferToFBO()
+{
+	mScreenSpace1.bindFramebuffer();
+	
+	//color clears to grey, normal/depth to the packed "facing the camera at the far plane" ( see GBufferPacking.glsl )
+	glDrawBuffer( GL_COLOR_ATTACHMENT1_EXT );
+	glClearColor( 0.5f, 0.5f, 1.0f, 1.0f );
+	glClear( GL_COLOR_BUFFER_BIT );
+	
+	//the frustum is a color only thing, keep it out of the normal/depth attachment
+	glDrawBuffer( GL_COLOR_ATTACHMENT0_EXT );
+	glClearColor( 0.5f, 0.5f, 0.5f, 1 );
+	glClearDepth(1.0f);
+	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+	
+	glDisable(GL_LIGHTING);
+	glColor3f( 1.0f, 1.0f, 0.1f );
+	gl::drawFrustum( mLightRef->getShadowCamera() );
+	++mDrawCalls;
+	glColor3f( 1.0f, 1.0f, 1.0f );
+	
+	GLenum buffers[2] = { GL_COLOR_ATTACHMENT0_EXT, GL_COLOR_ATTACHMENT1_EXT };
+	glDrawBuffers( 2, buffers );
+	
+	gl::setMatrices( *mCam );
+	mLight->update( *mCam );
+	
+	gl::GlslProg &gbufferShader = mSceneRenderer.isInstancingSupported() ? mGBufferInstancedShader : mGBufferShader;
+	gbufferShader.bind();
+	gbufferShader.uniform( "lightingOn", mLightingOn );
+	gbufferShader.uniform( "clipPlanes", getClipPlanes() );
+	drawTestObjects( &gbufferShader );
+	gbufferShader.unbind();
+	
+	mScreenSpace1.unbindFramebuffer();
+}
+
+/* 
+ * @Description: apply the eye distance to the camera ( every pass that draws geometry uses these matrices, so done before any of them )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::updateCamera()
+{
 	mEye = mCam->getEyePoint();
 	mEye.normalize();
 	mEye = mEye * abs(mCameraDistance);
 	mCam->lookAt( mEye, mCenter, mUp );
 	gl::setMatrices( *mCam );
 	mLight->update( *mCam );
+}
+
+/* 
+ * @Description: re-upload the meshes when the normal format changed, bring mScene's extra instances to mExtraInstances ( a square grid
+ *				 of small boxes on the board's plane, reaching well past the board so a good part of them is culled )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::updateScene()
+{
+	ssao::NormalFormat normalFormat = mQuantizeNormals ? ssao::NORMAL_BYTE : ssao::NORMAL_FLOAT;
+	if ( mSceneRenderer.getNormalFormat() != normalFormat ) {
+		mSceneRenderer.setNormalFormat( normalFormat );
+		mSceneRenderer.upload( mScene );
+		mMeshKB = mSceneRenderer.getUploadedBytes() / 1024.0f;
+		mChangeTracker.invalidate();
+	}
 	
-	drawTestObjects();
+	if ( mSceneExtraInstances == mExtraInstances )
+		return;
 	
-	mScreenSpace1.unbindFramebuffer();
+	mScene.truncate( (int)mTestScene.getObjects().size() );
+	int side = (int)ceil( sqrt( (double)mExtraInstances ) );
+	Matrix44f scale = Matrix44f::createScale( Vec3f( 0.1f, 0.1f, 0.1f ) );
+	for ( int i = 0; i < mExtraInstances; ++i ) {
+		Vec3f position( ( i % side - side * 0.5f ) * 0.3f, -1.25f, ( i / side - side * 0.5f ) * 0.3f );
+		mScene.addInstance( mBoxMesh, Matrix44f::createTranslation( position ) * scale );
+	}
+	mSceneExtraInstances = mExtraInstances;
+}
+
+/* 
+ * @Description: frustum cull mScene against mCam ( after updateCamera() ) and upload the visible instances' matrices
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::cullScene()
+{
+	Timer timer( true );
+	mScene.cull( ssao::Frustum::fromViewProjection( mCam->getProjectionMatrix() * mCam->getModelViewMatrix() ), &mVisible );
+	mCullMs = (float)( timer.getSeconds() * 1000.0 );
+	mVisibleInstances = mVisible.visible;
 	
-	glDisable(GL_LIGHTING);
+	mSceneRenderer.prepare( mScene, mVisible );
+}
+
+/* 
+ * @Description: time the scalar, simd and threaded culling paths on the current scene and view and log them ( key M, too slow for every frame )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::measureCulling()
+{
+	ssao::CullReport report = mScene.measureCulling( ssao::Frustum::fromViewProjection( mCam->getProjectionMatrix() * mCam->getModelViewMatrix() ), 10 );
+	console() << "culling " << report.instances << " instances ( " << report.visible << " visible ): scalar " << (int)report.scalarPerMs
+			  << "/ms, simd " << (int)report.simdPerMs << "/ms, " << mTaskPool.getNumThreads() << " threads " << (int)report.parallelPerMs << "/ms"
+			  << ( report.mismatches ? ", paths disagree!" : "" ) << std::endl;
+}
+
+/* 
+ * @Description: feed everything the cacheable passes read into the change tracker ( after updateCamera() )
+ * @param: none
+ * @return: bool ( true if they have to run this frame )
+ */
+bool Base_ThreeD_ProjectApp::trackChanges()
+{
+	mChangeTracker.beginFrame();
+	
+	Matrix44f view			= mCam->getModelViewMatrix();
+	Matrix44f projection	= mCam->getProjectionMatrix();
+	mChangeTracker.add( mChannelCamera, view );
+	mChangeTracker.add( mChannelCamera, projection );
+	
+	mChangeTracker.add( mChannelLight, mLight->getPosition() );
+	mChangeTracker.add( mChannelLight, mLightRef->getPosition() );
+	mChangeTracker.add( mChannelLight, mLightingOn );
+	
+	mChangeTracker.add( mChannelObjects, mScene.getRevision() );
+	
+	//the toggles that change which passes run ( MRT, temporal, AO divisor ... ) rebuild the graph, which invalidates the tracker
+	mChangeTracker.add( mChannelSettings, getWindowSize() );
+	mChangeTracker.add( mChannelSettings, mQualityTier );
+	mChangeTracker.add( mChannelSettings, mAOMethod );
+	mChangeTracker.add( mChannelSettings, mKernelType );
+	mChangeTracker.add( mChannelSettings, mKernelTowardCenter );
+	mChangeTracker.add( mChannelSettings, mRadiusScale );
+	mChangeTracker.add( mChannelSettings, mHiZParams.lodOffset );
+	mChangeTracker.add( mChannelSettings, mHiZParams.maxLevels );
+	mChangeTracker.add( mChannelSettings, mTemporalParams.maxHistory );
+	mChangeTracker.add( mChannelSettings, mTemporalParams.depthTolerance );
+	mChangeTracker.add( mChannelSettings, mBlurParams.radius );
+	mChangeTracker.add( mChannelSettings, mBlurParams.depthAware );
+	mChangeTracker.add( mChannelSettings, mBlurParams.depthSigma );
+	
+	//temporal AO keeps converging for maxHistory frames after the last change, freeze it only once it has
+	mChangeTracker.setSettleFrames( mTemporalOn ? mTemporalParams.maxHistory : 0 );
+	return mChangeTracker.endFrame();
 }
 
 /* 
@@ -326,19 +822,39 @@ void Base_ThreeD_ProjectApp::renderNormalsDepthToFBO()
 	//render out main scene to FBO
 	mNormalDepthMap.bindFramebuffer();
 	
-	glClearColor( 0.5f, 0.5f, 0.5f, 1 );
+	//packed normal ( 0, 0, 1 ) at the far plane, see GBufferPacking.glsl
+	glClearColor( 0.5f, 0.5f, 1.0f, 1.0f );
 	glClearDepth(1.0f);
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 	
-	mNormalDepthShader.bind();
-    drawTestObjects();
-	mNormalDepthShader.unbind();
+	gl::GlslProg &normalDepthShader = mSceneRenderer.isInstancingSupported() ? mNormalDepthInstancedShader : mNormalDepthShader;
+	normalDepthShader.bind();
+	normalDepthShader.uniform( "clipPlanes", getClipPlanes() );
+	drawTestObjects( &normalDepthShader );
+	normalDepthShader.unbind();
 	
 	mNormalDepthMap.unbindFramebuffer();
 	
 	gl::setViewport( getWindowBounds() );
 }
 
+/* 
+ * @Description: min / max depth pyramid of the normal/depth buffer for the Hi-Z SSAO variants ( HiZReduce_frag.glsl, CPU version in HiZPyramid.h )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::renderHiZ()
+{
+	mHiZReduceShader.bind();
+	mHiZReduceShader.uniform( "clipPlanes", getClipPlanes() );
+	mHiZReduceShader.unbind();
+	
+	mHiZ.build( mNormalDepthMap.getTexture( mNormalDepthAttachment ), mHiZReduceShader, mHiZParams );
+	mDrawCalls += mHiZ.getNumLevels();
+	
+	gl::setViewport( getWindowBounds() );
+}
+
 /* 
  * @Description: render SSAO now - woohoo!
  * @param: KeyEvent
@@ -358,14 +874,34 @@ void Base_ThreeD_ProjectApp::renderSSAOToFBO()
 	gl::setMatricesWindow( mSSAOMap.getSize() );
 	
 	mRandomNoise.bind(1);
-	mNormalDepthMap.getTexture().bind(2);
+	mNormalDepthMap.getTexture( mNormalDepthAttachment ).bind(2);
 	
+	//sample count and constants are baked into the variant, only the textures are uniforms
+	if ( mAOMethod == ssao::AO_HORIZON )
+		mSSAOShader = mHorizonVariants[mQualityTier];
+	else
+		mSSAOShader = isHiZUsed() ? mSSAOHiZVariants[mQualityTier] : mSSAOVariants[mQualityTier];
 	mSSAOShader.bind();
 	
 	mSSAOShader.uniform("rnm", 1 );
 	mSSAOShader.uniform("normalMap", 2 );
+	mSSAOShader.uniform("frameRotation", mTemporalOn ? ssao::TemporalAO::getFrameRotation( mFrameIndex ) : 0.0f );
+	mSSAOShader.uniform("radiusScale", mRadiusScale );
+	mSSAOShader.uniform("clipPlanes", getClipPlanes() );
+	if ( mAOMethod == ssao::AO_HORIZON ) {
+		const Matrix44f &projection = mCam->getProjectionMatrix();
+		mSSAOShader.uniform("projection", Vec2f( projection.at( 0, 0 ), projection.at( 1, 1 ) ) );
+	}
+	if ( isHiZUsed() ) {
+		mHiZ.getTexture().bind(3);
+		mSSAOShader.uniform("hiZ", 3 );
+		mSSAOShader.uniform("hiZSize", Vec2f( mHiZ.getSize() ) );
+		mSSAOShader.uniform("hiZLodOffset", (float)mHiZParams.lodOffset );
+		mSSAOShader.uniform("hiZMaxLevel", (float)( mHiZ.getNumLevels() - 1 ) );
+	}
     
     //look at shader and see you can set these through the client if you so desire.
+    //( the scene constants are now baked in per quality tier instead, see ssao::buildSSAOVariant() in initShaders() )
     //	mSSAOShader.uniform("rnm", 1 );
     //	mSSAOShader.uniform("normalMap", 2 );	
     //	mSSAOShader.uniform("totStrength", 1.38f);
@@ -386,10 +922,13 @@ void Base_ThreeD_ProjectApp::renderSSAOToFBO()
     //	mSSAOShader.uniform("gdiffuse", 1 );
     
     gl::drawSolidRect( Rectf( 0, 0, getWindowWidth(), getWindowHeight()) );
+	++mDrawCalls;
 	
 	mSSAOShader.unbind();
 	
-	mNormalDepthMap.getTexture().unbind(2);
+	if ( isHiZUsed() )
+		mHiZ.getTexture().unbind(3);
+	mNormalDepthMap.getTexture( mNormalDepthAttachment ).unbind(2);
 	mRandomNoise.unbind(1);
 	
 	mSSAOMap.unbindFramebuffer();
@@ -397,12 +936,62 @@ void Base_ThreeD_ProjectApp::renderSSAOToFBO()
 	gl::setViewport( getWindowBounds() );
 }
 
+/* 
+ * @Description: blend the fresh SSAO into last frame's reprojected history ( TemporalAO_frag.glsl, CPU version in TemporalAO.h )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::renderTemporalAOToFBO()
+{
+	gl::Fbo &prev = mAOHistory[mHistoryIndex];
+	gl::Fbo &next = mAOHistory[1 - mHistoryIndex];
+	
+	Matrix44f view			= mCam->getModelViewMatrix();
+	Matrix44f projection	= mCam->getProjectionMatrix();
+	
+	gl::setViewport( next.getBounds() );
+	next.bindFramebuffer();
+	gl::setMatricesWindow( next.getSize() );
+	
+	mSSAOMap.getTexture().bind(0);
+	prev.getTexture().bind(1);
+	mNormalDepthMap.getTexture( mNormalDepthAttachment ).bind(2);
+	
+	mTemporalShader.bind();
+	mTemporalShader.uniform("currentAO", 0 );
+	mTemporalShader.uniform("history", 1 );
+	mTemporalShader.uniform("normalMap", 2 );
+	mTemporalShader.uniform("viewToPrevView", mPrevView * view.inverted() );
+	mTemporalShader.uniform("prevProjection", mPrevProjection );
+	mTemporalShader.uniform("projParams", Vec4f( projection.at( 0, 0 ), projection.at( 1, 1 ), projection.at( 0, 2 ), projection.at( 1, 2 ) ) );
+	mTemporalShader.uniform("historyValid", mHistoryValid );
+	mTemporalShader.uniform("maxHistory", (float)mTemporalParams.maxHistory );
+	mTemporalShader.uniform("depthTolerance", mTemporalParams.depthTolerance );
+	mTemporalShader.uniform("clipPlanes", getClipPlanes() );
+	gl::drawSolidRect( Rectf( 0, 0, getWindowWidth(), getWindowHeight()) );
+	++mDrawCalls;
+	mTemporalShader.unbind();
+	
+	mNormalDepthMap.getTexture( mNormalDepthAttachment ).unbind(2);
+	prev.getTexture().unbind(1);
+	mSSAOMap.getTexture().unbind(0);
+	
+	next.unbindFramebuffer();
+	gl::setViewport( getWindowBounds() );
+	
+	mAOResult		= next;
+	mHistoryIndex	= 1 - mHistoryIndex;
+	mHistoryValid	= true;
+	mPrevView		= view;
+	mPrevProjection	= projection;
+}
+
 /* 
  * @Description: need to blur[the SSAO texture] horizonatally then vertically (for shader performance reasons). Called ping-ponging as it one FBO drawn to another
- * @param: KeyEvent
+ * @param: none
  * @return: none
  */
-void Base_ThreeD_ProjectApp::pingPongBlur()
+void Base_ThreeD_ProjectApp::pingPongBlurH()
 {
 	//render horizontal blue first
 	gl::setViewport( mPingPongBlurH.getBounds() );
@@ -415,18 +1004,46 @@ void Base_ThreeD_ProjectApp::pingPongBlur()
 	
 	gl::setMatricesWindow( mPingPongBlurH.getSize() );
 	
-	mSSAOMap.getTexture().bind(0);
+	mAOResult.getTexture().bind(0);
+	if ( mBlurParams.depthAware )
+		mNormalDepthMap.getTexture( mNormalDepthAttachment ).bind(1);
 	mHBlurShader.bind();
 	mHBlurShader.uniform("RTScene", 0);
+	setBlurUniforms( mHBlurShader, mAOResult.getSize() );
     gl::drawSolidRect( Rectf( 0, 0, getWindowWidth(), getWindowHeight()) );
+	++mDrawCalls;
 	mHBlurShader.unbind();
-	mSSAOMap.getTexture().unbind(0);
+	if ( mBlurParams.depthAware )
+		mNormalDepthMap.getTexture( mNormalDepthAttachment ).unbind(1);
+	mAOResult.getTexture().unbind(0);
 	
 	mPingPongBlurH.unbindFramebuffer();
 	
-	//gl::setViewport( getWindowBounds() ); //redundant
-	
-	//now render vertical blur
+	gl::setViewport( getWindowBounds() );
+}
+
+/* 
+ * @Description: what both blur shaders share: the source's texel size ( taps land on texel centers at any AO divisor ) and the depth aware inputs
+ * @param: gl::GlslProg ( bound ), Vec2i size of the texture being blurred, texture unit normal/depth is bound to ( depth aware only )
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::setBlurUniforms( gl::GlslProg &shader, const Vec2i &sourceSize, int normalMapUnit )
+{
+	shader.uniform("texelSize", Vec2f( 1.0f / sourceSize.x, 1.0f / sourceSize.y ) );
+	if ( mBlurParams.depthAware ) {
+		shader.uniform("normalMap", normalMapUnit );
+		shader.uniform("depthSigma", mBlurParams.depthSigma );
+		shader.uniform("clipPlanes", getClipPlanes() );
+	}
+}
+
+/* 
+ * @Description: second half of the ping-pong, vertical blur of mPingPongBlurH
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::pingPongBlurV()
+{
 	gl::setViewport( mPingPongBlurV.getBounds() );
 	
 	mPingPongBlurV.bindFramebuffer();
@@ -438,10 +1055,16 @@ void Base_ThreeD_ProjectApp::pingPongBlur()
 	gl::setMatricesWindow( mPingPongBlurV.getSize() );
 	
 	mPingPongBlurH.getTexture().bind(0);
-	mHBlurShader.bind();
-	mHBlurShader.uniform("RTBlurH", 0);
+	if ( mBlurParams.depthAware )
+		mNormalDepthMap.getTexture( mNormalDepthAttachment ).bind(1);
+	mVBlurShader.bind();
+	mVBlurShader.uniform("RTBlurH", 0);
+	setBlurUniforms( mVBlurShader, mPingPongBlurH.getSize() );
 	gl::drawSolidRect( Rectf( 0, 0, getWindowWidth(), getWindowHeight()) );
-	mHBlurShader.unbind();
+	++mDrawCalls;
+	mVBlurShader.unbind();
+	if ( mBlurParams.depthAware )
+		mNormalDepthMap.getTexture( mNormalDepthAttachment ).unbind(1);
 	mPingPongBlurH.getTexture().unbind(0);
 	
 	mPingPongBlurV.unbindFramebuffer();
@@ -468,50 +1091,95 @@ void Base_ThreeD_ProjectApp::renderScreenSpace()
 		{
 			mScreenSpace1.getTexture(0).bind(0);
             gl::drawSolidRect( Rectf( 0, getWindowHeight(), getWindowWidth(), 0) );
+			++mDrawCalls;
 			mScreenSpace1.getTexture(0).unbind(0);
 		}
             break;
 			
 		case SHOW_SSAO:
 		{
-			mSSAOMap.getTexture().bind(0);
+			mAOResult.getTexture().bind(0);
 			
 			mBasicBlender.bind();
 			
 			mBasicBlender.uniform("ssaoTex", 0 );
 			mBasicBlender.uniform("baseTex", 0 );
 			gl::drawSolidRect( Rectf( 0, getWindowHeight(), getWindowWidth(), 0) );
+			++mDrawCalls;
 			
 			mBasicBlender.unbind();
 			
-			mSSAOMap.getTexture().unbind(0);
+			mAOResult.getTexture().unbind(0);
 		}
             break;
 			
 		case SHOW_NORMALMAP:
 		{
-			mNormalDepthMap.getTexture().bind(0);
+			//the target holds packed octahedral normals and depth bytes, decode them to show the normals
+			mNormalDepthMap.getTexture( mNormalDepthAttachment ).bind(0);
+			mNormalViewShader.bind();
+			mNormalViewShader.uniform("ssaoTex", 0 );
+			mNormalViewShader.uniform("clipPlanes", getClipPlanes() );
             gl::drawSolidRect( Rectf( 0, getWindowHeight(), getWindowWidth(), 0) );
-			mNormalDepthMap.getTexture().unbind(0);
+			++mDrawCalls;
+			mNormalViewShader.unbind();
+			mNormalDepthMap.getTexture( mNormalDepthAttachment ).unbind(0);
 		}
             break;
 			
 		case SHOW_FINAL_SCENE:
 		{
-			pingPongBlur();
-			
 			gl::setMatricesWindow( getWindowSize() );
 			
+			if ( isCompositeFused() ) {
+				//blur V + BasicBlender in one pass, straight from mPingPongBlurH
+				mPingPongBlurH.getTexture().bind(0);
+				mScreenSpace1.getTexture().bind(1);
+				if ( mBlurParams.depthAware )
+					mNormalDepthMap.getTexture( mNormalDepthAttachment ).bind(2);
+				mBlurCompositeShader.bind();
+				mBlurCompositeShader.uniform("RTBlurH", 0 );
+				mBlurCompositeShader.uniform("baseTex", 1 );
+				setBlurUniforms( mBlurCompositeShader, mPingPongBlurH.getSize(), 2 );
+				gl::drawSolidRect( Rectf( 0, getWindowHeight(), getWindowWidth(), 0) );
+				++mDrawCalls;
+				mBlurCompositeShader.unbind();
+				if ( mBlurParams.depthAware )
+					mNormalDepthMap.getTexture( mNormalDepthAttachment ).unbind(2);
+				mScreenSpace1.getTexture().unbind(1);
+				mPingPongBlurH.getTexture().unbind(0);
+				break;
+			}
+			
 			mPingPongBlurV.getTexture().bind(0);
 			mScreenSpace1.getTexture().bind(1);
 			
-			mBasicBlender.bind();
-			
-			mBasicBlender.uniform("ssaoTex", 0 );
-			mBasicBlender.uniform("baseTex", 1 );
+			if ( mBilateralOn ) {
+				//AO is mAODivisor times smaller than the window, bring it up along the full res normal/depth
+				mNormalDepthMap.getTexture( mNormalDepthAttachment ).bind(2);
+				mBilateralBlender.bind();
+				mBilateralBlender.uniform("ssaoTex", 0 );
+				mBilateralBlender.uniform("baseTex", 1 );
+				mBilateralBlender.uniform("normalMap", 2 );
+				mBilateralBlender.uniform("aoSize", Vec2f( mPingPongBlurV.getSize() ) );
+				mBilateralBlender.uniform("depthSigma", mUpsampleParams.depthSigma );
+				mBilateralBlender.uniform("normalPower", (float)mUpsampleParams.normalPower );
+				mBilateralBlender.uniform("clipPlanes", getClipPlanes() );
+			}
+			else {
+				mBasicBlender.bind();
+				mBasicBlender.uniform("ssaoTex", 0 );
+				mBasicBlender.uniform("baseTex", 1 );
+			}
 			gl::drawSolidRect( Rectf( 0, getWindowHeight(), getWindowWidth(), 0) );
+			++mDrawCalls;
 			
-			mBasicBlender.unbind();
+			if ( mBilateralOn ) {
+				mBilateralBlender.unbind();
+				mNormalDepthMap.getTexture( mNormalDepthAttachment ).unbind(2);
+			}
+			else
+				mBasicBlender.unbind();
 			
 			mScreenSpace1.getTexture().unbind(1);
 			mPingPongBlurV.getTexture().unbind(0);
@@ -654,43 +1322,30 @@ void Base_ThreeD_ProjectApp::keyDown( KeyEvent event )
 			mLightRef->update( *mCam );
 		}
 			break;
+		case KeyEvent::KEY_p:
+		{
+			exportProfile();
+		}
+			break;
+		case KeyEvent::KEY_m:
+		{
+			measureCulling();
+		}
+			break;
 		default:
 			break;
 	}
 }
 
 /* 
- * @Description: drawing all objects in scene here
- * @param: none
+ * @Description: drawing all visible objects in scene here ( one instanced draw per mesh when instancedProgram is bound, else one per object )
+ * @param: gl::GlslProg* ( the bound program's INSTANCED variant, 0 for fixed function )
  * @return: none
  */
-void Base_ThreeD_ProjectApp::drawTestObjects()
+void Base_ThreeD_ProjectApp::drawTestObjects( const gl::GlslProg *instancedProgram )
 {
-	//glColor3f(1.0, 0.2, 0.2);
-	gl::pushMatrices();
-	glTranslatef(-2.0f, -1.0f, 0.0f);
-	glRotated(90.0f, 1, 0, 0);
-    mTorus.draw();
-	gl::popMatrices();
-	
-	//glColor3f(0.4, 1.0, 0.2);
-	gl::pushMatrices();
-	glTranslatef(0.0f, -1.35f, 0.0f);
-    mBoard.draw();
-	gl::popMatrices();
-	
-	//glColor3f(0.8, 0.5, 0.2);
-	gl::pushMatrices();
-	glTranslatef(0.4f, -0.3f, 0.5f);
-	glScalef(2.0f, 2.0f, 2.0f);
-    mBox.draw();
-	gl::popMatrices();
-	
-	//glColor3f(0.3, 0.5, 0.9);
-	gl::pushMatrices();
-	glTranslatef(0.1f, -0.56f, -1.25f);
-    mSphere.draw();
-	gl::popMatrices();
+	++mGeometryPasses;
+	mDrawCalls += mSceneRenderer.draw( mScene, mVisible, instancedProgram );
 }
 
 /* 
@@ -700,11 +1355,90 @@ void Base_ThreeD_ProjectApp::drawTestObjects()
  */
 void Base_ThreeD_ProjectApp::initShaders()
 {
-	mSSAOShader			= gl::GlslProg( loadResource( SSAO_VERT ), loadResource( SSAO_FRAG_LIGHT ) );
-	mNormalDepthShader	= gl::GlslProg( loadResource( NaDepth_VERT ), loadResource( NaDepth_FRAG ) );
-	mBasicBlender		= gl::GlslProg( loadResource( BBlender_VERT ), loadResource( BBlender_FRAG ) );
-	mHBlurShader		= gl::GlslProg( loadResource( BLUR_H_VERT ), loadResource( BLUR_H_FRAG ) );
-	mVBlurShader		= gl::GlslProg( loadResource( BLUR_V_VERT ), loadResource( BLUR_V_FRAG ) );
+	std::string cacheDir = getHomeDirectory() + ".ssao_shader_cache/";
+	if ( !createDirectories( cacheDir ) )
+		cacheDir.clear();
+	mProgramCache = new ssao::GlProgramCache( cacheDir );
+	
+	Buffer packing	= loadResource( GBUFFER_PACKING_GLSL )->getBuffer();
+	mGBufferPacking	= std::string( (const char*)packing.getData(), packing.getDataSize() );
+	
+	initSSAOShaders();
+	mTemporalShader		= loadProgram( loadResource( SSAO_VERT ), loadResource( TEMPORAL_AO_FRAG ) );
+	mHiZReduceShader	= loadProgram( loadResource( SSAO_VERT ), loadResource( HIZ_REDUCE_FRAG ) );
+	mNormalDepthShader	= loadProgram( loadResource( NaDepth_VERT ), loadResource( NaDepth_FRAG ) );
+	mGBufferShader		= loadProgram( loadResource( GBUFFER_VERT ), loadResource( GBUFFER_FRAG ) );
+	if ( mSceneRenderer.isInstancingSupported() ) {
+		mNormalDepthInstancedShader	= loadProgram( loadResource( NaDepth_VERT ), loadResource( NaDepth_FRAG ), "#define INSTANCED\n" );
+		mGBufferInstancedShader		= loadProgram( loadResource( GBUFFER_VERT ), loadResource( GBUFFER_FRAG ), "#define INSTANCED\n" );
+	}
+	mBasicBlender		= loadProgram( loadResource( BBlender_VERT ), loadResource( BBlender_FRAG ) );
+	mNormalViewShader	= loadProgram( loadResource( BBlender_VERT ), loadResource( BBlender_FRAG ), "#define SHOW_NORMALS\n" );
+	mBilateralBlender	= loadProgram( loadResource( BBlender_VERT ), loadResource( BILATERAL_BLENDER_FRAG ) );
+	initBlurShaders();
+	
+	//programs nobody asked for in a while ( edited shaders, variants not picked lately ) go once the cache is over budget
+	mProgramCache->trim( SHADER_CACHE_MAX_BYTES );
+	mShaderLoadMs = (float)( mProgramCache->getSeconds() * 1000.0 );
+}
+
+/* 
+ * @Description: one specialized ( unrolled, constants and the mKernelType kernel baked in ) SSAO program per quality tier, switching tiers is just picking another one.
+ *				 The horizon programs ( directions / steps of the tier ) are built alongside
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::initSSAOShaders()
+{
+	Buffer ssaoVert = loadResource( SSAO_VERT )->getBuffer();
+	Buffer ssaoFrag = loadResource( SSAO_FRAG_LIGHT )->getBuffer();
+	std::string vertSource( (const char*)ssaoVert.getData(), ssaoVert.getDataSize() );
+	std::string fragSource( (const char*)ssaoFrag.getData(), ssaoFrag.getDataSize() );
+	//the variant defines go in ahead of the packing functions ( the Hi-Z #extension has to come before any code )
+	fragSource = ssao::insertDefines( fragSource, mGBufferPacking );
+	Buffer horizonFrag = loadResource( HORIZON_AO_FRAG )->getBuffer();
+	std::string horizonSource = ssao::insertDefines( std::string( (const char*)horizonFrag.getData(), horizonFrag.getDataSize() ), mGBufferPacking );
+	
+	ssao::SSAOParams base;
+	base.kernel.type			= (ssao::KernelType)mKernelType;
+	base.kernel.towardCenter	= mKernelTowardCenter;
+	for ( int i = 0; i < ssao::NUM_QUALITY_TIERS; ++i ) {
+		ssao::SSAOParams params = ssao::getTierParams( (ssao::QualityTier)i, base );
+		mSSAOVariants[i] = mProgramCache->getProgram( vertSource, ssao::buildSSAOVariant( fragSource, params ) );
+		//same tier reading occluders from the Hi-Z pyramid
+		mSSAOHiZVariants[i] = mProgramCache->getProgram( vertSource, ssao::buildSSAOVariant( fragSource, params, true, true ) );
+		mHorizonVariants[i] = mProgramCache->getProgram( vertSource, ssao::buildHorizonVariant( horizonSource, params ) );
+	}
+	mSSAOShader			= mSSAOVariants[mQualityTier];
+	mSSAOShaderKernel	= base.kernel;
+}
+
+/* 
+ * @Description: the two blur passes specialized for mBlurParams ( merged bilinear taps, or one tap per texel when depth aware )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::initBlurShaders()
+{
+	std::string defines	= ssao::buildBlurDefines( mBlurParams );
+	mHBlurShader		= loadProgram( loadResource( BLUR_H_VERT ), loadResource( BLUR_H_FRAG ), defines );
+	mVBlurShader		= loadProgram( loadResource( BLUR_V_VERT ), loadResource( BLUR_V_FRAG ), defines );
+	//samples between AO texel centers, merged taps would pull in a third texel
+	mBlurCompositeShader	= loadProgram( loadResource( BBlender_VERT ), loadResource( BLUR_COMPOSITE_FRAG ), ssao::buildBlurDefines( mBlurParams, false ) );
+	mBlurShaderParams	= mBlurParams;
+}
+
+/* 
+ * @Description: compile ( or fetch from the program cache ) a vertex / fragment pair, both with GBufferPacking.glsl pasted in
+ * @param: DataSourceRef vertex, DataSourceRef fragment, defines ( ahead of the packing functions in both )
+ * @return: gl::GlslProg
+ */
+gl::GlslProg Base_ThreeD_ProjectApp::loadProgram( DataSourceRef vertex, DataSourceRef fragment, const std::string &defines )
+{
+	Buffer vert = vertex->getBuffer();
+	Buffer frag = fragment->getBuffer();
+	return mProgramCache->getProgram( ssao::insertDefines( std::string( (const char*)vert.getData(), vert.getDataSize() ), defines + mGBufferPacking ),
+									  ssao::insertDefines( std::string( (const char*)frag.getData(), frag.getDataSize() ), defines + mGBufferPacking ) );
 }
 
 /* 
@@ -714,21 +1448,400 @@ void Base_ThreeD_ProjectApp::initShaders()
  */
 void Base_ThreeD_ProjectApp::initFBOs()
 {		
-    gl::Fbo::Format format;
-	//format.setDepthInternalFormat( GL_DEPTH_COMPONENT32 );
-	format.setColorInternalFormat( GL_RGBA16F_ARB );
-	format.setSamples( 4 ); // enable 4x antialiasing
-    
-	//init screen space render
-	mScreenSpace1	= gl::Fbo( getWindowWidth(), getWindowHeight(), format );
-	mNormalDepthMap	= gl::Fbo( getWindowWidth()/2.0f, getWindowHeight()/2.0f, format );
-	mPingPongBlurH	= gl::Fbo( getWindowWidth()/2.0f, getWindowHeight()/2.0f, format );
-	mPingPongBlurV	= gl::Fbo( getWindowWidth()/2.0f, getWindowHeight()/2.0f, format );
-	mFinalScreenTex = gl::Fbo( getWindowWidth(), getWindowHeight(), format );
-	mSSAOMap		= gl::Fbo( getWindowWidth()/2.0f, getWindowHeight()/2.0f, format );
+	//the FBOs themselves come from the frame graph ( see allocateTargets() ), this only declares the frame for the current mode
+	buildFrameGraph();
     
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE );
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );	
 }
 
+/* 
+ * @Description: declare every pass with what it reads and writes, then compile ( culls passes that RENDER_MODE doesn't need and aliases targets )
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::buildFrameGraph()
+{
+	using ssao::FrameGraph;
+	using ssao::TextureDesc;
+	
+	//every target says what it needs: the geometry passes get 4x antialiasing and a depth buffer, the full screen
+	//AO / blur passes get neither ( resolving them only blurred nothing and cost samples x the memory ).
+	//the lit color is LDR like the window, only AO keeps half floats
+	TextureDesc full( getWindowWidth(), getWindowHeight(), TextureDesc::FORMAT_RGBA8, 4 ); // 4x antialiasing
+	float aoScale = getAOScale();
+	TextureDesc aoDesc( std::max( (int)( getWindowWidth() * aoScale ), 1 ), std::max( (int)( getWindowHeight() * aoScale ), 1 ), TextureDesc::FORMAT_RGBA16F, 0, 1, false );
+	
+	mFrameGraph.clear();
+	mProfiler.clear();
+	//normal/depth is packed into RGBA8 ( GBufferPacking.glsl ), half the bandwidth of RGBA16F for every pass that reads it
+	if ( mUseMRT ) {
+		//color and normal/depth are two attachments of one full size target, the normal/depth half just reads attachment 1
+		mResScene		= mFrameGraph.createTexture( "mGBuffer", TextureDesc( full.width, full.height, full.format, full.samples, 2 ) );
+		mResNormalDepth	= mResScene;
+	}
+	else {
+		mResScene		= mFrameGraph.createTexture( "mScreenSpace1", full );
+		//the bilateral upsample needs it at full res as its guide
+		const TextureDesc &size = mBilateralOn ? full : aoDesc;
+		mResNormalDepth	= mFrameGraph.createTexture( "mNormalDepthMap", TextureDesc( size.width, size.height, TextureDesc::FORMAT_RGBA8, full.samples ) );
+	}
+	mResSSAO		= mFrameGraph.createTexture( "mSSAOMap", aoDesc );
+	mResBlurH		= mFrameGraph.createTexture( "mPingPongBlurH", aoDesc );
+	mResBlurV		= mFrameGraph.createTexture( "mPingPongBlurV", aoDesc );
+	mResHistory		= mFrameGraph.importTexture( "mAOHistory", TextureDesc( aoDesc.width, aoDesc.height, TextureDesc::FORMAT_RGBA16F, 0, 1, false ) );
+	mResHiZ			= mFrameGraph.importTexture( "mHiZ", TextureDesc( mUseMRT || mBilateralOn ? full.width : aoDesc.width, mUseMRT || mBilateralOn ? full.height : aoDesc.height, TextureDesc::FORMAT_RGBA16F, 0, 1, false ) );
+	mResWindow		= mFrameGraph.importTexture( "window", TextureDesc( getWindowWidth(), getWindowHeight(), TextureDesc::FORMAT_RGBA8 ) );
+	mFrameGraph.markOutput( mResWindow );
+	
+	if ( mUseMRT ) {
+		FrameGraph::PassId gbuffer = mFrameGraph.addPass( "G-buffer", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::renderGBufferToFBO ) );
+		mFrameGraph.write( gbuffer, mResScene );
+	}
+	else {
+		FrameGraph::PassId scene = mFrameGraph.addPass( "scene", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::renderSceneToFBO ) );
+		mFrameGraph.write( scene, mResScene );
+		
+		FrameGraph::PassId normalDepth = mFrameGraph.addPass( "normal/depth", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::renderNormalsDepthToFBO ) );
+		mFrameGraph.write( normalDepth, mResNormalDepth );
+	}
+	
+	if ( isHiZUsed() ) {
+		FrameGraph::PassId hiZ = mFrameGraph.addPass( "Hi-Z", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::renderHiZ ) );
+		mFrameGraph.read( hiZ, mResNormalDepth );
+		mFrameGraph.write( hiZ, mResHiZ );
+	}
+	
+	FrameGraph::PassId ssaoPass = mFrameGraph.addPass( "SSAO", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::renderSSAOToFBO ) );
+	mFrameGraph.read( ssaoPass, mResNormalDepth );
+	if ( isHiZUsed() )
+		mFrameGraph.read( ssaoPass, mResHiZ );
+	mFrameGraph.write( ssaoPass, mResSSAO );
+	
+	//with temporal AO on everything downstream reads the accumulated history instead of the raw SSAO
+	FrameGraph::ResourceId aoResult = mResSSAO;
+	if ( mTemporalOn ) {
+		FrameGraph::PassId temporal = mFrameGraph.addPass( "temporal AO", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::renderTemporalAOToFBO ) );
+		mFrameGraph.read( temporal, mResSSAO );
+		mFrameGraph.read( temporal, mResNormalDepth );
+		mFrameGraph.read( temporal, mResHistory );
+		mFrameGraph.write( temporal, mResHistory );
+		aoResult = mResHistory;
+	}
+	
+	FrameGraph::PassId blurH = mFrameGraph.addPass( "blur H", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::pingPongBlurH ) );
+	mFrameGraph.read( blurH, aoResult );
+	if ( mBlurParams.depthAware )
+		mFrameGraph.read( blurH, mResNormalDepth );
+	mFrameGraph.write( blurH, mResBlurH );
+	
+	//fused, the composite blurs mPingPongBlurH itself and mPingPongBlurV is never allocated
+	if ( !isCompositeFused() ) {
+		FrameGraph::PassId blurV = mFrameGraph.addPass( "blur V", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::pingPongBlurV ) );
+		mFrameGraph.read( blurV, mResBlurH );
+		if ( mBlurParams.depthAware )
+			mFrameGraph.read( blurV, mResNormalDepth );
+		mFrameGraph.write( blurV, mResBlurV );
+	}
+	
+	FrameGraph::PassId composite = mFrameGraph.addPass( "composite", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::renderScreenSpace ) );
+	mFrameGraph.write( composite, mResWindow );
+	switch (RENDER_MODE) 
+	{
+		case SHOW_STANDARD_VIEW:	mFrameGraph.read( composite, mResScene );			break;
+		case SHOW_SSAO:				mFrameGraph.read( composite, aoResult );			break;
+		case SHOW_NORMALMAP:		mFrameGraph.read( composite, mResNormalDepth );		break;
+		case SHOW_FINAL_SCENE:
+			mFrameGraph.read( composite, isCompositeFused() ? mResBlurH : mResBlurV );
+			mFrameGraph.read( composite, mResScene );
+			if ( mBilateralOn || ( isCompositeFused() && mBlurParams.depthAware ) )
+				mFrameGraph.read( composite, mResNormalDepth );
+			break;
+	}
+	
+	//capture reads its targets last, so they live ( unaliased ) until the frame is done. A side effect, nothing reads what it writes
+	FrameGraph::PassId capture = -1;
+	if ( mCaptureOn ) {
+		capture = mFrameGraph.addPass( "capture", FrameGraph::makeExecutor( this, &Base_ThreeD_ProjectApp::captureTargets ) );
+		mFrameGraph.read( capture, mResScene );
+		mFrameGraph.read( capture, mResNormalDepth );
+		mFrameGraph.read( capture, mResSSAO );
+		mFrameGraph.setSideEffect( capture );
+	}
+	
+	//everything but the composite ( and capture ) depends only on what mChangeTracker watches, an unchanged frame just redraws the composite
+	for ( FrameGraph::PassId p = 0; p < mFrameGraph.getNumPasses(); ++p )
+		if ( p != composite && p != capture )
+			mFrameGraph.setCacheable( p );
+	
+	if ( !mFrameGraph.compile() )
+		mFrameGraph.dump( console() );
+	
+	allocateTargets();
+	planTargets();
+	mGraphMode				= RENDER_MODE;
+	mGraphMRT				= mUseMRT;
+	mGraphTemporal			= mTemporalOn;
+	mGraphAOScale			= aoScale;
+	mGraphWindowSize		= getWindowSize();
+	mGraphBilateral			= mBilateralOn;
+	mGraphHiZ				= isHiZUsed();
+	mGraphBlurDepthAware	= mBlurParams.depthAware;
+	mGraphFusedComposite	= mFusedComposite;
+	mGraphCapture			= mCaptureOn;
+	mHistoryValid			= false;	//whatever is in the history may be from a different set of passes
+	mChangeTracker.invalidate();		//and the targets may be new
+	mNormalDepthAttachment	= mUseMRT ? 1 : 0;
+}
+
+/* 
+ * @Description: make sure there is one FBO per physical target of the compiled graph ( and the history / Hi-Z this mode uses ) and point the named handles at them
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::allocateTargets()
+{
+	//everything goes back to the pool first, targets whose desc didn't change come straight back out
+	for ( size_t i = 0; i < mTargets.size(); ++i )
+		if ( mTargets[i] )
+			mTargetPool.release( mTargetDescs[i], mTargets[i] );
+	//the history too: it is invalid after a rebuild anyway, and has the AO targets' desc so any of them will do
+	for ( int i = 0; i < 2; ++i ) {
+		if ( mAOHistory[i] )
+			mTargetPool.release( mAOHistoryDesc, mAOHistory[i] );
+		mAOHistory[i] = gl::Fbo();
+	}
+	//the pyramid reallocates from mTexturePool on its next build()
+	if ( !isHiZUsed() )
+		mHiZ.release();
+	
+	int numPhysical = mFrameGraph.getNumPhysical();
+	mTargets.assign( numPhysical, gl::Fbo() );
+	mTargetDescs.resize( numPhysical );
+	
+	for ( int i = 0; i < numPhysical; ++i ) {
+		const ssao::TextureDesc &desc = mFrameGraph.getPhysicalDesc( i );
+		mTargetDescs[i]	= desc;
+		mTargets[i]		= acquireTarget( desc );
+	}
+	
+	//culled resources get an empty handle
+	int physical;
+	mScreenSpace1	= ( physical = mFrameGraph.getPhysicalIndex( mResScene ) ) >= 0 ? mTargets[physical] : gl::Fbo();
+	mNormalDepthMap	= ( physical = mFrameGraph.getPhysicalIndex( mResNormalDepth ) ) >= 0 ? mTargets[physical] : gl::Fbo();
+	mSSAOMap		= ( physical = mFrameGraph.getPhysicalIndex( mResSSAO ) ) >= 0 ? mTargets[physical] : gl::Fbo();
+	mPingPongBlurH	= ( physical = mFrameGraph.getPhysicalIndex( mResBlurH ) ) >= 0 ? mTargets[physical] : gl::Fbo();
+	mPingPongBlurV	= ( physical = mFrameGraph.getPhysicalIndex( mResBlurV ) ) >= 0 ? mTargets[physical] : gl::Fbo();
+	mAOResult		= mSSAOMap;
+	
+	//history is imported, not aliased: it lives outside the graph's targets but comes from the same pool ( no multisampling, it is read with offsets )
+	if ( mTemporalOn ) {
+		mAOHistoryDesc = mFrameGraph.getResourceDesc( mResHistory );
+		for ( int i = 0; i < 2; ++i )
+			mAOHistory[i] = acquireTarget( mAOHistoryDesc );
+	}
+}
+
+/* 
+ * @Description: an FBO for desc, the newest one released with that desc if mTargetPool has one
+ * @param: TextureDesc
+ * @return: gl::Fbo
+ */
+gl::Fbo Base_ThreeD_ProjectApp::acquireTarget( const ssao::TextureDesc &desc )
+{
+	gl::Fbo target;
+	if ( mTargetPool.acquire( desc, &target ) )
+		return target;
+	
+	gl::Fbo::Format format;
+	//format.setDepthInternalFormat( GL_DEPTH_COMPONENT32 );
+	format.setColorInternalFormat( desc.format == ssao::TextureDesc::FORMAT_RGBA8 ? GL_RGBA8 : ( desc.format == ssao::TextureDesc::FORMAT_RGBA32F ? GL_RGBA32F_ARB : GL_RGBA16F_ARB ) );
+	format.setSamples( desc.samples );
+	format.enableColorBuffer( true, desc.attachments );
+	format.enableDepthBuffer( desc.depth );
+	return gl::Fbo( desc.width, desc.height, format );
+}
+
+/* 
+ * @Description: VRAM of the graph's targets plus the imported ones this mode allocates, logged for the common output sizes
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::planTargets()
+{
+	mTargetPlanner.clear( getWindowWidth(), getWindowHeight() );
+	mTargetPlanner.addFrameGraph( mFrameGraph );
+	if ( mTemporalOn )
+		mTargetPlanner.addTarget( "mAOHistory", mFrameGraph.getResourceDesc( mResHistory ), 2 );
+	if ( isHiZUsed() )
+		mTargetPlanner.addTarget( "mHiZ", mFrameGraph.getResourceDesc( mResHiZ ), 1, mHiZParams.maxLevels );
+	
+	mTargetMB = (float)( mTargetPlanner.plan().totalBytes / ( 1024.0 * 1024.0 ) );
+	
+	static const int sizes[][2] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+	ssao::TargetPlanner::dump( mTargetPlanner.plan(), console() );
+	for ( int i = 0; i < 4; ++i ) {
+		ssao::TargetPlan plan = mTargetPlanner.plan( sizes[i][0], sizes[i][1] );
+		console() << "  at " << plan.width << "x" << plan.height << ": " << plan.totalBytes / ( 1024 * 1024 ) << " MB" << std::endl;
+	}
+}
+
+/* 
+ * @Description: p50 / p95 / p99 of every profiler scope into the params rows, rows are added as new scopes ( passes ) show up
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::updateProfileRows()
+{
+	for ( int scope = 0; scope < mProfiler.getNumScopes() && scope + 1 < MAX_PROFILE_ROWS; ++scope ) {
+		std::string &row = mProfileRows[scope + 1];
+		if ( scope + 1 >= mNumProfileRows ) {
+			mParams.addParam( mProfiler.getScopeName( scope ) + " ms", &row, "", true );
+			mNumProfileRows = scope + 2;
+		}
+		
+		ssao::ProfileStats cpu = mProfiler.getStats( scope, ssao::FrameProfiler::CLOCK_CPU );
+		ssao::ProfileStats gpu = mProfiler.getStats( scope, ssao::FrameProfiler::CLOCK_GPU );
+		char text[96] = "-";
+		if ( gpu.count )
+			std::sprintf( text, "%.2f %.2f %.2f | %.2f %.2f %.2f", cpu.p50, cpu.p95, cpu.p99, gpu.p50, gpu.p95, gpu.p99 );
+		else if ( cpu.count )
+			std::sprintf( text, "%.2f %.2f %.2f", cpu.p50, cpu.p95, cpu.p99 );
+		row = text;
+	}
+}
+
+/* 
+ * @Description: write the profiler's stats ( and sample histories ) to the home directory as ssao_profile.csv / ssao_profile.json
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::exportProfile()
+{
+	std::string path = getHomeDirectory() + "ssao_profile";
+	std::ofstream csv( ( path + ".csv" ).c_str() );
+	mProfiler.writeCsv( csv );
+	std::ofstream json( ( path + ".json" ).c_str() );
+	mProfiler.writeJson( json );
+	console() << "profile: " << mProfiler.getFrameCount() << " frames written to " << path << ".csv / .json" << ( csv && json ? "" : " ( failed )" ) << std::endl;
+}
+
+/* 
+ * @Description: start capturing into ~/ssao_capture/ or stop and log what the run wrote
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::toggleCapture()
+{
+	if ( mCaptureOn ) {
+		std::string directory = getHomeDirectory() + "ssao_capture/";
+		createDirectories( directory );
+		mCapture->start( directory );
+		console() << "capture: writing to " << directory << std::endl;
+	}
+	else {
+		mCapture->stop();
+		ssao::CaptureStats stats = mCapture->getStats();
+		console() << "capture: " << stats.written << " of " << mCapture->getFrame() << " frames written ( " << stats.droppedRing << " dropped waiting on the GPU, "
+				  << stats.droppedBacklog << " on the writers, " << stats.failed << " failed ), " << stats.encodedBytes / ( 1024 * 1024 ) << " MB ( "
+				  << stats.getRatio() << "x compressed ), readback " << ( mCapture->getFrame() ? stats.readbackMs / mCapture->getFrame() : 0.0 ) << " ms per frame" << std::endl;
+	}
+	updateCaptureStatus();
+}
+
+/* 
+ * @Description: the capture pass, after everything it reads is drawn. Sources are set every frame, the graph may have moved them
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::captureTargets()
+{
+	//lit color and packed normal/depth as they are ( RGBA8 ), the half float AO as floats of its .r
+	std::vector<ssao::CaptureTarget> targets( NUM_CAPTURE_TARGETS );
+	targets[CAPTURE_SCENE]			= ssao::CaptureTarget( "scene", mScreenSpace1.getWidth(), mScreenSpace1.getHeight(), 4, 1 );
+	targets[CAPTURE_NORMAL_DEPTH]	= ssao::CaptureTarget( "normaldepth", mNormalDepthMap.getWidth(), mNormalDepthMap.getHeight(), 4, 1 );
+	targets[CAPTURE_SSAO]			= ssao::CaptureTarget( "ssao", mSSAOMap.getWidth(), mSSAOMap.getHeight(), 1, 4 );
+	mReadback->setSource( CAPTURE_SCENE, mScreenSpace1.getTexture( 0 ) );
+	mReadback->setSource( CAPTURE_NORMAL_DEPTH, mNormalDepthMap.getTexture( mNormalDepthAttachment ) );
+	mReadback->setSource( CAPTURE_SSAO, mSSAOMap.getTexture() );
+	mCapture->setTargets( targets );
+	mCapture->captureFrame();
+}
+
+/* 
+ * @Description: frames written / dropped and the compression ratio into the "Capture" params row
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::updateCaptureStatus()
+{
+	if ( !mCapture->isCapturing() && !mCapture->getFrame() )
+		return;
+	ssao::CaptureStats stats = mCapture->getStats();
+	char text[96];
+	std::sprintf( text, "%s%d written, %d dropped, %.1fx", mCapture->isCapturing() ? "" : "off, ", stats.written, stats.droppedRing + stats.droppedBacklog + stats.failed, stats.getRatio() );
+	mCaptureStatus = text;
+}
+
+/* 
+ * @Description: the window was resized, keep the projection's aspect ( the graph notices the new size in draw() )
+ * @param: ResizeEvent
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::resize( ResizeEvent /*event*/ )
+{
+	mCam->setPerspective( 45.0f, getWindowAspectRatio(), 1.0f, 50.0f );
+}
+
+/* 
+ * @Description: what the last frame cost: CPU time of draw() or, if GPU timers are there, the passes' GPU times added up
+ *				 ( the newest sample of every pass, they come back a few frames late )
+ * @param: none
+ * @return: float ( ms )
+ */
+float Base_ThreeD_ProjectApp::getFrameCostMs() const
+{
+	int frameScope = mProfiler.findScope( "frame" );
+	float cpuMs = frameScope >= 0 ? mProfiler.getHistory( frameScope, ssao::FrameProfiler::CLOCK_CPU ).getLast() : 0.0f;
+	float gpuMs = 0.0f;
+	for ( int i = 0; i < mProfiler.getNumScopes(); ++i )
+		if ( i != frameScope )
+			gpuMs += mProfiler.getHistory( i, ssao::FrameProfiler::CLOCK_GPU ).getLast();
+	return std::max( cpuMs, gpuMs );
+}
+
+/* 
+ * @Description: feed the frame to mResolution, a new scale rebuilds the graph next frame, a new tier switches the SSAO variant
+ * @param: dirty ( clean frames skip the AO, they say nothing about what it costs )
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::updateResolution( bool dirty )
+{
+	if ( !mDynamicResolution ) {
+		//picks up from what the params are set to when it is switched on
+		mResolution.reset( 1.0f / mAODivisor, (ssao::QualityTier)mQualityTier );
+		return;
+	}
+	if ( !dirty )
+		return;
+	mResolution.setBudget( mBudgetMs );
+	if ( mResolution.update( getFrameCostMs() ) )
+		mQualityTier = mResolution.getTier();
+}
+
+/* 
+ * @Description: AO scale, quality tier, measured p90 and pooled target count into the "AO Resolution" params row
+ * @param: none
+ * @return: none
+ */
+void Base_ThreeD_ProjectApp::updateResolutionStatus()
+{
+	char text[96];
+	if ( mDynamicResolution )
+		std::sprintf( text, "%.0f%% %s, p90 %.1f ms, pool %d", getAOScale() * 100.0f, ssao::getTierName( (ssao::QualityTier)mQualityTier ), mResolution.getMeasuredMs(), mTargetPool.size() + mTexturePool.size() );
+	else
+		std::sprintf( text, "off, pool %d", mTargetPool.size() + mTexturePool.size() );
+	mResolutionStatus = text;
+}
+
 CINDER_APP_BASIC( Base_ThreeD_ProjectApp, RendererGl )
@@ -0,0 +1,248 @@
+#include "BatchAOProcessor.h"
+#include "BoundedQueue.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace ssao {
+
+/*
+ * SSAO rows of one frame, one task per block of rows
+ */
+class BatchAOProcessor::RowJob : public TaskPool::Job
+{
+public:
+	static const int ROWS_PER_TASK = 16;
+
+	RowJob( const SSAOEngine *engine, const FloatImage &normalDepth, FloatImage *ao )
+	: mEngine( engine ), mNormalDepth( normalDepth ), mAO( ao ) {}
+
+	int getNumTasks() const { return ( mAO->getHeight() + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK; }
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		int rowBegin	= index * ROWS_PER_TASK;
+		int rowEnd		= std::min( rowBegin + ROWS_PER_TASK, mAO->getHeight() );
+		mEngine->computeRegion( mNormalDepth, mAO, 0, mAO->getWidth(), rowBegin, rowEnd );
+	}
+
+private:
+	const SSAOEngine	*mEngine;
+	const FloatImage	&mNormalDepth;
+	FloatImage			*mAO;
+};
+
+//one frame buffer and the frame it holds
+struct FrameSlot
+{
+	FloatImage	image;
+	int			frame;
+};
+
+/*
+ * the queues of one run. Each side has queueDepth + 2 slots ( one per stage plus the queue ), they go round
+ * free -> filled -> free, so a stage waiting on a free slot means the next stage is behind
+ */
+struct BatchAOProcessor::Pipeline
+{
+	Pipeline( GBufferSequenceReader &input, GBufferSequenceWriter &output, int firstFrame, int endFrame, int queueDepth )
+	: input( input ), output( output ), firstFrame( firstFrame ), endFrame( endFrame ),
+	  inputSlots( queueDepth + 2 ), outputSlots( queueDepth + 2 ),
+	  freeInputs( inputSlots.size() ), filled( queueDepth ), freeOutputs( outputSlots.size() ), computed( queueDepth )
+	{
+		for ( size_t i = 0; i < inputSlots.size(); ++i )
+			freeInputs.push( &inputSlots[i] );
+		for ( size_t i = 0; i < outputSlots.size(); ++i )
+			freeOutputs.push( &outputSlots[i] );
+	}
+
+	GBufferSequenceReader	&input;
+	GBufferSequenceWriter	&output;
+	int						firstFrame, endFrame;
+
+	std::vector<FrameSlot>		inputSlots, outputSlots;
+	BoundedQueue<FrameSlot*>	freeInputs, filled;		//reader -> compute
+	BoundedQueue<FrameSlot*>	freeOutputs, computed;	//compute -> writer
+};
+
+/*
+ * @Description: constructor
+ * @param: TaskPool*, SSAOEngine* ( both borrowed )
+ * @return: none
+ */
+BatchAOProcessor::BatchAOProcessor( TaskPool *pool, const SSAOEngine *engine )
+: mPool( pool ), mEngine( engine ), mBlur( pool )
+{}
+
+GBufferSequenceInfo BatchAOProcessor::getOutputInfo( const GBufferSequenceInfo &input ) const
+{
+	GBufferSequenceInfo info( input );
+	info.width		= std::max( (int)std::floor( input.width * mSettings.aoScale + 0.5f ), 1 );
+	info.height		= std::max( (int)std::floor( input.height * mSettings.aoScale + 0.5f ), 1 );
+	info.channels	= 1;
+	info.frameCount	= 0;
+	return info;
+}
+
+/*
+ * @Description: AO of the G-buffer sequence at inputPath into a new sequence at outputPath
+ * @param: paths
+ * @return: bool ( false if a file couldn't be opened or a stage failed, see getError() )
+ */
+bool BatchAOProcessor::run( const std::string &inputPath, const std::string &outputPath )
+{
+	GBufferSequenceReader input;
+	if ( !input.open( inputPath ) ) {
+		mStats = BatchStats();
+		mError = "can't read " + inputPath + " as a G-buffer sequence";
+		return false;
+	}
+	GBufferSequenceWriter output;
+	if ( !output.open( outputPath, getOutputInfo( input.getInfo() ) ) ) {
+		mStats = BatchStats();
+		mError = "can't write " + outputPath;
+		return false;
+	}
+
+	bool ok = process( input, output );
+	if ( !output.close() && ok ) {
+		mError = "can't finish " + outputPath;
+		ok = false;
+	}
+	return ok;
+}
+
+/*
+ * @Description: run the three stages over the settings' frame range until all are written or one stage fails
+ * @param: GBufferSequenceReader input ( 4 channel normal/depth ), GBufferSequenceWriter output
+ * @return: bool
+ */
+bool BatchAOProcessor::process( GBufferSequenceReader &input, GBufferSequenceWriter &output )
+{
+	mStats = BatchStats();
+	mError.clear();
+	if ( input.getInfo().channels != 4 ) {
+		mError = "the input has to be 4 channel normal/depth";
+		return false;
+	}
+	GBufferSequenceInfo expected = getOutputInfo( input.getInfo() );
+	if ( output.getInfo().width != expected.width || output.getInfo().height != expected.height || output.getInfo().channels != 1 ) {
+		mError = "the output isn't sized for this input ( getOutputInfo() )";
+		return false;
+	}
+	mBlur.setParams( mSettings.blurParams );
+
+	int firstFrame	= std::min( std::max( mSettings.firstFrame, 0 ), input.getFrameCount() );
+	int endFrame	= mSettings.frameCount < 0 ? input.getFrameCount() : std::min( firstFrame + mSettings.frameCount, input.getFrameCount() );
+	Pipeline pipeline( input, output, firstFrame, endFrame, std::max( mSettings.queueDepth, 1 ) );
+
+	ci::Timer wall( true );
+	std::thread reader( &BatchAOProcessor::readLoop, this, &pipeline );
+	std::thread writer( &BatchAOProcessor::writeLoop, this, &pipeline );
+
+	FrameSlot *in = 0, *out = 0;
+	while ( pipeline.filled.pop( &in ) ) {
+		if ( !pipeline.freeOutputs.pop( &out ) )
+			break;
+		ci::Timer timer( true );
+		computeFrame( in->image, &out->image );
+		mStats.computeMs += timer.getSeconds() * 1000.0;
+
+		out->frame = in->frame;
+		pipeline.freeInputs.push( in );
+		if ( !pipeline.computed.push( out ) )
+			break;
+	}
+	//after a failure downstream this is what stops the reader
+	pipeline.freeInputs.close();
+	pipeline.filled.close();
+	pipeline.computed.close();
+
+	reader.join();
+	writer.join();
+	mStats.wallMs = wall.getSeconds() * 1000.0;
+	return mError.empty();
+}
+
+void BatchAOProcessor::readLoop( Pipeline *pipeline )
+{
+	FrameSlot *slot = 0;
+	for ( int frame = pipeline->firstFrame; frame < pipeline->endFrame; ++frame ) {
+		if ( !pipeline->freeInputs.pop( &slot ) )
+			break;
+		ci::Timer timer( true );
+		bool ok = pipeline->input.readFrame( frame, &slot->image );
+		mStats.readMs += timer.getSeconds() * 1000.0;
+		if ( !ok ) {
+			std::stringstream ss;
+			ss << "can't read frame " << frame;
+			setError( ss.str() );
+			break;
+		}
+		slot->frame = frame;
+		if ( !pipeline->filled.push( slot ) )
+			break;
+	}
+	pipeline->filled.close();
+}
+
+void BatchAOProcessor::writeLoop( Pipeline *pipeline )
+{
+	FrameSlot *slot = 0;
+	while ( pipeline->computed.pop( &slot ) ) {
+		ci::Timer timer( true );
+		bool ok = pipeline->output.append( slot->image );
+		mStats.writeMs += timer.getSeconds() * 1000.0;
+		if ( !ok ) {
+			std::stringstream ss;
+			ss << "can't write frame " << slot->frame;
+			setError( ss.str() );
+			//fails the compute stage's next push / pop, which then stops the reader
+			pipeline->computed.close();
+			pipeline->freeOutputs.close();
+			break;
+		}
+		++mStats.frames;
+		pipeline->freeOutputs.push( slot );
+	}
+}
+
+/*
+ * @Description: renderSSAOToFBO() and the blur for one frame, spread over the pool
+ * @param: FloatImage normal/depth, FloatImage* ao ( AO sized, 1 channel )
+ * @return: none
+ */
+void BatchAOProcessor::computeFrame( const FloatImage &normalDepth, FloatImage *ao )
+{
+	GBufferSequenceInfo frame;
+	frame.width		= normalDepth.getWidth();
+	frame.height	= normalDepth.getHeight();
+	GBufferSequenceInfo info = getOutputInfo( frame );
+
+	FloatImage *target = mSettings.blur ? &mRawAO : ao;
+	if ( target->getWidth() != info.width || target->getHeight() != info.height || target->getChannels() != 1 )
+		target->allocate( info.width, info.height, 1 );
+
+	RowJob job( mEngine, normalDepth, target );
+	mPool->parallelFor( job.getNumTasks(), &job );
+
+	if ( !mSettings.blur )
+		return;
+	if ( mSettings.blurParams.depthAware )
+		mBlur.blurDepthAware( mRawAO, normalDepth, ao );
+	else
+		mBlur.blur( mRawAO, ao );
+}
+
+//the first error wins, later ones are usually its consequence
+void BatchAOProcessor::setError( const std::string &error )
+{
+	std::lock_guard<std::mutex> lock( mErrorMutex );
+	if ( mError.empty() )
+		mError = error;
+}
+
+} // namespace ssao
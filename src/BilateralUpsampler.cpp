@@ -0,0 +1,222 @@
+#include "BilateralUpsampler.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ssao {
+
+/*
+ * rows of one of the full frame passes, one task per block of rows
+ */
+class BilateralUpsampler::RowJob : public TaskPool::Job
+{
+public:
+	enum Pass { SSAO, UPSAMPLE };
+	static const int ROWS_PER_TASK = 16;
+
+	RowJob( BilateralUpsampler *upsampler, Pass pass, int rows, const SSAOEngine *engine = 0, FloatImage *ao = 0 )
+	: mUpsampler( upsampler ), mPass( pass ), mRows( rows ), mEngine( engine ), mAO( ao ) {}
+
+	int getNumTasks() const { return ( mRows + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK; }
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		int rowBegin	= index * ROWS_PER_TASK;
+		int rowEnd		= std::min( rowBegin + ROWS_PER_TASK, mRows );
+
+		if ( mPass == SSAO )
+			mEngine->computeRegion( *mUpsampler->mNormalDepth, mAO, 0, mAO->getWidth(), rowBegin, rowEnd );
+		else
+			for ( int y = rowBegin; y < rowEnd; ++y )
+				mUpsampler->upsampleRow( y );
+	}
+
+private:
+	BilateralUpsampler	*mUpsampler;
+	Pass				mPass;
+	int					mRows;
+	const SSAOEngine	*mEngine;
+	FloatImage			*mAO;
+};
+
+/*
+ * @Description: constructor
+ * @param: TaskPool* ( borrowed )
+ * @return: none
+ */
+BilateralUpsampler::BilateralUpsampler( TaskPool *pool )
+: mPool( pool ), mNormalDepth( 0 ), mAO( 0 ), mResult( 0 )
+{}
+
+/*
+ * @Description: joint bilateral upsample of ao to the normalDepth size
+ * @param: FloatImage full res normal/depth, FloatImage low res AO, FloatImage* result
+ * @return: none
+ */
+void BilateralUpsampler::upsample( const FloatImage &normalDepth, const FloatImage &ao, FloatImage *result )
+{
+	const int w = normalDepth.getWidth();
+	const int h = normalDepth.getHeight();
+	if ( result->getWidth() != w || result->getHeight() != h || result->getChannels() != 1 )
+		result->allocate( w, h, 1 );
+
+	//the guide is the G-buffer as the SSAO pass sampled it, at the low res texel centers
+	const int aw = ao.getWidth();
+	const int ah = ao.getHeight();
+	if ( mGuide.getWidth() != aw || mGuide.getHeight() != ah )
+		mGuide.allocate( aw, ah, 4 );
+	for ( int y = 0; y < ah; ++y )
+		for ( int x = 0; x < aw; ++x )
+			normalDepth.sampleBilinear( ( x + 0.5f ) / aw, ( y + 0.5f ) / ah, mGuide.getPixel( x, y ) );
+
+	mNormalDepth	= &normalDepth;
+	mAO				= &ao;
+	mResult			= result;
+
+	RowJob job( this, RowJob::UPSAMPLE, h );
+	mPool->parallelFor( job.getNumTasks(), &job );
+}
+
+/*
+ * @Description: one output row, the body of BilateralBlender_frag.glsl
+ * @param: row
+ * @return: none
+ */
+void BilateralUpsampler::upsampleRow( int y )
+{
+	const int w		= mResult->getWidth();
+	const int h		= mResult->getHeight();
+	const int aw	= mAO->getWidth();
+	const int ah	= mAO->getHeight();
+	const float scaleX = (float)aw / w, scaleY = (float)ah / h;
+	const int normalPower = std::max( mParams.normalPower, 0 );
+
+	float *out = mResult->getPixel( 0, y );
+	for ( int x = 0; x < w; ++x ) {
+		const float *nd = mNormalDepth->getPixel( x, y );
+		const float invSigma = 1.0f / ( mParams.depthSigma * std::max( nd[3], 1e-4f ) );
+
+		float fx = ( x + 0.5f ) * scaleX - 0.5f;
+		float fy = ( y + 0.5f ) * scaleY - 0.5f;
+		float xf = std::floor( fx ), yf = std::floor( fy );
+		float tx = fx - xf, ty = fy - yf;
+
+		float sum = 0.0f, weightSum = 0.0f;
+		float nearest = 0.0f, nearestDiff = 1e30f;
+		for ( int j = 0; j < 2; ++j ) {
+			int ay = std::min( std::max( (int)yf + j, 0 ), ah - 1 );
+			float wy = j ? ty : 1.0f - ty;
+			for ( int i = 0; i < 2; ++i ) {
+				int ax = std::min( std::max( (int)xf + i, 0 ), aw - 1 );
+				float wx = i ? tx : 1.0f - tx;
+
+				const float *g	= mGuide.getPixel( ax, ay );
+				float value		= *mAO->getPixel( ax, ay );
+				float depthDiff	= std::fabs( g[3] - nd[3] );
+				float normalDot	= std::max( g[0] * nd[0] + g[1] * nd[1] + g[2] * nd[2], 0.0f );
+
+				float k			= depthDiff * invSigma;
+				float normalW	= 1.0f;
+				for ( int p = 0; p < normalPower; ++p )
+					normalW *= normalDot;
+
+				float weight	= wx * wy * normalW / ( 1.0f + k * k );
+				sum			+= value * weight;
+				weightSum	+= weight;
+
+				if ( depthDiff < nearestDiff ) {
+					nearestDiff	= depthDiff;
+					nearest		= value;
+				}
+			}
+		}
+
+		//nothing similar around ( thin features ), the closest depth is the best guess
+		out[x] = weightSum > 1e-4f ? sum / weightSum : nearest;
+	}
+}
+
+/*
+ * @Description: clamp to edge bilinear upsample ( GL_LINEAR on the low res texture )
+ * @param: FloatImage low res AO, output size, FloatImage* result
+ * @return: none
+ */
+void BilateralUpsampler::upsampleBilinear( const FloatImage &ao, int width, int height, FloatImage *result )
+{
+	if ( result->getWidth() != width || result->getHeight() != height || result->getChannels() != 1 )
+		result->allocate( width, height, 1 );
+
+	for ( int y = 0; y < height; ++y )
+		for ( int x = 0; x < width; ++x )
+			ao.sampleBilinear( ( x + 0.5f ) / width, ( y + 0.5f ) / height, result->getPixel( x, y ) );
+}
+
+/*
+ * @Description: time and error of low res + upsampled AO against full res AO
+ * @param: SSAOEngine, FloatImage full res normal/depth, AO divisor ( 2 = half res, 4 = quarter res ... )
+ * @return: UpsampleReport
+ */
+UpsampleReport BilateralUpsampler::measure( const SSAOEngine &engine, const FloatImage &normalDepth, int divisor )
+{
+	const int w = normalDepth.getWidth();
+	const int h = normalDepth.getHeight();
+
+	UpsampleReport report;
+	report.divisor = divisor;
+	mNormalDepth = &normalDepth;
+
+	FloatImage reference( w, h, 1 );
+	ci::Timer timer( true );
+	RowJob fullJob( this, RowJob::SSAO, h, &engine, &reference );
+	mPool->parallelFor( fullJob.getNumTasks(), &fullJob );
+	report.fullResMs = timer.getSeconds() * 1000.0;
+
+	FloatImage lowRes( std::max( w / divisor, 1 ), std::max( h / divisor, 1 ), 1 );
+	timer.start();
+	RowJob lowJob( this, RowJob::SSAO, lowRes.getHeight(), &engine, &lowRes );
+	mPool->parallelFor( lowJob.getNumTasks(), &lowJob );
+	report.lowResMs = timer.getSeconds() * 1000.0;
+
+	FloatImage bilateral, bilinear;
+	timer.start();
+	upsample( normalDepth, lowRes, &bilateral );
+	report.upsampleMs = timer.getSeconds() * 1000.0;
+	upsampleBilinear( lowRes, w, h, &bilinear );
+
+	//edge pixels: depth jumps by more than 10% within one low res texel
+	double errLinear = 0.0, errBilateral = 0.0, edgeLinear = 0.0, edgeBilateral = 0.0;
+	int edges = 0;
+	for ( int y = 0; y < h; ++y ) {
+		for ( int x = 0; x < w; ++x ) {
+			float d = normalDepth.getPixel( x, y )[3];
+			float jump = 0.0f;
+			jump = std::max( jump, std::fabs( normalDepth.getPixel( std::max( x - divisor, 0 ), y )[3] - d ) );
+			jump = std::max( jump, std::fabs( normalDepth.getPixel( std::min( x + divisor, w - 1 ), y )[3] - d ) );
+			jump = std::max( jump, std::fabs( normalDepth.getPixel( x, std::max( y - divisor, 0 ) )[3] - d ) );
+			jump = std::max( jump, std::fabs( normalDepth.getPixel( x, std::min( y + divisor, h - 1 ) )[3] - d ) );
+
+			float ref	= *reference.getPixel( x, y );
+			double el	= std::fabs( *bilinear.getPixel( x, y ) - ref );
+			double eb	= std::fabs( *bilateral.getPixel( x, y ) - ref );
+			errLinear		+= el;
+			errBilateral	+= eb;
+			if ( jump > 0.1f * d ) {
+				edgeLinear		+= el;
+				edgeBilateral	+= eb;
+				++edges;
+			}
+		}
+	}
+
+	const double count = (double)w * h;
+	report.bilinearError		= errLinear / count;
+	report.bilateralError		= errBilateral / count;
+	report.bilinearEdgeError	= edges ? edgeLinear / edges : 0.0;
+	report.bilateralEdgeError	= edges ? edgeBilateral / edges : 0.0;
+	report.edgePixels			= edges;
+	return report;
+}
+
+} // namespace ssao
@@ -0,0 +1,159 @@
+#include "BlueNoise.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ssao {
+
+//xorshift32, same stream everywhere so the tiles are reproducible
+static inline unsigned int nextRandom( unsigned int *state )
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/*
+ * energy field of the pattern: energy[p] = sum over the set texels q of kernel( p - q ), wrapped around the tile
+ */
+class EnergyField
+{
+public:
+	EnergyField( int size, float sigma )
+	: mSize( size ), mEnergy( size * size, 0.0f ), mKernel( size * size )
+	{
+		for ( int dy = 0; dy < size; ++dy ) {
+			for ( int dx = 0; dx < size; ++dx ) {
+				int wx = std::min( dx, size - dx ), wy = std::min( dy, size - dy );
+				mKernel[dy * size + dx] = std::exp( -( wx * wx + wy * wy ) / ( 2.0f * sigma * sigma ) );
+			}
+		}
+	}
+
+	void add( size_t texel, float sign )
+	{
+		const int tx = (int)texel % mSize, ty = (int)texel / mSize;
+		for ( int y = 0; y < mSize; ++y ) {
+			const float *kernel = &mKernel[( ( y - ty + mSize ) % mSize ) * mSize];
+			float *energy = &mEnergy[y * mSize];
+			for ( int x = 0; x < mSize; ++x )
+				energy[x] += sign * kernel[( x - tx + mSize ) % mSize];
+		}
+	}
+
+	//set texel with the most energy ( tightest cluster ) or unset texel with the least ( largest void ), callers make sure there is one
+	size_t find( const std::vector<char> &pattern, bool set ) const
+	{
+		size_t best = pattern.size();
+		for ( size_t i = 0; i < pattern.size(); ++i ) {
+			if ( ( pattern[i] != 0 ) != set )
+				continue;
+			if ( best == pattern.size() || ( set ? mEnergy[i] > mEnergy[best] : mEnergy[i] < mEnergy[best] ) )
+				best = i;
+		}
+		return best;
+	}
+
+private:
+	int					mSize;
+	std::vector<float>	mEnergy, mKernel;
+};
+
+void generateBlueNoise( int size, float sigma, std::vector<int> *ranks )
+{
+	const int count = size * size;
+	std::vector<char> pattern( count, 0 );
+	EnergyField field( size, sigma );
+
+	//initial binary pattern: a tenth of the texels at random ...
+	unsigned int state = 0x2545F491u;
+	int ones = 0;
+	while ( ones < count / 10 ) {
+		size_t texel = nextRandom( &state ) % count;
+		if ( pattern[texel] )
+			continue;
+		pattern[texel] = 1;
+		field.add( texel, 1.0f );
+		++ones;
+	}
+
+	//... evened out by moving the tightest cluster into the largest void until that puts it back where it was
+	for ( int it = 0; it < count; ++it ) {
+		size_t cluster = field.find( pattern, true );
+		pattern[cluster] = 0;
+		field.add( cluster, -1.0f );
+
+		size_t gap = field.find( pattern, false );
+		pattern[gap] = 1;
+		field.add( gap, 1.0f );
+		if ( gap == cluster )
+			break;
+	}
+
+	ranks->assign( count, 0 );
+	std::vector<char> initial = pattern;
+	EnergyField initialField = field;
+
+	//ranks below the initial pattern: take its tightest clusters out first
+	for ( int rank = ones - 1; rank >= 0; --rank ) {
+		size_t cluster = field.find( pattern, true );
+		pattern[cluster] = 0;
+		field.add( cluster, -1.0f );
+		(*ranks)[cluster] = rank;
+	}
+
+	//ranks above: fill the largest voids ( past half full that is also the tightest cluster of the unset texels )
+	pattern = initial;
+	field = initialField;
+	for ( int rank = ones; rank < count; ++rank ) {
+		size_t gap = field.find( pattern, false );
+		pattern[gap] = 1;
+		field.add( gap, 1.0f );
+		(*ranks)[gap] = rank;
+	}
+}
+
+void generateWhiteNoise( int size, std::vector<unsigned char> *values )
+{
+	unsigned int state = 0x9E3779B9u;
+	values->resize( size * size );
+	for ( int i = 0; i < size * size; ++i )
+		(*values)[i] = (unsigned char)( nextRandom( &state ) >> 24 );
+}
+
+void buildRotationTile( const unsigned char *values, int size, std::vector<unsigned char> *rgb )
+{
+	const float twoPi = 6.28318531f;
+	rgb->resize( size * size * 3 );
+	for ( int i = 0; i < size * size; ++i ) {
+		//texel centers of the 256 steps, so 0 and 255 aren't the same angle
+		float angle = twoPi * ( values[i] + 0.5f ) / 256.0f;
+		(*rgb)[i * 3 + 0] = (unsigned char)( ( std::cos( angle ) * 0.5f + 0.5f ) * 255.0f + 0.5f );
+		(*rgb)[i * 3 + 1] = (unsigned char)( ( std::sin( angle ) * 0.5f + 0.5f ) * 255.0f + 0.5f );
+		(*rgb)[i * 3 + 2] = 128;
+	}
+}
+
+void buildRotationTile( const unsigned char *values, int size, FloatImage *tile )
+{
+	std::vector<unsigned char> rgb;
+	buildRotationTile( values, size, &rgb );
+
+	tile->allocate( size, size, 3 );
+	float *data = tile->getData();
+	for ( size_t i = 0; i < rgb.size(); ++i )
+		data[i] = rgb[i] / 255.0f;
+}
+
+void buildRandomNormalTile( int size, FloatImage *tile )
+{
+	tile->allocate( size, size, 3 );
+
+	unsigned int state = 0x9E3779B9u;
+	float *data = tile->getData();
+	for ( int i = 0; i < size * size * 3; ++i )
+		data[i] = ( nextRandom( &state ) & 0xFFFFFF ) / 16777215.0f;
+}
+
+} // namespace ssao
@@ -0,0 +1,73 @@
+//generated by tools/BlueNoiseGen.cpp, do not edit ( see BlueNoise.h )
+#include "BlueNoise.h"
+
+namespace ssao {
+
+const unsigned char BLUE_NOISE_TILE[BLUE_NOISE_SIZE * BLUE_NOISE_SIZE] = {
+	134,8,160,253,35,165,13,197,45,105,244,208,0,176,251,194,130,227,39,186,128,11,183,95,136,77,248,103,161,68,47,147,88,191,0,244,126,212,108,52,254,122,93,229,136,27,224,60,195,124,255,26,139,188,158,70,233,87,148,219,184,153,39,175,
+	210,69,116,201,82,222,64,123,155,18,169,131,79,120,43,160,93,18,75,238,55,213,112,63,205,153,56,189,23,233,114,13,235,166,141,98,59,14,226,163,3,206,38,164,73,208,110,244,79,18,157,73,231,4,100,47,171,207,7,76,126,16,250,92,
+	25,227,44,136,4,111,183,249,80,226,58,33,237,214,19,69,243,199,169,108,154,31,247,171,37,234,11,120,218,93,183,213,72,53,30,178,202,149,90,188,68,144,104,246,15,188,45,147,176,105,199,51,117,202,221,124,19,136,53,239,102,199,55,144,
+	187,85,166,239,194,150,51,30,139,204,111,152,191,97,145,181,123,48,138,3,205,90,142,15,127,97,199,144,59,157,37,136,103,205,119,251,77,41,239,116,33,225,176,55,126,159,95,4,216,41,235,89,165,30,81,179,243,106,187,155,27,226,170,113,
+	246,34,105,59,21,93,234,172,6,92,182,14,73,47,230,108,29,220,86,255,67,181,49,222,78,176,45,241,85,3,250,172,18,229,152,9,111,173,18,212,132,81,10,216,77,203,233,66,122,143,12,184,134,250,58,152,35,67,210,89,45,133,71,2,
+	152,125,223,178,130,202,68,122,213,42,242,132,207,165,16,201,64,157,191,40,126,234,111,198,154,231,17,108,192,212,74,115,48,87,192,67,216,137,87,54,184,251,155,114,35,139,23,185,249,78,204,62,101,19,190,94,226,140,10,255,163,194,98,212,
+	61,204,10,78,252,36,161,225,107,77,162,59,119,252,78,138,239,8,104,173,25,150,12,62,32,124,67,166,128,41,153,185,239,128,30,167,46,243,197,152,25,96,46,181,244,101,165,52,108,159,33,238,149,214,125,1,198,116,175,62,121,14,228,40,
+	183,93,161,47,145,98,19,54,147,197,28,220,2,104,43,172,92,129,231,71,218,95,169,250,102,183,213,247,21,89,225,9,61,210,143,227,102,2,117,73,231,128,202,69,0,224,86,211,8,223,128,176,46,73,170,247,52,82,218,33,236,80,148,113,
+	138,27,238,195,118,209,237,186,9,248,136,94,184,152,215,193,32,55,200,140,43,191,76,216,143,6,82,48,149,189,136,107,170,93,14,75,187,162,36,211,169,14,239,144,171,124,37,137,181,66,92,15,115,232,29,105,158,24,144,101,201,167,22,247,
+	83,217,107,68,0,173,82,127,102,68,170,35,238,63,20,120,248,166,14,114,244,0,130,53,36,201,161,101,233,63,28,249,44,201,241,124,51,254,133,60,109,84,40,106,56,197,72,235,25,149,253,188,208,83,142,60,196,234,178,49,132,68,189,53,
+	6,163,38,153,230,57,35,157,221,49,121,203,83,140,226,90,67,146,219,83,175,103,229,164,112,243,128,16,205,116,215,80,148,113,24,155,215,83,20,179,223,155,190,220,21,250,158,98,203,119,35,57,154,5,181,222,114,8,87,251,15,225,103,209,
+	178,255,130,192,97,141,250,203,23,180,234,10,110,45,164,4,189,101,24,196,60,150,25,206,88,59,186,73,174,40,164,0,187,64,173,39,96,191,147,237,48,6,127,76,177,114,12,51,174,79,226,100,128,243,94,32,136,68,207,123,163,38,149,118,
+	90,51,75,14,217,26,116,74,99,137,71,153,254,181,209,125,243,46,227,135,34,253,69,180,13,226,31,145,255,91,135,224,98,236,206,131,230,4,66,118,90,202,245,33,148,87,213,133,244,7,163,214,21,198,50,159,239,173,43,100,214,77,243,26,
+	144,208,233,119,159,64,169,194,3,225,43,198,22,96,59,29,156,112,77,168,118,212,98,140,117,157,210,103,11,58,201,30,123,49,13,73,110,162,212,35,171,142,103,62,195,233,37,186,106,65,140,45,171,70,111,219,80,21,192,141,1,176,56,195,
+	9,107,30,184,90,244,41,232,147,113,167,79,120,148,229,82,216,182,20,236,56,9,190,39,246,52,75,190,123,229,155,72,246,161,142,184,241,27,135,251,73,15,231,163,9,126,58,154,25,201,239,87,120,252,185,12,127,154,246,64,230,94,121,235,
+	67,172,136,46,203,10,131,87,59,190,16,235,205,41,174,131,12,64,144,204,89,157,231,78,168,2,136,239,43,179,106,7,190,84,219,41,94,58,197,100,181,216,51,115,209,81,255,93,219,125,35,178,1,146,39,99,208,48,113,30,202,137,39,160,
+	189,249,83,230,148,112,209,176,30,247,91,134,65,1,244,94,198,252,101,42,183,129,23,104,195,222,90,161,18,84,139,215,54,113,20,129,207,168,12,124,42,138,86,187,30,143,179,6,165,74,195,102,230,63,199,162,237,71,180,87,166,14,224,101,
+	27,126,5,61,168,24,72,223,106,154,49,218,182,109,150,53,32,163,126,3,240,68,214,147,58,118,36,208,64,199,251,27,164,231,176,249,75,147,230,69,239,23,155,247,65,222,45,109,232,54,147,19,213,129,82,26,135,5,212,123,249,74,196,51,
+	211,94,222,195,98,253,45,139,6,202,121,21,160,80,212,187,114,229,78,209,153,113,44,252,17,178,244,102,130,170,49,92,134,63,96,2,112,34,188,98,167,200,106,1,171,96,135,193,21,118,250,85,164,48,246,175,95,226,149,23,53,141,111,155,
+	71,175,144,34,121,185,159,84,239,175,73,251,39,227,13,70,144,19,173,59,31,179,88,200,135,73,151,6,227,24,117,191,212,37,151,201,53,217,133,8,54,223,72,131,214,19,245,68,154,207,32,185,111,8,206,117,36,58,186,104,173,230,3,243,
+	134,17,54,240,74,14,221,113,32,54,102,195,141,97,125,243,46,196,100,248,139,227,7,163,98,232,50,184,79,156,241,69,10,246,184,122,236,159,83,254,117,145,33,190,50,120,166,36,224,79,138,56,239,148,70,190,142,251,76,218,35,82,187,40,
+	227,200,110,156,206,135,60,196,165,232,131,17,171,58,205,156,83,221,129,14,91,204,69,41,126,27,201,113,217,43,99,176,143,106,82,28,71,17,206,44,180,88,244,159,78,234,90,188,104,4,171,202,95,40,228,22,106,164,7,131,203,159,125,98,
+	150,84,180,2,96,237,23,91,144,4,213,81,235,29,181,3,111,31,161,186,46,121,174,238,213,170,67,145,14,132,206,22,233,51,216,173,138,186,102,151,26,218,15,109,204,7,148,54,134,236,114,18,216,126,161,86,210,42,237,95,57,16,254,61,
+	213,32,247,64,170,43,181,217,70,118,177,43,152,116,88,254,208,59,232,74,245,148,19,80,107,4,254,89,228,165,59,86,127,162,7,115,249,57,222,123,72,192,132,60,175,40,210,253,26,194,63,155,77,183,0,241,56,117,189,149,223,112,195,25,
+	132,52,122,223,145,106,128,254,33,206,92,247,63,220,134,44,168,142,120,5,108,211,55,193,157,131,50,192,31,109,238,198,36,225,69,204,38,91,2,164,242,49,156,93,227,140,112,76,163,94,221,31,249,49,109,195,141,174,12,73,39,173,79,165,
+	236,191,90,21,207,75,9,150,58,165,21,109,185,9,199,75,17,94,193,218,38,179,96,243,34,225,101,150,75,182,1,153,103,184,140,99,159,193,232,35,106,206,8,249,29,66,187,10,129,45,177,137,91,149,224,70,29,85,233,207,137,242,6,102,
+	66,11,156,177,37,231,191,89,200,122,228,140,36,162,102,226,178,242,50,84,164,125,9,140,67,185,11,214,245,137,48,72,253,20,53,242,13,135,77,178,141,85,185,118,165,216,98,232,201,245,117,6,205,172,17,128,255,157,104,28,116,53,216,148,
+	199,111,252,134,58,118,163,44,245,1,73,211,85,241,57,147,34,127,155,25,253,63,222,201,88,167,123,63,24,115,210,168,124,89,210,176,66,111,214,55,19,219,41,73,135,18,48,147,62,24,82,223,66,39,101,211,48,186,61,195,161,81,178,33,
+	228,48,76,215,97,240,16,141,105,177,149,47,192,128,16,111,201,65,221,114,195,144,42,107,22,247,44,202,174,84,232,11,191,149,40,119,233,25,156,254,121,153,240,101,207,237,180,121,170,107,189,160,129,246,190,145,92,4,126,230,15,250,97,127,
+	144,172,16,193,27,185,79,210,59,30,235,115,23,221,176,248,88,3,184,96,15,80,174,228,157,132,80,229,101,155,38,106,62,220,15,160,87,205,44,99,193,61,4,172,33,65,90,1,212,35,239,51,11,110,76,22,236,177,214,72,143,43,208,0,
+	88,244,103,126,152,46,166,120,225,188,89,168,63,152,77,48,160,230,141,53,238,206,121,0,57,189,30,145,4,59,198,245,139,83,240,193,60,140,173,13,81,226,138,200,116,157,194,254,73,153,92,137,230,178,219,54,156,114,26,100,170,115,187,69,
+	160,41,209,63,229,91,250,7,74,132,12,255,105,204,9,123,209,29,120,168,32,149,68,250,94,217,109,196,255,176,117,21,164,47,129,105,1,217,122,244,183,112,43,75,245,18,138,39,126,220,17,203,68,37,165,127,85,38,248,198,54,237,29,221,
+	18,183,136,8,200,113,34,191,159,47,200,143,36,229,138,184,100,72,251,85,217,103,185,41,167,139,69,17,127,77,225,93,215,186,29,171,234,77,34,59,159,24,211,169,98,52,224,105,183,55,170,116,150,99,2,241,193,162,68,137,12,90,146,123,
+	96,53,239,81,172,56,146,216,99,242,79,173,57,94,25,241,43,175,16,195,60,10,130,204,25,236,49,222,154,35,52,134,5,75,249,55,151,196,100,223,133,91,238,8,146,208,167,78,7,243,85,24,251,184,208,62,24,215,123,231,177,215,62,253,
+	168,217,116,150,24,241,127,66,28,121,21,223,129,196,157,64,218,148,106,129,229,157,241,80,112,160,87,184,100,203,172,238,156,200,119,93,19,125,167,10,200,48,119,188,64,124,27,234,150,198,133,217,50,79,137,109,147,91,5,47,107,157,37,194,
+	3,70,35,227,98,197,3,181,228,163,206,104,1,233,81,117,7,201,47,170,28,93,47,179,6,208,124,22,244,10,115,62,100,39,146,211,230,43,253,71,151,228,79,36,252,92,185,45,114,61,34,103,172,12,235,42,178,254,166,75,190,16,85,113,
+	154,132,204,179,46,76,158,111,86,48,140,71,186,38,169,249,134,88,238,74,192,119,216,146,61,248,40,150,75,141,214,28,179,226,13,63,177,85,190,109,27,176,138,216,162,12,135,215,84,168,237,142,212,119,196,71,218,34,116,206,242,142,228,207,
+	248,89,13,110,143,254,212,38,237,194,18,246,151,55,100,20,181,35,213,140,2,254,32,77,192,103,169,224,52,189,89,252,127,81,194,112,142,3,131,54,240,89,5,57,107,200,65,247,20,191,1,64,87,30,151,102,15,135,88,57,22,122,66,44,
+	185,55,234,167,21,60,129,14,146,62,125,87,221,115,202,224,62,157,108,56,160,97,175,133,229,26,84,197,108,32,162,6,151,49,245,164,36,236,199,156,212,125,192,146,242,34,177,97,145,122,225,162,250,188,55,244,200,173,235,150,182,98,167,26,
+	101,139,215,78,196,105,186,165,95,219,170,33,178,8,142,78,125,246,15,195,231,67,209,12,113,55,138,3,242,130,228,71,204,109,18,92,220,67,97,17,42,65,233,19,82,120,156,48,209,30,93,44,130,10,169,123,79,50,1,209,42,246,198,127,
+	5,162,37,121,244,43,226,73,249,3,104,209,74,255,45,189,29,172,86,132,28,116,47,167,246,187,156,210,63,172,97,44,180,232,138,58,188,122,174,251,114,183,97,168,203,222,4,233,71,173,113,197,77,228,99,20,160,222,108,129,86,13,76,220,
+	235,188,70,15,155,91,24,123,51,202,154,53,123,161,96,228,112,211,51,219,177,243,148,92,70,220,41,87,122,17,218,145,24,78,169,209,8,153,33,78,207,151,27,132,42,68,111,189,133,248,8,218,145,60,203,238,36,144,64,177,231,161,143,61,
+	117,92,205,137,221,173,210,145,179,31,133,237,13,215,24,150,68,7,155,99,72,4,199,33,130,9,104,182,255,54,191,106,247,125,33,101,243,51,223,136,2,56,221,79,237,180,149,21,86,56,160,39,182,25,135,177,83,193,250,23,53,104,204,40,
+	170,26,241,49,81,6,111,66,241,95,76,193,110,182,54,242,126,188,251,38,141,225,110,179,206,152,232,23,140,165,82,0,199,65,222,145,82,118,190,102,242,194,119,158,9,99,50,240,203,106,227,123,94,252,107,52,119,13,97,139,220,181,16,253,
+	67,151,108,176,126,248,42,190,11,166,224,25,66,141,92,171,34,78,203,116,169,25,84,57,248,46,117,76,213,36,226,158,135,45,179,13,202,167,23,66,163,88,33,251,199,135,218,165,34,143,16,194,68,154,5,218,236,163,205,74,32,121,87,133,
+	185,1,224,29,196,71,155,227,136,107,45,154,250,200,2,224,146,103,11,61,212,240,127,161,17,93,169,189,59,100,119,27,236,91,112,249,69,42,236,141,15,180,51,108,66,24,82,118,63,180,80,234,47,210,174,74,39,131,55,229,150,198,50,227,
+	100,201,60,95,142,219,22,87,56,208,181,128,86,37,115,64,207,180,237,152,91,42,184,74,219,143,230,11,133,245,196,70,175,210,22,158,131,216,86,198,121,234,207,150,175,231,194,1,254,213,126,162,29,120,91,145,198,102,2,174,108,240,12,145,
+	38,123,235,167,46,107,180,124,247,19,79,9,214,158,232,134,17,52,122,23,194,139,5,202,107,33,67,204,44,168,6,147,52,129,82,188,3,104,152,30,61,99,7,130,29,94,160,139,101,48,11,99,247,192,14,238,28,183,254,81,24,66,188,80,
+	211,152,19,83,255,5,199,38,170,150,232,189,105,51,175,95,252,81,166,231,69,112,253,50,173,125,247,151,112,77,217,96,253,30,225,61,238,47,175,253,211,159,81,217,57,245,38,69,198,171,146,219,65,137,52,214,115,60,136,158,220,130,164,250,
+	7,71,174,208,128,158,74,221,96,65,118,31,247,72,20,192,36,144,203,100,34,216,154,94,223,9,83,181,17,237,137,21,181,151,109,164,197,120,75,19,131,41,241,180,110,189,128,220,25,233,83,37,179,109,159,84,168,204,41,96,192,31,52,110,
+	132,237,105,29,56,230,116,23,139,207,50,143,168,124,210,153,110,222,2,57,187,169,14,65,134,197,47,99,209,60,191,118,72,215,42,89,15,143,227,190,110,171,69,22,151,5,86,164,113,59,130,205,3,231,31,248,7,76,240,15,117,233,89,183,
+	220,42,197,142,178,95,43,245,183,1,229,90,218,8,86,243,49,72,130,245,141,79,120,242,30,149,233,164,129,31,158,46,236,5,137,206,243,37,97,62,0,204,138,99,235,210,51,250,11,188,240,96,149,71,187,101,131,151,216,177,71,200,152,26,
+	166,97,67,246,8,201,133,161,58,102,163,27,193,58,137,28,185,162,198,107,18,230,44,205,183,108,68,19,249,89,223,104,197,82,174,61,113,182,218,158,245,50,222,35,124,74,196,138,103,157,28,52,174,127,222,55,197,22,108,44,142,0,242,62,
+	193,11,160,121,84,225,20,76,204,128,247,75,112,238,172,99,228,11,85,41,211,177,98,155,81,6,214,116,193,64,175,12,153,124,248,26,149,78,13,126,90,149,80,184,161,15,171,36,226,76,208,118,254,40,12,156,86,224,66,167,211,129,83,115,
+	253,140,211,37,168,55,187,113,223,14,47,183,148,39,206,64,144,115,255,152,70,124,23,57,252,133,172,45,148,26,134,239,58,37,100,190,223,49,172,210,31,192,10,255,56,112,242,95,55,132,182,20,88,215,109,179,240,32,122,249,96,29,217,45,
+	21,90,60,238,104,145,252,34,154,93,134,214,5,89,125,16,215,50,179,26,235,164,195,221,103,32,228,85,241,103,217,80,205,169,230,2,86,119,251,65,108,233,133,102,205,152,22,187,215,0,237,63,163,195,73,135,50,147,182,10,57,189,148,176,
+	225,131,178,26,194,6,88,178,54,239,170,70,252,191,154,235,80,193,97,136,53,90,7,139,180,69,153,199,2,181,42,115,20,143,65,130,158,202,20,140,163,47,72,177,37,220,78,144,116,166,93,146,122,31,229,3,98,212,72,203,132,235,105,74,
+	49,111,232,76,119,219,136,70,201,23,105,33,117,58,27,171,39,128,0,226,202,115,246,49,213,18,117,50,129,67,161,194,255,94,187,23,240,44,95,182,4,200,224,16,92,130,59,234,31,50,203,17,244,56,185,158,251,27,114,159,84,40,4,167,
+	199,11,156,209,52,166,20,234,121,146,231,206,162,224,91,110,248,208,159,71,169,28,79,127,160,95,235,165,207,245,91,14,127,41,211,110,170,77,221,114,245,88,118,147,246,174,10,191,85,252,176,105,212,81,132,109,64,171,228,16,246,179,219,141,
+	251,70,35,138,96,248,45,92,186,4,84,46,137,8,199,143,67,18,106,40,236,146,186,229,39,196,74,11,104,32,142,232,75,154,227,60,31,146,192,56,34,156,60,190,40,107,223,158,114,138,70,41,161,9,221,38,200,92,52,143,107,67,122,89,
+	182,106,236,188,1,196,114,160,211,57,175,101,187,72,243,46,182,225,139,189,93,9,61,110,16,252,131,185,224,62,178,46,198,6,88,180,122,250,8,134,174,231,22,213,82,141,66,28,209,5,228,125,192,95,142,238,22,125,217,186,32,207,51,18,
+	147,46,166,80,128,65,227,26,77,255,119,234,22,124,157,28,118,83,53,253,120,203,221,168,85,151,58,29,155,119,219,102,165,135,241,19,205,97,69,214,105,76,131,162,2,196,249,99,53,186,153,21,241,54,169,75,182,153,0,80,236,133,162,229,
+	28,121,222,20,213,177,40,148,130,12,159,38,197,218,85,232,172,207,5,166,32,70,132,48,193,115,214,90,240,7,81,25,208,62,110,153,49,166,234,20,197,44,242,111,220,43,120,174,234,83,109,63,205,120,13,213,104,56,253,167,100,10,197,84,
+	240,191,95,57,142,103,240,87,217,184,65,94,146,54,108,13,61,147,105,219,86,158,242,27,226,0,175,40,133,202,173,252,124,38,220,78,186,31,139,84,151,182,17,62,180,88,156,10,140,37,215,171,91,42,248,134,28,194,117,36,65,225,114,61
+};
+
+} // namespace ssao
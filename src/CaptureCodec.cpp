@@ -0,0 +1,184 @@
+#include "CaptureCodec.h"
+
+#include <stdint.h>
+#include <cstring>
+#include <fstream>
+
+namespace ssao {
+
+static const uint32_t FCAP_MAGIC	= 0x50414346;	//"FCAP" little endian
+static const uint32_t FCAP_VERSION	= 1;
+
+//PackBits: a header byte h < 128 is followed by h + 1 literal bytes, h > 128 by one byte repeated 257 - h times
+static const size_t PACKBITS_MAX_RUN = 128;
+
+struct CaptureFileHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	width, height, channels, bytesPerChannel;
+	uint32_t	frame;
+	uint32_t	encodedBytes;
+};
+
+static void packBits( const unsigned char *in, size_t n, std::vector<unsigned char> *out )
+{
+	size_t i = 0;
+	while ( i < n ) {
+		size_t run = 1;
+		while ( i + run < n && run < PACKBITS_MAX_RUN && in[i + run] == in[i] )
+			++run;
+		//2 byte runs cost as much as literals and would split them up
+		if ( run >= 3 ) {
+			out->push_back( (unsigned char)( 257 - run ) );
+			out->push_back( in[i] );
+			i += run;
+			continue;
+		}
+
+		size_t begin = i;
+		while ( i < n && i - begin < PACKBITS_MAX_RUN ) {
+			if ( i + 2 < n && in[i] == in[i + 1] && in[i] == in[i + 2] )
+				break;
+			++i;
+		}
+		out->push_back( (unsigned char)( i - begin - 1 ) );
+		out->insert( out->end(), in + begin, in + i );
+	}
+}
+
+static bool unpackBits( const unsigned char *in, size_t n, unsigned char *out, size_t outSize )
+{
+	size_t i = 0, o = 0;
+	while ( i < n ) {
+		unsigned int header = in[i++];
+		if ( header < 128 ) {
+			size_t count = header + 1;
+			if ( i + count > n || o + count > outSize )
+				return false;
+			std::memcpy( out + o, in + i, count );
+			i += count;
+			o += count;
+		}
+		else if ( header > 128 ) {
+			size_t count = 257 - header;
+			if ( i >= n || o + count > outSize )
+				return false;
+			std::memset( out + o, in[i++], count );
+			o += count;
+		}
+		else
+			return false;
+	}
+	return o == outSize;
+}
+
+/*
+ * @Description: byte planes, delta along each plane, PackBits
+ * @param: pixels ( target.getBytes() ), CaptureTarget, encoded* ( replaced )
+ * @return: none
+ */
+void encodeCapture( const unsigned char *pixels, const CaptureTarget &target, std::vector<unsigned char> *encoded )
+{
+	const size_t numPixels	= (size_t)target.width * target.height;
+	const int stride		= target.channels * target.bytesPerChannel;
+
+	std::vector<unsigned char> planes( target.getBytes() );
+	for ( int p = 0; p < stride; ++p ) {
+		unsigned char *plane	= planes.empty() ? 0 : &planes[p * numPixels];
+		unsigned char previous	= 0;
+		for ( size_t i = 0; i < numPixels; ++i ) {
+			unsigned char value = pixels[i * stride + p];
+			plane[i]	= (unsigned char)( value - previous );
+			previous	= value;
+		}
+	}
+
+	encoded->clear();
+	encoded->reserve( planes.size() / 4 );
+	if ( !planes.empty() )
+		packBits( &planes[0], planes.size(), encoded );
+}
+
+bool decodeCapture( const unsigned char *encoded, size_t size, const CaptureTarget &target, std::vector<unsigned char> *pixels )
+{
+	const size_t numPixels	= (size_t)target.width * target.height;
+	const int stride		= target.channels * target.bytesPerChannel;
+
+	std::vector<unsigned char> planes( target.getBytes() );
+	if ( planes.empty() || !unpackBits( encoded, size, &planes[0], planes.size() ) )
+		return false;
+
+	pixels->resize( planes.size() );
+	for ( int p = 0; p < stride; ++p ) {
+		const unsigned char *plane	= &planes[p * numPixels];
+		unsigned char value			= 0;
+		for ( size_t i = 0; i < numPixels; ++i ) {
+			value = (unsigned char)( value + plane[i] );
+			(*pixels)[i * stride + p] = value;
+		}
+	}
+	return true;
+}
+
+bool writeCaptureFile( const std::string &path, const CaptureTarget &target, int frame, const std::vector<unsigned char> &encoded )
+{
+	CaptureFileHeader header;
+	header.magic			= FCAP_MAGIC;
+	header.version			= FCAP_VERSION;
+	header.width			= (uint32_t)target.width;
+	header.height			= (uint32_t)target.height;
+	header.channels			= (uint32_t)target.channels;
+	header.bytesPerChannel	= (uint32_t)target.bytesPerChannel;
+	header.frame			= (uint32_t)frame;
+	header.encodedBytes		= (uint32_t)encoded.size();
+
+	std::ofstream out( path.c_str(), std::ios::binary | std::ios::trunc );
+	out.write( (const char*)&header, sizeof( header ) );
+	if ( !encoded.empty() )
+		out.write( (const char*)&encoded[0], encoded.size() );
+	return (bool)out;
+}
+
+/*
+ * @Description: load and decode a .cap, anything that is not one fails and leaves the outputs alone
+ * @param: path, CaptureTarget* ( size and format ), frame*, pixels*
+ * @return: bool
+ */
+bool readCaptureFile( const std::string &path, CaptureTarget *target, int *frame, std::vector<unsigned char> *pixels )
+{
+	std::ifstream in( path.c_str(), std::ios::binary );
+	CaptureFileHeader header;
+	if ( !in.read( (char*)&header, sizeof( header ) ) || header.magic != FCAP_MAGIC || header.version != FCAP_VERSION
+		 || header.width == 0 || header.height == 0 || header.channels == 0 || header.channels > 4
+		 || ( header.bytesPerChannel != 1 && header.bytesPerChannel != 4 ) )
+		return false;
+
+	CaptureTarget loaded( target->name, (int)header.width, (int)header.height, (int)header.channels, (int)header.bytesPerChannel );
+	std::vector<unsigned char> encoded( header.encodedBytes );
+	std::vector<unsigned char> decoded;
+	if ( encoded.empty() || !in.read( (char*)&encoded[0], encoded.size() ) || !decodeCapture( &encoded[0], encoded.size(), loaded, &decoded ) )
+		return false;
+
+	*target	= loaded;
+	*frame	= (int)header.frame;
+	pixels->swap( decoded );
+	return true;
+}
+
+void captureToFloatImage( const CaptureTarget &target, const std::vector<unsigned char> &pixels, FloatImage *image )
+{
+	image->allocate( target.width, target.height, target.channels );
+	const size_t count = (size_t)target.width * target.height * target.channels;
+	if ( pixels.size() < target.getBytes() || !count )
+		return;
+
+	float *dst = image->getData();
+	if ( target.bytesPerChannel == 4 )
+		std::memcpy( dst, &pixels[0], count * sizeof( float ) );
+	else
+		for ( size_t i = 0; i < count; ++i )
+			dst[i] = pixels[i] / 255.0f;
+}
+
+} // namespace ssao
@@ -0,0 +1,81 @@
+#include "ChangeTracker.h"
+#include "ShaderCache.h"
+
+namespace ssao {
+
+/*
+ * @Description: constructor, the first endFrame() is always dirty
+ * @param: none
+ * @return: none
+ */
+ChangeTracker::ChangeTracker()
+: mHasPrevious( false ), mInvalid( true ), mDirty( true ), mSettleFrames( 0 ), mSettleLeft( 0 ), mCleanFrames( 0 )
+{}
+
+int ChangeTracker::addChannel( const std::string &name )
+{
+	Channel channel;
+	channel.name		= name;
+	channel.hash		= FNV_OFFSET_BASIS;
+	channel.lastHash	= FNV_OFFSET_BASIS;
+	channel.changed		= false;
+
+	mChannels.push_back( channel );
+	mInvalid = true;
+	return (int)mChannels.size() - 1;
+}
+
+void ChangeTracker::beginFrame()
+{
+	for ( size_t c = 0; c < mChannels.size(); ++c )
+		mChannels[c].hash = FNV_OFFSET_BASIS;
+}
+
+void ChangeTracker::add( int channel, const void *data, size_t size )
+{
+	mChannels[channel].hash = hashFnv1a( data, size, mChannels[channel].hash );
+}
+
+/*
+ * @Description: compare this frame's channels with last frame's and run the settle countdown
+ * @param: none
+ * @return: bool ( true = render, false = last frame's results still hold )
+ */
+bool ChangeTracker::endFrame()
+{
+	bool changed = mInvalid;
+	for ( size_t c = 0; c < mChannels.size(); ++c ) {
+		Channel &channel	= mChannels[c];
+		channel.changed		= !mHasPrevious || channel.hash != channel.lastHash;
+		channel.lastHash	= channel.hash;
+		changed				= changed || channel.changed;
+	}
+	mHasPrevious	= true;
+	mInvalid		= false;
+
+	if ( changed )
+		mSettleLeft = mSettleFrames;
+	else if ( mSettleLeft > 0 ) {
+		--mSettleLeft;
+		changed = true;
+	}
+
+	mDirty			= changed;
+	mCleanFrames	= mDirty ? 0 : mCleanFrames + 1;
+	return mDirty;
+}
+
+std::string ChangeTracker::getChangedNames() const
+{
+	std::string names;
+	for ( size_t c = 0; c < mChannels.size(); ++c ) {
+		if ( !mChannels[c].changed )
+			continue;
+		if ( !names.empty() )
+			names += ", ";
+		names += mChannels[c].name;
+	}
+	return names;
+}
+
+} // namespace ssao
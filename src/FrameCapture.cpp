@@ -0,0 +1,233 @@
+#include "FrameCapture.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ssao {
+
+CaptureRing::CaptureRing( int slots, int latency )
+: mSlotFrames( std::max( slots, 1 ), -1 ), mOldest( 0 ), mInFlight( 0 )
+{
+	mLatency = std::min( std::max( latency, 0 ), (int)mSlotFrames.size() - 1 );
+}
+
+int CaptureRing::acquire( int frame )
+{
+	if ( mInFlight == (int)mSlotFrames.size() )
+		return -1;
+	int slot = ( mOldest + mInFlight ) % (int)mSlotFrames.size();
+	mSlotFrames[slot] = frame;
+	++mInFlight;
+	return slot;
+}
+
+int CaptureRing::getReady( int frame, bool flush ) const
+{
+	if ( !mInFlight )
+		return -1;
+	return flush || frame - mSlotFrames[mOldest] >= mLatency ? mOldest : -1;
+}
+
+/*
+ * @Description: free a slot, slots come back oldest first ( getReady() only ever returns the oldest )
+ * @param: slot
+ * @return: none
+ */
+void CaptureRing::release( int slot )
+{
+	if ( !mInFlight || slot != mOldest )
+		return;
+	mSlotFrames[slot]	= -1;
+	mOldest				= ( mOldest + 1 ) % (int)mSlotFrames.size();
+	--mInFlight;
+}
+
+void CaptureRing::reset()
+{
+	std::fill( mSlotFrames.begin(), mSlotFrames.end(), -1 );
+	mOldest		= 0;
+	mInFlight	= 0;
+}
+
+/*
+ * @Description: constructor, nothing is allocated or started before start()
+ * @param: ReadbackDevice* ( borrowed ), ring slots, latency in frames, writer threads, frames that may wait for them
+ * @return: none
+ */
+FrameCapture::FrameCapture( ReadbackDevice *device, int slots, int latency, int writerThreads, int maxQueued )
+: mDevice( device ), mRing( slots, latency ), mSlotTargets( std::max( slots, 1 ) ), mNumWriters( std::max( writerThreads, 1 ) ),
+  mMaxQueued( std::max( maxQueued, 1 ) ), mFrame( 0 ), mCapturing( false ), mFree( 0 ), mQueue( 0 )
+{}
+
+FrameCapture::~FrameCapture()
+{
+	stop();
+}
+
+void FrameCapture::start( const std::string &directory )
+{
+	stop();
+
+	mDirectory	= directory;
+	mFrame		= 0;
+	mRing.reset();
+	{
+		std::lock_guard<std::mutex> lock( mStatsMutex );
+		mStats = CaptureStats();
+	}
+
+	mFrames.assign( mMaxQueued, Frame() );
+	mFree	= new BoundedQueue<Frame*>( mMaxQueued );
+	mQueue	= new BoundedQueue<Frame*>( mMaxQueued );
+	for ( size_t i = 0; i < mFrames.size(); ++i )
+		mFree->push( &mFrames[i] );
+	for ( int i = 0; i < mNumWriters; ++i )
+		mWriters.push_back( new std::thread( &FrameCapture::writerLoop, this ) );
+	mCapturing = true;
+}
+
+void FrameCapture::stop()
+{
+	if ( !mCapturing )
+		return;
+
+	int slot;
+	while ( ( slot = mRing.getReady( mFrame, true ) ) >= 0 )
+		collect( slot, true );
+
+	mQueue->close();
+	for ( size_t i = 0; i < mWriters.size(); ++i ) {
+		mWriters[i]->join();
+		delete mWriters[i];
+	}
+	mWriters.clear();
+	delete mQueue;
+	delete mFree;
+	mQueue		= 0;
+	mFree		= 0;
+	mFrames.clear();
+	mCapturing	= false;
+}
+
+/*
+ * @Description: once per frame after the targets are drawn: copy out what is ready, start this frame's readbacks
+ * @param: none
+ * @return: none
+ */
+void FrameCapture::captureFrame()
+{
+	if ( !mCapturing )
+		return;
+
+	ci::Timer timer( true );
+	int slot;
+	while ( ( slot = mRing.getReady( mFrame ) ) >= 0 && mDevice->isReadbackDone( slot ) )
+		collect( slot, false );
+
+	slot = mRing.acquire( mFrame );
+	if ( slot >= 0 ) {
+		mSlotTargets[slot] = mTargets;
+		mDevice->startReadback( slot, mTargets );
+	}
+	++mFrame;
+
+	std::lock_guard<std::mutex> lock( mStatsMutex );
+	if ( slot >= 0 )
+		++mStats.started;
+	else
+		++mStats.droppedRing;
+	mStats.readbackMs += timer.getSeconds() * 1000.0;
+}
+
+CaptureStats FrameCapture::getStats()
+{
+	std::lock_guard<std::mutex> lock( mStatsMutex );
+	return mStats;
+}
+
+void FrameCapture::collect( int slot, bool wait )
+{
+	Frame *frame = 0;
+	bool haveFrame = wait ? mFree->pop( &frame ) : mFree->tryPop( &frame );
+	if ( !haveFrame ) {
+		mRing.release( slot );
+		std::lock_guard<std::mutex> lock( mStatsMutex );
+		++mStats.droppedBacklog;
+		return;
+	}
+
+	const std::vector<CaptureTarget> &targets = mSlotTargets[slot];
+	frame->frame	= mRing.getSlotFrame( slot );
+	frame->targets	= targets;
+	frame->pixels.resize( targets.size() );
+	bool ok = true;
+	for ( size_t t = 0; t < targets.size(); ++t ) {
+		frame->pixels[t].resize( targets[t].getBytes() );
+		if ( !frame->pixels[t].empty() )
+			ok = mDevice->finishReadback( slot, (int)t, &frame->pixels[t][0] ) && ok;
+	}
+	mRing.release( slot );
+
+	if ( !ok ) {
+		mFree->push( frame );
+		std::lock_guard<std::mutex> lock( mStatsMutex );
+		++mStats.failed;
+		return;
+	}
+	//there are only as many frames as the queue holds, this never waits
+	mQueue->push( frame );
+}
+
+void FrameCapture::writerLoop()
+{
+	std::vector<unsigned char> encoded;
+	Frame *frame = 0;
+	while ( mQueue->pop( &frame ) ) {
+		writeFrame( frame, &encoded );
+		mFree->push( frame );
+	}
+}
+
+/*
+ * @Description: encode and write every target of a frame, writer thread
+ * @param: Frame*, encoded* ( scratch )
+ * @return: none
+ */
+void FrameCapture::writeFrame( Frame *frame, std::vector<unsigned char> *encoded )
+{
+	double encodeMs = 0.0, writeMs = 0.0;
+	size_t rawBytes = 0, encodedBytes = 0;
+	bool ok = true;
+	for ( size_t t = 0; t < frame->targets.size(); ++t ) {
+		const CaptureTarget &target = frame->targets[t];
+		if ( frame->pixels[t].empty() )
+			continue;
+
+		ci::Timer timer( true );
+		encodeCapture( &frame->pixels[t][0], target, encoded );
+		encodeMs += timer.getSeconds() * 1000.0;
+
+		char number[16];
+		std::sprintf( number, "_%06d.cap", frame->frame );
+		timer.start();
+		ok = writeCaptureFile( mDirectory + target.name + number, target, frame->frame, *encoded ) && ok;
+		writeMs += timer.getSeconds() * 1000.0;
+
+		rawBytes		+= frame->pixels[t].size();
+		encodedBytes	+= encoded->size();
+	}
+
+	std::lock_guard<std::mutex> lock( mStatsMutex );
+	if ( ok )
+		++mStats.written;
+	else
+		++mStats.failed;
+	mStats.rawBytes		+= rawBytes;
+	mStats.encodedBytes	+= encodedBytes;
+	mStats.encodeMs		+= encodeMs;
+	mStats.writeMs		+= writeMs;
+}
+
+} // namespace ssao
@@ -0,0 +1,288 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+
+namespace ssao {
+
+static const char* formatName( TextureDesc::Format format )
+{
+	switch ( format ) {
+		case TextureDesc::FORMAT_RGBA8:		return "RGBA8";
+		case TextureDesc::FORMAT_RGBA16F:	return "RGBA16F";
+		case TextureDesc::FORMAT_RGBA32F:	return "RGBA32F";
+	}
+	return "?";
+}
+
+/*
+ * @Description: constructor
+ * @param: none
+ * @return: none
+ */
+FrameGraph::FrameGraph()
+: mCompiled( false ), mObserver( 0 )
+{}
+
+void FrameGraph::clear()
+{
+	mPasses.clear();
+	mResources.clear();
+	mOrder.clear();
+	mPhysical.clear();
+	mErrors.clear();
+	mCompiled = false;
+}
+
+FrameGraph::ResourceId FrameGraph::createTexture( const std::string &name, const TextureDesc &desc )
+{
+	Resource res;
+	res.name		= name;
+	res.desc		= desc;
+	res.imported	= false;
+	res.output		= false;
+	res.persistent	= false;
+	res.firstUse	= -1;
+	res.lastUse		= -1;
+	res.physical	= -1;
+
+	mResources.push_back( res );
+	mCompiled = false;
+	return (ResourceId)mResources.size() - 1;
+}
+
+FrameGraph::ResourceId FrameGraph::importTexture( const std::string &name, const TextureDesc &desc )
+{
+	ResourceId id = createTexture( name, desc );
+	mResources[id].imported = true;
+	return id;
+}
+
+FrameGraph::PassId FrameGraph::addPass( const std::string &name, const ExecutorRef &executor )
+{
+	Pass pass;
+	pass.name		= name;
+	pass.executor	= executor;
+	pass.sideEffect	= false;
+	pass.cacheable	= false;
+	pass.culled		= false;
+
+	mPasses.push_back( pass );
+	mCompiled = false;
+	return (PassId)mPasses.size() - 1;
+}
+
+void FrameGraph::read( PassId pass, ResourceId resource )
+{
+	mPasses[pass].reads.push_back( resource );
+	mCompiled = false;
+}
+
+void FrameGraph::write( PassId pass, ResourceId resource )
+{
+	mPasses[pass].writes.push_back( resource );
+	mCompiled = false;
+}
+
+void FrameGraph::setSideEffect( PassId pass, bool sideEffect )
+{
+	mPasses[pass].sideEffect = sideEffect;
+	mCompiled = false;
+}
+
+void FrameGraph::setCacheable( PassId pass, bool cacheable )
+{
+	mPasses[pass].cacheable = cacheable;
+	mCompiled = false;
+}
+
+void FrameGraph::markOutput( ResourceId resource )
+{
+	mResources[resource].output = true;
+	mCompiled = false;
+}
+
+/*
+ * @Description: cull, order, compute lifetimes and alias transient resources
+ * @param: none
+ * @return: bool ( false if the declared passes are inconsistent, see getErrors() )
+ */
+bool FrameGraph::compile()
+{
+	mOrder.clear();
+	mPhysical.clear();
+	mErrors.clear();
+
+	//every read must see an earlier write ( or an imported resource )
+	std::vector<bool> written( mResources.size(), false );
+	for ( size_t p = 0; p < mPasses.size(); ++p ) {
+		const Pass &pass = mPasses[p];
+		for ( size_t r = 0; r < pass.reads.size(); ++r ) {
+			ResourceId res = pass.reads[r];
+			if ( !written[res] && !mResources[res].imported )
+				mErrors.push_back( "pass '" + pass.name + "' reads '" + mResources[res].name + "' before anything writes it" );
+		}
+		for ( size_t w = 0; w < pass.writes.size(); ++w )
+			written[pass.writes[w]] = true;
+	}
+
+	//walk backwards from the outputs, a pass survives if anything still needed comes out of it
+	std::vector<bool> needed( mResources.size(), false );
+	for ( size_t r = 0; r < mResources.size(); ++r )
+		needed[r] = mResources[r].output;
+
+	for ( int p = (int)mPasses.size() - 1; p >= 0; --p ) {
+		Pass &pass = mPasses[p];
+		bool alive = pass.sideEffect;
+		for ( size_t w = 0; w < pass.writes.size() && !alive; ++w )
+			alive = needed[pass.writes[w]];
+
+		pass.culled = !alive;
+		if ( alive ) {
+			for ( size_t r = 0; r < pass.reads.size(); ++r )
+				needed[pass.reads[r]] = true;
+		}
+	}
+
+	for ( size_t p = 0; p < mPasses.size(); ++p )
+		if ( !mPasses[p].culled )
+			mOrder.push_back( (PassId)p );
+
+	//lifetimes in execution order
+	for ( size_t r = 0; r < mResources.size(); ++r ) {
+		mResources[r].firstUse		= -1;
+		mResources[r].lastUse		= -1;
+		mResources[r].physical		= -1;
+		mResources[r].persistent	= false;
+	}
+	for ( size_t i = 0; i < mOrder.size(); ++i ) {
+		const Pass &pass = mPasses[mOrder[i]];
+		for ( int k = 0; k < 2; ++k ) {
+			const std::vector<ResourceId> &list = ( k == 0 ) ? pass.writes : pass.reads;
+			for ( size_t j = 0; j < list.size(); ++j ) {
+				Resource &res = mResources[list[j]];
+				if ( res.firstUse < 0 )
+					res.firstUse = (int)i;
+				res.lastUse = (int)i;
+			}
+		}
+	}
+
+	//what a cacheable pass hands to a pass that always runs has to survive until next frame's reader
+	std::vector<bool> cachedWrite( mResources.size(), false );
+	for ( size_t i = 0; i < mOrder.size(); ++i ) {
+		const Pass &pass = mPasses[mOrder[i]];
+		if ( pass.cacheable ) {
+			for ( size_t w = 0; w < pass.writes.size(); ++w )
+				cachedWrite[pass.writes[w]] = true;
+		}
+		else {
+			for ( size_t r = 0; r < pass.reads.size(); ++r )
+				if ( cachedWrite[pass.reads[r]] && !mResources[pass.reads[r]].imported )
+					mResources[pass.reads[r]].persistent = true;
+		}
+	}
+
+	//interval allocation: transient resources sorted by first use, reuse any physical target that matches and is already dead.
+	//persistent resources live over the whole frame so they never share
+	const int frameEnd = (int)mOrder.size();
+	std::vector< std::pair<int, ResourceId> > byStart;
+	for ( size_t r = 0; r < mResources.size(); ++r )
+		if ( !mResources[r].imported && mResources[r].firstUse >= 0 )
+			byStart.push_back( std::make_pair( mResources[r].persistent ? -1 : mResources[r].firstUse, (ResourceId)r ) );
+	std::sort( byStart.begin(), byStart.end() );
+
+	std::vector<int> physicalLastUse;
+	for ( size_t i = 0; i < byStart.size(); ++i ) {
+		Resource &res	= mResources[byStart[i].second];
+		int lastUse		= res.persistent ? frameEnd : res.lastUse;
+		for ( size_t p = 0; p < mPhysical.size() && res.physical < 0 && !res.persistent; ++p ) {
+			if ( mPhysical[p] == res.desc && physicalLastUse[p] < res.firstUse ) {
+				res.physical		= (int)p;
+				physicalLastUse[p]	= lastUse;
+			}
+		}
+		if ( res.physical < 0 ) {
+			res.physical = (int)mPhysical.size();
+			mPhysical.push_back( res.desc );
+			physicalLastUse.push_back( lastUse );
+		}
+	}
+
+	mCompiled = mErrors.empty();
+	return mCompiled;
+}
+
+/*
+ * @Description: run every surviving pass in order
+ * @param: bool reuseCached ( skip cacheable passes, their outputs from the last run are still valid )
+ * @return: none
+ */
+void FrameGraph::execute( bool reuseCached )
+{
+	if ( !mCompiled )
+		compile();
+
+	for ( size_t i = 0; i < mOrder.size(); ++i ) {
+		const Pass &pass = mPasses[mOrder[i]];
+		if ( reuseCached && pass.cacheable )
+			continue;
+		if ( !pass.executor )
+			continue;
+		if ( mObserver )
+			mObserver->passBegin( *this, mOrder[i] );
+		pass.executor->execute( *this, mOrder[i] );
+		if ( mObserver )
+			mObserver->passEnd( *this, mOrder[i] );
+	}
+}
+
+/*
+ * @Description: everything that is allocated ( or declared ) but never read by a surviving pass
+ * @param: none
+ * @return: vector of ResourceId
+ */
+std::vector<FrameGraph::ResourceId> FrameGraph::getUnusedResources() const
+{
+	std::vector<bool> read( mResources.size(), false );
+	for ( size_t i = 0; i < mOrder.size(); ++i ) {
+		const Pass &pass = mPasses[mOrder[i]];
+		for ( size_t r = 0; r < pass.reads.size(); ++r )
+			read[pass.reads[r]] = true;
+	}
+
+	std::vector<ResourceId> unused;
+	for ( size_t r = 0; r < mResources.size(); ++r )
+		if ( !read[r] && !mResources[r].output )
+			unused.push_back( (ResourceId)r );
+	return unused;
+}
+
+void FrameGraph::dump( std::ostream &os ) const
+{
+	os << "FrameGraph: " << mOrder.size() << "/" << mPasses.size() << " passes, " << mPhysical.size() << " physical targets" << std::endl;
+	for ( size_t p = 0; p < mPasses.size(); ++p )
+		os << ( mPasses[p].culled ? "  [culled] " : "  " ) << mPasses[p].name << ( mPasses[p].cacheable ? " ( cacheable )" : "" ) << std::endl;
+
+	for ( size_t r = 0; r < mResources.size(); ++r ) {
+		const Resource &res = mResources[r];
+		os << "  " << res.name << " " << res.desc.width << "x" << res.desc.height << " " << formatName( res.desc.format );
+		if ( res.desc.attachments > 1 )
+			os << " x" << res.desc.attachments;
+		if ( res.desc.samples > 0 )
+			os << " " << res.desc.samples << "x MSAA";
+		if ( !res.desc.depth )
+			os << " no depth";
+		if ( res.imported )
+			os << " imported";
+		else if ( res.physical >= 0 )
+			os << " -> target " << res.physical << " [" << res.firstUse << ", " << res.lastUse << "]" << ( res.persistent ? " persistent" : "" );
+		else
+			os << " unused";
+		os << std::endl;
+	}
+
+	for ( size_t e = 0; e < mErrors.size(); ++e )
+		os << "  error: " << mErrors[e] << std::endl;
+}
+
+} // namespace ssao
@@ -0,0 +1,279 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace ssao {
+
+static const char* CLOCK_NAMES[FrameProfiler::NUM_CLOCKS] = { "cpu", "gpu" };
+
+//fixed notation whatever state the stream is in
+static std::string formatMs( float ms )
+{
+	char buffer[32];
+	std::sprintf( buffer, "%.4f", ms );
+	return buffer;
+}
+
+//pass names are free text, quotes ( and for JSON backslashes ) have to be escaped
+static std::string escapeCsv( const std::string &str )
+{
+	std::string escaped;
+	for ( size_t i = 0; i < str.size(); ++i ) {
+		if ( str[i] == '"' )
+			escaped += '"';
+		escaped += str[i];
+	}
+	return escaped;
+}
+
+static std::string escapeJson( const std::string &str )
+{
+	std::string escaped;
+	for ( size_t i = 0; i < str.size(); ++i ) {
+		if ( str[i] == '"' || str[i] == '\\' )
+			escaped += '\\';
+		escaped += str[i];
+	}
+	return escaped;
+}
+
+SampleHistory::SampleHistory( size_t capacity )
+: mSamples( std::max<size_t>( capacity, 1 ), 0.0f ), mNext( 0 ), mCount( 0 ), mTotal( 0 )
+{}
+
+void SampleHistory::push( float value )
+{
+	mSamples[mNext] = value;
+	mNext = ( mNext + 1 ) % mSamples.size();
+	mCount = std::min( mCount + 1, mSamples.size() );
+	++mTotal;
+}
+
+void SampleHistory::clear()
+{
+	mNext	= 0;
+	mCount	= 0;
+	mTotal	= 0;
+}
+
+float SampleHistory::getLast() const
+{
+	return mCount ? mSamples[( mNext + mSamples.size() - 1 ) % mSamples.size()] : 0.0f;
+}
+
+void SampleHistory::getSamples( std::vector<float> *samples ) const
+{
+	samples->resize( mCount );
+	size_t first = ( mNext + mSamples.size() - mCount ) % mSamples.size();
+	for ( size_t i = 0; i < mCount; ++i )
+		(*samples)[i] = mSamples[( first + i ) % mSamples.size()];
+}
+
+/*
+ * @Description: nearest rank: the smallest sample with at least p percent of the samples at or below it
+ * @param: samples sorted ascending, percentile 0 - 100
+ * @return: float ( 0 if there are no samples )
+ */
+float percentile( const std::vector<float> &sorted, float p )
+{
+	if ( sorted.empty() )
+		return 0.0f;
+	int rank = (int)std::ceil( p / 100.0f * sorted.size() ) - 1;
+	return sorted[std::min( std::max( rank, 0 ), (int)sorted.size() - 1 )];
+}
+
+/*
+ * @Description: count, mean, min / max and p50 / p95 / p99 of samples ( oldest first, last is the newest )
+ * @param: samples
+ * @return: ProfileStats
+ */
+ProfileStats computeStats( const std::vector<float> &samples )
+{
+	ProfileStats stats;
+	if ( samples.empty() )
+		return stats;
+
+	std::vector<float> sorted( samples );
+	std::sort( sorted.begin(), sorted.end() );
+
+	double sum = 0.0;
+	for ( size_t i = 0; i < sorted.size(); ++i )
+		sum += sorted[i];
+
+	stats.count	= (int)sorted.size();
+	stats.last	= samples.back();
+	stats.mean	= (float)( sum / sorted.size() );
+	stats.min	= sorted.front();
+	stats.max	= sorted.back();
+	stats.p50	= percentile( sorted, 50.0f );
+	stats.p95	= percentile( sorted, 95.0f );
+	stats.p99	= percentile( sorted, 99.0f );
+	return stats;
+}
+
+/*
+ * @Description: constructor
+ * @param: samples kept per scope and clock ( 240 = 4 seconds at 60 fps )
+ * @return: none
+ */
+FrameProfiler::FrameProfiler( size_t historySize )
+: mHistorySize( historySize ), mClock( true ), mGpuTimer( 0 ), mFrameCount( 0 )
+{
+	mFrameScope = getScope( "frame" );
+}
+
+int FrameProfiler::getScope( const std::string &name )
+{
+	std::map<std::string, int>::const_iterator it = mScopeIndices.find( name );
+	if ( it != mScopeIndices.end() )
+		return it->second;
+
+	Scope scope;
+	scope.name = name;
+	for ( int c = 0; c < NUM_CLOCKS; ++c )
+		scope.history[c] = SampleHistory( mHistorySize );
+	mScopes.push_back( scope );
+	mScopeIndices[name] = (int)mScopes.size() - 1;
+	return (int)mScopes.size() - 1;
+}
+
+int FrameProfiler::findScope( const std::string &name ) const
+{
+	std::map<std::string, int>::const_iterator it = mScopeIndices.find( name );
+	return it != mScopeIndices.end() ? it->second : -1;
+}
+
+void FrameProfiler::beginFrame()
+{
+	beginScope( mFrameScope, false );
+}
+
+void FrameProfiler::endFrame()
+{
+	//whatever a pass left open ends with the frame
+	while ( !mStack.empty() )
+		endScope();
+	if ( mGpuTimer )
+		mGpuTimer->collect( this );
+	++mFrameCount;
+}
+
+/*
+ * @Description: open a scope, the GPU query only starts if there is a GPU timer and no GPU scope is open already
+ * @param: scope index, whether to time it on the GPU too
+ * @return: none
+ */
+void FrameProfiler::beginScope( int scope, bool gpu )
+{
+	OpenScope open;
+	open.scope	= scope;
+	open.start	= mClock.getSeconds();
+	open.gpu	= false;
+
+	if ( gpu && mGpuTimer ) {
+		bool gpuOpen = false;
+		for ( size_t i = 0; i < mStack.size(); ++i )
+			gpuOpen = gpuOpen || mStack[i].gpu;
+		if ( !gpuOpen ) {
+			mGpuTimer->begin( scope );
+			open.gpu = true;
+		}
+	}
+	mStack.push_back( open );
+}
+
+void FrameProfiler::endScope()
+{
+	if ( mStack.empty() )
+		return;
+
+	OpenScope open = mStack.back();
+	mStack.pop_back();
+	if ( open.gpu )
+		mGpuTimer->end();
+	addSample( open.scope, CLOCK_CPU, (float)( ( mClock.getSeconds() - open.start ) * 1000.0 ) );
+}
+
+void FrameProfiler::addSample( int scope, Clock clock, float ms )
+{
+	if ( scope >= 0 && scope < (int)mScopes.size() )
+		mScopes[scope].history[clock].push( ms );
+}
+
+void FrameProfiler::clear()
+{
+	for ( size_t s = 0; s < mScopes.size(); ++s )
+		for ( int c = 0; c < NUM_CLOCKS; ++c )
+			mScopes[s].history[c].clear();
+	mFrameCount = 0;
+}
+
+ProfileStats FrameProfiler::getStats( int scope, Clock clock ) const
+{
+	std::vector<float> samples;
+	mScopes[scope].history[clock].getSamples( &samples );
+	return computeStats( samples );
+}
+
+void FrameProfiler::writeCsv( std::ostream &os ) const
+{
+	os << "scope,clock,count,last_ms,mean_ms,min_ms,p50_ms,p95_ms,p99_ms,max_ms" << std::endl;
+	for ( size_t s = 0; s < mScopes.size(); ++s ) {
+		for ( int c = 0; c < NUM_CLOCKS; ++c ) {
+			ProfileStats stats = getStats( (int)s, (Clock)c );
+			if ( !stats.count )
+				continue;
+			os << "\"" << escapeCsv( mScopes[s].name ) << "\"," << CLOCK_NAMES[c] << "," << stats.count << "," << formatMs( stats.last ) << "," << formatMs( stats.mean )
+			   << "," << formatMs( stats.min ) << "," << formatMs( stats.p50 ) << "," << formatMs( stats.p95 ) << "," << formatMs( stats.p99 ) << "," << formatMs( stats.max ) << std::endl;
+		}
+	}
+}
+
+void FrameProfiler::writeJson( std::ostream &os, bool withSamples ) const
+{
+	os << "{" << std::endl;
+	os << "  \"frames\": " << mFrameCount << "," << std::endl;
+	os << "  \"historySize\": " << mHistorySize << "," << std::endl;
+	os << "  \"scopes\": [" << std::endl;
+	for ( size_t s = 0; s < mScopes.size(); ++s ) {
+		os << "    { \"name\": \"" << escapeJson( mScopes[s].name ) << "\"";
+		for ( int c = 0; c < NUM_CLOCKS; ++c ) {
+			std::vector<float> samples;
+			mScopes[s].history[c].getSamples( &samples );
+			os << ", \"" << CLOCK_NAMES[c] << "\": ";
+			if ( samples.empty() ) {
+				os << "null";
+				continue;
+			}
+
+			ProfileStats stats = computeStats( samples );
+			os << "{ \"count\": " << stats.count << ", \"last\": " << formatMs( stats.last ) << ", \"mean\": " << formatMs( stats.mean )
+			   << ", \"min\": " << formatMs( stats.min ) << ", \"p50\": " << formatMs( stats.p50 ) << ", \"p95\": " << formatMs( stats.p95 )
+			   << ", \"p99\": " << formatMs( stats.p99 ) << ", \"max\": " << formatMs( stats.max );
+			if ( withSamples ) {
+				os << ", \"samples\": [";
+				for ( size_t i = 0; i < samples.size(); ++i )
+					os << ( i ? ", " : "" ) << formatMs( samples[i] );
+				os << "]";
+			}
+			os << " }";
+		}
+		os << " }" << ( s + 1 < mScopes.size() ? "," : "" ) << std::endl;
+	}
+	os << "  ]" << std::endl;
+	os << "}" << std::endl;
+}
+
+void FrameProfiler::passBegin( const FrameGraph &graph, FrameGraph::PassId pass )
+{
+	beginScope( getScope( graph.getPassName( pass ) ) );
+}
+
+void FrameProfiler::passEnd( const FrameGraph&, FrameGraph::PassId )
+{
+	endScope();
+}
+
+} // namespace ssao
@@ -0,0 +1,216 @@
+#include "GBufferPacking.h"
+#include "SimdFloat.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+
+namespace ssao {
+
+/*
+ * the simd versions below repeat these expressions operation for operation, so both give bit identical texels
+ */
+uint32_t packTexel( const float *normalDepth, const ClipPlanes &clip )
+{
+	float e[2];
+	encodeOctahedral( normalDepth, e );
+	uint32_t r = (uint32_t)( std::min( std::max( e[0] * 0.5f + 0.5f, 0.0f ), 1.0f ) * 255.0f + 0.5f );
+	uint32_t g = (uint32_t)( std::min( std::max( e[1] * 0.5f + 0.5f, 0.0f ), 1.0f ) * 255.0f + 0.5f );
+
+	float linear	= std::min( std::max( ( normalDepth[3] * DEPTH_UNIT - clip.nearClip ) / ( clip.farClip - clip.nearClip ), 0.0f ), 1.0f );
+	float d			= std::floor( linear * 65535.0f + 0.5f );
+	float high		= std::floor( d * ( 1.0f / 256.0f ) );
+	float low		= d - high * 256.0f;
+
+	return r | ( g << 8 ) | ( (uint32_t)high << 16 ) | ( (uint32_t)low << 24 );
+}
+
+void unpackTexel( uint32_t packed, const ClipPlanes &clip, float *normalDepth )
+{
+	float e[2];
+	e[0] = (float)( packed & 0xFF ) * ( 2.0f / 255.0f ) - 1.0f;
+	e[1] = (float)( ( packed >> 8 ) & 0xFF ) * ( 2.0f / 255.0f ) - 1.0f;
+	decodeOctahedral( e, normalDepth );
+
+	float linear	= ( (float)( ( packed >> 16 ) & 0xFF ) * 256.0f + (float)( packed >> 24 ) ) * ( 1.0f / 65535.0f );
+	normalDepth[3]	= ( clip.nearClip + linear * ( clip.farClip - clip.nearClip ) ) * ( 1.0f / DEPTH_UNIT );
+}
+
+/*
+ * @Description: FloatImage normal/depth -> packed texels, simd::WIDTH at a time
+ * @param: FloatImage ( 4 channels ), ClipPlanes, vector* packed ( resized to width * height )
+ * @return: none
+ */
+void packNormalDepth( const FloatImage &normalDepth, const ClipPlanes &clip, std::vector<uint32_t> *packed )
+{
+	using namespace simd;
+
+	const int count = normalDepth.getWidth() * normalDepth.getHeight();
+	packed->resize( count );
+	if ( count == 0 )
+		return;
+
+	const float *src	= normalDepth.getData();
+	int *dst			= (int*)&( *packed )[0];
+
+	const Float zero( 0.0f ), one( 1.0f ), minusOne( -1.0f ), half( 0.5f ), byteMax( 255.0f );
+	const Float depthUnit( DEPTH_UNIT ), nearClip( clip.nearClip ), range( clip.farClip - clip.nearClip );
+	const Float depthMax( 65535.0f ), invHigh( 1.0f / 256.0f ), high( 256.0f );
+	const Int lanes = toInt( iota() ) * Int( 4 );
+
+	int i = 0;
+	for ( ; i + WIDTH <= count; i += WIDTH ) {
+		const float *base = src + i * 4;
+		Float nx = gather( base, lanes );
+		Float ny = gather( base, lanes + Int( 1 ) );
+		Float nz = gather( base, lanes + Int( 2 ) );
+		Float nd = gather( base, lanes + Int( 3 ) );
+
+		//encodeOctahedral()
+		Float l1	= abs( nx ) + abs( ny ) + abs( nz );
+		Float inv	= select( cmpGt( l1, zero ), one / max( l1, Float( 1e-30f ) ), zero );
+		Float x		= nx * inv;
+		Float y		= ny * inv;
+		Float back	= cmpLt( nz, zero );
+		Float fx	= ( one - abs( y ) ) * select( cmpGe( x, zero ), one, minusOne );
+		Float fy	= ( one - abs( x ) ) * select( cmpGe( y, zero ), one, minusOne );
+		x = select( back, fx, x );
+		y = select( back, fy, y );
+
+		Int r = toInt( clamp( x * half + half, zero, one ) * byteMax + half );
+		Int g = toInt( clamp( y * half + half, zero, one ) * byteMax + half );
+
+		Float linear	= clamp( ( nd * depthUnit - nearClip ) / range, zero, one );
+		Float d			= floor( linear * depthMax + half );
+		Float hi		= floor( d * invHigh );
+		Float lo		= d - hi * high;
+
+		store( dst + i, r | shiftLeft( g, 8 ) | shiftLeft( toInt( hi ), 16 ) | shiftLeft( toInt( lo ), 24 ) );
+	}
+
+	for ( ; i < count; ++i )
+		( *packed )[i] = packTexel( src + i * 4, clip );
+}
+
+/*
+ * @Description: packed texels -> FloatImage normal/depth ( the RGBA16F layout ), simd::WIDTH at a time
+ * @param: packed texels, size, ClipPlanes, FloatImage* ( allocated to width x height x 4 if it isn't )
+ * @return: none
+ */
+void unpackNormalDepth( const std::vector<uint32_t> &packed, int width, int height, const ClipPlanes &clip, FloatImage *normalDepth )
+{
+	using namespace simd;
+
+	if ( normalDepth->getWidth() != width || normalDepth->getHeight() != height || normalDepth->getChannels() != 4 )
+		normalDepth->allocate( width, height, 4 );
+
+	const int count = width * height;
+	if ( count == 0 )
+		return;
+
+	const int *src	= (const int*)&packed[0];
+	float *dst		= normalDepth->getData();
+
+	const Float zero( 0.0f ), one( 1.0f ), minusOne( -1.0f ), toSigned( 2.0f / 255.0f ), high( 256.0f ), invDepthMax( 1.0f / 65535.0f );
+	const Float nearClip( clip.nearClip ), range( clip.farClip - clip.nearClip ), invDepthUnit( 1.0f / DEPTH_UNIT );
+	const Int byteMask( 0xFF );
+
+	float nx[WIDTH], ny[WIDTH], nz[WIDTH], nd[WIDTH];
+
+	int i = 0;
+	for ( ; i + WIDTH <= count; i += WIDTH ) {
+		Int p = load( src + i );
+
+		//decodeOctahedral()
+		Float x		= toFloat( p & byteMask ) * toSigned - one;
+		Float y		= toFloat( shiftRight( p, 8 ) & byteMask ) * toSigned - one;
+		Float z		= one - abs( x ) - abs( y );
+		Float back	= cmpLt( z, zero );
+		Float fx	= ( one - abs( y ) ) * select( cmpGe( x, zero ), one, minusOne );
+		Float fy	= ( one - abs( x ) ) * select( cmpGe( y, zero ), one, minusOne );
+		x = select( back, fx, x );
+		y = select( back, fy, y );
+		Float len	= sqrt( x * x + y * y + z * z );
+		Float inv	= select( cmpGt( len, zero ), one / max( len, Float( 1e-30f ) ), zero );
+
+		Float linear = ( toFloat( shiftRight( p, 16 ) & byteMask ) * high + toFloat( shiftRight( p, 24 ) ) ) * invDepthMax;
+
+		store( nx, x * inv );
+		store( ny, y * inv );
+		store( nz, z * inv );
+		store( nd, ( nearClip + linear * range ) * invDepthUnit );
+
+		//back to interleaved
+		float *out = dst + i * 4;
+		for ( int lane = 0; lane < WIDTH; ++lane, out += 4 ) {
+			out[0] = nx[lane];
+			out[1] = ny[lane];
+			out[2] = nz[lane];
+			out[3] = nd[lane];
+		}
+	}
+
+	for ( ; i < count; ++i )
+		unpackTexel( packed[i], clip, dst + i * 4 );
+}
+
+/*
+ * @Description: round trip a normal/depth buffer through the packed format, checks the simd paths against packTexel() / unpackTexel()
+ * @param: FloatImage normal/depth, ClipPlanes
+ * @return: PackingReport
+ */
+PackingReport measurePacking( const FloatImage &normalDepth, const ClipPlanes &clip )
+{
+	PackingReport report;
+	const int count = normalDepth.getWidth() * normalDepth.getHeight();
+
+	std::vector<uint32_t> packed;
+	FloatImage unpacked;
+
+	ci::Timer timer( true );
+	packNormalDepth( normalDepth, clip, &packed );
+	report.packMs = timer.getSeconds() * 1000.0;
+
+	timer.start();
+	unpackNormalDepth( packed, normalDepth.getWidth(), normalDepth.getHeight(), clip, &unpacked );
+	report.unpackMs = timer.getSeconds() * 1000.0;
+
+	report.texels				= 0;
+	report.meanNormalDegrees	= report.maxNormalDegrees = 0.0;
+	report.meanDepthError		= report.maxDepthError = 0.0;
+	report.simdMismatches		= 0;
+	report.unpackedBytes		= (size_t)count * 4 * 2;
+	report.packedBytes			= (size_t)count * 4;
+
+	for ( int i = 0; i < count; ++i ) {
+		const float *in		= normalDepth.getData() + i * 4;
+		const float *out	= unpacked.getData() + i * 4;
+
+		float reference[4];
+		unpackTexel( packed[i], clip, reference );
+		if ( packed[i] != packTexel( in, clip ) || !std::equal( reference, reference + 4, out ) )
+			++report.simdMismatches;
+
+		float length = std::sqrt( in[0] * in[0] + in[1] * in[1] + in[2] * in[2] );
+		if ( std::fabs( length - 1.0f ) > 0.01f )
+			continue;
+
+		float cosAngle	= std::min( std::max( ( in[0] * out[0] + in[1] * out[1] + in[2] * out[2] ) / length, -1.0f ), 1.0f );
+		double degrees	= std::acos( cosAngle ) * 180.0 / 3.14159265358979;
+		double depth	= std::fabs( in[3] - out[3] ) * DEPTH_UNIT;
+
+		report.meanNormalDegrees	+= degrees;
+		report.maxNormalDegrees		= std::max( report.maxNormalDegrees, degrees );
+		report.meanDepthError		+= depth;
+		report.maxDepthError		= std::max( report.maxDepthError, depth );
+		++report.texels;
+	}
+
+	if ( report.texels ) {
+		report.meanNormalDegrees	/= report.texels;
+		report.meanDepthError		/= report.texels;
+	}
+	return report;
+}
+
+} // namespace ssao
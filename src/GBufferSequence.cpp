@@ -0,0 +1,194 @@
+#include "GBufferSequence.h"
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+
+#if !defined( _WIN32 )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ssao {
+
+static const uint32_t GBSQ_MAGIC	= 0x51534247;	//"GBSQ" little endian
+static const uint32_t GBSQ_VERSION	= 1;
+
+struct GBufferSequenceHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	width, height, channels;
+	uint32_t	frameCount;
+	float		projection[2];
+};
+
+GBufferSequenceReader::GBufferSequenceReader()
+: mOpen( false ), mMapping( 0 ), mMappingSize( 0 )
+{}
+
+GBufferSequenceReader::~GBufferSequenceReader()
+{
+	close();
+}
+
+/*
+ * @Description: read the header and map the file, a frame count the header doesn't have comes from the file size
+ * @param: path
+ * @return: bool
+ */
+bool GBufferSequenceReader::open( const std::string &path )
+{
+	close();
+
+	mStream.open( path.c_str(), std::ios::binary );
+	GBufferSequenceHeader header;
+	if ( !mStream.read( (char*)&header, sizeof( header ) ) || header.magic != GBSQ_MAGIC || header.version != GBSQ_VERSION
+		 || header.width == 0 || header.height == 0 || header.channels == 0 || header.channels > 4 ) {
+		close();
+		return false;
+	}
+
+	mInfo.width			= (int)header.width;
+	mInfo.height		= (int)header.height;
+	mInfo.channels		= (int)header.channels;
+	mInfo.projection[0]	= header.projection[0];
+	mInfo.projection[1]	= header.projection[1];
+
+	mStream.seekg( 0, std::ios::end );
+	size_t fileSize = (size_t)mStream.tellg();
+	size_t available = fileSize > GBUFFER_SEQUENCE_HEADER_SIZE ? ( fileSize - GBUFFER_SEQUENCE_HEADER_SIZE ) / mInfo.getFrameBytes() : 0;
+	//a header claiming more than the file holds is a truncated copy, only the whole frames count
+	mInfo.frameCount = (int)( header.frameCount && header.frameCount < available ? header.frameCount : available );
+	mOpen = true;
+
+#if !defined( _WIN32 )
+	int fd = ::open( path.c_str(), O_RDONLY );
+	if ( fd >= 0 && fileSize ) {
+		void *mapping = ::mmap( 0, fileSize, PROT_READ, MAP_SHARED, fd, 0 );
+		if ( mapping != MAP_FAILED ) {
+			mMapping		= mapping;
+			mMappingSize	= fileSize;
+			::madvise( mMapping, mMappingSize, MADV_SEQUENTIAL );
+		}
+	}
+	if ( fd >= 0 )
+		::close( fd );
+#endif
+	return true;
+}
+
+void GBufferSequenceReader::close()
+{
+#if !defined( _WIN32 )
+	if ( mMapping )
+		::munmap( mMapping, mMappingSize );
+#endif
+	mMapping		= 0;
+	mMappingSize	= 0;
+	if ( mStream.is_open() )
+		mStream.close();
+	mStream.clear();
+	mInfo	= GBufferSequenceInfo();
+	mOpen	= false;
+}
+
+const float* GBufferSequenceReader::getFrame( int index ) const
+{
+	if ( !mMapping || index < 0 || index >= mInfo.frameCount )
+		return 0;
+	return (const float*)( (const char*)mMapping + GBUFFER_SEQUENCE_HEADER_SIZE + (size_t)index * mInfo.getFrameBytes() );
+}
+
+bool GBufferSequenceReader::readFrame( int index, FloatImage *image )
+{
+	if ( !mOpen || index < 0 || index >= mInfo.frameCount )
+		return false;
+	if ( image->getWidth() != mInfo.width || image->getHeight() != mInfo.height || image->getChannels() != mInfo.channels )
+		image->allocate( mInfo.width, mInfo.height, mInfo.channels );
+
+	if ( mMapping ) {
+		std::memcpy( image->getData(), getFrame( index ), mInfo.getFrameBytes() );
+		return true;
+	}
+	mStream.clear();
+	mStream.seekg( (std::streamoff)( GBUFFER_SEQUENCE_HEADER_SIZE + (size_t)index * mInfo.getFrameBytes() ) );
+	return (bool)mStream.read( (char*)image->getData(), mInfo.getFrameBytes() );
+}
+
+GBufferSequenceWriter::GBufferSequenceWriter()
+{}
+
+GBufferSequenceWriter::~GBufferSequenceWriter()
+{
+	close();
+}
+
+/*
+ * @Description: start a new sequence, the header goes out with a frame count of 0 until close()
+ * @param: path, GBufferSequenceInfo ( size, channels and projection )
+ * @return: bool
+ */
+bool GBufferSequenceWriter::open( const std::string &path, const GBufferSequenceInfo &info )
+{
+	close();
+	if ( info.width <= 0 || info.height <= 0 || info.channels <= 0 || info.channels > 4 )
+		return false;
+
+	mInfo				= info;
+	mInfo.frameCount	= 0;
+	mStream.open( path.c_str(), std::ios::binary | std::ios::trunc );
+	if ( !writeHeader() ) {
+		mStream.close();
+		return false;
+	}
+	return true;
+}
+
+/*
+ * @Description: patch the frame count into the header and close the file
+ * @param: none
+ * @return: bool ( false if it wasn't open or a write failed )
+ */
+bool GBufferSequenceWriter::close()
+{
+	if ( !mStream.is_open() )
+		return false;
+	bool ok = writeHeader();
+	mStream.close();
+	return ok && !mStream.fail();
+}
+
+bool GBufferSequenceWriter::append( const FloatImage &image )
+{
+	if ( !mStream.is_open() || image.getWidth() != mInfo.width || image.getHeight() != mInfo.height || image.getChannels() != mInfo.channels )
+		return false;
+
+	mStream.seekp( (std::streamoff)( GBUFFER_SEQUENCE_HEADER_SIZE + (size_t)mInfo.frameCount * mInfo.getFrameBytes() ) );
+	if ( !mStream.write( (const char*)image.getData(), mInfo.getFrameBytes() ) )
+		return false;
+	++mInfo.frameCount;
+	return true;
+}
+
+bool GBufferSequenceWriter::writeHeader()
+{
+	std::vector<char> block( GBUFFER_SEQUENCE_HEADER_SIZE, 0 );
+	GBufferSequenceHeader header;
+	header.magic			= GBSQ_MAGIC;
+	header.version			= GBSQ_VERSION;
+	header.width			= (uint32_t)mInfo.width;
+	header.height			= (uint32_t)mInfo.height;
+	header.channels			= (uint32_t)mInfo.channels;
+	header.frameCount		= (uint32_t)mInfo.frameCount;
+	header.projection[0]	= mInfo.projection[0];
+	header.projection[1]	= mInfo.projection[1];
+	std::memcpy( &block[0], &header, sizeof( header ) );
+
+	mStream.seekp( 0 );
+	return (bool)mStream.write( &block[0], block.size() );
+}
+
+} // namespace ssao
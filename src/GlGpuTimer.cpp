@@ -0,0 +1,69 @@
+#include "GlGpuTimer.h"
+
+namespace ssao {
+
+//results that never come back ( lost context ) stop new queries instead of piling up
+static const size_t MAX_PENDING_QUERIES = 64;
+
+GlGpuTimer::GlGpuTimer()
+: mActive( false )
+{
+	mSupported = ci::gl::isExtensionAvailable( "GL_EXT_timer_query" ) || ci::gl::isExtensionAvailable( "GL_ARB_timer_query" );
+}
+
+GlGpuTimer::~GlGpuTimer()
+{
+	for ( size_t i = 0; i < mPending.size(); ++i )
+		mFree.push_back( mPending[i].id );
+	if ( !mFree.empty() )
+		glDeleteQueries( (GLsizei)mFree.size(), &mFree[0] );
+}
+
+void GlGpuTimer::begin( int scope )
+{
+	mActive = mSupported && mPending.size() < MAX_PENDING_QUERIES;
+	if ( !mActive )
+		return;
+
+	Query query;
+	query.scope = scope;
+	if ( mFree.empty() )
+		glGenQueries( 1, &query.id );
+	else {
+		query.id = mFree.back();
+		mFree.pop_back();
+	}
+	glBeginQuery( GL_TIME_ELAPSED_EXT, query.id );
+	mPending.push_back( query );
+}
+
+void GlGpuTimer::end()
+{
+	if ( mActive )
+		glEndQuery( GL_TIME_ELAPSED_EXT );
+	mActive = false;
+}
+
+/*
+ * @Description: hand every finished query to the profiler as a GPU sample, stops at the first one still running
+ * @param: FrameProfiler
+ * @return: none
+ */
+void GlGpuTimer::collect( FrameProfiler *profiler )
+{
+	while ( !mPending.empty() ) {
+		const Query &query = mPending.front();
+		GLint available = 0;
+		glGetQueryObjectiv( query.id, GL_QUERY_RESULT_AVAILABLE, &available );
+		if ( !available )
+			break;
+
+		GLuint64EXT ns = 0;
+		glGetQueryObjectui64vEXT( query.id, GL_QUERY_RESULT, &ns );
+		profiler->addSample( query.scope, FrameProfiler::CLOCK_GPU, (float)( ns / 1000000.0 ) );
+		mFree.push_back( query.id );
+		mPending.pop_front();
+	}
+}
+
+} // namespace ssao
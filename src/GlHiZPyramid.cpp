@@ -0,0 +1,128 @@
+#include "GlHiZPyramid.h"
+
+namespace ssao {
+
+GlHiZPyramid::GlHiZPyramid()
+: mPool( 0 ), mFramebuffer( 0 ), mMaxLevels( 0 )
+{}
+
+GlHiZPyramid::~GlHiZPyramid()
+{
+	if ( mFramebuffer )
+		glDeleteFramebuffersEXT( 1, &mFramebuffer );
+}
+
+/*
+ * @Description: texture with every level allocated ( same sizes as HiZPyramid::build() ), from the pool if it has one,
+ *				 plus the FBO the levels are attached to in turn
+ * @param: level 0 size, maximum level count
+ * @return: none
+ */
+void GlHiZPyramid::allocate( int width, int height, int maxLevels )
+{
+	release();
+
+	mMaxLevels = maxLevels;
+	mLevelSizes.clear();
+	for ( int w = width, h = height; (int)mLevelSizes.size() < maxLevels; w /= 2, h /= 2 ) {
+		mLevelSizes.push_back( ci::Vec2i( w, h ) );
+		if ( w <= 1 || h <= 1 )
+			break;
+	}
+
+	if ( !mPool || !mPool->acquire( getDesc(), &mTexture, getNumLevels() ) ) {
+		ci::gl::Texture::Format format;
+		format.setInternalFormat( GL_RGBA16F_ARB );
+		format.setMinFilter( GL_NEAREST_MIPMAP_NEAREST );
+		format.setMagFilter( GL_NEAREST );
+		format.setWrap( GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE );
+		mTexture = ci::gl::Texture( width, height, format );
+
+		mTexture.bind();
+		for ( size_t level = 1; level < mLevelSizes.size(); ++level )
+			glTexImage2D( GL_TEXTURE_2D, (GLint)level, GL_RGBA16F_ARB, mLevelSizes[level].x, mLevelSizes[level].y, 0, GL_RGBA, GL_FLOAT, 0 );
+		mTexture.unbind();
+	}
+
+	mTexture.bind();
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0 );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)mLevelSizes.size() - 1 );
+	mTexture.unbind();
+
+	if ( !mFramebuffer )
+		glGenFramebuffersEXT( 1, &mFramebuffer );
+}
+
+/* 
+ * @Description: hand the texture to the pool ( or drop it ) and forget the levels, the next build() allocates again
+ * @param: none
+ * @return: none
+ */
+void GlHiZPyramid::release()
+{
+	if ( mTexture && mPool )
+		mPool->release( getDesc(), mTexture, getNumLevels() );
+	mTexture = ci::gl::Texture();
+	mLevelSizes.clear();
+	mMaxLevels = 0;
+}
+
+//what the pool knows the texture by, the level count goes alongside
+TextureDesc GlHiZPyramid::getDesc() const
+{
+	return TextureDesc( getSize().x, getSize().y, TextureDesc::FORMAT_RGBA16F, 0, 1, false );
+}
+
+/*
+ * @Description: render every level, level 0 from normalDepth ( rgb = normal, a = depth )
+ * @param: gl::Texture normal/depth, HiZReduce_frag.glsl program, HiZParams ( level count )
+ * @return: none
+ */
+void GlHiZPyramid::build( const ci::gl::Texture &normalDepth, ci::gl::GlslProg &reduceShader, const HiZParams &params )
+{
+	if ( !mTexture || mTexture.getWidth() != normalDepth.getWidth() || mTexture.getHeight() != normalDepth.getHeight() || mMaxLevels != params.maxLevels )
+		allocate( normalDepth.getWidth(), normalDepth.getHeight(), params.maxLevels );
+
+	glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, mFramebuffer );
+	reduceShader.bind();
+	reduceShader.uniform( "source", 0 );
+
+	for ( int level = 0; level < getNumLevels(); ++level ) {
+		const ci::Vec2i &size = mLevelSizes[level];
+		glFramebufferTexture2DEXT( GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, mTexture.getId(), level );
+		ci::gl::setViewport( ci::Area( 0, 0, size.x, size.y ) );
+		ci::gl::setMatricesWindow( size );
+
+		if ( level == 0 ) {
+			normalDepth.bind( 0 );
+			reduceShader.uniform( "fromNormalDepth", true );
+			reduceShader.uniform( "sourceSize", ci::Vec2f( (float)normalDepth.getWidth(), (float)normalDepth.getHeight() ) );
+		}
+		else {
+			//only the level below is visible to the sampler while this one is the render target
+			mTexture.bind( 0 );
+			glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1 );
+			glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1 );
+			reduceShader.uniform( "fromNormalDepth", false );
+			reduceShader.uniform( "sourceSize", ci::Vec2f( (float)mLevelSizes[level - 1].x, (float)mLevelSizes[level - 1].y ) );
+		}
+
+		ci::gl::drawSolidRect( ci::Rectf( 0.0f, 0.0f, (float)size.x, (float)size.y ) );
+
+		if ( level == 0 )
+			normalDepth.unbind( 0 );
+		else
+			mTexture.unbind( 0 );
+	}
+
+	reduceShader.unbind();
+
+	mTexture.bind( 0 );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0 );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, getNumLevels() - 1 );
+	mTexture.unbind( 0 );
+
+	glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+}
+
+} // namespace ssao
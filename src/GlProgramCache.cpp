@@ -0,0 +1,157 @@
+#include "GlProgramCache.h"
+
+#include "cinder/gl/gl.h"
+#include "cinder/Timer.h"
+
+#if defined( GL_ARB_get_program_binary ) || defined( GL_VERSION_4_1 )
+	#define SSAO_HAS_PROGRAM_BINARY 1
+#else
+	#define SSAO_HAS_PROGRAM_BINARY 0
+#endif
+
+namespace ssao {
+
+/*
+ * GlslProg only builds itself from source, this wraps a program handle we linked from a binary
+ */
+class GlProgramCache::AdoptedProgram : public ci::gl::GlslProg
+{
+public:
+	explicit AdoptedProgram( GLuint handle )
+	{
+		mObj = std::shared_ptr<Obj>( new Obj );
+		mObj->mHandle = handle;
+	}
+};
+
+static std::string glString( GLenum name )
+{
+	const GLubyte *str = glGetString( name );
+	return str ? std::string( (const char*)str ) : std::string();
+}
+
+/*
+ * @Description: constructor, needs a current GL context ( reads the driver strings )
+ * @param: cache directory ( empty = disabled )
+ * @return: none
+ */
+GlProgramCache::GlProgramCache( const std::string &directory )
+: mStore( directory ), mBinarySupported( false ), mSeconds( 0.0 ), mLoaded( 0 ), mCompiled( 0 )
+{
+	mDriverTag = glString( GL_VENDOR ) + "|" + glString( GL_RENDERER ) + "|" + glString( GL_VERSION );
+
+#if SSAO_HAS_PROGRAM_BINARY
+	GLint numFormats = 0;
+	if ( ci::gl::isExtensionAvailable( "GL_ARB_get_program_binary" ) )
+		glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats );
+	mBinarySupported = numFormats > 0;
+#endif
+}
+
+/*
+ * @Description: cached binary if possible, else compile ( and cache )
+ * @param: vertex source, fragment source
+ * @return: gl::GlslProg ( throws like GlslProg does if the source doesn't compile )
+ */
+ci::gl::GlslProg GlProgramCache::getProgram( const std::string &vertexSource, const std::string &fragmentSource )
+{
+	ci::Timer timer( true );
+	uint64_t key = makeShaderKey( vertexSource, fragmentSource, mDriverTag );
+
+#if SSAO_HAS_PROGRAM_BINARY
+	if ( mBinarySupported ) {
+		uint32_t format;
+		std::vector<uint8_t> blob;
+		if ( mStore.load( key, &format, &blob ) ) {
+			GLuint handle = glCreateProgram();
+			glProgramBinary( handle, (GLenum)format, &blob[0], (GLsizei)blob.size() );
+
+			GLint linked = GL_FALSE;
+			glGetProgramiv( handle, GL_LINK_STATUS, &linked );
+			if ( linked == GL_TRUE ) {
+				++mLoaded;
+				mSeconds += timer.getSeconds();
+				return AdoptedProgram( handle );
+			}
+
+			//the driver changed its mind about the binary, fall through and rebuild it
+			glDeleteProgram( handle );
+			mStore.invalidate( key );
+		}
+	}
+#endif
+
+#if SSAO_HAS_PROGRAM_BINARY
+	if ( mBinarySupported ) {
+		GLuint handle = linkRetrievable( vertexSource, fragmentSource );
+		if ( handle ) {
+			++mCompiled;
+			GLint length = 0;
+			glGetProgramiv( handle, GL_PROGRAM_BINARY_LENGTH, &length );
+			if ( length > 0 ) {
+				std::vector<uint8_t> blob( length );
+				GLenum format = 0;
+				GLsizei written = 0;
+				glGetProgramBinary( handle, length, &written, &format, &blob[0] );
+				blob.resize( written );
+				if ( written > 0 )
+					mStore.store( key, (uint32_t)format, blob );
+			}
+			mSeconds += timer.getSeconds();
+			return AdoptedProgram( handle );
+		}
+		//a compile or link error: GlslProg below fails the same way and reports it like everywhere else
+	}
+#endif
+
+	ci::gl::GlslProg program( vertexSource.c_str(), fragmentSource.c_str() );
+	++mCompiled;
+	mSeconds += timer.getSeconds();
+	return program;
+}
+
+/*
+ * @Description: what GlslProg( vs, fs ) does, with the retrievable hint set before the link
+ * @param: vertex source, fragment source
+ * @return: GLuint ( linked program, 0 on any error )
+ */
+GLuint GlProgramCache::linkRetrievable( const std::string &vertexSource, const std::string &fragmentSource )
+{
+#if SSAO_HAS_PROGRAM_BINARY
+	const GLenum types[2]		= { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char *sources[2]		= { vertexSource.c_str(), fragmentSource.c_str() };
+	GLuint handle = glCreateProgram();
+	bool ok = true;
+	for ( int i = 0; i < 2 && ok; ++i ) {
+		GLuint shader = glCreateShader( types[i] );
+		glShaderSource( shader, 1, &sources[i], 0 );
+		glCompileShader( shader );
+		GLint compiled = GL_FALSE;
+		glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+		ok = compiled == GL_TRUE;
+		if ( ok )
+			glAttachShader( handle, shader );
+		//attached shaders go with the program
+		glDeleteShader( shader );
+	}
+
+	if ( ok ) {
+		glProgramParameteri( handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+		glLinkProgram( handle );
+		GLint linked = GL_FALSE;
+		glGetProgramiv( handle, GL_LINK_STATUS, &linked );
+		ok = linked == GL_TRUE;
+	}
+	if ( !ok ) {
+		glDeleteProgram( handle );
+		return 0;
+	}
+	return handle;
+#else
+	(void)vertexSource;
+	(void)fragmentSource;
+	return 0;
+#endif
+}
+
+} // namespace ssao
@@ -0,0 +1,123 @@
+#include "GlReadback.h"
+
+#include <cstring>
+
+namespace ssao {
+
+GlReadback::GlReadback( int slots )
+: mBuffers( slots > 0 ? slots : 1 )
+{
+	mSupported		= ci::gl::isExtensionAvailable( "GL_ARB_pixel_buffer_object" ) || ci::gl::isExtensionAvailable( "GL_EXT_pixel_buffer_object" );
+	mSyncSupported	= false;
+#if defined( GL_ARB_sync )
+	mSyncSupported	= ci::gl::isExtensionAvailable( "GL_ARB_sync" );
+	mFences.assign( mBuffers.size(), (GLsync)0 );
+#endif
+}
+
+GlReadback::~GlReadback()
+{
+	for ( size_t s = 0; s < mBuffers.size(); ++s ) {
+		deleteFence( (int)s );
+		for ( size_t t = 0; t < mBuffers[s].size(); ++t )
+			if ( mBuffers[s][t].pbo )
+				glDeleteBuffers( 1, &mBuffers[s][t].pbo );
+	}
+}
+
+void GlReadback::setSource( int target, const ci::gl::Texture &texture )
+{
+	if ( target >= (int)mSources.size() )
+		mSources.resize( target + 1 );
+	mSources[target] = texture;
+}
+
+/*
+ * @Description: glGetTexImage() of every target's source into the slot's PBOs, ( re )sized to the target, then fence the slot
+ * @param: slot, CaptureTargets ( channels 1 reads GL_RED, 4 GL_RGBA, bytesPerChannel 1 / 4 as unsigned byte / float )
+ * @return: none
+ */
+void GlReadback::startReadback( int slot, const std::vector<CaptureTarget> &targets )
+{
+	std::vector<Buffer> &buffers = mBuffers[slot];
+	if ( buffers.size() < targets.size() )
+		buffers.resize( targets.size() );
+	if ( !mSupported )
+		return;
+
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	for ( size_t t = 0; t < targets.size(); ++t ) {
+		Buffer &buffer	= buffers[t];
+		buffer.started	= false;
+		if ( t >= mSources.size() || !mSources[t] || !targets[t].getBytes() )
+			continue;
+
+		if ( !buffer.pbo )
+			glGenBuffers( 1, &buffer.pbo );
+		glBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, buffer.pbo );
+		if ( buffer.bytes != targets[t].getBytes() ) {
+			buffer.bytes = targets[t].getBytes();
+			glBufferData( GL_PIXEL_PACK_BUFFER_ARB, buffer.bytes, 0, GL_STREAM_READ );
+		}
+
+		//with a PBO bound the last argument is an offset into it, not a pointer
+		const ci::gl::Texture &texture = mSources[t];
+		texture.bind();
+		glGetTexImage( texture.getTarget(), 0, targets[t].channels == 1 ? GL_RED : GL_RGBA, targets[t].bytesPerChannel == 1 ? GL_UNSIGNED_BYTE : GL_FLOAT, 0 );
+		texture.unbind();
+		buffer.started = true;
+	}
+	glBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+
+#if defined( GL_ARB_sync )
+	deleteFence( slot );
+	if ( mSyncSupported )
+		mFences[slot] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+#endif
+}
+
+bool GlReadback::isReadbackDone( int slot )
+{
+#if defined( GL_ARB_sync )
+	if ( mSyncSupported && mFences[slot] ) {
+		GLenum status = glClientWaitSync( mFences[slot], 0, 0 );
+		return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+	}
+#endif
+	//no fences, the ring's latency alone has to cover it
+	return true;
+}
+
+/*
+ * @Description: map the slot's PBO for target and copy it out
+ * @param: slot, target, dst ( the target's getBytes() )
+ * @return: bool ( false if nothing was read back for it or the map failed )
+ */
+bool GlReadback::finishReadback( int slot, int target, unsigned char *dst )
+{
+	if ( target >= (int)mBuffers[slot].size() || !mBuffers[slot][target].started )
+		return false;
+
+	const Buffer &buffer = mBuffers[slot][target];
+	glBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, buffer.pbo );
+	const void *pixels = glMapBuffer( GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY );
+	if ( pixels ) {
+		std::memcpy( dst, pixels, buffer.bytes );
+		glUnmapBuffer( GL_PIXEL_PACK_BUFFER_ARB );
+	}
+	glBindBuffer( GL_PIXEL_PACK_BUFFER_ARB, 0 );
+	return pixels != 0;
+}
+
+void GlReadback::deleteFence( int slot )
+{
+#if defined( GL_ARB_sync )
+	if ( mFences[slot] )
+		glDeleteSync( mFences[slot] );
+	mFences[slot] = 0;
+#else
+	(void)slot;
+#endif
+}
+
+} // namespace ssao
@@ -0,0 +1,179 @@
+#include "GlSceneRenderer.h"
+
+namespace ssao {
+
+static const char *INSTANCE_ROWS[3] = { "instanceRow0", "instanceRow1", "instanceRow2" };
+
+GlSceneRenderer::GlSceneRenderer()
+: mInstanceBuffer( 0 ), mInstancingSupported( false ), mNormalFormat( NORMAL_FLOAT ), mUploadedBytes( 0 )
+{}
+
+GlSceneRenderer::~GlSceneRenderer()
+{
+	release();
+	if ( mInstanceBuffer )
+		glDeleteBuffers( 1, &mInstanceBuffer );
+}
+
+void GlSceneRenderer::release()
+{
+	for ( size_t m = 0; m < mMeshes.size(); ++m ) {
+		GLuint buffers[2] = { mMeshes[m].vertices, mMeshes[m].indices };
+		glDeleteBuffers( 2, buffers );
+	}
+	mMeshes.clear();
+}
+
+/*
+ * @Description: interleaved vertex VBO and index VBO of every mesh in the current normal format, materials set so far are kept
+ * @param: SceneContainer
+ * @return: none
+ */
+void GlSceneRenderer::upload( const SceneContainer &scene )
+{
+	std::vector<MeshBuffers> previous = mMeshes;
+	release();
+
+	//needs a context, so checked here rather than in the constructor
+	mInstancingSupported = ci::gl::isExtensionAvailable( "GL_ARB_instanced_arrays" ) && ci::gl::isExtensionAvailable( "GL_ARB_draw_instanced" );
+	if ( !mInstanceBuffer )
+		glGenBuffers( 1, &mInstanceBuffer );
+
+	mUploadedBytes = 0;
+	for ( int m = 0; m < scene.getNumMeshes(); ++m ) {
+		InterleavedMesh data;
+		interleaveMesh( *scene.getMesh( m ), mNormalFormat, &data );
+
+		MeshBuffers mesh;
+		mesh.numIndices		= (GLsizei)data.numIndices;
+		mesh.indexType		= data.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		mesh.stride			= data.getStride();
+		mesh.normalType		= mNormalFormat == NORMAL_BYTE ? GL_BYTE : GL_FLOAT;
+		mesh.hasMaterial	= m < (int)previous.size() && previous[m].hasMaterial;
+		if ( mesh.hasMaterial )
+			mesh.material = previous[m].material;
+
+		GLuint buffers[2];
+		glGenBuffers( 2, buffers );
+		mesh.vertices	= buffers[0];
+		mesh.indices	= buffers[1];
+
+		glBindBuffer( GL_ARRAY_BUFFER, mesh.vertices );
+		glBufferData( GL_ARRAY_BUFFER, data.vertices.size(), data.vertices.empty() ? 0 : &data.vertices[0], GL_STATIC_DRAW );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, mesh.indices );
+		glBufferData( GL_ELEMENT_ARRAY_BUFFER, data.indices.size(), data.indices.empty() ? 0 : &data.indices[0], GL_STATIC_DRAW );
+		mUploadedBytes += data.vertices.size() + data.indices.size();
+
+		mMeshes.push_back( mesh );
+	}
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+}
+
+void GlSceneRenderer::setMaterial( int mesh, const ci::gl::Material &material )
+{
+	mMeshes[mesh].material		= material;
+	mMeshes[mesh].hasMaterial	= true;
+}
+
+void GlSceneRenderer::prepare( const SceneContainer &scene, const CullResult &visible )
+{
+	mBatchOffsets.resize( visible.batches.size() );
+	mInstanceRows.resize( visible.visible * 12 );
+
+	int offset = 0;
+	for ( size_t m = 0; m < visible.batches.size(); ++m ) {
+		mBatchOffsets[m] = offset;
+		if ( !visible.batches[m].empty() )
+			scene.gatherRows( visible.batches[m], &mInstanceRows[offset * 12] );
+		offset += (int)visible.batches[m].size();
+	}
+
+	if ( !mInstancingSupported || mInstanceRows.empty() )
+		return;
+	//orphan last frame's storage instead of waiting for the passes still reading it
+	glBindBuffer( GL_ARRAY_BUFFER, mInstanceBuffer );
+	glBufferData( GL_ARRAY_BUFFER, mInstanceRows.size() * sizeof( float ), 0, GL_STREAM_DRAW );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, mInstanceRows.size() * sizeof( float ), &mInstanceRows[0] );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void GlSceneRenderer::bindMesh( const MeshBuffers &mesh )
+{
+	//GL_BYTE normals are signed normalized by glNormalPointer, no shader change needed
+	glBindBuffer( GL_ARRAY_BUFFER, mesh.vertices );
+	glVertexPointer( 3, GL_FLOAT, mesh.stride, 0 );
+	glNormalPointer( mesh.normalType, mesh.stride, (const GLvoid*)12 );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, mesh.indices );
+}
+
+/*
+ * @Description: every mesh's visible instances, one instanced draw per mesh or one draw per instance
+ * @param: SceneContainer, CullResult ( the one given to prepare() ), bound GlslProg built with INSTANCED ( 0 = fixed function )
+ * @return: int draw calls
+ */
+int GlSceneRenderer::draw( const SceneContainer &scene, const CullResult &visible, const ci::gl::GlslProg *instancedProgram )
+{
+	int drawCalls = 0;
+
+	GLint rows[3] = { -1, -1, -1 };
+	bool instanced = mInstancingSupported && instancedProgram;
+	for ( int r = 0; r < 3 && instanced; ++r ) {
+		rows[r]		= glGetAttribLocation( instancedProgram->getHandle(), INSTANCE_ROWS[r] );
+		instanced	= rows[r] >= 0;
+	}
+
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glEnableClientState( GL_NORMAL_ARRAY );
+	if ( instanced ) {
+		for ( int r = 0; r < 3; ++r ) {
+			glEnableVertexAttribArray( rows[r] );
+			glVertexAttribDivisorARB( rows[r], 1 );
+		}
+	}
+
+	for ( size_t m = 0; m < mMeshes.size() && m < visible.batches.size(); ++m ) {
+		const std::vector<int> &batch = visible.batches[m];
+		if ( batch.empty() )
+			continue;
+
+		const MeshBuffers &mesh = mMeshes[m];
+		if ( mesh.hasMaterial )
+			mesh.material.apply();
+		bindMesh( mesh );
+
+		if ( instanced ) {
+			glBindBuffer( GL_ARRAY_BUFFER, mInstanceBuffer );
+			for ( int r = 0; r < 3; ++r ) {
+				size_t offset = ( (size_t)mBatchOffsets[m] * 12 + r * 4 ) * sizeof( float );
+				glVertexAttribPointer( rows[r], 4, GL_FLOAT, GL_FALSE, 12 * sizeof( float ), (const GLvoid*)offset );
+			}
+			glDrawElementsInstancedARB( GL_TRIANGLES, mesh.numIndices, mesh.indexType, 0, (GLsizei)batch.size() );
+			++drawCalls;
+			continue;
+		}
+
+		for ( size_t i = 0; i < batch.size(); ++i ) {
+			ci::Matrix44f transform = scene.getTransform( batch[i] );
+			glPushMatrix();
+			glMultMatrixf( transform.m );
+			glDrawElements( GL_TRIANGLES, mesh.numIndices, mesh.indexType, 0 );
+			glPopMatrix();
+			++drawCalls;
+		}
+	}
+
+	if ( instanced ) {
+		for ( int r = 0; r < 3; ++r ) {
+			glVertexAttribDivisorARB( rows[r], 0 );
+			glDisableVertexAttribArray( rows[r] );
+		}
+	}
+	glDisableClientState( GL_NORMAL_ARRAY );
+	glDisableClientState( GL_VERTEX_ARRAY );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	return drawCalls;
+}
+
+} // namespace ssao
@@ -0,0 +1,246 @@
+#include "HiZPyramid.h"
+#include "SSAOEngine.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ssao {
+
+/*
+ * rows of one level ( or of one of the SSAO passes measure() runs ), one task per block of rows
+ */
+class HiZPyramid::RowJob : public TaskPool::Job
+{
+public:
+	enum Pass { BASE, REDUCE, SSAO, SSAO_HIZ };
+	static const int ROWS_PER_TASK = 16;
+
+	RowJob( HiZPyramid *pyramid, Pass pass, int level, int rows, const SSAOEngine *engine = 0, FloatImage *ao = 0 )
+	: mPyramid( pyramid ), mPass( pass ), mLevel( level ), mRows( rows ), mEngine( engine ), mAO( ao ) {}
+
+	int getNumTasks() const { return ( mRows + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK; }
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		int rowBegin	= index * ROWS_PER_TASK;
+		int rowEnd		= std::min( rowBegin + ROWS_PER_TASK, mRows );
+
+		switch ( mPass ) {
+			case BASE:
+				for ( int y = rowBegin; y < rowEnd; ++y )
+					mPyramid->buildBaseRow( y );
+				break;
+			case REDUCE:
+				for ( int y = rowBegin; y < rowEnd; ++y )
+					mPyramid->reduceRow( mLevel, y );
+				break;
+			case SSAO:
+				mEngine->computeRegion( *mPyramid->mSource, mAO, 0, mAO->getWidth(), rowBegin, rowEnd );
+				break;
+			case SSAO_HIZ:
+				mEngine->computeRegionHiZ( *mPyramid->mSource, *mPyramid, mAO, 0, mAO->getWidth(), rowBegin, rowEnd );
+				break;
+		}
+	}
+
+private:
+	HiZPyramid			*mPyramid;
+	Pass				mPass;
+	int					mLevel;
+	int					mRows;
+	const SSAOEngine	*mEngine;
+	FloatImage			*mAO;
+};
+
+/*
+ * @Description: constructor
+ * @param: TaskPool* ( borrowed, may be 0 )
+ * @return: none
+ */
+HiZPyramid::HiZPyramid( TaskPool *pool )
+: mPool( pool ), mSource( 0 )
+{}
+
+/*
+ * @Description: build every level from a 4 channel normal/depth buffer
+ * @param: FloatImage normal/depth
+ * @return: none
+ */
+void HiZPyramid::build( const FloatImage &normalDepth )
+{
+	int w = normalDepth.getWidth();
+	int h = normalDepth.getHeight();
+
+	int numLevels = 1;
+	for ( int lw = w, lh = h; numLevels < mParams.maxLevels && lw > 1 && lh > 1; ++numLevels ) {
+		lw /= 2;
+		lh /= 2;
+	}
+
+	//keep the allocations between frames, only resize what changed
+	mLevels.resize( numLevels );
+	for ( int i = 0; i < numLevels; ++i ) {
+		if ( mLevels[i].getWidth() != w || mLevels[i].getHeight() != h || mLevels[i].getChannels() != 4 )
+			mLevels[i].allocate( w, h, 4 );
+		w = std::max( w / 2, 1 );
+		h = std::max( h / 2, 1 );
+	}
+
+	//level i from 2^( i + lodOffset ) texels out, i.e. once its texels are 1 / 2^lodOffset of the tap distance
+	mThresholds.resize( numLevels );
+	for ( int i = 0; i < numLevels; ++i ) {
+		float distance = std::ldexp( 1.0f, i + mParams.lodOffset );
+		mThresholds[i] = i == 0 ? 0.0f : distance * distance;
+	}
+
+	mSource = &normalDepth;
+	runRows( -1, mLevels[0].getHeight() );
+	for ( int i = 1; i < numLevels; ++i )
+		runRows( i, mLevels[i].getHeight() );
+}
+
+void HiZPyramid::runRows( int level, int rows )
+{
+	RowJob job( this, level < 0 ? RowJob::BASE : RowJob::REDUCE, level, rows );
+	if ( mPool )
+		mPool->parallelFor( job.getNumTasks(), &job );
+	else
+		for ( int i = 0; i < job.getNumTasks(); ++i )
+			job.run( i, 0 );
+}
+
+/*
+ * @Description: level 0, normal/depth ( nx, ny, nz, depth ) -> ( depth, depth, octahedral normal )
+ * @param: row
+ * @return: none
+ */
+void HiZPyramid::buildBaseRow( int y )
+{
+	const float *src	= mSource->getPixel( 0, y );
+	float *dst			= mLevels[0].getPixel( 0, y );
+	const int w			= mLevels[0].getWidth();
+
+	for ( int x = 0; x < w; ++x, src += 4, dst += 4 ) {
+		dst[0] = src[3];
+		dst[1] = src[3];
+		encodeOctahedral( src, dst + 2 );
+	}
+}
+
+/*
+ * @Description: one row of a level from the 2x2 ( up to 3x3 on odd edges ) texels below it
+ * @param: level ( >= 1 ), row
+ * @return: none
+ */
+void HiZPyramid::reduceRow( int level, int y )
+{
+	const FloatImage &src	= mLevels[level - 1];
+	FloatImage &dst			= mLevels[level];
+	const int w				= dst.getWidth();
+	const int srcW			= src.getWidth();
+
+	//rows 2y and 2y + 1, plus 2y + 2 if this is the last row of an odd sized source
+	int rowCount = ( y == dst.getHeight() - 1 && ( src.getHeight() & 1 ) ) ? 3 : 2;
+	const float *rows[3];
+	for ( int r = 0; r < rowCount; ++r )
+		rows[r] = src.getPixel( 0, src.clampY( 2 * y + r ) );
+
+	float *out = dst.getPixel( 0, y );
+	for ( int x = 0; x < w; ++x, out += 4 ) {
+		int colCount = ( x == w - 1 && ( srcW & 1 ) ) ? 3 : 2;
+		int col = std::min( 2 * x, srcW - 1 ) * 4;
+
+		float minDepth = rows[0][col], maxDepth = rows[0][col + 1];
+		float sum[3] = { 0.0f, 0.0f, 0.0f };
+		for ( int r = 0; r < rowCount; ++r ) {
+			const float *p = rows[r] + col;
+			for ( int c = 0; c < colCount; ++c, p += 4 ) {
+				float n[3];
+				decodeOctahedral( p + 2, n );
+				minDepth	= std::min( minDepth, p[0] );
+				maxDepth	= std::max( maxDepth, p[1] );
+				sum[0]		+= n[0];
+				sum[1]		+= n[1];
+				sum[2]		+= n[2];
+			}
+		}
+
+		//the encoding normalizes, so the average ends up as its direction
+		out[0] = minDepth;
+		out[1] = maxDepth;
+		encodeOctahedral( sum, out + 2 );
+	}
+}
+
+void HiZPyramid::sample( float u, float v, int level, float *texel ) const
+{
+	const FloatImage &image = mLevels[level];
+	int x = image.clampX( (int)std::floor( u * image.getWidth() ) );
+	int y = image.clampY( (int)std::floor( v * image.getHeight() ) );
+	const float *p = image.getPixel( x, y );
+	texel[0] = p[0];
+	texel[1] = p[1];
+	texel[2] = p[2];
+	texel[3] = p[3];
+}
+
+/*
+ * @Description: small radius vs wide radius, full detail vs pyramid lookups, all at the normalDepth size
+ * @param: SSAOEngine, FloatImage normal/depth, wide radius ( uv units like SSAOParams::rad )
+ * @return: HiZReport
+ */
+HiZReport HiZPyramid::measure( const SSAOEngine &engine, const FloatImage &normalDepth, float wideRadius )
+{
+	HiZReport report;
+	const int w = normalDepth.getWidth();
+	const int h = normalDepth.getHeight();
+
+	SSAOEngine wide = engine;
+	SSAOParams params = engine.getParams();
+	params.rad = wideRadius;
+	wide.setParams( params );
+
+	FloatImage small( w, h, 1 ), reference( w, h, 1 ), hiZ( w, h, 1 );
+	mSource = &normalDepth;
+
+	ci::Timer timer( true );
+	build( normalDepth );
+	report.buildMs	= timer.getSeconds() * 1000.0;
+	report.levels	= getNumLevels();
+
+	RowJob smallJob( this, RowJob::SSAO, 0, h, &engine, &small );
+	RowJob wideJob( this, RowJob::SSAO, 0, h, &wide, &reference );
+	RowJob hiZJob( this, RowJob::SSAO_HIZ, 0, h, &wide, &hiZ );
+	RowJob *jobs[3]		= { &smallJob, &wideJob, &hiZJob };
+	double *times[3]	= { &report.smallMs, &report.wideMs, &report.wideHiZMs };
+
+	for ( int i = 0; i < 3; ++i ) {
+		timer.start();
+		if ( mPool )
+			mPool->parallelFor( jobs[i]->getNumTasks(), jobs[i] );
+		else
+			for ( int t = 0; t < jobs[i]->getNumTasks(); ++t )
+				jobs[i]->run( t, 0 );
+		*times[i] = timer.getSeconds() * 1000.0;
+	}
+
+	//geometry only: the clear color's ( 0.5, 0.5, 0.5 ) "normal" is not unit length and the pyramid stores directions
+	double error = 0.0;
+	int pixels = 0;
+	const float *a = reference.getData();
+	const float *b = hiZ.getData();
+	for ( int i = 0; i < w * h; ++i ) {
+		const float *n = normalDepth.getData() + i * 4;
+		if ( std::fabs( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] - 1.0f ) > 0.01f )
+			continue;
+		error += std::fabs( a[i] - b[i] );
+		++pixels;
+	}
+	report.wideHiZError = pixels ? error / pixels : 0.0;
+
+	return report;
+}
+
+} // namespace ssao
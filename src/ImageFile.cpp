@@ -0,0 +1,126 @@
+#include "ImageFile.h"
+
+#include <stdint.h>
+#include <cmath>
+#include <fstream>
+
+namespace ssao {
+
+static const uint32_t FIMG_MAGIC	= 0x474d4946;	//"FIMG" little endian
+static const uint32_t FIMG_VERSION	= 1;
+
+struct FloatImageHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	width, height, channels;
+};
+
+bool writeFloatImage( const std::string &path, const FloatImage &image )
+{
+	FloatImageHeader header;
+	header.magic	= FIMG_MAGIC;
+	header.version	= FIMG_VERSION;
+	header.width	= (uint32_t)image.getWidth();
+	header.height	= (uint32_t)image.getHeight();
+	header.channels	= (uint32_t)image.getChannels();
+
+	std::ofstream out( path.c_str(), std::ios::binary | std::ios::trunc );
+	out.write( (const char*)&header, sizeof( header ) );
+	if ( !image.isEmpty() )
+		out.write( (const char*)image.getData(), image.getRowStride() * image.getHeight() * sizeof( float ) );
+	return (bool)out;
+}
+
+/*
+ * @Description: load a .fimg, anything that is not one ( magic, version, size ) fails and leaves image alone
+ * @param: path, FloatImage* image
+ * @return: bool
+ */
+bool readFloatImage( const std::string &path, FloatImage *image )
+{
+	std::ifstream in( path.c_str(), std::ios::binary );
+	FloatImageHeader header;
+	if ( !in.read( (char*)&header, sizeof( header ) ) || header.magic != FIMG_MAGIC || header.version != FIMG_VERSION
+		 || header.width == 0 || header.height == 0 || header.channels == 0 || header.channels > 4 )
+		return false;
+
+	FloatImage loaded( (int)header.width, (int)header.height, (int)header.channels );
+	if ( !in.read( (char*)loaded.getData(), loaded.getRowStride() * loaded.getHeight() * sizeof( float ) ) )
+		return false;
+	*image = loaded;
+	return true;
+}
+
+bool writePgm16( const std::string &path, const FloatImage &image, int channel )
+{
+	const int w = image.getWidth(), h = image.getHeight();
+	std::vector<unsigned char> bytes( (size_t)w * h * 2 );
+	size_t i = 0;
+	for ( int y = h - 1; y >= 0; --y ) {
+		for ( int x = 0; x < w; ++x ) {
+			float v = std::min( std::max( image.getPixel( x, y )[channel], 0.0f ), 1.0f );
+			unsigned int value = (unsigned int)( v * 65535.0f + 0.5f );
+			//PGM samples are big endian
+			bytes[i++] = (unsigned char)( value >> 8 );
+			bytes[i++] = (unsigned char)( value & 0xFF );
+		}
+	}
+
+	std::ofstream out( path.c_str(), std::ios::binary | std::ios::trunc );
+	out << "P5\n" << w << " " << h << "\n65535\n";
+	if ( !bytes.empty() )
+		out.write( (const char*)&bytes[0], bytes.size() );
+	return (bool)out;
+}
+
+bool readPgm16( const std::string &path, FloatImage *image )
+{
+	std::ifstream in( path.c_str(), std::ios::binary );
+	std::string magic;
+	int w = 0, h = 0, maxValue = 0;
+	in >> magic >> w >> h >> maxValue;
+	if ( !in || magic != "P5" || w <= 0 || h <= 0 || maxValue != 65535 )
+		return false;
+	in.get();	//the single whitespace ending the header
+
+	std::vector<unsigned char> bytes( (size_t)w * h * 2 );
+	if ( !in.read( (char*)&bytes[0], bytes.size() ) )
+		return false;
+
+	image->allocate( w, h, 1 );
+	size_t i = 0;
+	for ( int y = h - 1; y >= 0; --y ) {
+		for ( int x = 0; x < w; ++x, i += 2 )
+			*image->getPixel( x, y ) = ( ( bytes[i] << 8 ) | bytes[i + 1] ) / 65535.0f;
+	}
+	return true;
+}
+
+ImageDiff compareImages( const FloatImage &a, int channelA, const FloatImage &b, int channelB, float badThreshold )
+{
+	ImageDiff diff;
+	if ( a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() ) {
+		diff.sizeMismatch = true;
+		return diff;
+	}
+
+	double sumSq = 0.0;
+	size_t bad = 0;
+	for ( int y = 0; y < a.getHeight(); ++y ) {
+		for ( int x = 0; x < a.getWidth(); ++x ) {
+			float d = std::fabs( a.getPixel( x, y )[channelA] - b.getPixel( x, y )[channelB] );
+			sumSq			+= (double)d * d;
+			diff.maxError	= std::max( diff.maxError, d );
+			if ( d > badThreshold )
+				++bad;
+		}
+	}
+
+	const double count	= (double)a.getWidth() * a.getHeight();
+	diff.rms			= count > 0.0 ? (float)std::sqrt( sumSq / count ) : 0.0f;
+	diff.badFraction	= count > 0.0 ? (float)( bad / count ) : 0.0f;
+	return diff;
+}
+
+} // namespace ssao
@@ -0,0 +1,137 @@
+#include "MeshCache.h"
+#include "ShaderCache.h"
+
+#include <iomanip>
+
+using namespace ci;
+
+namespace ssao {
+
+//parameter keys and content keys start from different seeds so a parameter block can't pass for a mesh
+static uint64_t hashParameters( const std::string &primitive, const float *values, size_t count )
+{
+	return hashFnv1a( values, count * sizeof( float ), hashFnv1a( primitive ) );
+}
+
+static uint64_t hashContent( const MeshData &mesh )
+{
+	uint64_t key = hashFnv1a( "content" );
+	if ( !mesh.positions.empty() )
+		key = hashFnv1a( &mesh.positions[0], mesh.positions.size() * sizeof( Vec3f ), key );
+	if ( !mesh.normals.empty() )
+		key = hashFnv1a( &mesh.normals[0], mesh.normals.size() * sizeof( Vec3f ), key );
+	if ( !mesh.indices.empty() )
+		key = hashFnv1a( &mesh.indices[0], mesh.indices.size() * sizeof( uint32_t ), key );
+	return key;
+}
+
+/*
+ * @Description: constructor
+ * @param: MeshOptions ( applied to every mesh added )
+ * @return: none
+ */
+MeshCache::MeshCache( const MeshOptions &options )
+: mOptions( options ), mRequests( 0 ), mHits( 0 )
+{}
+
+MeshCache::~MeshCache()
+{
+	for ( size_t e = 0; e < mEntries.size(); ++e ) {
+		delete mEntries[e]->mesh;
+		delete mEntries[e];
+	}
+}
+
+const MeshData* MeshCache::find( uint64_t key )
+{
+	++mRequests;
+	for ( size_t e = 0; e < mEntries.size(); ++e ) {
+		if ( mEntries[e]->key == key ) {
+			++mHits;
+			return mEntries[e]->mesh;
+		}
+	}
+	return 0;
+}
+
+/*
+ * @Description: take ownership of a freshly built mesh and optimize it
+ * @param: key, MeshData* ( heap, owned from here on ), name ( for dump() )
+ * @return: const MeshData*
+ */
+const MeshData* MeshCache::insert( uint64_t key, MeshData *mesh, const std::string &name )
+{
+	Entry *entry	= new Entry;
+	entry->name		= name;
+	entry->key		= key;
+	entry->mesh		= mesh;
+	entry->source	= measureMesh( *mesh, mOptions.cacheSize );
+	if ( mOptions.optimize )
+		optimizeMesh( mesh, mOptions.cacheSize );
+	entry->optimized = measureMesh( *mesh, mOptions.cacheSize );
+
+	mEntries.push_back( entry );
+	return mesh;
+}
+
+const MeshData* MeshCache::acquire( const MeshData &mesh, const std::string &name )
+{
+	uint64_t key = hashContent( mesh );
+	if ( const MeshData *cached = find( key ) )
+		return cached;
+	return insert( key, new MeshData( mesh ), name );
+}
+
+const MeshData* MeshCache::getTorus( float outerRadius, float innerRadius, int longitudeSegments, int latitudeSegments )
+{
+	float values[4] = { outerRadius, innerRadius, (float)longitudeSegments, (float)latitudeSegments };
+	uint64_t key = hashParameters( "torus", values, 4 );
+	if ( const MeshData *cached = find( key ) )
+		return cached;
+
+	MeshData *mesh = new MeshData;
+	buildTorus( mesh, outerRadius, innerRadius, longitudeSegments, latitudeSegments );
+	return insert( key, mesh, "torus" );
+}
+
+const MeshData* MeshCache::getCube( const Vec3f &center, const Vec3f &size )
+{
+	float values[6] = { center.x, center.y, center.z, size.x, size.y, size.z };
+	uint64_t key = hashParameters( "cube", values, 6 );
+	if ( const MeshData *cached = find( key ) )
+		return cached;
+
+	MeshData *mesh = new MeshData;
+	buildCube( mesh, center, size );
+	return insert( key, mesh, "cube" );
+}
+
+const MeshData* MeshCache::getSphere( const Vec3f &center, float radius, int segments )
+{
+	float values[5] = { center.x, center.y, center.z, radius, (float)segments };
+	uint64_t key = hashParameters( "sphere", values, 5 );
+	if ( const MeshData *cached = find( key ) )
+		return cached;
+
+	MeshData *mesh = new MeshData;
+	buildSphere( mesh, center, radius, segments );
+	return insert( key, mesh, "sphere" );
+}
+
+void MeshCache::dump( std::ostream &os ) const
+{
+	std::ios::fmtflags flags	= os.flags();
+	std::streamsize precision	= os.precision();
+
+	os << "mesh cache: " << mEntries.size() << " meshes, " << mHits << " of " << mRequests << " requests shared ( ACMR / ATVR for a "
+	   << mOptions.cacheSize << " entry FIFO )" << std::endl << std::fixed << std::setprecision( 3 );
+	for ( size_t e = 0; e < mEntries.size(); ++e ) {
+		const Entry &entry = *mEntries[e];
+		os << "  " << entry.name << ": " << entry.optimized.triangles << " triangles, " << entry.optimized.vertices << " vertices, ACMR "
+		   << entry.source.acmr << " -> " << entry.optimized.acmr << ", ATVR " << entry.source.atvr << " -> " << entry.optimized.atvr << std::endl;
+	}
+	os.flags( flags );
+	os.precision( precision );
+}
+
+} // namespace ssao
@@ -0,0 +1,265 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace ci;
+
+namespace ssao {
+
+/*
+ * @Description: simulate a FIFO post transform cache over the triangles in index order
+ * @param: indices, vertex count, cache entries
+ * @return: MeshStats
+ */
+MeshStats measureMesh( const std::vector<uint32_t> &indices, size_t vertexCount, int cacheSize )
+{
+	MeshStats stats;
+	stats.vertices	= vertexCount;
+	stats.triangles	= indices.size() / 3;
+
+	//a vertex is still cached while fewer than cacheSize misses happened since it was ( last ) loaded
+	std::vector<unsigned int> loadedAt( vertexCount, 0 );
+	unsigned int misses = 0, clock = cacheSize + 1;
+	for ( size_t i = 0; i < stats.triangles * 3; ++i ) {
+		uint32_t v = indices[i];
+		if ( clock - loadedAt[v] > (unsigned int)cacheSize ) {
+			loadedAt[v] = clock++;
+			++misses;
+		}
+	}
+
+	stats.acmr = stats.triangles ? (float)misses / stats.triangles : 0.0f;
+	stats.atvr = vertexCount ? (float)misses / vertexCount : 0.0f;
+	return stats;
+}
+
+//Forsyth's vertex score: recently used vertices score high ( the last triangle's three a fixed 0.75 so the next
+//triangle doesn't just repeat them ), vertices with few triangles left get a boost so they are finished off
+static const int	FORSYTH_MAX_CACHE	= 64;
+
+static float getVertexScore( int cachePosition, int remaining, int cacheSize )
+{
+	if ( remaining == 0 )
+		return -1.0f;
+
+	float score = 0.0f;
+	if ( cachePosition >= 0 ) {
+		if ( cachePosition < 3 )
+			score = 0.75f;
+		else
+			score = std::pow( 1.0f - (float)( cachePosition - 3 ) / ( cacheSize - 3 ), 1.5f );
+	}
+	return score + 2.0f / std::sqrt( (float)remaining );
+}
+
+/*
+ * @Description: greedy triangle order, always emitting the best scoring triangle touching the cache ( Forsyth, "Linear-Speed Vertex Cache Optimisation" )
+ * @param: indices ( reordered in place ), vertex count, cache entries ( 4 - 64 )
+ * @return: none
+ */
+void optimizeVertexCache( std::vector<uint32_t> *indices, size_t vertexCount, int cacheSize )
+{
+	const size_t numTriangles = indices->size() / 3;
+	if ( numTriangles == 0 )
+		return;
+	cacheSize = std::max( 4, std::min( cacheSize, FORSYTH_MAX_CACHE ) );
+	const std::vector<uint32_t> &source = *indices;
+
+	//triangles of every vertex ( compressed rows ), the first remaining[v] of a row are the ones not emitted yet
+	std::vector<int> remaining( vertexCount, 0 ), rowStart( vertexCount + 1, 0 );
+	for ( size_t i = 0; i < numTriangles * 3; ++i )
+		++remaining[source[i]];
+	for ( size_t v = 0; v < vertexCount; ++v )
+		rowStart[v + 1] = rowStart[v] + remaining[v];
+	std::vector<int> vertexTriangles( rowStart[vertexCount] ), filled( rowStart.begin(), rowStart.end() - 1 );
+	for ( size_t t = 0; t < numTriangles; ++t )
+		for ( int c = 0; c < 3; ++c )
+			vertexTriangles[filled[source[t * 3 + c]]++] = (int)t;
+
+	std::vector<int> cachePosition( vertexCount, -1 );
+	std::vector<float> vertexScore( vertexCount );
+	for ( size_t v = 0; v < vertexCount; ++v )
+		vertexScore[v] = getVertexScore( -1, remaining[v], cacheSize );
+
+	std::vector<float> triangleScore( numTriangles );
+	std::vector<bool> emitted( numTriangles, false );
+	for ( size_t t = 0; t < numTriangles; ++t )
+		triangleScore[t] = vertexScore[source[t * 3]] + vertexScore[source[t * 3 + 1]] + vertexScore[source[t * 3 + 2]];
+
+	std::vector<uint32_t> result;
+	result.reserve( numTriangles * 3 );
+	std::vector<int> cache, nextCache;
+	cache.reserve( cacheSize + 3 );
+	nextCache.reserve( cacheSize + 3 );
+
+	size_t cursor = 0;		//every triangle before it has been emitted
+	int best = -1;
+	while ( result.size() < numTriangles * 3 ) {
+		//nothing in the cache touches a triangle left ( start, or a finished island ): take the next one in the original order
+		if ( best < 0 ) {
+			while ( emitted[cursor] )
+				++cursor;
+			best = (int)cursor;
+		}
+
+		emitted[best] = true;
+		nextCache.clear();
+		for ( int c = 0; c < 3; ++c ) {
+			uint32_t v = source[best * 3 + c];
+			result.push_back( v );
+			nextCache.push_back( (int)v );
+
+			//move the triangle past the vertex's remaining ones
+			int *row = &vertexTriangles[rowStart[v]];
+			for ( int k = 0; k < remaining[v]; ++k ) {
+				if ( row[k] == best ) {
+					std::swap( row[k], row[remaining[v] - 1] );
+					break;
+				}
+			}
+			--remaining[v];
+		}
+
+		//the triangle's vertices go to the front, the rest keeps its order, whatever is past cacheSize falls out
+		for ( size_t k = 0; k < cache.size(); ++k )
+			if ( std::find( nextCache.begin(), nextCache.begin() + 3, cache[k] ) == nextCache.begin() + 3 )
+				nextCache.push_back( cache[k] );
+		for ( size_t k = cacheSize; k < nextCache.size(); ++k ) {
+			cachePosition[nextCache[k]]	= -1;
+			vertexScore[nextCache[k]]	= getVertexScore( -1, remaining[nextCache[k]], cacheSize );
+		}
+		nextCache.resize( std::min( nextCache.size(), (size_t)cacheSize ) );
+		cache.swap( nextCache );
+
+		for ( size_t k = 0; k < cache.size(); ++k ) {
+			cachePosition[cache[k]]	= (int)k;
+			vertexScore[cache[k]]	= getVertexScore( (int)k, remaining[cache[k]], cacheSize );
+		}
+
+		//only triangles of cached vertices changed score, the best of them is next
+		best = -1;
+		float bestScore = -1.0f;
+		for ( size_t k = 0; k < cache.size(); ++k ) {
+			int v = cache[k];
+			for ( int r = 0; r < remaining[v]; ++r ) {
+				int t = vertexTriangles[rowStart[v] + r];
+				triangleScore[t] = vertexScore[source[t * 3]] + vertexScore[source[t * 3 + 1]] + vertexScore[source[t * 3 + 2]];
+				if ( triangleScore[t] > bestScore ) {
+					bestScore	= triangleScore[t];
+					best		= t;
+				}
+			}
+		}
+	}
+
+	indices->swap( result );
+}
+
+void optimizeVertexFetch( MeshData *mesh )
+{
+	const uint32_t UNUSED = 0xffffffffu;
+	std::vector<uint32_t> remap( mesh->positions.size(), UNUSED );
+	std::vector<Vec3f> positions, normals;
+	positions.reserve( mesh->positions.size() );
+	normals.reserve( mesh->normals.size() );
+
+	for ( size_t i = 0; i < mesh->indices.size(); ++i ) {
+		uint32_t &v = mesh->indices[i];
+		if ( remap[v] == UNUSED ) {
+			remap[v] = (uint32_t)positions.size();
+			positions.push_back( mesh->positions[v] );
+			normals.push_back( mesh->normals[v] );
+		}
+		v = remap[v];
+	}
+
+	mesh->positions.swap( positions );
+	mesh->normals.swap( normals );
+}
+
+void optimizeMesh( MeshData *mesh, int cacheSize )
+{
+	optimizeVertexCache( &mesh->indices, mesh->positions.size(), cacheSize );
+	optimizeVertexFetch( mesh );
+}
+
+static int8_t quantizeSnorm8( float value )
+{
+	float scaled = std::floor( std::max( -1.0f, std::min( 1.0f, value ) ) * 127.0f + 0.5f );
+	return (int8_t)scaled;
+}
+
+/*
+ * @Description: pack position + normal per vertex, indices narrowed to 16 bit when the vertex count allows
+ * @param: MeshData, NormalFormat, InterleavedMesh*
+ * @return: none
+ */
+void interleaveMesh( const MeshData &mesh, NormalFormat normalFormat, InterleavedMesh *result )
+{
+	result->normalFormat	= normalFormat;
+	result->numVertices		= mesh.positions.size();
+	result->numIndices		= mesh.indices.size();
+	result->shortIndices	= mesh.positions.size() <= 0x10000;
+
+	const int stride = result->getStride();
+	result->vertices.assign( result->numVertices * stride, 0 );
+	for ( size_t v = 0; v < result->numVertices; ++v ) {
+		uint8_t *vertex = &result->vertices[v * stride];
+		std::memcpy( vertex, &mesh.positions[v].x, 3 * sizeof( float ) );
+
+		const Vec3f &n = mesh.normals[v];
+		if ( normalFormat == NORMAL_BYTE ) {
+			int8_t packed[4] = { quantizeSnorm8( n.x ), quantizeSnorm8( n.y ), quantizeSnorm8( n.z ), 0 };
+			std::memcpy( vertex + result->getNormalOffset(), packed, 4 );
+		}
+		else
+			std::memcpy( vertex + result->getNormalOffset(), &n.x, 3 * sizeof( float ) );
+	}
+
+	result->indices.resize( result->numIndices * result->getIndexSize() );
+	for ( size_t i = 0; i < result->numIndices; ++i ) {
+		if ( result->shortIndices ) {
+			uint16_t index = (uint16_t)mesh.indices[i];
+			std::memcpy( &result->indices[i * 2], &index, 2 );
+		}
+		else
+			std::memcpy( &result->indices[i * 4], &mesh.indices[i], 4 );
+	}
+}
+
+void deinterleaveMesh( const InterleavedMesh &mesh, MeshData *result )
+{
+	const int stride = mesh.getStride();
+	result->positions.resize( mesh.numVertices );
+	result->normals.resize( mesh.numVertices );
+	for ( size_t v = 0; v < mesh.numVertices; ++v ) {
+		const uint8_t *vertex = &mesh.vertices[v * stride];
+		std::memcpy( &result->positions[v].x, vertex, 3 * sizeof( float ) );
+
+		Vec3f &n = result->normals[v];
+		if ( mesh.normalFormat == NORMAL_BYTE ) {
+			int8_t packed[4];
+			std::memcpy( packed, vertex + mesh.getNormalOffset(), 4 );
+			//GL's signed normalized conversion
+			n = Vec3f( std::max( packed[0] / 127.0f, -1.0f ), std::max( packed[1] / 127.0f, -1.0f ), std::max( packed[2] / 127.0f, -1.0f ) );
+			n.normalize();
+		}
+		else
+			std::memcpy( &n.x, vertex + mesh.getNormalOffset(), 3 * sizeof( float ) );
+	}
+
+	result->indices.resize( mesh.numIndices );
+	for ( size_t i = 0; i < mesh.numIndices; ++i ) {
+		if ( mesh.shortIndices ) {
+			uint16_t index;
+			std::memcpy( &index, &mesh.indices[i * 2], 2 );
+			result->indices[i] = index;
+		}
+		else
+			std::memcpy( &result->indices[i], &mesh.indices[i * 4], 4 );
+	}
+}
+
+} // namespace ssao
@@ -0,0 +1,355 @@
+#include "PostChain.h"
+#include "SeparableBlur.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ssao {
+
+/*
+ * 1 channel blur along x of the rows [rowBegin, rowEnd), columns [colBegin, colEnd).
+ * src / dst can be windows into bigger images starting at ( x0, srcY0 ) / ( x0, dstY0 ), taps are clamped to
+ * [0, imageWidth) like GL_CLAMP_TO_EDGE. The window holds every tap short of the image edges, so clamping to it is the same.
+ */
+static void blurH( const FloatImage &src, int x0, int srcY0, FloatImage *dst, int dstY0,
+				   int colBegin, int colEnd, int rowBegin, int rowEnd, int imageWidth, const float *weights )
+{
+	const int width = std::min( src.getWidth(), imageWidth - x0 );
+	for ( int y = rowBegin; y < rowEnd; ++y )
+		blurRow( src.getPixel( 0, y - srcY0 ), width, dst->getPixel( 0, y - dstY0 ), colBegin - x0, colEnd - x0, weights, PostChain::BLUR_RADIUS );
+}
+
+//same along y, src and dst windows may start at different x
+static void blurV( const FloatImage &src, int srcX0, int srcY0, FloatImage *dst, int dstX0, int dstY0,
+				   int colBegin, int colEnd, int rowBegin, int rowEnd, int imageHeight, const float *weights )
+{
+	const int R = PostChain::BLUR_RADIUS;
+	const float *rows[2 * R + 1];
+	for ( int y = rowBegin; y < rowEnd; ++y ) {
+		for ( int k = -R; k <= R; ++k ) {
+			int sy = std::min( std::max( y + k, 0 ), imageHeight - 1 );
+			rows[k + R] = src.getPixel( colBegin - srcX0, sy - srcY0 );
+		}
+		blurColumns( rows, dst->getPixel( colBegin - dstX0, y - dstY0 ), 0, colEnd - colBegin, weights, R );
+	}
+}
+
+/*
+ * bilinear AO lookup at output pixel ( ox, oy ) from a window of the AO image starting at ( x0, y0 )
+ */
+static inline float sampleAO( const FloatImage &window, int x0, int y0, int aoWidth, int aoHeight, float scaleX, float scaleY, int ox, int oy )
+{
+	float fx = ( ox + 0.5f ) * scaleX - 0.5f;
+	float fy = ( oy + 0.5f ) * scaleY - 0.5f;
+	float xf = std::floor( fx ), yf = std::floor( fy );
+	float tx = fx - xf, ty = fy - yf;
+
+	int ax0 = std::min( std::max( (int)xf, 0 ), aoWidth - 1 ) - x0;
+	int ax1 = std::min( std::max( (int)xf + 1, 0 ), aoWidth - 1 ) - x0;
+	int ay0 = std::min( std::max( (int)yf, 0 ), aoHeight - 1 ) - y0;
+	int ay1 = std::min( std::max( (int)yf + 1, 0 ), aoHeight - 1 ) - y0;
+
+	float bottom	= *window.getPixel( ax0, ay0 ) + ( *window.getPixel( ax1, ay0 ) - *window.getPixel( ax0, ay0 ) ) * tx;
+	float top		= *window.getPixel( ax0, ay1 ) + ( *window.getPixel( ax1, ay1 ) - *window.getPixel( ax0, ay1 ) ) * tx;
+	return bottom + ( top - bottom ) * ty;
+}
+
+//first output pixel owned by AO column / row a ( the tiles partition the output without gaps )
+static inline int outputBegin( int a, int aoSize, int outSize )
+{
+	return (int)( ( (double)a * outSize + aoSize - 1 ) / aoSize );
+}
+
+class PostChain::FusedJob : public TaskPool::Job
+{
+public:
+	FusedJob( PostChain *chain ) : mChain( chain ) {}
+	void run( int index, int threadIndex ) { mChain->runFusedTile( index, threadIndex ); }
+private:
+	PostChain *mChain;
+};
+
+/*
+ * one full frame pass of the unfused chain, one task per block of rows
+ */
+class PostChain::PassJob : public TaskPool::Job
+{
+public:
+	enum Pass { SSAO, BLUR_H, BLUR_V, COMPOSITE, BLUR_V_COMPOSITE };
+	static const int ROWS_PER_TASK = 16;
+
+	PassJob( PostChain *chain, Pass pass, int rows ) : mChain( chain ), mPass( pass ), mRows( rows ) {}
+
+	int getNumTasks() const { return ( mRows + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK; }
+
+	void run( int index, int threadIndex )
+	{
+		PostChain &c	= *mChain;
+		int rowBegin	= index * ROWS_PER_TASK;
+		int rowEnd		= std::min( rowBegin + ROWS_PER_TASK, mRows );
+
+		switch ( mPass ) {
+			case SSAO:
+				c.mEngine->computeRegion( *c.mNormalDepth, &c.mSSAOMap, 0, c.mAOWidth, rowBegin, rowEnd );
+				break;
+			case BLUR_H:
+				blurH( c.mSSAOMap, 0, 0, &c.mBlurH, 0, 0, c.mAOWidth, rowBegin, rowEnd, c.mAOWidth, &c.mBlurWeights[0] );
+				break;
+			case BLUR_V:
+				blurV( c.mBlurH, 0, 0, &c.mBlurV, 0, 0, 0, c.mAOWidth, rowBegin, rowEnd, c.mAOHeight, &c.mBlurWeights[0] );
+				break;
+			case COMPOSITE: {
+				int outW = c.mResult->getWidth();
+				float scaleX = (float)c.mAOWidth / outW, scaleY = (float)c.mAOHeight / c.mResult->getHeight();
+				for ( int y = rowBegin; y < rowEnd; ++y )
+					for ( int x = 0; x < outW; ++x )
+						compositeAO( c.mBase->getPixel( x, y ), sampleAO( c.mBlurV, 0, 0, c.mAOWidth, c.mAOHeight, scaleX, scaleY, x, y ), c.mResult->getPixel( x, y ) );
+				break;
+			}
+			case BLUR_V_COMPOSITE:
+				c.blurComposite( rowBegin, rowEnd, threadIndex );
+				break;
+		}
+	}
+
+private:
+	PostChain	*mChain;
+	Pass		mPass;
+	int			mRows;
+};
+
+/*
+ * @Description: constructor
+ * @param: TaskPool*, SSAOEngine* ( both borrowed )
+ * @return: none
+ */
+PostChain::PostChain( TaskPool *pool, const SSAOEngine *engine )
+: mPool( pool ), mEngine( engine ), mTileSize( 128 ), mNormalDepth( 0 ), mBase( 0 ), mResult( 0 ),
+  mAOWidth( 0 ), mAOHeight( 0 ), mTilesX( 0 ), mTilesY( 0 )
+{
+	mScratch.resize( pool->getNumThreads() );
+
+	std::vector<float> half;
+	computeBlurWeights( BlurParams(), &half );
+	mBlurWeights.resize( 2 * BLUR_RADIUS + 1 );
+	for ( int k = -BLUR_RADIUS; k <= BLUR_RADIUS; ++k )
+		mBlurWeights[k + BLUR_RADIUS] = half[std::abs( k )];
+}
+
+/*
+ * @Description: SSAO -> blur -> composite one tile at a time
+ * @param: normal/depth, base color, AO resolution, FloatImage* result
+ * @return: none
+ */
+void PostChain::runFused( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result )
+{
+	if ( result->getWidth() != base.getWidth() || result->getHeight() != base.getHeight() || result->getChannels() != 4 )
+		result->allocate( base.getWidth(), base.getHeight(), 4 );
+
+	mNormalDepth	= &normalDepth;
+	mBase			= &base;
+	mResult			= result;
+	mAOWidth		= aoWidth;
+	mAOHeight		= aoHeight;
+	mTilesX			= ( aoWidth + mTileSize - 1 ) / mTileSize;
+	mTilesY			= ( aoHeight + mTileSize - 1 ) / mTileSize;
+
+	//the intermediates never leave the tile scratch
+	mTraffic					= ChainTraffic();
+	mTraffic.frameRead			= ( (size_t)normalDepth.getWidth() * normalDepth.getHeight() + (size_t)base.getWidth() * base.getHeight() ) * 4 * sizeof( float );
+	mTraffic.frameWritten		= (size_t)base.getWidth() * base.getHeight() * 4 * sizeof( float );
+
+	ci::Timer timer( true );
+	FusedJob job( this );
+	mPool->parallelFor( mTilesX * mTilesY, &job );
+	mTimings		= ChainTimings();
+	mTimings.total	= timer.getSeconds() * 1000.0;
+}
+
+/*
+ * @Description: one tile of the fused chain, every intermediate lives in this thread's Scratch
+ * @param: int tile, int thread index
+ * @return: none
+ */
+void PostChain::runFusedTile( int tile, int threadIndex )
+{
+	const int R		= BLUR_RADIUS;
+	const int outW	= mResult->getWidth();
+	const int outH	= mResult->getHeight();
+
+	//AO texels this tile is responsible for
+	const int x0 = ( tile % mTilesX ) * mTileSize,	x1 = std::min( x0 + mTileSize, mAOWidth );
+	const int y0 = ( tile / mTilesX ) * mTileSize,	y1 = std::min( y0 + mTileSize, mAOHeight );
+
+	//the composite's bilinear lookups reach one texel ( more if AO is bigger than the output ) past the tile
+	const int margin = 1 + mAOWidth / outW;
+	const int bx0 = std::max( x0 - margin, 0 ), bx1 = std::min( x1 + margin, mAOWidth );
+	const int by0 = std::max( y0 - margin, 0 ), by1 = std::min( y1 + margin, mAOHeight );
+
+	//plus the blur apron for the SSAO itself
+	const int sx0 = std::max( bx0 - R, 0 ), sx1 = std::min( bx1 + R, mAOWidth );
+	const int sy0 = std::max( by0 - R, 0 ), sy1 = std::min( by1 + R, mAOHeight );
+
+	Scratch &s = mScratch[threadIndex];
+	if ( s.ssao.getWidth() < sx1 - sx0 || s.ssao.getHeight() < sy1 - sy0 ) {
+		int w = mTileSize + 2 * ( margin + R ), h = w;
+		s.ssao.allocate( std::max( w, sx1 - sx0 ), std::max( h, sy1 - sy0 ), 1 );
+		s.blurH.allocate( s.ssao.getWidth(), s.ssao.getHeight(), 1 );
+		s.blurV.allocate( s.ssao.getWidth(), s.ssao.getHeight(), 1 );
+	}
+
+	//SSAO into the tile local window
+	for ( int y = sy0; y < sy1; ++y )
+		mEngine->computeSpan( *mNormalDepth, mAOWidth, mAOHeight, y, sx0, sx1, s.ssao.getPixel( 0, y - sy0 ) );
+
+	blurH( s.ssao, sx0, sy0, &s.blurH, sy0, bx0, bx1, sy0, sy1, mAOWidth, &mBlurWeights[0] );
+	blurV( s.blurH, sx0, sy0, &s.blurV, bx0, by0, bx0, bx1, by0, by1, mAOHeight, &mBlurWeights[0] );
+
+	//composite every output pixel owned by this tile
+	const float scaleX = (float)mAOWidth / outW, scaleY = (float)mAOHeight / outH;
+	const int ox0 = outputBegin( x0, mAOWidth, outW ), ox1 = outputBegin( x1, mAOWidth, outW );
+	const int oy0 = outputBegin( y0, mAOHeight, outH ), oy1 = outputBegin( y1, mAOHeight, outH );
+
+	for ( int oy = oy0; oy < oy1; ++oy )
+		for ( int ox = ox0; ox < ox1; ++ox )
+			compositeAO( mBase->getPixel( ox, oy ), sampleAO( s.blurV, bx0, by0, mAOWidth, mAOHeight, scaleX, scaleY, ox, oy ), mResult->getPixel( ox, oy ) );
+}
+
+/*
+ * @Description: composite rows [rowBegin, rowEnd) of the output, blurring mBlurH vertically on the way: each output row
+ *				 interpolates between two AO rows, those are blurred into this thread's Scratch ( once per task when
+ *				 consecutive output rows share them ). Same operations as BLUR_V + COMPOSITE, so the same pixels
+ * @param: int rowBegin, int rowEnd, int thread index
+ * @return: none
+ */
+void PostChain::blurComposite( int rowBegin, int rowEnd, int threadIndex )
+{
+	const int outW		= mResult->getWidth();
+	const float scaleX	= (float)mAOWidth / outW, scaleY = (float)mAOHeight / mResult->getHeight();
+
+	Scratch &s = mScratch[threadIndex];
+	if ( s.blurRows.getWidth() < mAOWidth )
+		s.blurRows.allocate( mAOWidth, 2, 1 );
+
+	int blurred = -2;
+	for ( int y = rowBegin; y < rowEnd; ++y ) {
+		float fy	= ( y + 0.5f ) * scaleY - 0.5f;
+		float yf	= std::floor( fy );
+		float ty	= fy - yf;
+		int ay0		= std::min( std::max( (int)yf, 0 ), mAOHeight - 1 );
+		int ay1		= std::min( std::max( (int)yf + 1, 0 ), mAOHeight - 1 );
+
+		//rows clamp at the edges, so key on the unclamped one
+		if ( (int)yf != blurred ) {
+			blurV( mBlurH, 0, 0, &s.blurRows, 0, ay0, 0, mAOWidth, ay0, ay0 + 1, mAOHeight, &mBlurWeights[0] );
+			blurV( mBlurH, 0, 0, &s.blurRows, 0, ay1 - 1, 0, mAOWidth, ay1, ay1 + 1, mAOHeight, &mBlurWeights[0] );
+			blurred = (int)yf;
+		}
+		const float *row0 = s.blurRows.getPixel( 0, 0 ), *row1 = s.blurRows.getPixel( 0, 1 );
+
+		for ( int x = 0; x < outW; ++x ) {
+			float fx	= ( x + 0.5f ) * scaleX - 0.5f;
+			float xf	= std::floor( fx );
+			float tx	= fx - xf;
+			int ax0		= std::min( std::max( (int)xf, 0 ), mAOWidth - 1 );
+			int ax1		= std::min( std::max( (int)xf + 1, 0 ), mAOWidth - 1 );
+
+			float bottom	= row0[ax0] + ( row0[ax1] - row0[ax0] ) * tx;
+			float top		= row1[ax0] + ( row1[ax1] - row1[ax0] ) * tx;
+			compositeAO( mBase->getPixel( x, y ), bottom + ( top - bottom ) * ty, mResult->getPixel( x, y ) );
+		}
+	}
+}
+
+void PostChain::begin( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result )
+{
+	if ( result->getWidth() != base.getWidth() || result->getHeight() != base.getHeight() || result->getChannels() != 4 )
+		result->allocate( base.getWidth(), base.getHeight(), 4 );
+
+	mNormalDepth	= &normalDepth;
+	mBase			= &base;
+	mResult			= result;
+	mAOWidth		= aoWidth;
+	mAOHeight		= aoHeight;
+
+	if ( mSSAOMap.getWidth() != aoWidth || mSSAOMap.getHeight() != aoHeight ) {
+		mSSAOMap.allocate( aoWidth, aoHeight, 1 );
+		mBlurH.allocate( aoWidth, aoHeight, 1 );
+		mBlurV.allocate( aoWidth, aoHeight, 1 );
+	}
+}
+
+/*
+ * @Description: SSAO, blur H, then blur V + composite as one pass or as two with mBlurV in between
+ * @param: bool fuseComposite
+ * @return: none
+ */
+void PostChain::runPasses( bool fuseComposite )
+{
+	const size_t aoBytes = (size_t)mAOWidth * mAOHeight * sizeof( float );
+	mTraffic				= ChainTraffic();
+	mTraffic.frameRead		= ( (size_t)mNormalDepth->getWidth() * mNormalDepth->getHeight() + (size_t)mBase->getWidth() * mBase->getHeight() ) * 4 * sizeof( float );
+	mTraffic.frameWritten	= (size_t)mResult->getWidth() * mResult->getHeight() * 4 * sizeof( float );
+	mTimings				= ChainTimings();
+
+	ci::Timer timer( true );
+	PassJob ssaoPass( this, PassJob::SSAO, mAOHeight );
+	mPool->parallelFor( ssaoPass.getNumTasks(), &ssaoPass );
+	mTimings.ssao = timer.getSeconds() * 1000.0;
+
+	double start = timer.getSeconds() * 1000.0;
+	PassJob hPass( this, PassJob::BLUR_H, mAOHeight );
+	mPool->parallelFor( hPass.getNumTasks(), &hPass );
+	mTimings.blurH = timer.getSeconds() * 1000.0 - start;
+	//mSSAOMap and mBlurH each written once and read once
+	mTraffic.intermediateWritten	= 2 * aoBytes;
+	mTraffic.intermediateRead		= 2 * aoBytes;
+
+	if ( fuseComposite ) {
+		start = timer.getSeconds() * 1000.0;
+		PassJob composite( this, PassJob::BLUR_V_COMPOSITE, mResult->getHeight() );
+		mPool->parallelFor( composite.getNumTasks(), &composite );
+		mTimings.composite	= timer.getSeconds() * 1000.0 - start;
+		mTimings.total		= timer.getSeconds() * 1000.0;
+		return;
+	}
+
+	start = timer.getSeconds() * 1000.0;
+	PassJob vPass( this, PassJob::BLUR_V, mAOHeight );
+	mPool->parallelFor( vPass.getNumTasks(), &vPass );
+	mTimings.blurV = timer.getSeconds() * 1000.0 - start;
+
+	start = timer.getSeconds() * 1000.0;
+	PassJob composite( this, PassJob::COMPOSITE, mResult->getHeight() );
+	mPool->parallelFor( composite.getNumTasks(), &composite );
+	mTimings.composite	= timer.getSeconds() * 1000.0 - start;
+	mTimings.total		= timer.getSeconds() * 1000.0;
+	mTraffic.intermediateWritten	+= aoBytes;
+	mTraffic.intermediateRead		+= aoBytes;
+}
+
+/*
+ * @Description: the GL path on the CPU, full frame buffer between every pass
+ * @param: normal/depth, base color, AO resolution, FloatImage* result
+ * @return: none
+ */
+void PostChain::runUnfused( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result )
+{
+	begin( normalDepth, base, aoWidth, aoHeight, result );
+	runPasses( false );
+}
+
+/*
+ * @Description: runUnfused() without mBlurV, the vertical blur is done by the composite
+ * @param: normal/depth, base color, AO resolution, FloatImage* result
+ * @return: none
+ */
+void PostChain::runFusedComposite( const FloatImage &normalDepth, const FloatImage &base, int aoWidth, int aoHeight, FloatImage *result )
+{
+	begin( normalDepth, base, aoWidth, aoHeight, result );
+	runPasses( true );
+}
+
+} // namespace ssao
@@ -0,0 +1,145 @@
+#include "ResolutionController.h"
+
+#include <algorithm>
+
+namespace ssao {
+
+ResolutionController::ResolutionController( const ResolutionParams &params )
+: mRung( 0 ), mSettle( 0 ), mCooldown( 0 ), mProbation( 0 ), mMeasuredMs( 0.0f ), mNumChanges( 0 )
+{
+	mParams = params;
+	buildLadder();
+	reset( mParams.maxScale, mParams.maxTier );
+}
+
+void ResolutionController::setParams( const ResolutionParams &params )
+{
+	float scale			= getScale();
+	QualityTier tier	= getTier();
+	mParams = params;
+	buildLadder();
+	reset( scale, tier );
+}
+
+void ResolutionController::reset( float scale, QualityTier tier )
+{
+	mRung		= findRung( scale, tier );
+	mSamples	= SampleHistory( std::max( mParams.windowFrames, 1 ) );
+	mSettle		= 0;
+	mCooldown	= 0;
+	mBackoff	= mParams.cooldownFrames;
+	mProbation	= 0;
+	mMeasuredMs	= 0.0f;
+}
+
+float ResolutionController::getCost( float scale, QualityTier tier )
+{
+	return scale * scale * getTierSamples( tier );
+}
+
+/*
+ * @Description: judge the frames since the last change once there are enough of them, move along the ladder
+ * @param: frame time in ms ( whatever the caller holds to the budget, CPU or GPU )
+ * @return: bool ( the scale or tier changed, rebuild what depends on them )
+ */
+bool ResolutionController::update( float frameMs )
+{
+	if ( mCooldown > 0 )
+		--mCooldown;
+	//the last step up held for as long as the cooldown before it, the next one waits the short cooldown again
+	if ( mProbation > 0 && !--mProbation )
+		mBackoff = mParams.cooldownFrames;
+	if ( mSettle > 0 ) {
+		--mSettle;
+		return false;
+	}
+
+	mSamples.push( frameMs );
+	if ( (int)mSamples.size() < mParams.windowFrames )
+		return false;
+
+	mSamples.getSamples( &mSorted );
+	std::sort( mSorted.begin(), mSorted.end() );
+	mMeasuredMs = percentile( mSorted, mParams.percentile );
+
+	if ( mMeasuredMs > mParams.budgetMs && mRung > 0 ) {
+		//the AO is only part of the frame, so scaling its cost by budget / measured undershoots rather than overshoots
+		float fit = mRungs[mRung].cost * mParams.budgetMs / mMeasuredMs;
+		int rung = mRung - 1;
+		while ( rung > 0 && mRungs[rung].cost > fit )
+			--rung;
+
+		mBackoff	= mProbation ? std::min( mBackoff * 2, mParams.maxCooldownFrames ) : mParams.cooldownFrames;
+		mCooldown	= mBackoff;
+		mProbation	= 0;
+		setRung( rung );
+		return true;
+	}
+
+	if ( mMeasuredMs < mParams.budgetMs * mParams.headroom && mRung + 1 < (int)mRungs.size() && !mCooldown ) {
+		mProbation = mBackoff;
+		setRung( mRung + 1 );
+		return true;
+	}
+	return false;
+}
+
+/*
+ * @Description: walk from ( minScale, minTier ) to ( maxScale, maxTier ) one notch at a time, raising whichever of the
+ *				 two is further behind in its own range ( quarter res at 32 samples looks worse than half res at 10 )
+ * @param: none
+ * @return: none
+ */
+void ResolutionController::buildLadder()
+{
+	std::vector<float> scales;
+	float minScale = std::min( mParams.minScale, mParams.maxScale );
+	if ( mParams.scaleStep > 0.0f )
+		for ( float scale = minScale; scale < mParams.maxScale - mParams.scaleStep * 0.5f; scale += mParams.scaleStep )
+			scales.push_back( scale );
+	scales.push_back( mParams.maxScale );
+
+	int minTier		= std::min( mParams.minTier, mParams.maxTier );
+	int numTiers	= std::max( mParams.minTier, mParams.maxTier ) - minTier + 1;
+	int numScales	= (int)scales.size();
+
+	mRungs.clear();
+	int s = 0, t = 0;
+	while ( true ) {
+		Rung rung;
+		rung.scale	= scales[s];
+		rung.tier	= (QualityTier)( minTier + t );
+		rung.cost	= getCost( rung.scale, rung.tier );
+		mRungs.push_back( rung );
+
+		if ( s + 1 == numScales && t + 1 == numTiers )
+			break;
+		//progress through each range, ties go to the resolution ( no shader switch )
+		float scaleDone	= numScales > 1 ? (float)s / ( numScales - 1 ) : 1.0f;
+		float tierDone	= numTiers > 1 ? (float)t / ( numTiers - 1 ) : 1.0f;
+		if ( s + 1 < numScales && ( t + 1 == numTiers || scaleDone <= tierDone ) )
+			++s;
+		else
+			++t;
+	}
+	mRung = std::min( mRung, (int)mRungs.size() - 1 );
+}
+
+int ResolutionController::findRung( float scale, QualityTier tier ) const
+{
+	float cost = getCost( scale, tier ) * 1.0001f;
+	int rung = 0;
+	while ( rung + 1 < (int)mRungs.size() && mRungs[rung + 1].cost <= cost )
+		++rung;
+	return rung;
+}
+
+void ResolutionController::setRung( int rung )
+{
+	mRung	= rung;
+	mSettle	= mParams.settleFrames;
+	mSamples.clear();
+	++mNumChanges;
+}
+
+} // namespace ssao
@@ -0,0 +1,658 @@
+#include "SSAOEngine.h"
+#include "BlueNoise.h"
+#include "HiZPyramid.h"
+#include "SeparableBlur.h"
+#include "SimdFloat.h"
+#include "TemporalAO.h"
+
+#include "cinder/Timer.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace ssao {
+
+static const float PI = 3.14159265f;
+
+const char* getAOMethodName( AOMethod method )
+{
+	static const char *names[NUM_AO_METHODS] = { "SSAO", "Horizon" };
+	return names[method];
+}
+
+//rand() from the shader
+static inline float shaderRand( float u, float v )
+{
+	float s = std::sin( u * 12.9898f + v * 78.233f ) * 43758.5453f;
+	return s - std::floor( s );
+}
+
+static inline float smoothstepf( float edge0, float edge1, float x )
+{
+	float t = std::min( std::max( ( x - edge0 ) / ( edge1 - edge0 ), 0.0f ), 1.0f );
+	return t * t * ( 3.0f - 2.0f * t );
+}
+
+static inline float signf( float x )
+{
+	return x > 0.0f ? 1.0f : ( x < 0.0f ? -1.0f : 0.0f );
+}
+
+/*
+ * @Description: constructor, rnm is the blue noise rotation tile the app uploads ( no image decoding )
+ * @param: none
+ * @return: none
+ */
+SSAOEngine::SSAOEngine()
+: mNoiseLookup( NOISE_TILE )
+{
+	generateKernel( mParams.kernel, std::min( std::max( mParams.samples, 1 ), SSAO_KERNEL_SIZE ), &mKernel );
+	buildRotationTile( BLUE_NOISE_TILE, BLUE_NOISE_SIZE, &mNoise );
+}
+
+/*
+ * @Description: set the shader constants, the kernel is only rebuilt when its params or the sample count changed
+ * @param: SSAOParams
+ * @return: none
+ */
+void SSAOEngine::setParams( const SSAOParams &params )
+{
+	const KernelParams &a = params.kernel, &b = mParams.kernel;
+	bool kernelChanged = params.samples != mParams.samples || a.type != b.type || a.towardCenter != b.towardCenter
+						 || a.minScale != b.minScale || a.seed != b.seed;
+	mParams = params;
+	if ( kernelChanged )
+		generateKernel( mParams.kernel, std::min( std::max( mParams.samples, 1 ), SSAO_KERNEL_SIZE ), &mKernel );
+}
+
+/*
+ * @Description: set the rnm texture
+ * @param: FloatImage ( 3 or 4 channels, values in [0,1] ), NoiseLookup
+ * @return: none
+ */
+void SSAOEngine::setNoise( const FloatImage &noise, NoiseLookup lookup )
+{
+	mNoise			= noise;
+	mNoiseLookup	= lookup;
+}
+
+/*
+ * @Description: which simd path this build was compiled for
+ * @param: none
+ * @return: const char*
+ */
+const char* SSAOEngine::getSimdPathName()
+{
+	return simd::getPathName();
+}
+
+int SSAOEngine::getSimdWidth()
+{
+	return simd::WIDTH;
+}
+
+/*
+ * @Description: run SSAO over the whole output buffer ( allocated to the normal/depth size if empty )
+ * @param: FloatImage normal/depth, FloatImage* AO output, KernelPath
+ * @return: none
+ */
+void SSAOEngine::compute( const FloatImage &normalDepth, FloatImage *ao, KernelPath path ) const
+{
+	if ( ao->isEmpty() || ao->getChannels() != 1 )
+		ao->allocate( normalDepth.getWidth(), normalDepth.getHeight(), 1 );
+
+	computeRegion( normalDepth, ao, 0, ao->getWidth(), 0, ao->getHeight(), path );
+}
+
+/*
+ * @Description: run SSAO over a sub rectangle of the output ( used by the tiled executors )
+ * @param: FloatImage normal/depth, FloatImage* AO output, column range, row range, KernelPath
+ * @return: none
+ */
+void SSAOEngine::computeRegion( const FloatImage &normalDepth, FloatImage *ao, int colBegin, int colEnd, int rowBegin, int rowEnd, KernelPath path ) const
+{
+	for ( int y = rowBegin; y < rowEnd; ++y )
+		computeSpan( normalDepth, ao->getWidth(), ao->getHeight(), y, colBegin, colEnd, ao->getPixel( colBegin, y ), path );
+}
+
+/*
+ * @Description: run SSAO over part of one row of a ( virtual ) aoWidth x aoHeight target, lets tiled callers write into their own scratch
+ * @param: FloatImage normal/depth, AO target size, row, column range, float* output, KernelPath
+ * @return: none
+ */
+void SSAOEngine::computeSpan( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out, KernelPath path ) const
+{
+	if ( mParams.method == AO_HORIZON ) {
+		computeSpanHorizon( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out );
+		return;
+	}
+
+	//the sample counts the shader variants are built for get a kernel with a compile time trip count, anything else the generic loop
+	switch ( mParams.samples ) {
+		case 4:		computeSpanVariant<4>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out, path );	break;
+		case 8:		computeSpanVariant<8>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out, path );	break;
+		case 10:	computeSpanVariant<10>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out, path );	break;
+		case 16:	computeSpanVariant<16>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out, path );	break;
+		case 32:	computeSpanVariant<32>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out, path );	break;
+		default:	computeSpanVariant<0>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out, path );	break;
+	}
+}
+
+template<int SAMPLES>
+void SSAOEngine::computeSpanVariant( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out, KernelPath path ) const
+{
+	if ( path == PATH_SIMD )
+		computeSpanSimd<SAMPLES>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out );
+	else
+		computeSpanScalar<SAMPLES>( normalDepth, aoWidth, aoHeight, y, colBegin, colEnd, out );
+}
+
+/*
+ * @Description: grab a normal for reflecting the sample rays later on ( same lookup as the shader )
+ * @param: AO pixel, its uv, float[3] result
+ * @return: none
+ */
+void SSAOEngine::fetchReflectionNormal( int x, int y, float u, float v, float *fres ) const
+{
+	float noise[4];
+	if ( mNoiseLookup == NOISE_TILE ) {
+		const float *texel = mNoise.getPixel( x % mNoise.getWidth(), y % mNoise.getHeight() );
+		std::copy( texel, texel + 3, noise );
+	}
+	else {
+		float r = shaderRand( u, v ) * mParams.offset;
+		mNoise.sampleBilinear( r * u, r * v, noise );
+	}
+
+	float nx = noise[0] * 2.0f - 1.0f;
+	float ny = noise[1] * 2.0f - 1.0f;
+	float nz = noise[2] * 2.0f - 1.0f;
+	float len = std::sqrt( nx * nx + ny * ny + nz * nz );
+	float inv = len > 0.0f ? 1.0f / len : 0.0f;
+
+	nx *= inv;
+	ny *= inv;
+	if ( mParams.rotation != 0.0f ) {
+		float c = std::cos( mParams.rotation ), s = std::sin( mParams.rotation );
+		float rx = c * nx - s * ny;
+		ny = s * nx + c * ny;
+		nx = rx;
+	}
+
+	fres[0] = nx;
+	fres[1] = ny;
+	fres[2] = nz * inv;
+}
+
+/*
+ * @Description: the shader, line for line, one pixel at a time ( SAMPLES 0 = mParams.samples at run time )
+ * @param: FloatImage normal/depth, AO target size, row, column range, float* output
+ * @return: none
+ */
+template<int SAMPLES>
+void SSAOEngine::computeSpanScalar( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const
+{
+	const int samples		= SAMPLES > 0 ? SAMPLES : std::min( std::max( mParams.samples, 1 ), SSAO_KERNEL_SIZE );
+	const float invSamples	= -0.5f / samples;
+	const float invW		= 1.0f / aoWidth;
+	const float v			= ( y + 0.5f ) * 1.0f / aoHeight;
+
+	for ( int x = colBegin; x < colEnd; ++x ) {
+		float u = ( x + 0.5f ) * invW;
+
+		float fres[3];
+		fetchReflectionNormal( x, y, u, v, fres );
+
+		float current[4];
+		normalDepth.sampleBilinear( u, v, current );
+		const float currentPixelDepth = current[3];
+
+		float bl = 0.0f;
+		for ( int i = 0; i < samples; ++i ) {
+			const float *k = &mKernel[i * 3];
+
+			//ray = rad * reflect( pSphere[i], fres )
+			float kDotN = k[0] * fres[0] + k[1] * fres[1] + k[2] * fres[2];
+			float rx = mParams.rad * ( k[0] - 2.0f * kDotN * fres[0] );
+			float ry = mParams.rad * ( k[1] - 2.0f * kDotN * fres[1] );
+			float rz = mParams.rad * ( k[2] - 2.0f * kDotN * fres[2] );
+
+			//if the ray is outside the hemisphere then change direction
+			float s = signf( rx * current[0] + ry * current[1] + rz * current[2] );
+
+			float occluder[4];
+			normalDepth.sampleBilinear( u + s * rx, v + s * ry, occluder );
+
+			float depthDifference	= currentPixelDepth - occluder[3];
+			float normDiff			= 1.0f - ( occluder[0] * current[0] + occluder[1] * current[1] + occluder[2] * current[2] );
+			float stepTerm			= depthDifference >= mParams.falloff ? 1.0f : 0.0f;
+
+			bl += stepTerm * normDiff * ( 1.0f - smoothstepf( mParams.falloff, mParams.strength, depthDifference ) );
+		}
+
+		out[x - colBegin] = 1.0f + bl * invSamples;
+	}
+}
+
+/*
+ * @Description: run the pyramid version over the whole output buffer ( allocated to the normal/depth size if empty )
+ * @param: FloatImage normal/depth, HiZPyramid built from it, FloatImage* AO output
+ * @return: none
+ */
+void SSAOEngine::computeHiZ( const FloatImage &normalDepth, const HiZPyramid &pyramid, FloatImage *ao ) const
+{
+	if ( ao->isEmpty() || ao->getChannels() != 1 )
+		ao->allocate( normalDepth.getWidth(), normalDepth.getHeight(), 1 );
+
+	computeRegionHiZ( normalDepth, pyramid, ao, 0, ao->getWidth(), 0, ao->getHeight() );
+}
+
+void SSAOEngine::computeRegionHiZ( const FloatImage &normalDepth, const HiZPyramid &pyramid, FloatImage *ao, int colBegin, int colEnd, int rowBegin, int rowEnd ) const
+{
+	for ( int y = rowBegin; y < rowEnd; ++y )
+		computeSpanHiZ( normalDepth, pyramid, ao->getWidth(), ao->getHeight(), y, colBegin, colEnd, ao->getPixel( colBegin, y ) );
+}
+
+/*
+ * @Description: computeSpanScalar() with the occluder lookups going through the min / max pyramid
+ * @param: FloatImage normal/depth, HiZPyramid, AO target size, row, column range, float* output
+ * @return: none
+ */
+void SSAOEngine::computeSpanHiZ( const FloatImage &normalDepth, const HiZPyramid &pyramid, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const
+{
+	const int samples		= std::min( std::max( mParams.samples, 1 ), SSAO_KERNEL_SIZE );
+	const float invSamples	= -0.5f / samples;
+	const float invW		= 1.0f / aoWidth;
+	const float v			= ( y + 0.5f ) * 1.0f / aoHeight;
+	const float texW		= (float)pyramid.getLevel( 0 ).getWidth();
+	const float texH		= (float)pyramid.getLevel( 0 ).getHeight();
+
+	for ( int x = colBegin; x < colEnd; ++x ) {
+		float u = ( x + 0.5f ) * invW;
+
+		float fres[3];
+		fetchReflectionNormal( x, y, u, v, fres );
+
+		float current[4];
+		normalDepth.sampleBilinear( u, v, current );
+		const float currentPixelDepth = current[3];
+
+		float bl = 0.0f;
+		for ( int i = 0; i < samples; ++i ) {
+			const float *k = &mKernel[i * 3];
+
+			float kDotN = k[0] * fres[0] + k[1] * fres[1] + k[2] * fres[2];
+			float rx = mParams.rad * ( k[0] - 2.0f * kDotN * fres[0] );
+			float ry = mParams.rad * ( k[1] - 2.0f * kDotN * fres[1] );
+			float rz = mParams.rad * ( k[2] - 2.0f * kDotN * fres[2] );
+			float s = signf( rx * current[0] + ry * current[1] + rz * current[2] );
+
+			//the further out the tap, the coarser the level
+			float ox = s * rx * texW, oy = s * ry * texH;
+			int level = pyramid.selectLevelSquared( ox * ox + oy * oy );
+
+			float occluder[4];
+			pyramid.sample( u + s * rx, v + s * ry, level, occluder );
+
+			//behind us or too far in front ( most taps ), no need to look at the normal
+			float depthDifference	= currentPixelDepth - occluder[0];
+			if ( depthDifference < mParams.falloff || depthDifference >= mParams.strength )
+				continue;
+
+			//the part of the texel's depth range in front of us, a flat texel ( always at level 0 ) is all or nothing like step() in the shader
+			float range				= occluder[1] - occluder[0];
+			float coverage			= range > 0.0f ? std::min( depthDifference / range, 1.0f ) : 1.0f;
+			float occluderNormal[3];
+			decodeOctahedral( occluder + 2, occluderNormal );
+			float normDiff			= 1.0f - ( occluderNormal[0] * current[0] + occluderNormal[1] * current[1] + occluderNormal[2] * current[2] );
+
+			bl += coverage * normDiff * ( 1.0f - smoothstepf( mParams.falloff, mParams.strength, depthDifference ) );
+		}
+
+		out[x - colBegin] = 1.0f + bl * invSamples;
+	}
+}
+
+/*
+ * @Description: same math as computeSpanScalar() but simd::WIDTH pixels at a time, occluder lookups are bilinear gathers
+ * @param: FloatImage normal/depth, AO target size, row, column range, float* output
+ * @return: none
+ */
+template<int SAMPLES>
+void SSAOEngine::computeSpanSimd( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const
+{
+	using namespace simd;
+
+	const int W				= WIDTH;
+	const int samples		= SAMPLES > 0 ? SAMPLES : std::min( std::max( mParams.samples, 1 ), SSAO_KERNEL_SIZE );
+	const float invW		= 1.0f / aoWidth;
+	const float v			= ( y + 0.5f ) * 1.0f / aoHeight;
+
+	const int srcW			= normalDepth.getWidth();
+	const int srcH			= normalDepth.getHeight();
+	const float *src		= normalDepth.getData();
+
+	const Float rad( mParams.rad ), falloff( mParams.falloff ), strength( mParams.strength );
+	const Float one( 1.0f ), two( 2.0f ), half( 0.5f );
+	const Float texW( (float)srcW ), texH( (float)srcH );
+	const Int maxX( srcW - 1 ), maxY( srcH - 1 ), zeroI( 0 ), oneI( 1 ), rowStride( srcW ), four( 4 );
+
+	float fresX[W], fresY[W], fresZ[W];
+	float curX[W], curY[W], curZ[W], curD[W];
+
+	int x = colBegin;
+	for ( ; x + W <= colEnd; x += W ) {
+		//per pixel setup is scalar, the sample loop below is where the time goes
+		for ( int lane = 0; lane < W; ++lane ) {
+			float u = ( x + lane + 0.5f ) * invW;
+			float fres[3], current[4];
+			fetchReflectionNormal( x + lane, y, u, v, fres );
+			normalDepth.sampleBilinear( u, v, current );
+			fresX[lane] = fres[0];		fresY[lane] = fres[1];		fresZ[lane] = fres[2];
+			curX[lane] = current[0];	curY[lane] = current[1];	curZ[lane] = current[2];	curD[lane] = current[3];
+		}
+
+		Float fx = load( fresX ), fy = load( fresY ), fz = load( fresZ );
+		Float nx = load( curX ), ny = load( curY ), nz = load( curZ ), depth = load( curD );
+		Float u = ( Float( (float)x ) + iota() + half ) * Float( invW );
+		Float vv( v );
+		Float bl( 0.0f );
+
+		for ( int i = 0; i < samples; ++i ) {
+			const Float kx( mKernel[i * 3] ), ky( mKernel[i * 3 + 1] ), kz( mKernel[i * 3 + 2] );
+
+			Float kDotN	= kx * fx + ky * fy + kz * fz;
+			Float rx	= rad * ( kx - two * kDotN * fx );
+			Float ry	= rad * ( ky - two * kDotN * fy );
+			Float rz	= rad * ( kz - two * kDotN * fz );
+			Float s		= sign( rx * nx + ry * ny + rz * nz );
+
+			//bilinear, clamp to edge
+			Float px	= ( u + s * rx ) * texW - half;
+			Float py	= ( vv + s * ry ) * texH - half;
+			Float x0f	= floor( px );
+			Float y0f	= floor( py );
+			Float tx	= px - x0f;
+			Float ty	= py - y0f;
+			Int x0		= toInt( x0f );
+			Int y0		= toInt( y0f );
+			Int x1		= clamp( x0 + oneI, zeroI, maxX );
+			Int y1		= clamp( y0 + oneI, zeroI, maxY );
+			x0			= clamp( x0, zeroI, maxX );
+			y0			= clamp( y0, zeroI, maxY );
+
+			Int i00		= ( y0 * rowStride + x0 ) * four;
+			Int i10		= ( y0 * rowStride + x1 ) * four;
+			Int i01		= ( y1 * rowStride + x0 ) * four;
+			Int i11		= ( y1 * rowStride + x1 ) * four;
+
+			Float occ[4];
+			for ( int c = 0; c < 4; ++c ) {
+				const float *base = src + c;
+				Float p00 = gather( base, i00 ), p10 = gather( base, i10 );
+				Float p01 = gather( base, i01 ), p11 = gather( base, i11 );
+				Float bottom	= p00 + ( p10 - p00 ) * tx;
+				Float top		= p01 + ( p11 - p01 ) * tx;
+				occ[c]			= bottom + ( top - bottom ) * ty;
+			}
+
+			Float depthDifference	= depth - occ[3];
+			Float normDiff			= one - ( occ[0] * nx + occ[1] * ny + occ[2] * nz );
+			bl = bl + step( falloff, depthDifference ) * normDiff * ( one - smoothstep( falloff, strength, depthDifference ) );
+		}
+
+		Float result = one + bl * Float( -0.5f / samples );
+		store( out + ( x - colBegin ), result );
+	}
+
+	//leftovers that don't fill a whole vector
+	if ( x < colEnd )
+		computeSpanScalar<SAMPLES>( normalDepth, aoWidth, aoHeight, y, x, colEnd, out + ( x - colBegin ) );
+}
+
+//view position of the texel at ( u, v ) with linear depth ( the depth channel's units )
+static inline void viewPosition( const SSAOParams &params, float u, float v, float depth, float *p )
+{
+	p[0] = depth * ( u * 2.0f - 1.0f ) / params.projection[0];
+	p[1] = depth * ( v * 2.0f - 1.0f ) / params.projection[1];
+	p[2] = -depth;
+}
+
+static inline float dot3( const float *a, const float *b )
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/*
+ * @Description: GTAO, one pixel at a time ( see HorizonAO_frag.glsl, line for line )
+ * @param: FloatImage normal/depth, AO target size, row, column range, float* output
+ * @return: none
+ */
+void SSAOEngine::computeSpanHorizon( const FloatImage &normalDepth, int aoWidth, int aoHeight, int y, int colBegin, int colEnd, float *out ) const
+{
+	const int directions	= std::min( std::max( mParams.directions, 1 ), MAX_HORIZON_DIRECTIONS );
+	const int steps			= std::min( std::max( mParams.steps, 1 ), MAX_HORIZON_STEPS );
+	const float radius		= mParams.horizonRadius;
+	const float invW		= 1.0f / aoWidth;
+	const float v			= ( y + 0.5f ) * 1.0f / aoHeight;
+
+	for ( int x = colBegin; x < colEnd; ++x ) {
+		float u = ( x + 0.5f ) * invW;
+
+		//the rnm rotation picks the first slice, the same tile half a tile over where along them the taps go
+		float fres[3], jitterNoise[3];
+		fetchReflectionNormal( x, y, u, v, fres );
+		fetchReflectionNormal( x + mNoise.getWidth() / 2, y + mNoise.getHeight() / 2, u, v, jitterNoise );
+		const float phi		= std::atan2( fres[1], fres[0] );
+		float jitter		= std::atan2( jitterNoise[1], jitterNoise[0] ) / ( 2.0f * PI );
+		jitter				-= std::floor( jitter );
+
+		float current[4];
+		normalDepth.sampleBilinear( u, v, current );
+		float pos[3], view[3];
+		viewPosition( mParams, u, v, current[3], pos );
+		float viewLength = std::sqrt( dot3( pos, pos ) );
+		for ( int c = 0; c < 3; ++c )
+			view[c] = viewLength > 0.0f ? -pos[c] / viewLength : ( c == 2 ? 1.0f : 0.0f );
+		float normal[3] = { current[0], current[1], current[2] };
+		float normalLength = std::sqrt( dot3( normal, normal ) );
+		for ( int c = 0; c < 3; ++c )
+			normal[c] = normalLength > 0.0f ? normal[c] / normalLength : ( c == 2 ? 1.0f : 0.0f );
+
+		//radius in uv at the pixel's depth
+		const float radiusU = radius * mParams.projection[0] * 0.5f / std::max( current[3], 1e-4f );
+		const float radiusV = radius * mParams.projection[1] * 0.5f / std::max( current[3], 1e-4f );
+
+		float visibility = 0.0f;
+		for ( int d = 0; d < directions; ++d ) {
+			const float angle = phi + d * PI / directions;
+			const float dirX = std::cos( angle ), dirY = std::sin( angle );
+
+			//the slice plane holds the view vector and the screen direction, the normal is projected into it
+			float direction[3] = { dirX, dirY, 0.0f };
+			float along = dot3( direction, view );
+			float ortho[3] = { direction[0] - along * view[0], direction[1] - along * view[1], direction[2] - along * view[2] };
+			float axis[3] = { ortho[1] * view[2] - ortho[2] * view[1], ortho[2] * view[0] - ortho[0] * view[2], ortho[0] * view[1] - ortho[1] * view[0] };
+			float axisLength = std::sqrt( dot3( axis, axis ) );
+			if ( axisLength <= 0.0f )
+				continue;
+			for ( int c = 0; c < 3; ++c )
+				axis[c] /= axisLength;
+
+			float nDotAxis = dot3( normal, axis );
+			float projected[3] = { normal[0] - axis[0] * nDotAxis, normal[1] - axis[1] * nDotAxis, normal[2] - axis[2] * nDotAxis };
+			float projectedLength = std::sqrt( dot3( projected, projected ) );
+			if ( projectedLength <= 0.0f )
+				continue;
+			float cosN	= std::min( std::max( dot3( projected, view ) / projectedLength, -1.0f ), 1.0f );
+			float n		= ( dot3( ortho, projected ) < 0.0f ? -1.0f : 1.0f ) * std::acos( cosN );
+
+			//start at the tangent plane each way, taps can only raise the horizon
+			float lowCos[2]		= { std::cos( n + 0.5f * PI ), std::cos( n - 0.5f * PI ) };
+			float horizonCos[2]	= { lowCos[0], lowCos[1] };
+			for ( int i = 0; i < steps; ++i ) {
+				float t = ( i + jitter ) / steps;
+				t *= t;
+				for ( int side = 0; side < 2; ++side ) {
+					float sign = side == 0 ? 1.0f : -1.0f;
+					float tapU = u + sign * dirX * radiusU * t, tapV = v + sign * dirY * radiusV * t;
+					float tap[4];
+					normalDepth.sampleBilinear( tapU, tapV, tap );
+					float tapPos[3];
+					viewPosition( mParams, tapU, tapV, tap[3], tapPos );
+					float delta[3] = { tapPos[0] - pos[0], tapPos[1] - pos[1], tapPos[2] - pos[2] };
+					float distance = std::sqrt( dot3( delta, delta ) );
+					if ( distance <= 0.0f )
+						continue;
+
+					float weight	= std::min( std::max( ( radius - distance ) / ( 0.6f * radius ), 0.0f ), 1.0f );
+					float tapCos	= dot3( delta, view ) / distance;
+					tapCos			= lowCos[side] + ( tapCos - lowCos[side] ) * weight;
+					horizonCos[side] = std::max( horizonCos[side], tapCos );
+				}
+			}
+
+			//horizon angles from the view vector, clamped to the hemisphere around the projected normal
+			float h1 = std::acos( std::min( std::max( horizonCos[0], -1.0f ), 1.0f ) );
+			float h0 = -std::acos( std::min( std::max( horizonCos[1], -1.0f ), 1.0f ) );
+			h0 = n + std::max( h0 - n, -0.5f * PI );
+			h1 = n + std::min( h1 - n, 0.5f * PI );
+
+			float sinN = std::sin( n );
+			float arc0 = ( cosN + 2.0f * h0 * sinN - std::cos( 2.0f * h0 - n ) ) * 0.25f;
+			float arc1 = ( cosN + 2.0f * h1 * sinN - std::cos( 2.0f * h1 - n ) ) * 0.25f;
+			visibility += projectedLength * ( arc0 + arc1 );
+		}
+
+		//no clamp at 1: one slice can go over ( only the average over all directions is normalized ), blur / history average it back
+		out[x - colBegin] = std::max( visibility / directions, 0.0f );
+	}
+}
+
+const char* NoiseReport::getName( int noise )
+{
+	static const char *names[NUM_NOISES] = { "random.png lookup", "white noise tile", "blue noise tile" };
+	return names[noise];
+}
+
+static float rmsDifference( const FloatImage &a, const FloatImage &b )
+{
+	double sum = 0.0;
+	size_t count = (size_t)a.getWidth() * a.getHeight();
+	for ( size_t i = 0; i < count; ++i ) {
+		double d = a.getData()[i] - b.getData()[i];
+		sum += d * d;
+	}
+	return (float)std::sqrt( sum / std::max( count, (size_t)1 ) );
+}
+
+/*
+ * @Description: how far one frame ( raw and blurred ) and frames accumulated frames are from the converged AO, for each rnm
+ * @param: SSAOEngine ( params used as is, rotation aside ), normal/depth, AO size, frames ( at most 64 )
+ * @return: NoiseReport
+ */
+NoiseReport measureNoise( const SSAOEngine &engine, const FloatImage &normalDepth, int aoWidth, int aoHeight, int frames )
+{
+	//the converged AO, what is left of the noise in it is well below the errors measured
+	const int REFERENCE_FRAMES = 64;
+
+	NoiseReport report;
+	report.samples	= engine.getParams().samples;
+	report.frames	= frames = std::min( std::max( frames, 1 ), REFERENCE_FRAMES );
+
+	FloatImage noises[NoiseReport::NUM_NOISES];
+	buildRandomNormalTile( BLUE_NOISE_SIZE, &noises[NoiseReport::LEGACY] );
+	std::vector<unsigned char> white;
+	generateWhiteNoise( BLUE_NOISE_SIZE, &white );
+	buildRotationTile( &white[0], BLUE_NOISE_SIZE, &noises[NoiseReport::WHITE_TILE] );
+	buildRotationTile( BLUE_NOISE_TILE, BLUE_NOISE_SIZE, &noises[NoiseReport::BLUE_TILE] );
+
+	SeparableBlur blur;
+	const size_t count = (size_t)aoWidth * aoHeight;
+	for ( int n = 0; n < NoiseReport::NUM_NOISES; ++n ) {
+		SSAOEngine e( engine );
+		e.setNoise( noises[n], n == NoiseReport::LEGACY ? SSAOEngine::NOISE_LEGACY : SSAOEngine::NOISE_TILE );
+		SSAOParams params = engine.getParams();
+
+		FloatImage ao( aoWidth, aoHeight, 1 ), first, reference( aoWidth, aoHeight, 1 ), accumulated( aoWidth, aoHeight, 1 );
+		for ( int f = 0; f < REFERENCE_FRAMES; ++f ) {
+			params.rotation = TemporalAO::getFrameRotation( f );
+			e.setParams( params );
+			e.compute( normalDepth, &ao );
+			if ( f == 0 )
+				first = ao;
+			for ( size_t i = 0; i < count; ++i ) {
+				reference.getData()[i] += ao.getData()[i] / REFERENCE_FRAMES;
+				if ( f < frames )
+					accumulated.getData()[i] += ao.getData()[i] / frames;
+			}
+		}
+
+		FloatImage blurredFirst, blurredReference;
+		blur.blur( first, &blurredFirst, false );
+		blur.blur( reference, &blurredReference, false );
+
+		report.raw[n]			= rmsDifference( first, reference );
+		report.blurred[n]		= rmsDifference( blurredFirst, blurredReference );
+		report.accumulated[n]	= rmsDifference( accumulated, reference );
+	}
+	return report;
+}
+
+/*
+ * @Description: average frames frames of AO, each with the next temporal rotation
+ * @param: SSAOEngine ( params used as is, rotation aside ), normal/depth, AO size, frames, FloatImage* result
+ * @return: none
+ */
+void computeConvergedAO( const SSAOEngine &engine, const FloatImage &normalDepth, int aoWidth, int aoHeight, int frames, FloatImage *result )
+{
+	frames = std::max( frames, 1 );
+	result->allocate( aoWidth, aoHeight, 1 );
+	std::fill( result->getData(), result->getData() + (size_t)aoWidth * aoHeight, 0.0f );
+
+	SSAOEngine e( engine );
+	SSAOParams params = engine.getParams();
+	FloatImage ao( aoWidth, aoHeight, 1 );
+	for ( int f = 0; f < frames; ++f ) {
+		params.rotation = TemporalAO::getFrameRotation( f );
+		e.setParams( params );
+		e.compute( normalDepth, &ao );
+		for ( size_t i = 0; i < (size_t)aoWidth * aoHeight; ++i )
+			result->getData()[i] += ao.getData()[i] / frames;
+	}
+}
+
+/*
+ * @Description: time one frame, then compare it ( blurred ) with its own converged AO and that with the reference
+ * @param: SSAOEngine, normal/depth, reference ( 1 channel, the AO size ), frames to converge over
+ * @return: AOReport
+ */
+AOReport measureAO( const SSAOEngine &engine, const FloatImage &normalDepth, const FloatImage &reference, int frames )
+{
+	const int w = reference.getWidth(), h = reference.getHeight();
+	const SSAOParams &params = engine.getParams();
+
+	AOReport report;
+	report.taps = params.method == AO_HORIZON ? std::min( std::max( params.directions, 1 ), MAX_HORIZON_DIRECTIONS ) * std::min( std::max( params.steps, 1 ), MAX_HORIZON_STEPS ) * 2
+											  : std::min( std::max( params.samples, 1 ), SSAO_KERNEL_SIZE );
+
+	FloatImage first( w, h, 1 ), converged;
+	ci::Timer timer( true );
+	engine.compute( normalDepth, &first );
+	report.ms = timer.getSeconds() * 1000.0;
+	computeConvergedAO( engine, normalDepth, w, h, frames, &converged );
+
+	SeparableBlur blur;
+	FloatImage blurredFirst, blurredConverged;
+	blur.blur( first, &blurredFirst, false );
+	blur.blur( converged, &blurredConverged, false );
+	report.noise = rmsDifference( blurredFirst, blurredConverged );
+
+	double sum = 0.0;
+	for ( size_t i = 0; i < (size_t)w * h; ++i )
+		sum += std::fabs( converged.getData()[i] - reference.getData()[i] );
+	report.error = (float)( sum / std::max( (size_t)w * h, (size_t)1 ) );
+	return report;
+}
+
+} // namespace ssao
@@ -0,0 +1,300 @@
+#include "SampleKernel.h"
+#include "ShaderVariants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace ssao {
+
+static const float PI = 3.14159265f;
+
+const float SSAO_KERNEL[SSAO_KERNEL_SIZE][3] = {
+	{ 0.13790712f, 0.24864247f, 0.44301823f },
+	{ 0.33715037f, 0.56794053f, -0.005789503f },
+	{ 0.06896307f, -0.15983082f, -0.85477847f },
+	{ -0.014653638f, 0.14027752f, 0.0762037f },
+	{ 0.010019933f, -0.1924225f, -0.034443386f },
+	{ -0.35775623f, -0.5301969f, -0.43581226f },
+	{ -0.3169221f, 0.106360726f, 0.015860917f },
+	{ 0.010350345f, -0.58698344f, 0.0046293875f },
+	{ -0.053382345f, 0.059675813f, -0.5411899f },
+	{ 0.035267662f, -0.063188605f, 0.54602677f },
+	//extra samples for the 16 / 32 sample variants ( fixed seed, biased towards the center )
+	{ 0.26513290f, 0.07490093f, -0.30205648f },
+	{ -0.46036590f, 0.44667943f, -0.16014449f },
+	{ -0.10973202f, 0.34328084f, 0.34151965f },
+	{ 0.88438953f, 0.25123299f, -0.10390727f },
+	{ 0.63418852f, -0.39947086f, 0.40862655f },
+	{ -0.01164791f, -0.06393041f, -0.08129653f },
+	{ 0.01798841f, 0.08390155f, 0.05464923f },
+	{ -0.21968465f, 0.36306911f, 0.28429978f },
+	{ 0.09703155f, -0.21776948f, -0.15458745f },
+	{ 0.60626502f, 0.22738110f, -0.13921023f },
+	{ 0.08249087f, 0.45893095f, 0.09213675f },
+	{ 0.01068643f, 0.01045573f, 0.10119075f },
+	{ -0.01834455f, 0.81238028f, -0.15393907f },
+	{ 0.44532754f, -0.01812426f, 0.36822025f },
+	{ -0.13604401f, 0.05388541f, 0.06366542f },
+	{ 0.31103321f, -0.41602580f, 0.60679364f },
+	{ 0.10523088f, -0.01710364f, 0.05885880f },
+	{ 0.05945945f, -0.06779737f, -0.19162261f },
+	{ 0.07897742f, 0.04508344f, 0.09706895f },
+	{ -0.01556109f, 0.11052667f, 0.05158661f },
+	{ 0.06802183f, 0.11026429f, -0.03444560f },
+	{ 0.10668285f, 0.05071580f, -0.03348840f }
+};
+
+static const char* KERNEL_TYPE_NAMES[NUM_KERNEL_TYPES] = { "Original", "Poisson", "Hammersley", "Cosine" };
+
+const char* getKernelTypeName( KernelType type )
+{
+	return KERNEL_TYPE_NAMES[type];
+}
+
+//xorshift32 in [0,1)
+static inline float nextUniform( unsigned int *state )
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return ( *state >> 8 ) * ( 1.0f / 16777216.0f );
+}
+
+//i with its base digits mirrored about the point, in [0,1)
+static float radicalInverse( unsigned int i, unsigned int base )
+{
+	const float invBase = 1.0f / base;
+	float result = 0.0f, digit = invBase;
+	for ( ; i > 0; i /= base, digit *= invBase )
+		result += ( i % base ) * digit;
+	return result;
+}
+
+//the length of a tap whose volume fraction ( length^3 without the remap ) is t
+static float kernelLength( const KernelParams &params, float t )
+{
+	if ( params.towardCenter )
+		return params.minScale + ( 1.0f - params.minScale ) * t * t;
+	return std::pow( t, 1.0f / 3.0f );
+}
+
+static void appendTap( std::vector<float> *kernel, float cosTheta, float phi, float length )
+{
+	float sinTheta = std::sqrt( std::max( 1.0f - cosTheta * cosTheta, 0.0f ) );
+	kernel->push_back( length * sinTheta * std::cos( phi ) );
+	kernel->push_back( length * sinTheta * std::sin( phi ) );
+	kernel->push_back( length * cosTheta );
+}
+
+//Mitchell's best candidate: of ( taps so far + 1 ) * 8 random points in the hemisphere keep the one furthest from all taps
+static void generatePoisson( const KernelParams &params, int size, std::vector<float> *kernel )
+{
+	unsigned int state = params.seed * 0x9E3779B9u + 0x2545F491u;
+	std::vector<float> points;
+	for ( int i = 0; i < size; ++i ) {
+		float best[3] = { 0.0f, 0.0f, 1.0f };
+		float bestDistance = -1.0f;
+		for ( int c = 0; c < ( i + 1 ) * 8; ++c ) {
+			float p[3];
+			do {
+				p[0] = nextUniform( &state ) * 2.0f - 1.0f;
+				p[1] = nextUniform( &state ) * 2.0f - 1.0f;
+				p[2] = nextUniform( &state );
+			} while ( p[0] * p[0] + p[1] * p[1] + p[2] * p[2] > 1.0f || p[2] * p[2] < 1e-6f );
+
+			float nearest = 4.0f;
+			for ( size_t j = 0; j < points.size(); j += 3 ) {
+				float dx = p[0] - points[j], dy = p[1] - points[j + 1], dz = p[2] - points[j + 2];
+				nearest = std::min( nearest, dx * dx + dy * dy + dz * dz );
+			}
+			if ( nearest > bestDistance ) {
+				bestDistance = nearest;
+				std::copy( p, p + 3, best );
+			}
+		}
+		points.insert( points.end(), best, best + 3 );
+	}
+
+	//spread in the volume, then the lengths remapped like the other kernels
+	for ( size_t j = 0; j < points.size(); j += 3 ) {
+		float length = std::sqrt( points[j] * points[j] + points[j + 1] * points[j + 1] + points[j + 2] * points[j + 2] );
+		float scale = kernelLength( params, length * length * length ) / length;
+		for ( int c = 0; c < 3; ++c )
+			kernel->push_back( points[j + c] * scale );
+	}
+}
+
+/*
+ * @Description: build a sample kernel
+ * @param: KernelParams, number of samples ( KERNEL_ORIGINAL stops at SSAO_KERNEL_SIZE ), vector* result ( 3 floats per sample )
+ * @return: none
+ */
+void generateKernel( const KernelParams &params, int size, std::vector<float> *kernel )
+{
+	size = std::max( size, 1 );
+	kernel->clear();
+	kernel->reserve( size * 3 );
+
+	switch ( params.type ) {
+		case KERNEL_ORIGINAL:
+			for ( int i = 0; i < std::min( size, SSAO_KERNEL_SIZE ); ++i )
+				kernel->insert( kernel->end(), SSAO_KERNEL[i], SSAO_KERNEL[i] + 3 );
+			break;
+		case KERNEL_POISSON:
+			generatePoisson( params, size, kernel );
+			break;
+		case KERNEL_HAMMERSLEY:
+		case KERNEL_COSINE:
+			for ( int i = 0; i < size; ++i ) {
+				//( i + 0.5 ) / size, radical inverse base 2 is the Hammersley set, base 3 ( skipping 0 ) is independent of both
+				float u = ( i + 0.5f ) / size;
+				float cosTheta = params.type == KERNEL_COSINE ? std::sqrt( 1.0f - u ) : u;
+				appendTap( kernel, cosTheta, 2.0f * PI * radicalInverse( i, 2 ), kernelLength( params, radicalInverse( i + 1, 3 ) ) );
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+//a random unit vector
+static void randomDirection( unsigned int *state, float *d )
+{
+	float z = nextUniform( state ) * 2.0f - 1.0f;
+	float phi = 2.0f * PI * nextUniform( state );
+	float r = std::sqrt( std::max( 1.0f - z * z, 0.0f ) );
+	d[0] = r * std::cos( phi );
+	d[1] = r * std::sin( phi );
+	d[2] = z;
+}
+
+static inline float dot3( const float *a, const float *b )
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/*
+ * @Description: discrepancy / variance / spacing of a kernel ( see KernelMetrics )
+ * @param: kernel ( 3 floats per sample )
+ * @return: KernelMetrics
+ */
+KernelMetrics measureKernel( const std::vector<float> &kernel )
+{
+	const int size = (int)kernel.size() / 3;
+
+	KernelMetrics metrics;
+	metrics.size				= size;
+	metrics.discrepancy			= 0.0f;
+	metrics.occlusionVariance	= 0.0f;
+	metrics.minDistance			= 0.0f;
+	metrics.meanLength			= 0.0f;
+	if ( size == 0 )
+		return metrics;
+
+	std::vector<float> directions( kernel.size() );
+	float minDistance = 4.0f;
+	for ( int i = 0; i < size; ++i ) {
+		const float *k = &kernel[i * 3];
+		float length = std::sqrt( dot3( k, k ) );
+		metrics.meanLength += length / size;
+		for ( int c = 0; c < 3; ++c )
+			directions[i * 3 + c] = length > 0.0f ? k[c] / length : 0.0f;
+		for ( int j = 0; j < i; ++j ) {
+			const float *o = &kernel[j * 3];
+			float d[3] = { k[0] - o[0], k[1] - o[1], k[2] - o[2] };
+			minDistance = std::min( minDistance, dot3( d, d ) );
+		}
+	}
+	metrics.minDistance = size > 1 ? std::sqrt( minDistance ) : 0.0f;
+
+	//caps around 128 spiral axes, 10 sizes each. +d and -d both count, so a cap holds ( 1 - cos ) / 2 of them when uniform
+	const int AXES = 128, SIZES = 10;
+	for ( int a = 0; a < AXES; ++a ) {
+		float z = 1.0f - ( a + 0.5f ) * 2.0f / AXES;
+		float r = std::sqrt( std::max( 1.0f - z * z, 0.0f ) );
+		float phi = a * 2.39996323f;
+		float axis[3] = { r * std::cos( phi ), r * std::sin( phi ), z };
+		for ( int s = 0; s < SIZES; ++s ) {
+			float cosAngle = 1.0f - ( s + 0.5f ) / SIZES;
+			int inside = 0;
+			for ( int i = 0; i < size; ++i ) {
+				float c = dot3( &directions[i * 3], axis );
+				inside += ( c >= cosAngle ) + ( -c >= cosAngle );
+			}
+			float difference = std::fabs( inside / ( 2.0f * size ) - ( 1.0f - cosAngle ) * 0.5f );
+			metrics.discrepancy = std::max( metrics.discrepancy, difference );
+		}
+	}
+
+	/*
+	 * like the shader: taps reflected about an in-plane fres and flipped to the normal's side, occluded when past a
+	 * plane tilted 0, 45 or 80 degrees from the surface at 0, 0.25 or 0.5 from the pixel. Normal, tilt direction and
+	 * fres are random per trial, the variance is of the occluded fraction over the trials
+	 */
+	const int TRIALS = 512;
+	const float TILTS[3] = { 0.0f, 0.785398f, 1.396263f };
+	const float OFFSETS[3] = { 0.0f, 0.25f, 0.5f };
+	unsigned int state = 0x68E31DA4u;
+	for ( int t = 0; t < 3; ++t ) {
+		for ( int o = 0; o < 3; ++o ) {
+			double sum = 0.0, sumSquares = 0.0;
+			for ( int trial = 0; trial < TRIALS; ++trial ) {
+				float normal[3], other[3];
+				randomDirection( &state, normal );
+				randomDirection( &state, other );
+
+				//occluder plane normal: normal tilted towards a random tangent
+				float along = dot3( other, normal );
+				float tangent[3] = { other[0] - along * normal[0], other[1] - along * normal[1], other[2] - along * normal[2] };
+				float tangentLength = std::sqrt( dot3( tangent, tangent ) );
+				float plane[3];
+				for ( int c = 0; c < 3; ++c )
+					plane[c] = std::cos( TILTS[t] ) * normal[c] + std::sin( TILTS[t] ) * ( tangentLength > 0.0f ? tangent[c] / tangentLength : 0.0f );
+
+				float angle = 2.0f * PI * nextUniform( &state );
+				float fres[3] = { std::cos( angle ), std::sin( angle ), 0.0f };
+
+				int occluded = 0;
+				for ( int i = 0; i < size; ++i ) {
+					const float *k = &kernel[i * 3];
+					float kDotN = dot3( k, fres );
+					float ray[3] = { k[0] - 2.0f * kDotN * fres[0], k[1] - 2.0f * kDotN * fres[1], k[2] - 2.0f * kDotN * fres[2] };
+					float side = dot3( ray, normal ) < 0.0f ? -1.0f : 1.0f;
+					occluded += side * dot3( ray, plane ) > OFFSETS[o];
+				}
+				double fraction = (double)occluded / size;
+				sum += fraction;
+				sumSquares += fraction * fraction;
+			}
+			double mean = sum / TRIALS;
+			metrics.occlusionVariance += (float)( ( sumSquares / TRIALS - mean * mean ) / 9.0 );
+		}
+	}
+
+	return metrics;
+}
+
+std::string buildKernelGlsl( const std::vector<float> &kernel )
+{
+	std::ostringstream ss;
+	ss << "#define SSAO_KERNEL";
+	for ( size_t i = 0; i + 2 < kernel.size(); i += 3 )
+		ss << " pSphere[" << i / 3 << "] = vec3(" << glslFloat( kernel[i] ) << ", " << glslFloat( kernel[i + 1] ) << ", " << glslFloat( kernel[i + 2] ) << ");";
+	ss << "\n";
+	return ss.str();
+}
+
+std::string buildKernelCpp( const std::vector<float> &kernel )
+{
+	std::string result;
+	for ( size_t i = 0; i + 2 < kernel.size(); i += 3 ) {
+		char line[128];
+		std::sprintf( line, "\t{ %.8ff, %.8ff, %.8ff }%s\n", kernel[i], kernel[i + 1], kernel[i + 2], i + 3 < kernel.size() ? "," : "" );
+		result += line;
+	}
+	return result;
+}
+
+} // namespace ssao
@@ -0,0 +1,322 @@
+#include "SceneContainer.h"
+#include "SimdFloat.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+using namespace ci;
+
+namespace ssao {
+
+/*
+ * @Description: frustum planes from a world -> clip matrix, normalized
+ * @param: Matrix44f projection * view
+ * @return: Frustum
+ */
+Frustum Frustum::fromViewProjection( const Matrix44f &m )
+{
+	Frustum frustum;
+	//left, right, bottom, top, near, far: row 3 +- row 0 / 1 / 2
+	for ( int p = 0; p < 6; ++p ) {
+		int row			= p / 2;
+		float sign		= ( p % 2 == 0 ) ? 1.0f : -1.0f;
+		float *plane	= frustum.planes[p];
+		for ( int c = 0; c < 4; ++c )
+			plane[c] = m.at( 3, c ) + sign * m.at( row, c );
+
+		float length = std::sqrt( plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2] );
+		if ( length > 0.0f )
+			for ( int c = 0; c < 4; ++c )
+				plane[c] /= length;
+	}
+	return frustum;
+}
+
+/*
+ * one block of BLOCK_SIZE instances per task, survivors go straight into the block's own per mesh lists
+ */
+class SceneContainer::CullJob : public TaskPool::Job
+{
+public:
+	CullJob( const SceneContainer *scene, const Frustum &frustum )
+	: mScene( scene ), mFrustum( frustum )
+	{
+		int blocks = getNumTasks();
+		mBatches.resize( blocks );
+		for ( int b = 0; b < blocks; ++b )
+			mBatches[b].resize( scene->getNumMeshes() );
+		mVisible.resize( scene->getNumInstances() );
+	}
+
+	int getNumTasks() const { return ( mScene->getNumInstances() + BLOCK_SIZE - 1 ) / BLOCK_SIZE; }
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		int begin	= index * BLOCK_SIZE;
+		int end		= std::min( begin + BLOCK_SIZE, mScene->getNumInstances() );
+
+		unsigned char *visible = &mVisible[begin];
+		mScene->cullRange( mFrustum, begin, end, visible, CULL_SIMD );
+
+		std::vector< std::vector<int> > &batches = mBatches[index];
+		for ( int i = begin; i < end; ++i )
+			if ( visible[i - begin] )
+				batches[mScene->mMeshIds[i]].push_back( i );
+	}
+
+	//blocks in order, so every batch stays ascending
+	void merge( CullResult *result ) const
+	{
+		result->visible = 0;
+		for ( int m = 0; m < mScene->getNumMeshes(); ++m ) {
+			std::vector<int> &batch = result->batches[m];
+			for ( size_t b = 0; b < mBatches.size(); ++b )
+				batch.insert( batch.end(), mBatches[b][m].begin(), mBatches[b][m].end() );
+			result->visible += (int)batch.size();
+		}
+	}
+
+private:
+	const SceneContainer					*mScene;
+	Frustum									mFrustum;
+	std::vector< std::vector< std::vector<int> > >	mBatches;	//[block][mesh]
+	std::vector<unsigned char>				mVisible;
+};
+
+/*
+ * @Description: constructor
+ * @param: TaskPool* ( borrowed, may be 0 )
+ * @return: none
+ */
+SceneContainer::SceneContainer( TaskPool *pool )
+: mPool( pool ), mRevision( 0 )
+{}
+
+void SceneContainer::clear()
+{
+	mMeshes.clear();
+	truncate( 0 );
+}
+
+int SceneContainer::addMesh( const MeshData *mesh )
+{
+	Vec3f lo( 0.0f, 0.0f, 0.0f ), hi( 0.0f, 0.0f, 0.0f );
+	for ( size_t v = 0; v < mesh->positions.size(); ++v ) {
+		const Vec3f &p = mesh->positions[v];
+		if ( v == 0 )
+			lo = hi = p;
+		lo.set( std::min( lo.x, p.x ), std::min( lo.y, p.y ), std::min( lo.z, p.z ) );
+		hi.set( std::max( hi.x, p.x ), std::max( hi.y, p.y ), std::max( hi.z, p.z ) );
+	}
+
+	Mesh entry;
+	entry.data		= mesh;
+	entry.center	= ( lo + hi ) * 0.5f;
+	entry.radius	= 0.0f;
+	for ( size_t v = 0; v < mesh->positions.size(); ++v )
+		entry.radius = std::max( entry.radius, mesh->positions[v].distance( entry.center ) );
+
+	mMeshes.push_back( entry );
+	++mRevision;
+	return (int)mMeshes.size() - 1;
+}
+
+int SceneContainer::addInstance( int mesh, const Matrix44f &transform )
+{
+	mMeshIds.push_back( mesh );
+	for ( int k = 0; k < 12; ++k )
+		mRows[k].push_back( 0.0f );
+	mCenterX.push_back( 0.0f );
+	mCenterY.push_back( 0.0f );
+	mCenterZ.push_back( 0.0f );
+	mRadius.push_back( 0.0f );
+
+	int instance = (int)mMeshIds.size() - 1;
+	setTransform( instance, transform );
+	return instance;
+}
+
+void SceneContainer::setTransform( int instance, const Matrix44f &transform )
+{
+	for ( int r = 0; r < 3; ++r )
+		for ( int c = 0; c < 4; ++c )
+			mRows[r * 4 + c][instance] = transform.at( r, c );
+	updateBounds( instance );
+	++mRevision;
+}
+
+void SceneContainer::truncate( int count )
+{
+	count = std::min( count, getNumInstances() );
+	mMeshIds.resize( count );
+	for ( int k = 0; k < 12; ++k )
+		mRows[k].resize( count );
+	mCenterX.resize( count );
+	mCenterY.resize( count );
+	mCenterZ.resize( count );
+	mRadius.resize( count );
+	++mRevision;
+}
+
+Matrix44f SceneContainer::getTransform( int instance ) const
+{
+	Matrix44f transform;
+	for ( int r = 0; r < 3; ++r )
+		for ( int c = 0; c < 4; ++c )
+			transform.at( r, c ) = mRows[r * 4 + c][instance];
+	return transform;
+}
+
+void SceneContainer::gatherRows( const std::vector<int> &instances, float *rows ) const
+{
+	for ( size_t i = 0; i < instances.size(); ++i, rows += 12 )
+		for ( int k = 0; k < 12; ++k )
+			rows[k] = mRows[k][instances[i]];
+}
+
+/*
+ * @Description: world bounding sphere of one instance, the mesh's sphere moved by the transform and grown by its largest axis scale
+ * @param: instance
+ * @return: none
+ */
+void SceneContainer::updateBounds( int instance )
+{
+	const Mesh &mesh = mMeshes[mMeshIds[instance]];
+
+	float center[3], scale = 0.0f;
+	for ( int r = 0; r < 3; ++r )
+		center[r] = mRows[r * 4][instance] * mesh.center.x + mRows[r * 4 + 1][instance] * mesh.center.y + mRows[r * 4 + 2][instance] * mesh.center.z + mRows[r * 4 + 3][instance];
+	for ( int c = 0; c < 3; ++c ) {
+		float x = mRows[c][instance], y = mRows[4 + c][instance], z = mRows[8 + c][instance];
+		scale = std::max( scale, x * x + y * y + z * z );
+	}
+
+	mCenterX[instance]	= center[0];
+	mCenterY[instance]	= center[1];
+	mCenterZ[instance]	= center[2];
+	mRadius[instance]	= mesh.radius * std::sqrt( scale );
+}
+
+/*
+ * @Description: sphere / frustum test, the simd path does the same operations in the same order so both agree exactly
+ * @param: Frustum, instances [begin, end), visible flags ( one per instance, from begin ), CullPath ( CULL_PARALLEL counts as CULL_SIMD )
+ * @return: none
+ */
+void SceneContainer::cullRange( const Frustum &frustum, int begin, int end, unsigned char *visible, CullPath path ) const
+{
+	int i = begin;
+
+	if ( path != CULL_SCALAR ) {
+		using namespace simd;
+
+		const Float zero( 0.0f );
+		Float a[6], b[6], c[6], d[6];
+		for ( int p = 0; p < 6; ++p ) {
+			a[p] = Float( frustum.planes[p][0] );
+			b[p] = Float( frustum.planes[p][1] );
+			c[p] = Float( frustum.planes[p][2] );
+			d[p] = Float( frustum.planes[p][3] );
+		}
+
+		for ( ; i + WIDTH <= end; i += WIDTH ) {
+			Float x = load( &mCenterX[i] );
+			Float y = load( &mCenterY[i] );
+			Float z = load( &mCenterZ[i] );
+			Float r = load( &mRadius[i] );
+
+			int outside = 0;
+			for ( int p = 0; p < 6; ++p )
+				outside |= moveMask( cmpLt( x * a[p] + y * b[p] + z * c[p] + d[p] + r, zero ) );
+
+			for ( int lane = 0; lane < WIDTH; ++lane )
+				visible[i - begin + lane] = ( outside >> lane & 1 ) ? 0 : 1;
+		}
+	}
+
+	for ( ; i < end; ++i ) {
+		bool inside = true;
+		for ( int p = 0; p < 6 && inside; ++p ) {
+			const float *plane = frustum.planes[p];
+			inside = !( mCenterX[i] * plane[0] + mCenterY[i] * plane[1] + mCenterZ[i] * plane[2] + plane[3] + mRadius[i] < 0.0f );
+		}
+		visible[i - begin] = inside ? 1 : 0;
+	}
+}
+
+/*
+ * @Description: instances whose bounding sphere touches the frustum, grouped per mesh
+ * @param: Frustum, CullResult*, CullPath
+ * @return: none
+ */
+void SceneContainer::cull( const Frustum &frustum, CullResult *result, CullPath path ) const
+{
+	result->batches.resize( mMeshes.size() );
+	for ( size_t m = 0; m < mMeshes.size(); ++m )
+		result->batches[m].clear();
+	result->visible = 0;
+
+	const int count = getNumInstances();
+	if ( count == 0 )
+		return;
+
+	if ( path == CULL_PARALLEL ) {
+		CullJob job( this, frustum );
+		if ( mPool )
+			mPool->parallelFor( job.getNumTasks(), &job );
+		else
+			for ( int t = 0; t < job.getNumTasks(); ++t )
+				job.run( t, 0 );
+		job.merge( result );
+		return;
+	}
+
+	std::vector<unsigned char> visible( count );
+	cullRange( frustum, 0, count, &visible[0], path );
+	for ( int i = 0; i < count; ++i ) {
+		if ( visible[i] ) {
+			result->batches[mMeshIds[i]].push_back( i );
+			++result->visible;
+		}
+	}
+}
+
+/*
+ * @Description: time every path on the current instances, each run iterations times
+ * @param: Frustum, iterations
+ * @return: CullReport
+ */
+CullReport SceneContainer::measureCulling( const Frustum &frustum, int iterations ) const
+{
+	CullReport report;
+	report.instances	= getNumInstances();
+	iterations			= std::max( iterations, 1 );
+
+	CullResult results[3];
+	double *times[3] = { &report.scalarMs, &report.simdMs, &report.parallelMs };
+	double *rates[3] = { &report.scalarPerMs, &report.simdPerMs, &report.parallelPerMs };
+
+	for ( int path = 0; path < 3; ++path ) {
+		ci::Timer timer( true );
+		for ( int it = 0; it < iterations; ++it )
+			cull( frustum, &results[path], (CullPath)path );
+		*times[path] = timer.getSeconds() * 1000.0 / iterations;
+		*rates[path] = *times[path] > 0.0 ? report.instances / *times[path] : 0.0;
+	}
+
+	report.visible		= results[CULL_SCALAR].visible;
+	report.mismatches	= 0;
+	for ( int path = 1; path < 3; ++path ) {
+		for ( size_t m = 0; m < mMeshes.size(); ++m ) {
+			const std::vector<int> &expected = results[CULL_SCALAR].batches[m], &got = results[path].batches[m];
+			std::vector<int> difference;
+			std::set_symmetric_difference( expected.begin(), expected.end(), got.begin(), got.end(), std::back_inserter( difference ) );
+			report.mismatches += (int)difference.size();
+		}
+	}
+	return report;
+}
+
+} // namespace ssao
@@ -0,0 +1,146 @@
+#include "SceneGeometry.h"
+#include "MeshCache.h"
+#include <cmath>
+
+using namespace ci;
+
+namespace ssao {
+
+static const float PI_F = 3.14159265358979f;
+
+/*
+ * @Description: torus around the z axis, same parameters as gl::drawTorus()
+ * @param: MeshData*, outer radius, inner ( tube ) radius, segments around the ring, segments around the tube
+ * @return: none
+ */
+void buildTorus( MeshData *mesh, float outerRadius, float innerRadius, int longitudeSegments, int latitudeSegments )
+{
+	mesh->positions.clear();
+	mesh->normals.clear();
+	mesh->indices.clear();
+
+	for ( int i = 0; i <= longitudeSegments; ++i ) {
+		float ring = 2.0f * PI_F * i / longitudeSegments;
+		Vec3f ringDir( std::cos( ring ), std::sin( ring ), 0.0f );
+
+		for ( int j = 0; j <= latitudeSegments; ++j ) {
+			float side = 2.0f * PI_F * j / latitudeSegments;
+			Vec3f normal = ringDir * std::cos( side ) + Vec3f( 0.0f, 0.0f, std::sin( side ) );
+			mesh->positions.push_back( ringDir * outerRadius + normal * innerRadius );
+			mesh->normals.push_back( normal );
+		}
+	}
+
+	const uint32_t stride = latitudeSegments + 1;
+	for ( int i = 0; i < longitudeSegments; ++i ) {
+		for ( int j = 0; j < latitudeSegments; ++j ) {
+			uint32_t a = i * stride + j, b = ( i + 1 ) * stride + j;
+			mesh->indices.push_back( a );	mesh->indices.push_back( b );		mesh->indices.push_back( a + 1 );
+			mesh->indices.push_back( b );	mesh->indices.push_back( b + 1 );	mesh->indices.push_back( a + 1 );
+		}
+	}
+}
+
+/*
+ * @Description: axis aligned box with flat normals, same parameters as gl::drawCube()
+ * @param: MeshData*, center, size
+ * @return: none
+ */
+void buildCube( MeshData *mesh, const Vec3f &center, const Vec3f &size )
+{
+	mesh->positions.clear();
+	mesh->normals.clear();
+	mesh->indices.clear();
+
+	static const float faces[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	Vec3f half = size * 0.5f;
+
+	for ( int f = 0; f < 6; ++f ) {
+		Vec3f n( faces[f][0], faces[f][1], faces[f][2] );
+		//two axes spanning the face, u x v == n so the winding is counter clockwise seen from outside
+		Vec3f u = ( f < 2 ) ? Vec3f::yAxis() : ( f < 4 ? Vec3f::zAxis() : Vec3f::xAxis() );
+		Vec3f v = n.cross( u );
+
+		uint32_t base = (uint32_t)mesh->positions.size();
+		for ( int c = 0; c < 4; ++c ) {
+			float su = ( c == 1 || c == 2 ) ? 1.0f : -1.0f;
+			float sv = ( c >= 2 ) ? 1.0f : -1.0f;
+			Vec3f p = n + u * su + v * sv;
+			mesh->positions.push_back( center + Vec3f( p.x * half.x, p.y * half.y, p.z * half.z ) );
+			mesh->normals.push_back( n );
+		}
+
+		mesh->indices.push_back( base );		mesh->indices.push_back( base + 1 );	mesh->indices.push_back( base + 2 );
+		mesh->indices.push_back( base );		mesh->indices.push_back( base + 2 );	mesh->indices.push_back( base + 3 );
+	}
+}
+
+/*
+ * @Description: uv sphere, same parameters as gl::drawSphere() ( segments around, segments / 2 rings )
+ * @param: MeshData*, center, radius, segments
+ * @return: none
+ */
+void buildSphere( MeshData *mesh, const Vec3f &center, float radius, int segments )
+{
+	mesh->positions.clear();
+	mesh->normals.clear();
+	mesh->indices.clear();
+
+	const int rings = segments / 2;
+	for ( int j = 0; j <= rings; ++j ) {
+		float theta = PI_F * j / rings - PI_F * 0.5f;
+		for ( int i = 0; i <= segments; ++i ) {
+			float phi = 2.0f * PI_F * i / segments;
+			Vec3f n( std::cos( theta ) * std::cos( phi ), std::sin( theta ), std::cos( theta ) * std::sin( phi ) );
+			mesh->positions.push_back( center + n * radius );
+			mesh->normals.push_back( n );
+		}
+	}
+
+	const uint32_t stride = segments + 1;
+	for ( int j = 0; j < rings; ++j ) {
+		for ( int i = 0; i < segments; ++i ) {
+			uint32_t a = j * stride + i, b = ( j + 1 ) * stride + i;
+			mesh->indices.push_back( a );	mesh->indices.push_back( b );		mesh->indices.push_back( a + 1 );
+			mesh->indices.push_back( b );	mesh->indices.push_back( b + 1 );	mesh->indices.push_back( a + 1 );
+		}
+	}
+}
+
+/*
+ * @Description: constructor, tessellates the test objects and applies the transforms from drawTestObjects()
+ * @param: none ( default MeshOptions ) or MeshOptions
+ * @return: none
+ */
+TestScene::TestScene()
+: mMeshCache( 0 )
+{
+	build( MeshOptions() );
+}
+
+TestScene::TestScene( const MeshOptions &options )
+: mMeshCache( 0 )
+{
+	build( options );
+}
+
+TestScene::~TestScene()
+{
+	delete mMeshCache;
+}
+
+void TestScene::build( const MeshOptions &options )
+{
+	mMeshCache = new MeshCache( options );
+	const MeshData *torus	= mMeshCache->getTorus( 1.0f, 0.3f, 32, 64 );
+	const MeshData *board	= mMeshCache->getCube( Vec3f( 0.0f, 0.0f, 0.0f ), Vec3f( 10.0f, 0.1f, 10.0f ) );
+	const MeshData *box		= mMeshCache->getCube( Vec3f( 0.0f, 0.0f, 0.0f ), Vec3f( 1.0f, 1.0f, 1.0f ) );
+	const MeshData *sphere	= mMeshCache->getSphere( Vec3f::zero(), 0.8f, 30 );
+
+	mObjects.push_back( SceneObject( torus, Matrix44f::createTranslation( Vec3f( -2.0f, -1.0f, 0.0f ) ) * Matrix44f::createRotation( Vec3f( 1.0f, 0.0f, 0.0f ), PI_F * 0.5f ) ) );
+	mObjects.push_back( SceneObject( board, Matrix44f::createTranslation( Vec3f( 0.0f, -1.35f, 0.0f ) ) ) );
+	mObjects.push_back( SceneObject( box, Matrix44f::createTranslation( Vec3f( 0.4f, -0.3f, 0.5f ) ) * Matrix44f::createScale( Vec3f( 2.0f, 2.0f, 2.0f ) ) ) );
+	mObjects.push_back( SceneObject( sphere, Matrix44f::createTranslation( Vec3f( 0.1f, -0.56f, -1.25f ) ) ) );
+}
+
+} // namespace ssao
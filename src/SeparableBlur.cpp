@@ -0,0 +1,407 @@
+#include "SeparableBlur.h"
+#include "SimdFloat.h"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace ssao {
+
+//GLSL 1.20 wants a float literal, always print the decimal point
+static std::string glslFloat( float value )
+{
+	std::ostringstream ss;
+	ss.precision( 8 );
+	ss << value;
+	std::string str = ss.str();
+	if ( str.find_first_of( ".e" ) == std::string::npos )
+		str += ".0";
+	return str;
+}
+
+void computeBlurWeights( const BlurParams &params, std::vector<float> *weights )
+{
+	const int radius	= std::min( std::max( params.radius, 1 ), MAX_BLUR_RADIUS );
+	const float sigma	= ( radius + 1 ) * 0.5f;
+
+	weights->resize( radius + 1 );
+	float sum = 0.0f;
+	for ( int k = 0; k <= radius; ++k ) {
+		(*weights)[k] = std::exp( -( k * k ) / ( 2.0f * sigma * sigma ) );
+		sum += ( k == 0 ? 1.0f : 2.0f ) * (*weights)[k];
+	}
+	for ( int k = 0; k <= radius; ++k )
+		(*weights)[k] /= sum;
+}
+
+/*
+ * @Description: merge tap pairs so a bilinear fetch between them returns w1 * a + w2 * b ( scaled by w1 + w2 )
+ * @param: weights from computeBlurWeights(), offsets*, linearWeights* ( both [0] = center )
+ * @return: none
+ */
+void computeLinearTaps( const std::vector<float> &weights, std::vector<float> *offsets, std::vector<float> *linearWeights )
+{
+	const int radius = (int)weights.size() - 1;
+	offsets->assign( 1, 0.0f );
+	linearWeights->assign( 1, weights[0] );
+
+	for ( int k = 1; k <= radius; k += 2 ) {
+		//an odd radius leaves the last tap on its own, fetched at its texel center
+		float w1 = weights[k], w2 = ( k + 1 <= radius ) ? weights[k + 1] : 0.0f;
+		offsets->push_back( ( k * w1 + ( k + 1 ) * w2 ) / ( w1 + w2 ) );
+		linearWeights->push_back( w1 + w2 );
+	}
+}
+
+/*
+ * @Description: #define block that specializes Blur_h/v_frag.glsl for params
+ * @param: BlurParams, linearTaps ( merge tap pairs into bilinear fetches )
+ * @return: string ( one define per line )
+ */
+std::string buildBlurDefines( const BlurParams &params, bool linearTaps )
+{
+	std::vector<float> weights, offsets, linearWeights;
+	computeBlurWeights( params, &weights );
+
+	std::ostringstream ss;
+	if ( params.depthAware )
+		ss << "#define BLUR_DEPTH_AWARE\n";
+	//depth has to be looked up per texel ( merged taps would average it across the edge )
+	if ( params.depthAware || !linearTaps ) {
+		offsets.resize( weights.size() );
+		for ( size_t k = 0; k < weights.size(); ++k )
+			offsets[k] = (float)k;
+		linearWeights = weights;
+	}
+	else
+		computeLinearTaps( weights, &offsets, &linearWeights );
+
+	ss << "#define BLUR_TAPS BLUR_CENTER(" << glslFloat( linearWeights[0] ) << ")";
+	for ( size_t k = 1; k < offsets.size(); ++k )
+		ss << " BLUR_PAIR(" << glslFloat( offsets[k] ) << ", " << glslFloat( linearWeights[k] ) << ")";
+	ss << "\n";
+	return ss.str();
+}
+
+/*
+ * @Description: horizontal gaussian of one row, same operation order on both paths so they agree exactly
+ * @param: src row, its width, dst row, [begin, end), weights ( 2 * radius + 1, from -radius ), radius
+ * @return: none
+ */
+void blurRow( const float *src, int width, float *dst, int begin, int end, const float *weights, int radius )
+{
+	const int taps		= 2 * radius + 1;
+	const int safeBegin	= std::min( std::max( begin, radius ), end );
+	const int safeEnd	= std::max( std::min( end, width - radius ), safeBegin );
+
+	int x = begin;
+	for ( ; x < safeBegin; ++x ) {
+		float sum = src[std::min( std::max( x - radius, 0 ), width - 1 )] * weights[0];
+		for ( int k = 1; k < taps; ++k )
+			sum += src[std::min( std::max( x - radius + k, 0 ), width - 1 )] * weights[k];
+		dst[x] = sum;
+	}
+
+	{
+		using namespace simd;
+		Float w[2 * MAX_BLUR_RADIUS + 1];
+		for ( int k = 0; k < taps; ++k )
+			w[k] = Float( weights[k] );
+
+		for ( ; x + WIDTH <= safeEnd; x += WIDTH ) {
+			const float *p = src + x - radius;
+			Float sum = load( p ) * w[0];
+			for ( int k = 1; k < taps; ++k )
+				sum = sum + load( p + k ) * w[k];
+			store( dst + x, sum );
+		}
+	}
+
+	for ( ; x < end; ++x ) {
+		float sum = src[std::min( std::max( x - radius, 0 ), width - 1 )] * weights[0];
+		for ( int k = 1; k < taps; ++k )
+			sum += src[std::min( std::max( x - radius + k, 0 ), width - 1 )] * weights[k];
+		dst[x] = sum;
+	}
+}
+
+void blurColumns( const float *const *rows, float *dst, int begin, int end, const float *weights, int radius )
+{
+	using namespace simd;
+	const int taps = 2 * radius + 1;
+	Float w[2 * MAX_BLUR_RADIUS + 1];
+	for ( int k = 0; k < taps; ++k )
+		w[k] = Float( weights[k] );
+
+	int x = begin;
+	for ( ; x + WIDTH <= end; x += WIDTH ) {
+		Float sum = load( rows[0] + x ) * w[0];
+		for ( int k = 1; k < taps; ++k )
+			sum = sum + load( rows[k] + x ) * w[k];
+		store( dst + x, sum );
+	}
+	for ( ; x < end; ++x ) {
+		float sum = rows[0][x] * weights[0];
+		for ( int k = 1; k < taps; ++k )
+			sum += rows[k][x] * weights[k];
+		dst[x] = sum;
+	}
+}
+
+/*
+ * one pass over a block of rows
+ */
+class SeparableBlur::RowJob : public TaskPool::Job
+{
+public:
+	static const int ROWS_PER_TASK = 16;
+
+	RowJob( const SeparableBlur *blur, bool vertical, const FloatImage &src, FloatImage *dst )
+	: mBlur( blur ), mVertical( vertical ), mSrc( src ), mDst( dst ) {}
+
+	int getNumTasks() const { return ( mSrc.getHeight() + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK; }
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		int rowBegin	= index * ROWS_PER_TASK;
+		int rowEnd		= std::min( rowBegin + ROWS_PER_TASK, mSrc.getHeight() );
+		if ( mVertical )
+			mBlur->blurCols( mSrc, mDst, rowBegin, rowEnd );
+		else
+			mBlur->blurRows( mSrc, mDst, rowBegin, rowEnd );
+	}
+
+private:
+	const SeparableBlur	*mBlur;
+	bool				mVertical;
+	const FloatImage	&mSrc;
+	FloatImage			*mDst;
+};
+
+/*
+ * @Description: constructor
+ * @param: TaskPool* ( borrowed, may be 0 )
+ * @return: none
+ */
+SeparableBlur::SeparableBlur( TaskPool *pool )
+: mPool( pool )
+{
+	setParams( BlurParams() );
+}
+
+void SeparableBlur::setParams( const BlurParams &params )
+{
+	mParams			= params;
+	mParams.radius	= std::min( std::max( params.radius, 1 ), MAX_BLUR_RADIUS );
+
+	std::vector<float> half;
+	computeBlurWeights( mParams, &half );
+	computeLinearTaps( half, &mOffsets, &mLinearWeights );
+
+	//[ -radius, radius ] for the row / column kernels
+	mWeights.resize( 2 * mParams.radius + 1 );
+	for ( int k = -mParams.radius; k <= mParams.radius; ++k )
+		mWeights[k + mParams.radius] = half[std::abs( k )];
+}
+
+void SeparableBlur::blurRows( const FloatImage &src, FloatImage *dst, int rowBegin, int rowEnd ) const
+{
+	for ( int y = rowBegin; y < rowEnd; ++y )
+		blurRow( src.getPixel( 0, y ), src.getWidth(), dst->getPixel( 0, y ), 0, src.getWidth(), &mWeights[0], mParams.radius );
+}
+
+void SeparableBlur::blurCols( const FloatImage &src, FloatImage *dst, int rowBegin, int rowEnd ) const
+{
+	const int R = mParams.radius;
+	const float *rows[2 * MAX_BLUR_RADIUS + 1];
+	for ( int y = rowBegin; y < rowEnd; ++y ) {
+		for ( int k = -R; k <= R; ++k )
+			rows[k + R] = src.getPixel( 0, std::min( std::max( y + k, 0 ), src.getHeight() - 1 ) );
+		blurColumns( rows, dst->getPixel( 0, y ), 0, src.getWidth(), &mWeights[0], R );
+	}
+}
+
+/*
+ * @Description: both passes with the simd row / column kernels ( 1 channel images )
+ * @param: src, dst*, parallel ( spread the rows over the pool )
+ * @return: none
+ */
+void SeparableBlur::blur( const FloatImage &src, FloatImage *dst, bool parallel )
+{
+	mTemp.allocate( src.getWidth(), src.getHeight(), 1 );
+	if ( dst->getWidth() != src.getWidth() || dst->getHeight() != src.getHeight() || dst->getChannels() != 1 )
+		dst->allocate( src.getWidth(), src.getHeight(), 1 );
+
+	RowJob horizontal( this, false, src, &mTemp ), vertical( this, true, mTemp, dst );
+	if ( parallel && mPool ) {
+		mPool->parallelFor( horizontal.getNumTasks(), &horizontal );
+		mPool->parallelFor( vertical.getNumTasks(), &vertical );
+	}
+	else {
+		blurRows( src, &mTemp, 0, src.getHeight() );
+		blurCols( mTemp, dst, 0, src.getHeight() );
+	}
+}
+
+/*
+ * @Description: the loop the 9 tap shaders ran, one texel and one clamped tap at a time
+ * @param: src, dst*
+ * @return: none
+ */
+void SeparableBlur::blurNaive( const FloatImage &src, FloatImage *dst )
+{
+	const int w = src.getWidth(), h = src.getHeight(), R = mParams.radius;
+	mTemp.allocate( w, h, 1 );
+	if ( dst->getWidth() != w || dst->getHeight() != h || dst->getChannels() != 1 )
+		dst->allocate( w, h, 1 );
+
+	for ( int y = 0; y < h; ++y ) {
+		for ( int x = 0; x < w; ++x ) {
+			float sum = 0.0f;
+			for ( int k = -R; k <= R; ++k )
+				sum += *src.getPixel( std::min( std::max( x + k, 0 ), w - 1 ), y ) * mWeights[k + R];
+			*mTemp.getPixel( x, y ) = sum;
+		}
+	}
+	for ( int y = 0; y < h; ++y ) {
+		for ( int x = 0; x < w; ++x ) {
+			float sum = 0.0f;
+			for ( int k = -R; k <= R; ++k )
+				sum += *mTemp.getPixel( x, std::min( std::max( y + k, 0 ), h - 1 ) ) * mWeights[k + R];
+			*dst->getPixel( x, y ) = sum;
+		}
+	}
+}
+
+//GL_LINEAR + GL_CLAMP_TO_EDGE along one axis, position in texels ( integer = texel center )
+static inline float sampleLinear( const float *data, size_t stride, int size, float position )
+{
+	float f = std::floor( position ), t = position - f;
+	int i0 = std::min( std::max( (int)f, 0 ), size - 1 );
+	int i1 = std::min( std::max( (int)f + 1, 0 ), size - 1 );
+	return data[i0 * stride] + ( data[i1 * stride] - data[i0 * stride] ) * t;
+}
+
+void SeparableBlur::blurLinearTaps( const FloatImage &src, FloatImage *dst )
+{
+	const int w = src.getWidth(), h = src.getHeight();
+	mTemp.allocate( w, h, 1 );
+	if ( dst->getWidth() != w || dst->getHeight() != h || dst->getChannels() != 1 )
+		dst->allocate( w, h, 1 );
+
+	for ( int y = 0; y < h; ++y ) {
+		const float *row = src.getPixel( 0, y );
+		for ( int x = 0; x < w; ++x ) {
+			float sum = row[x] * mLinearWeights[0];
+			for ( size_t k = 1; k < mOffsets.size(); ++k )
+				sum += ( sampleLinear( row, 1, w, x + mOffsets[k] ) + sampleLinear( row, 1, w, x - mOffsets[k] ) ) * mLinearWeights[k];
+			*mTemp.getPixel( x, y ) = sum;
+		}
+	}
+	for ( int y = 0; y < h; ++y ) {
+		for ( int x = 0; x < w; ++x ) {
+			const float *column = mTemp.getPixel( x, 0 );
+			float sum = *mTemp.getPixel( x, y ) * mLinearWeights[0];
+			for ( size_t k = 1; k < mOffsets.size(); ++k )
+				sum += ( sampleLinear( column, w, h, y + mOffsets[k] ) + sampleLinear( column, w, h, y - mOffsets[k] ) ) * mLinearWeights[k];
+			*dst->getPixel( x, y ) = sum;
+		}
+	}
+}
+
+/*
+ * @Description: BLUR_DEPTH_AWARE, each tap's gaussian weight times exp( -( depth difference / ( depthSigma * depth ) )^2 ), renormalized
+ * @param: src, normalDepth ( 4 channel, a = depth ), dst*
+ * @return: none
+ */
+void SeparableBlur::blurDepthAware( const FloatImage &src, const FloatImage &normalDepth, FloatImage *dst )
+{
+	const int w = src.getWidth(), h = src.getHeight(), R = mParams.radius;
+	mTemp.allocate( w, h, 1 );
+	if ( dst->getWidth() != w || dst->getHeight() != h || dst->getChannels() != 1 )
+		dst->allocate( w, h, 1 );
+
+	//depth at every AO texel center, what the shader's normalMap lookups return
+	FloatImage depth( w, h, 1 );
+	for ( int y = 0; y < h; ++y ) {
+		for ( int x = 0; x < w; ++x ) {
+			float nd[4];
+			normalDepth.sampleBilinear( ( x + 0.5f ) / w, ( y + 0.5f ) / h, nd );
+			*depth.getPixel( x, y ) = nd[3];
+		}
+	}
+
+	for ( int pass = 0; pass < 2; ++pass ) {
+		const FloatImage &in	= pass == 0 ? src : mTemp;
+		FloatImage *out			= pass == 0 ? &mTemp : dst;
+
+		for ( int y = 0; y < h; ++y ) {
+			for ( int x = 0; x < w; ++x ) {
+				float center	= *depth.getPixel( x, y );
+				float invSigma	= 1.0f / ( mParams.depthSigma * std::max( center, 0.0001f ) );
+				float sum = 0.0f, weightSum = 0.0f;
+				for ( int k = -R; k <= R; ++k ) {
+					int sx = pass == 0 ? std::min( std::max( x + k, 0 ), w - 1 ) : x;
+					int sy = pass == 0 ? y : std::min( std::max( y + k, 0 ), h - 1 );
+					float dz		= ( *depth.getPixel( sx, sy ) - center ) * invSigma;
+					float weight	= mWeights[k + R] * std::exp( -dz * dz );
+					sum			+= *in.getPixel( sx, sy ) * weight;
+					weightSum	+= weight;
+				}
+				*out->getPixel( x, y ) = sum / weightSum;
+			}
+		}
+	}
+}
+
+static float maxDifference( const FloatImage &a, const FloatImage &b )
+{
+	float result = 0.0f;
+	for ( int y = 0; y < a.getHeight(); ++y )
+		for ( int x = 0; x < a.getWidth(); ++x )
+			result = std::max( result, std::abs( *a.getPixel( x, y ) - *b.getPixel( x, y ) ) );
+	return result;
+}
+
+/*
+ * @Description: time every version on src, each run iterations times, and compare them with blurNaive()
+ * @param: src ( 1 channel ), iterations
+ * @return: BlurReport
+ */
+BlurReport SeparableBlur::measure( const FloatImage &src, int iterations )
+{
+	BlurReport report;
+	report.width	= src.getWidth();
+	report.height	= src.getHeight();
+	report.radius	= mParams.radius;
+	iterations		= std::max( iterations, 1 );
+
+	FloatImage naive, simdResult, parallelResult, linear;
+	ci::Timer timer( true );
+	for ( int it = 0; it < iterations; ++it )
+		blurNaive( src, &naive );
+	report.naiveMs = timer.getSeconds() * 1000.0 / iterations;
+
+	timer.start();
+	for ( int it = 0; it < iterations; ++it )
+		blur( src, &simdResult, false );
+	report.simdMs = timer.getSeconds() * 1000.0 / iterations;
+
+	timer.start();
+	for ( int it = 0; it < iterations; ++it )
+		blur( src, &parallelResult, true );
+	report.parallelMs = timer.getSeconds() * 1000.0 / iterations;
+
+	timer.start();
+	for ( int it = 0; it < iterations; ++it )
+		blurLinearTaps( src, &linear );
+	report.linearTapsMs = timer.getSeconds() * 1000.0 / iterations;
+
+	report.maxSimdError			= std::max( maxDifference( naive, simdResult ), maxDifference( naive, parallelResult ) );
+	report.maxLinearTapsError	= maxDifference( naive, linear );
+	return report;
+}
+
+} // namespace ssao
@@ -0,0 +1,367 @@
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace ssao {
+
+static const uint32_t CACHE_MAGIC = 0x43485353; // "SSHC"
+
+struct CacheHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	format;
+	uint32_t	size;
+	uint64_t	key;
+	uint64_t	checksum;
+};
+
+/*
+ * @Description: normalize a shader so formatting and comment edits don't change its key
+ * @param: source
+ * @return: string
+ */
+std::string preprocessShader( const std::string &source )
+{
+	//comments out first ( GLSL has no string literals to worry about )
+	std::string code;
+	code.reserve( source.size() );
+	for ( size_t i = 0; i < source.size(); ) {
+		if ( source[i] == '/' && i + 1 < source.size() && source[i + 1] == '/' ) {
+			while ( i < source.size() && source[i] != '\n' )
+				++i;
+		}
+		else if ( source[i] == '/' && i + 1 < source.size() && source[i + 1] == '*' ) {
+			size_t end = source.find( "*/", i + 2 );
+			//keep the line count roughly right for the compiler, a block comment becomes a space
+			i = ( end == std::string::npos ) ? source.size() : end + 2;
+			code += ' ';
+		}
+		else if ( source[i] == '\r' )
+			++i;
+		else
+			code += source[i++];
+	}
+
+	//trailing whitespace and empty lines
+	std::string result;
+	result.reserve( code.size() );
+	std::istringstream lines( code );
+	std::string line;
+	while ( std::getline( lines, line ) ) {
+		size_t end = line.find_last_not_of( " \t" );
+		if ( end == std::string::npos )
+			continue;
+		result.append( line, 0, end + 1 );
+		result += '\n';
+	}
+	return result;
+}
+
+uint64_t hashFnv1a( const void *data, size_t size, uint64_t seed )
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+	uint64_t hash = seed;
+	for ( size_t i = 0; i < size; ++i ) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+uint64_t hashFnv1a( const std::string &str, uint64_t seed )
+{
+	return hashFnv1a( str.data(), str.size(), seed );
+}
+
+uint64_t makeShaderKey( const std::string &vertexSource, const std::string &fragmentSource, const std::string &driverTag )
+{
+	//the separators keep "ab" + "c" and "a" + "bc" apart
+	uint64_t hash = hashFnv1a( preprocessShader( vertexSource ) );
+	hash = hashFnv1a( "\0vs", 3, hash );
+	hash = hashFnv1a( preprocessShader( fragmentSource ), hash );
+	hash = hashFnv1a( "\0fs", 3, hash );
+	hash = hashFnv1a( driverTag, hash );
+	return hash;
+}
+
+std::string keyToHex( uint64_t key )
+{
+	char buf[17];
+	std::sprintf( buf, "%08x%08x", (unsigned int)( key >> 32 ), (unsigned int)( key & 0xFFFFFFFFu ) );
+	return std::string( buf );
+}
+
+static bool hexToKey( const std::string &hex, uint64_t *key )
+{
+	if ( hex.size() != 16 )
+		return false;
+	uint64_t value = 0;
+	for ( size_t i = 0; i < hex.size(); ++i ) {
+		char c = hex[i];
+		int digit;
+		if ( c >= '0' && c <= '9' )			digit = c - '0';
+		else if ( c >= 'a' && c <= 'f' )	digit = c - 'a' + 10;
+		else								return false;
+		value = ( value << 4 ) | (uint64_t)digit;
+	}
+	*key = value;
+	return true;
+}
+
+/*
+ * @Description: constructor, picks up the index left by earlier runs and starts a new session
+ * @param: cache directory ( empty = disabled )
+ * @return: none
+ */
+ShaderCache::ShaderCache( const std::string &directory )
+: mDirectory( directory ), mSession( 0 ), mDirty( false ), mHits( 0 ), mMisses( 0 ), mRejected( 0 )
+{
+	if ( !mDirectory.empty() && mDirectory[mDirectory.size() - 1] != '/' )
+		mDirectory += '/';
+	readIndex();
+	++mSession;
+}
+
+ShaderCache::~ShaderCache()
+{
+	flush();
+}
+
+std::string ShaderCache::getPath( uint64_t key ) const
+{
+	return mDirectory + keyToHex( key ) + ".bin";
+}
+
+std::string ShaderCache::getIndexPath() const
+{
+	return mDirectory + "index.txt";
+}
+
+int ShaderCache::findEntry( uint64_t key ) const
+{
+	for ( size_t i = 0; i < mEntries.size(); ++i )
+		if ( mEntries[i].key == key )
+			return (int)i;
+	return -1;
+}
+
+/*
+ * @Description: "session <n>" then one "<key> <last session> <bytes>" line per entry. Lines of the older index
+ *				 ( just the key ) count as used in session 0, so they are the first to go
+ * @param: none
+ * @return: none
+ */
+void ShaderCache::readIndex()
+{
+	mEntries.clear();
+	mSession = 0;
+	if ( !isEnabled() )
+		return;
+
+	std::ifstream in( getIndexPath().c_str() );
+	std::string line;
+	while ( std::getline( in, line ) ) {
+		std::istringstream fields( line );
+		std::string first;
+		fields >> first;
+		if ( first == "session" ) {
+			fields >> mSession;
+			continue;
+		}
+
+		Entry entry;
+		entry.lastUsed	= 0;
+		entry.bytes		= 0;
+		if ( !hexToKey( first, &entry.key ) || findEntry( entry.key ) >= 0 )
+			continue;
+		fields >> entry.lastUsed >> entry.bytes;
+		mEntries.push_back( entry );
+	}
+}
+
+void ShaderCache::writeIndex()
+{
+	mDirty = false;
+	if ( !isEnabled() )
+		return;
+
+	std::ofstream out( getIndexPath().c_str(), std::ios::trunc );
+	out << "session " << mSession << "\n";
+	for ( size_t i = 0; i < mEntries.size(); ++i )
+		out << keyToHex( mEntries[i].key ) << " " << mEntries[i].lastUsed << " " << mEntries[i].bytes << "\n";
+}
+
+void ShaderCache::flush()
+{
+	if ( mDirty )
+		writeIndex();
+}
+
+void ShaderCache::removeKey( uint64_t key )
+{
+	std::remove( getPath( key ).c_str() );
+	int entry = findEntry( key );
+	if ( entry >= 0 )
+		mEntries.erase( mEntries.begin() + entry );
+}
+
+std::vector<uint64_t> ShaderCache::getKeys() const
+{
+	std::vector<uint64_t> keys;
+	for ( size_t i = 0; i < mEntries.size(); ++i )
+		keys.push_back( mEntries[i].key );
+	return keys;
+}
+
+size_t ShaderCache::getBytes() const
+{
+	size_t bytes = 0;
+	for ( size_t i = 0; i < mEntries.size(); ++i )
+		bytes += mEntries[i].bytes;
+	return bytes;
+}
+
+uint32_t ShaderCache::getLastUsed( uint64_t key ) const
+{
+	int entry = findEntry( key );
+	return entry >= 0 ? mEntries[entry].lastUsed : 0;
+}
+
+/*
+ * @Description: fetch a blob, validating the header and checksum
+ * @param: key, uint32_t* format ( driver binary format ), vector* blob
+ * @return: bool ( hit )
+ */
+bool ShaderCache::load( uint64_t key, uint32_t *format, std::vector<uint8_t> *blob )
+{
+	int entry = isEnabled() ? findEntry( key ) : -1;
+	if ( entry < 0 ) {
+		++mMisses;
+		return false;
+	}
+
+	std::ifstream in( getPath( key ).c_str(), std::ios::binary );
+	CacheHeader header;
+	bool valid = in.read( (char*)&header, sizeof( header ) )
+				 && header.magic == CACHE_MAGIC && header.version == VERSION && header.key == key;
+	if ( valid ) {
+		blob->resize( header.size );
+		valid = header.size == 0 || in.read( (char*)&( *blob )[0], header.size );
+		valid = valid && hashFnv1a( blob->empty() ? 0 : &( *blob )[0], blob->size() ) == header.checksum;
+	}
+	in.close();
+
+	if ( !valid ) {
+		//truncated, corrupt or from an older cache layout
+		invalidate( key );
+		blob->clear();
+		++mRejected;
+		++mMisses;
+		return false;
+	}
+
+	*format = header.format;
+	//the index is written once per batch of loads ( trim(), flush() ), not per hit
+	mEntries[entry].lastUsed	= mSession;
+	mEntries[entry].bytes		= sizeof( header ) + blob->size();
+	mDirty = true;
+	++mHits;
+	return true;
+}
+
+/*
+ * @Description: write a blob and add it to the index
+ * @param: key, driver binary format, blob
+ * @return: bool ( written )
+ */
+bool ShaderCache::store( uint64_t key, uint32_t format, const std::vector<uint8_t> &blob )
+{
+	if ( !isEnabled() )
+		return false;
+
+	CacheHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	header.magic	= CACHE_MAGIC;
+	header.version	= VERSION;
+	header.format	= format;
+	header.size		= (uint32_t)blob.size();
+	header.key		= key;
+	header.checksum	= hashFnv1a( blob.empty() ? 0 : &blob[0], blob.size() );
+
+	std::ofstream out( getPath( key ).c_str(), std::ios::binary | std::ios::trunc );
+	out.write( (const char*)&header, sizeof( header ) );
+	if ( !blob.empty() )
+		out.write( (const char*)&blob[0], blob.size() );
+	if ( !out )
+		return false;
+	out.close();
+
+	int entry = findEntry( key );
+	if ( entry < 0 ) {
+		Entry added;
+		added.key = key;
+		mEntries.push_back( added );
+		entry = (int)mEntries.size() - 1;
+	}
+	mEntries[entry].lastUsed	= mSession;
+	mEntries[entry].bytes		= sizeof( header ) + blob.size();
+	writeIndex();
+	return true;
+}
+
+void ShaderCache::invalidate( uint64_t key )
+{
+	if ( !isEnabled() )
+		return;
+	removeKey( key );
+	writeIndex();
+}
+
+/*
+ * @Description: delete the entries used longest ago until the rest fits ( edited shaders, retired variants and old
+ *				 drivers are never asked for again, so they age out ). Entries of this session are kept whatever the budget
+ * @param: maxBytes, maxEntries ( 0 = no limit )
+ * @return: none
+ */
+void ShaderCache::trim( size_t maxBytes, size_t maxEntries )
+{
+	if ( !isEnabled() )
+		return;
+
+	//oldest session first, in index order within a session
+	std::vector< std::pair<uint32_t, size_t> > byAge;
+	for ( size_t i = 0; i < mEntries.size(); ++i )
+		if ( mEntries[i].lastUsed != mSession )
+			byAge.push_back( std::make_pair( mEntries[i].lastUsed, i ) );
+	std::stable_sort( byAge.begin(), byAge.end() );
+
+	size_t bytes = getBytes(), count = mEntries.size();
+	std::vector<uint64_t> evicted;
+	for ( size_t i = 0; i < byAge.size() && ( ( maxBytes && bytes > maxBytes ) || ( maxEntries && count > maxEntries ) ); ++i ) {
+		const Entry &entry = mEntries[byAge[i].second];
+		evicted.push_back( entry.key );
+		bytes -= entry.bytes;
+		--count;
+	}
+	for ( size_t i = 0; i < evicted.size(); ++i )
+		removeKey( evicted[i] );
+	writeIndex();
+}
+
+void ShaderCache::clear()
+{
+	if ( !isEnabled() )
+		return;
+
+	std::vector<uint64_t> keys = getKeys();
+	for ( size_t i = 0; i < keys.size(); ++i )
+		removeKey( keys[i] );
+	writeIndex();
+}
+
+} // namespace ssao
@@ -0,0 +1,122 @@
+#include "ShaderVariants.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ssao {
+
+static const int TIER_SAMPLES[NUM_QUALITY_TIERS] = { 4, 8, 10, 16, 32 };
+static const char* TIER_NAMES[NUM_QUALITY_TIERS] = { "Low", "Medium", "Original", "High", "Ultra" };
+//AO_HORIZON: directions * steps * 2 taps, 4 / 8 / 12 / 16 / 32 so a tier costs about the same either way
+static const int TIER_DIRECTIONS[NUM_QUALITY_TIERS] = { 1, 2, 2, 2, 4 };
+static const int TIER_STEPS[NUM_QUALITY_TIERS] = { 2, 2, 3, 4, 4 };
+
+int getTierSamples( QualityTier tier )
+{
+	return TIER_SAMPLES[tier];
+}
+
+const char* getTierName( QualityTier tier )
+{
+	return TIER_NAMES[tier];
+}
+
+SSAOParams getTierParams( QualityTier tier, const SSAOParams &base )
+{
+	SSAOParams params = base;
+	params.samples		= TIER_SAMPLES[tier];
+	params.directions	= TIER_DIRECTIONS[tier];
+	params.steps		= TIER_STEPS[tier];
+	return params;
+}
+
+std::string glslFloat( float value )
+{
+	std::ostringstream ss;
+	ss.precision( 8 );
+	ss << value;
+	std::string str = ss.str();
+	if ( str.find_first_of( ".e" ) == std::string::npos )
+		str += ".0";
+	return str;
+}
+
+/*
+ * @Description: #define block that specializes SSAOL_frag.glsl for params
+ * @param: SSAOParams, unroll the sample loop, read occluders from the Hi-Z pyramid
+ * @return: string ( one define per line )
+ */
+std::string buildSSAOVariantDefines( const SSAOParams &params, bool unroll, bool hiZ )
+{
+	const int samples = std::min( std::max( params.samples, 1 ), SSAO_KERNEL_SIZE );
+
+	std::ostringstream ss;
+	ss << "#define SSAO_VARIANT\n";
+	//the extension has to come before any code, and GBufferPacking.glsl is pasted in between these defines and the shader
+	if ( hiZ )
+		ss << "#extension GL_ARB_shader_texture_lod : require\n#define SSAO_HIZ\n";
+	ss << "#define SAMPLES " << samples << "\n";
+	ss << "#define SSAO_TOT_STRENGTH " << glslFloat( params.totStrength ) << "\n";
+	ss << "#define SSAO_STRENGTH " << glslFloat( params.strength ) << "\n";
+	ss << "#define SSAO_OFFSET " << glslFloat( params.offset ) << "\n";
+	ss << "#define SSAO_FALLOFF " << glslFloat( params.falloff ) << "\n";
+	ss << "#define SSAO_RAD " << glslFloat( params.rad ) << "\n";
+
+	std::vector<float> kernel;
+	generateKernel( params.kernel, samples, &kernel );
+	ss << buildKernelGlsl( kernel );
+
+	if ( unroll ) {
+		ss << "#define SSAO_TAPS";
+		for ( int i = 0; i < samples; ++i )
+			ss << " SSAO_TAP(" << i << ")";
+		ss << "\n";
+	}
+
+	return ss.str();
+}
+
+std::string buildSSAOVariant( const std::string &source, const SSAOParams &params, bool unroll, bool hiZ )
+{
+	return insertDefines( source, buildSSAOVariantDefines( params, unroll, hiZ ) );
+}
+
+/*
+ * @Description: #define block that specializes HorizonAO_frag.glsl for params
+ * @param: SSAOParams ( directions, steps, horizonRadius )
+ * @return: string ( one define per line )
+ */
+std::string buildHorizonVariantDefines( const SSAOParams &params )
+{
+	std::ostringstream ss;
+	ss << "#define HORIZON_VARIANT\n";
+	ss << "#define DIRECTIONS " << std::min( std::max( params.directions, 1 ), MAX_HORIZON_DIRECTIONS ) << "\n";
+	ss << "#define STEPS " << std::min( std::max( params.steps, 1 ), MAX_HORIZON_STEPS ) << "\n";
+	ss << "#define HORIZON_RADIUS " << glslFloat( params.horizonRadius ) << "\n";
+	return ss.str();
+}
+
+std::string buildHorizonVariant( const std::string &source, const SSAOParams &params )
+{
+	return insertDefines( source, buildHorizonVariantDefines( params ) );
+}
+
+/*
+ * @Description: paste defines in after #version ( it has to stay the first statement )
+ * @param: shader source, defines ( newline terminated )
+ * @return: string
+ */
+std::string insertDefines( const std::string &source, const std::string &defines )
+{
+	std::string::size_type version = source.find( "#version" );
+	if ( version == std::string::npos )
+		return defines + source;
+
+	std::string::size_type lineEnd = source.find( '\n', version );
+	if ( lineEnd == std::string::npos )
+		return source + "\n" + defines;
+
+	return source.substr( 0, lineEnd + 1 ) + defines + source.substr( lineEnd + 1 );
+}
+
+} // namespace ssao
@@ -0,0 +1,360 @@
+#include "SoftRasterizer.h"
+#include "GBufferPacking.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ci;
+
+namespace ssao {
+
+static const int VERTICES_PER_TASK = 4096;
+
+//depth = -viewPos.z/10.0 in NormalDepthTexCreate_vert.glsl
+static const float DEPTH_SCALE = 1.0f / 10.0f;
+
+/*
+ * transform the vertices of one object range ( gl_ModelViewMatrix * gl_Vertex, ftransform() and the normal )
+ */
+class SoftRasterizer::VertexJob : public TaskPool::Job
+{
+public:
+	VertexJob( SoftRasterizer *r ) : mR( r ) {}
+
+	//one entry per task, ( object, first vertex )
+	std::vector< std::pair<int, size_t> > mRanges;
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		int object				= mRanges[index].first;
+		size_t begin			= mRanges[index].second;
+		const MeshData *mesh	= (*mR->mObjects)[object].mesh;
+		size_t end				= std::min( begin + VERTICES_PER_TASK, mesh->positions.size() );
+
+		const Matrix44f &mv		= mR->mModelView[object];
+		const Matrix44f &mvp	= mR->mModelViewProjection[object];
+		std::vector<ClipVertex> &out = mR->mVertices[object];
+
+		for ( size_t i = begin; i < end; ++i ) {
+			const Vec3f &p	= mesh->positions[i];
+			Vec4f clip		= mvp * Vec4f( p, 1.0f );
+			Vec3f viewPos	= mv.transformPointAffine( p );
+			Vec3f normal	= mv.transformVec( mesh->normals[i] ).normalized();
+
+			ClipVertex &v	= out[i];
+			v.clip[0] = clip.x;		v.clip[1] = clip.y;		v.clip[2] = clip.z;		v.clip[3] = clip.w;
+			v.attr[0] = normal.x;	v.attr[1] = normal.y;	v.attr[2] = normal.z;	v.attr[3] = -viewPos.z * DEPTH_SCALE;
+		}
+	}
+
+private:
+	SoftRasterizer *mR;
+};
+
+/*
+ * clip, project and bin one chunk of triangles
+ */
+class SoftRasterizer::BinJob : public TaskPool::Job
+{
+public:
+	BinJob( SoftRasterizer *r ) : mR( r ) {}
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		Chunk &chunk = mR->mChunks[index];
+		const MeshData *mesh = (*mR->mObjects)[chunk.object].mesh;
+		const std::vector<ClipVertex> &verts = mR->mVertices[chunk.object];
+
+		chunk.triangles.clear();
+		chunk.bins.resize( mR->mTilesX * mR->mTilesY );
+		for ( size_t b = 0; b < chunk.bins.size(); ++b )
+			chunk.bins[b].clear();
+
+		for ( size_t t = chunk.firstTriangle; t < chunk.lastTriangle; ++t ) {
+			const uint32_t *idx = &mesh->indices[t * 3];
+			mR->setupTriangle( &verts[idx[0]], &verts[idx[1]], &verts[idx[2]], &chunk );
+		}
+	}
+
+private:
+	SoftRasterizer *mR;
+};
+
+/*
+ * rasterize every binned triangle touching one tile
+ */
+class SoftRasterizer::RasterJob : public TaskPool::Job
+{
+public:
+	RasterJob( SoftRasterizer *r, FloatImage *target ) : mR( r ), mTarget( target ) {}
+
+	void run( int index, int /*threadIndex*/ )
+	{
+		mR->rasterizeTile( index, mTarget );
+	}
+
+private:
+	SoftRasterizer	*mR;
+	FloatImage		*mTarget;
+};
+
+/*
+ * @Description: constructor
+ * @param: TaskPool* ( borrowed )
+ * @return: none
+ */
+SoftRasterizer::SoftRasterizer( TaskPool *pool )
+: mPool( pool ), mObjects( 0 ), mWidth( 0 ), mHeight( 0 ), mTilesX( 0 ), mTilesY( 0 ), mFarDepth( 0.0f ), mTrianglesSubmitted( 0 ), mTrianglesBinned( 0 )
+{}
+
+/*
+ * @Description: render the objects into the normal/depth buffer
+ * @param: objects, view matrix ( mCam->getModelViewMatrix() ), projection matrix, FloatImage* ( 4 channels, allocated )
+ * @return: none
+ */
+void SoftRasterizer::render( const std::vector<SceneObject> &objects, const Matrix44f &view, const Matrix44f &projection, FloatImage *normalDepth )
+{
+	mObjects	= &objects;
+	mWidth		= normalDepth->getWidth();
+	mHeight		= normalDepth->getHeight();
+	mTilesX		= ( mWidth + TILE_SIZE - 1 ) / TILE_SIZE;
+	mTilesY		= ( mHeight + TILE_SIZE - 1 ) / TILE_SIZE;
+	//far plane of a GL perspective matrix: m22 = ( f + n ) / ( n - f ), m23 = 2fn / ( n - f )
+	mFarDepth	= projection.at( 2, 3 ) / ( projection.at( 2, 2 ) + 1.0f ) / DEPTH_UNIT;
+
+	//vertex stage
+	VertexJob vertexJob( this );
+	mVertices.resize( objects.size() );
+	mModelView.resize( objects.size() );
+	mModelViewProjection.resize( objects.size() );
+	for ( size_t o = 0; o < objects.size(); ++o ) {
+		mModelView[o]			= view * objects[o].transform;
+		mModelViewProjection[o]	= projection * mModelView[o];
+		mVertices[o].resize( objects[o].mesh->positions.size() );
+		for ( size_t v = 0; v < objects[o].mesh->positions.size(); v += VERTICES_PER_TASK )
+			vertexJob.mRanges.push_back( std::make_pair( (int)o, v ) );
+	}
+	mPool->parallelFor( (int)vertexJob.mRanges.size(), &vertexJob );
+
+	//setup + binning, chunks stay in submission order so the raster stage resolves depth ties like GL
+	size_t numChunks = 0;
+	mTrianglesSubmitted = 0;
+	for ( size_t o = 0; o < objects.size(); ++o ) {
+		size_t tris = objects[o].mesh->getNumTriangles();
+		mTrianglesSubmitted += tris;
+		for ( size_t t = 0; t < tris; t += TRIANGLES_PER_CHUNK ) {
+			if ( mChunks.size() <= numChunks )
+				mChunks.push_back( Chunk() );
+			Chunk &chunk		= mChunks[numChunks++];
+			chunk.object		= (int)o;
+			chunk.firstTriangle	= t;
+			chunk.lastTriangle	= std::min( t + TRIANGLES_PER_CHUNK, tris );
+		}
+	}
+	mChunks.resize( numChunks );
+
+	BinJob binJob( this );
+	mPool->parallelFor( (int)mChunks.size(), &binJob );
+
+	mTrianglesBinned = 0;
+	for ( size_t c = 0; c < mChunks.size(); ++c )
+		mTrianglesBinned += mChunks[c].triangles.size();
+
+	//raster stage
+	RasterJob rasterJob( this, normalDepth );
+	mPool->parallelFor( mTilesX * mTilesY, &rasterJob );
+}
+
+/*
+ * @Description: near plane clipping ( the only plane that matters for w ), the others are handled by the tile bounds
+ * @param: the three post-transform vertices, Chunk* to append to
+ * @return: none
+ */
+void SoftRasterizer::setupTriangle( const ClipVertex *v0, const ClipVertex *v1, const ClipVertex *v2, Chunk *chunk )
+{
+	const ClipVertex *in[3] = { v0, v1, v2 };
+
+	//trivial reject against each side of the frustum
+	for ( int axis = 0; axis < 3; ++axis ) {
+		bool allBelow = true, allAbove = true;
+		for ( int i = 0; i < 3; ++i ) {
+			allBelow = allBelow && in[i]->clip[axis] < -in[i]->clip[3];
+			allAbove = allAbove && in[i]->clip[axis] > in[i]->clip[3];
+		}
+		if ( allBelow || allAbove )
+			return;
+	}
+
+	bool inside[3];
+	int numInside = 0;
+	for ( int i = 0; i < 3; ++i ) {
+		inside[i] = in[i]->clip[2] >= -in[i]->clip[3];
+		numInside += inside[i] ? 1 : 0;
+	}
+
+	if ( numInside == 3 ) {
+		emitTriangle( *v0, *v1, *v2, chunk );
+		return;
+	}
+
+	//Sutherland-Hodgman against z = -w, at most 4 vertices come out
+	ClipVertex poly[4];
+	int count = 0;
+	for ( int i = 0; i < 3; ++i ) {
+		const ClipVertex &a = *in[i];
+		const ClipVertex &b = *in[( i + 1 ) % 3];
+		if ( inside[i] )
+			poly[count++] = a;
+		if ( inside[i] != inside[( i + 1 ) % 3] ) {
+			float da = a.clip[2] + a.clip[3];
+			float db = b.clip[2] + b.clip[3];
+			float t = da / ( da - db );
+			ClipVertex &v = poly[count++];
+			for ( int c = 0; c < 4; ++c ) {
+				v.clip[c] = a.clip[c] + ( b.clip[c] - a.clip[c] ) * t;
+				v.attr[c] = a.attr[c] + ( b.attr[c] - a.attr[c] ) * t;
+			}
+		}
+	}
+
+	for ( int i = 2; i < count; ++i )
+		emitTriangle( poly[0], poly[i - 1], poly[i], chunk );
+}
+
+/*
+ * @Description: perspective divide, viewport transform and binning of a clipped triangle
+ * @param: the three vertices, Chunk* to append to
+ * @return: none
+ */
+void SoftRasterizer::emitTriangle( const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Chunk *chunk )
+{
+	const ClipVertex *v[3] = { &a, &b, &c };
+	ScreenTriangle tri;
+
+	for ( int i = 0; i < 3; ++i ) {
+		float invW		= 1.0f / v[i]->clip[3];
+		tri.x[i]		= ( v[i]->clip[0] * invW * 0.5f + 0.5f ) * mWidth;
+		tri.y[i]		= ( v[i]->clip[1] * invW * 0.5f + 0.5f ) * mHeight;
+		tri.z[i]		= v[i]->clip[2] * invW * 0.5f + 0.5f;
+		tri.invW[i]		= invW;
+		for ( int k = 0; k < 4; ++k )
+			tri.attr[i][k] = v[i]->attr[k] * invW;
+	}
+
+	//no face culling in the GL path, so just make every triangle counter clockwise
+	float area = ( tri.x[1] - tri.x[0] ) * ( tri.y[2] - tri.y[0] ) - ( tri.x[2] - tri.x[0] ) * ( tri.y[1] - tri.y[0] );
+	if ( area == 0.0f )
+		return;
+	if ( area < 0.0f ) {
+		std::swap( tri.x[1], tri.x[2] );	std::swap( tri.y[1], tri.y[2] );
+		std::swap( tri.z[1], tri.z[2] );	std::swap( tri.invW[1], tri.invW[2] );
+		for ( int k = 0; k < 4; ++k )
+			std::swap( tri.attr[1][k], tri.attr[2][k] );
+	}
+
+	//pixel centres covered are in [ceil( min - 0.5 ), floor( max - 0.5 )]
+	float minX = std::min( tri.x[0], std::min( tri.x[1], tri.x[2] ) );
+	float maxX = std::max( tri.x[0], std::max( tri.x[1], tri.x[2] ) );
+	float minY = std::min( tri.y[0], std::min( tri.y[1], tri.y[2] ) );
+	float maxY = std::max( tri.y[0], std::max( tri.y[1], tri.y[2] ) );
+
+	tri.minX = std::max( (int)std::ceil( minX - 0.5f ), 0 );
+	tri.minY = std::max( (int)std::ceil( minY - 0.5f ), 0 );
+	tri.maxX = std::min( (int)std::floor( maxX - 0.5f ), mWidth - 1 );
+	tri.maxY = std::min( (int)std::floor( maxY - 0.5f ), mHeight - 1 );
+	if ( tri.minX > tri.maxX || tri.minY > tri.maxY )
+		return;
+
+	uint32_t index = (uint32_t)chunk->triangles.size();
+	chunk->triangles.push_back( tri );
+
+	for ( int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ++ty )
+		for ( int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; ++tx )
+			chunk->bins[ty * mTilesX + tx].push_back( index );
+}
+
+/*
+ * @Description: rasterize one tile with a tile local depth buffer, then resolve into the target
+ * @param: int tile index, FloatImage* target
+ * @return: none
+ */
+void SoftRasterizer::rasterizeTile( int tile, FloatImage *normalDepth )
+{
+	const int tileX0 = ( tile % mTilesX ) * TILE_SIZE;
+	const int tileY0 = ( tile / mTilesX ) * TILE_SIZE;
+	const int tileX1 = std::min( tileX0 + TILE_SIZE, mWidth ) - 1;
+	const int tileY1 = std::min( tileY0 + TILE_SIZE, mHeight ) - 1;
+
+	float depthBuffer[TILE_SIZE * TILE_SIZE];
+	std::fill( depthBuffer, depthBuffer + TILE_SIZE * TILE_SIZE, 1.0f );
+
+	//what unpackTexel() gives for the packed clear of renderNormalsDepthToFBO(): facing the camera at the far plane
+	const float clearValue[4] = { 0.0f, 0.0f, 1.0f, mFarDepth };
+	for ( int y = tileY0; y <= tileY1; ++y )
+		for ( int x = tileX0; x <= tileX1; ++x )
+			std::copy( clearValue, clearValue + 4, normalDepth->getPixel( x, y ) );
+
+	for ( size_t c = 0; c < mChunks.size(); ++c ) {
+		const Chunk &chunk = mChunks[c];
+		const std::vector<uint32_t> &bin = chunk.bins[tile];
+
+		for ( size_t b = 0; b < bin.size(); ++b ) {
+			const ScreenTriangle &tri = chunk.triangles[bin[b]];
+
+			int x0 = std::max( tri.minX, tileX0 ), x1 = std::min( tri.maxX, tileX1 );
+			int y0 = std::max( tri.minY, tileY0 ), y1 = std::min( tri.maxY, tileY1 );
+
+			//edge functions e_i = A_i * x + B_i * y + C_i, positive inside ( ccw )
+			float A[3], B[3], C[3];
+			bool topLeft[3];
+			for ( int e = 0; e < 3; ++e ) {
+				int i = ( e + 1 ) % 3, j = ( e + 2 ) % 3;
+				A[e]		= tri.y[i] - tri.y[j];
+				B[e]		= tri.x[j] - tri.x[i];
+				C[e]		= tri.x[i] * tri.y[j] - tri.x[j] * tri.y[i];
+				topLeft[e]	= ( A[e] > 0.0f ) || ( A[e] == 0.0f && B[e] < 0.0f );
+			}
+			float invArea = 1.0f / ( C[0] + C[1] + C[2] );
+
+			for ( int y = y0; y <= y1; ++y ) {
+				float py = y + 0.5f;
+				for ( int x = x0; x <= x1; ++x ) {
+					float px = x + 0.5f;
+					float w[3];
+					bool covered = true;
+					for ( int e = 0; e < 3; ++e ) {
+						w[e] = A[e] * px + B[e] * py + C[e];
+						covered = covered && ( w[e] > 0.0f || ( w[e] == 0.0f && topLeft[e] ) );
+					}
+					if ( !covered )
+						continue;
+
+					float b0 = w[0] * invArea, b1 = w[1] * invArea, b2 = w[2] * invArea;
+					float z = b0 * tri.z[0] + b1 * tri.z[1] + b2 * tri.z[2];
+					float &stored = depthBuffer[( y - tileY0 ) * TILE_SIZE + ( x - tileX0 )];
+					if ( z >= stored || z < 0.0f || z > 1.0f )
+						continue;
+					stored = z;
+
+					//perspective correct varyings
+					float invW = b0 * tri.invW[0] + b1 * tri.invW[1] + b2 * tri.invW[2];
+					float wInterp = 1.0f / invW;
+					float attr[4];
+					for ( int k = 0; k < 4; ++k )
+						attr[k] = ( b0 * tri.attr[0][k] + b1 * tri.attr[1][k] + b2 * tri.attr[2][k] ) * wInterp;
+
+					//gl_FragColor = vec4( normalize( Normal ), depth )
+					float len = std::sqrt( attr[0] * attr[0] + attr[1] * attr[1] + attr[2] * attr[2] );
+					float inv = len > 0.0f ? 1.0f / len : 0.0f;
+					float *out = normalDepth->getPixel( x, y );
+					out[0] = attr[0] * inv;
+					out[1] = attr[1] * inv;
+					out[2] = attr[2] * inv;
+					out[3] = attr[3];
+				}
+			}
+		}
+	}
+}
+
+} // namespace ssao
@@ -0,0 +1,150 @@
+#include "TargetPlanner.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace ssao {
+
+size_t getBytesPerTexel( TextureDesc::Format format )
+{
+	switch ( format ) {
+		case TextureDesc::FORMAT_RGBA8:		return 4;
+		case TextureDesc::FORMAT_RGBA16F:	return 8;
+		case TextureDesc::FORMAT_RGBA32F:	return 16;
+	}
+	return 0;
+}
+
+size_t getDepthBytesPerSample()
+{
+	return 4;
+}
+
+/*
+ * @Description: bytes one target takes at its desc's size
+ * @param: name, TextureDesc, copies ( 2 for a ping-pong pair ), mipLevels ( 1 = none, levels stop at 1x1 )
+ * @return: TargetFootprint
+ */
+TargetFootprint measureTarget( const std::string &name, const TextureDesc &desc, int copies, int mipLevels )
+{
+	TargetFootprint target;
+	target.name			= name;
+	target.desc			= desc;
+	target.copies		= copies;
+	target.mipLevels	= std::max( mipLevels, 1 );
+
+	size_t texels = 0;
+	int w = desc.width, h = desc.height;
+	for ( int level = 0; level < target.mipLevels; ++level ) {
+		texels += (size_t)w * h;
+		if ( w == 1 && h == 1 )
+			break;
+		w = std::max( w / 2, 1 );
+		h = std::max( h / 2, 1 );
+	}
+
+	size_t pixels			= (size_t)desc.width * desc.height;
+	size_t colorTexel		= getBytesPerTexel( desc.format ) * desc.attachments;
+	size_t depthSample		= desc.depth ? getDepthBytesPerSample() : 0;
+
+	target.textureBytes		= texels * colorTexel * copies;
+	target.multisampleBytes	= pixels * desc.samples * ( colorTexel + depthSample ) * copies;
+	target.depthBytes		= pixels * depthSample * copies;
+	return target;
+}
+
+/*
+ * @Description: constructor
+ * @param: reference size ( what the targets added are sized for )
+ * @return: none
+ */
+TargetPlanner::TargetPlanner( int referenceWidth, int referenceHeight )
+: mReferenceWidth( referenceWidth ), mReferenceHeight( referenceHeight )
+{}
+
+void TargetPlanner::clear( int referenceWidth, int referenceHeight )
+{
+	mReferenceWidth		= referenceWidth;
+	mReferenceHeight	= referenceHeight;
+	mTargets.clear();
+}
+
+void TargetPlanner::addTarget( const std::string &name, const TextureDesc &desc, int copies, int mipLevels )
+{
+	Target target;
+	target.name			= name;
+	target.desc			= desc;
+	target.copies		= copies;
+	target.mipLevels	= mipLevels;
+	mTargets.push_back( target );
+}
+
+void TargetPlanner::addFrameGraph( const FrameGraph &graph )
+{
+	for ( int p = 0; p < graph.getNumPhysical(); ++p ) {
+		std::string name;
+		for ( int r = 0; r < graph.getNumResources(); ++r ) {
+			if ( graph.getPhysicalIndex( r ) != p )
+				continue;
+			if ( !name.empty() )
+				name += "/";
+			name += graph.getResourceName( r );
+		}
+		addTarget( name, graph.getPhysicalDesc( p ) );
+	}
+}
+
+/*
+ * @Description: every target rescaled from the reference size to width x height ( a half res target stays half res )
+ * @param: output width, height
+ * @return: TargetPlan
+ */
+TargetPlan TargetPlanner::plan( int width, int height ) const
+{
+	TargetPlan result;
+	result.width			= width;
+	result.height			= height;
+	result.totalBytes		= 0;
+	result.multisampleBytes	= 0;
+
+	for ( size_t t = 0; t < mTargets.size(); ++t ) {
+		TextureDesc desc = mTargets[t].desc;
+		if ( mReferenceWidth > 0 && mReferenceHeight > 0 ) {
+			desc.width	= std::max( desc.width * width / mReferenceWidth, 1 );
+			desc.height	= std::max( desc.height * height / mReferenceHeight, 1 );
+		}
+
+		TargetFootprint target = measureTarget( mTargets[t].name, desc, mTargets[t].copies, mTargets[t].mipLevels );
+		result.totalBytes		+= target.getTotalBytes();
+		result.multisampleBytes	+= target.multisampleBytes;
+		result.targets.push_back( target );
+	}
+	return result;
+}
+
+void TargetPlanner::dump( const TargetPlan &plan, std::ostream &os )
+{
+	const double MB = 1024.0 * 1024.0;
+	std::ios::fmtflags flags	= os.flags();
+	std::streamsize precision	= os.precision();
+
+	os << "render targets at " << plan.width << "x" << plan.height << ": " << std::fixed << std::setprecision( 1 )
+	   << plan.totalBytes / MB << " MB ( " << plan.multisampleBytes / MB << " MB multisample )" << std::endl;
+	for ( size_t t = 0; t < plan.targets.size(); ++t ) {
+		const TargetFootprint &target = plan.targets[t];
+		os << "  " << target.name << " " << target.desc.width << "x" << target.desc.height << " " << getBytesPerTexel( target.desc.format ) * 8 << "bpp";
+		if ( target.desc.attachments > 1 )
+			os << " x" << target.desc.attachments;
+		if ( target.desc.samples > 0 )
+			os << " " << target.desc.samples << "x MSAA";
+		if ( target.copies > 1 )
+			os << " ( " << target.copies << " copies )";
+		if ( target.mipLevels > 1 )
+			os << " ( " << target.mipLevels << " levels )";
+		os << ": " << target.getTotalBytes() / MB << " MB" << std::endl;
+	}
+	os.flags( flags );
+	os.precision( precision );
+}
+
+} // namespace ssao
@@ -0,0 +1,184 @@
+#include "TaskPool.h"
+
+namespace ssao {
+
+/*
+ * @Description: constructor, spins up numThreads - 1 workers ( the caller of parallelFor() is the last one )
+ * @param: int number of threads ( 0 = hardware threads )
+ * @return: none
+ */
+TaskPool::TaskPool( int numThreads )
+: mJob( 0 ), mBusy( 0 ), mGeneration( 0 ), mQuit( false )
+{
+	if ( numThreads <= 0 )
+		numThreads = getHardwareThreads();
+
+	for ( int i = 0; i < numThreads; ++i )
+		mRanges.push_back( new WorkRange() );
+
+	for ( int i = 1; i < numThreads; ++i )
+		mWorkers.push_back( new std::thread( &TaskPool::workerLoop, this, i ) );
+}
+
+/*
+ * @Description: deconstructor, wakes and joins every worker
+ * @param: none
+ * @return: none
+ */
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mQuit = true;
+	}
+	mWorkReady.notify_all();
+
+	for ( size_t i = 0; i < mWorkers.size(); ++i ) {
+		mWorkers[i]->join();
+		delete mWorkers[i];
+	}
+
+	for ( size_t i = 0; i < mRanges.size(); ++i )
+		delete mRanges[i];
+}
+
+int TaskPool::getHardwareThreads()
+{
+	int count = (int)std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+/*
+ * @Description: run job->run( i ) for every i in [0, count) across the pool, blocks until all are finished
+ * @param: int count, Job*
+ * @return: none
+ */
+void TaskPool::parallelFor( int count, Job *job )
+{
+	if ( count <= 0 )
+		return;
+
+	if ( mWorkers.empty() || count == 1 ) {
+		for ( int i = 0; i < count; ++i )
+			job->run( i, 0 );
+		return;
+	}
+
+	//even split up front, stealing evens out whatever the split gets wrong
+	const int numThreads = getNumThreads();
+	for ( int t = 0; t < numThreads; ++t ) {
+		std::lock_guard<std::mutex> lock( mRanges[t]->mutex );
+		mRanges[t]->begin	= (int)( (double)count * t / numThreads );
+		mRanges[t]->end		= (int)( (double)count * ( t + 1 ) / numThreads );
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mJob	= job;
+		mBusy	= (int)mWorkers.size();
+		++mGeneration;
+	}
+	mWorkReady.notify_all();
+
+	drain( 0 );
+
+	std::unique_lock<std::mutex> lock( mMutex );
+	while ( mBusy > 0 )
+		mWorkDone.wait( lock );
+	mJob = 0;
+}
+
+/*
+ * @Description: take the next index from the front of this thread's own range
+ * @param: int thread index, int* index out
+ * @return: bool ( false when the range is empty )
+ */
+bool TaskPool::pop( int threadIndex, int *index )
+{
+	WorkRange *range = mRanges[threadIndex];
+	std::lock_guard<std::mutex> lock( range->mutex );
+	if ( range->begin >= range->end )
+		return false;
+
+	*index = range->begin++;
+	return true;
+}
+
+/*
+ * @Description: move the back half of some other thread's range into this thread's ( empty ) range
+ * @param: int thread index
+ * @return: bool ( false when every range is empty )
+ */
+bool TaskPool::steal( int threadIndex )
+{
+	const int numThreads = (int)mRanges.size();
+
+	for ( int i = 1; i < numThreads; ++i ) {
+		WorkRange *victim = mRanges[( threadIndex + i ) % numThreads];
+		int begin, end;
+		{
+			std::lock_guard<std::mutex> lock( victim->mutex );
+			int remaining = victim->end - victim->begin;
+			if ( remaining <= 0 )
+				continue;
+
+			end				= victim->end;
+			begin			= victim->begin + remaining / 2;
+			victim->end		= begin;
+		}
+
+		WorkRange *own = mRanges[threadIndex];
+		std::lock_guard<std::mutex> lock( own->mutex );
+		own->begin	= begin;
+		own->end	= end;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * @Description: run indices until there is nothing left to run or steal
+ * @param: int thread index
+ * @return: none
+ */
+void TaskPool::drain( int threadIndex )
+{
+	int index;
+	for (;;) {
+		while ( pop( threadIndex, &index ) )
+			mJob->run( index, threadIndex );
+
+		if ( !steal( threadIndex ) )
+			return;
+	}
+}
+
+/*
+ * @Description: worker thread body, sleeps until a new generation of work is posted
+ * @param: int thread index
+ * @return: none
+ */
+void TaskPool::workerLoop( int threadIndex )
+{
+	unsigned int seen = 0;
+
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock( mMutex );
+			while ( !mQuit && mGeneration == seen )
+				mWorkReady.wait( lock );
+			if ( mQuit )
+				return;
+			seen = mGeneration;
+		}
+
+		drain( threadIndex );
+
+		std::lock_guard<std::mutex> lock( mMutex );
+		if ( --mBusy == 0 )
+			mWorkDone.notify_all();
+	}
+}
+
+} // namespace ssao
@@ -0,0 +1,125 @@
+#include "TemporalAO.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace ssao {
+
+//the normal/depth shaders store -viewPos.z / DEPTH_SCALE
+static const float DEPTH_SCALE = 10.0f;
+
+/*
+ * @Description: constructor
+ * @param: none
+ * @return: none
+ */
+TemporalAO::TemporalAO()
+: mCurrent( 0 ), mValid( false ), mFrameIndex( 0 ), mRejected( 0 )
+{}
+
+void TemporalAO::reset()
+{
+	mValid		= false;
+	mFrameIndex	= 0;
+	mRejected	= 0;
+}
+
+float TemporalAO::getFrameRotation( int frameIndex )
+{
+	const float goldenAngle	= 2.39996323f;
+	const float twoPi		= 6.28318531f;
+	return std::fmod( frameIndex * goldenAngle, twoPi );
+}
+
+/*
+ * @Description: reconstruct the view position at ( u, v, depth ) and project it with the previous camera
+ * @param: uv, linear depth, current projection, current view -> previous view, previous projection, float* results
+ * @return: bool ( false if behind the previous camera )
+ */
+bool TemporalAO::reproject( float u, float v, float depth, const ci::Matrix44f &projection, const ci::Matrix44f &viewToPrevView, const ci::Matrix44f &prevProjection,
+						    float *prevU, float *prevV, float *prevDepth )
+{
+	//inverse of the ( possibly off center ) perspective for a known view z
+	float z		= -depth * DEPTH_SCALE;
+	float ndcX	= u * 2.0f - 1.0f;
+	float ndcY	= v * 2.0f - 1.0f;
+	ci::Vec3f viewPos( -z * ( ndcX + projection.at( 0, 2 ) ) / projection.at( 0, 0 ),
+					   -z * ( ndcY + projection.at( 1, 2 ) ) / projection.at( 1, 1 ),
+					   z );
+
+	ci::Vec3f prevPos	= viewToPrevView.transformPointAffine( viewPos );
+	ci::Vec4f clip		= prevProjection * ci::Vec4f( prevPos.x, prevPos.y, prevPos.z, 1.0f );
+	if ( clip.w <= 0.0f )
+		return false;
+
+	*prevU		= ( clip.x / clip.w ) * 0.5f + 0.5f;
+	*prevV		= ( clip.y / clip.w ) * 0.5f + 0.5f;
+	*prevDepth	= -prevPos.z / DEPTH_SCALE;
+	return true;
+}
+
+/*
+ * @Description: blend this frame's AO into the reprojected history ( the whole of TemporalAO_frag.glsl )
+ * @param: FloatImage normal/depth, FloatImage current AO, view and projection of this frame, FloatImage* result
+ * @return: none
+ */
+void TemporalAO::accumulate( const FloatImage &normalDepth, const FloatImage &currentAO, const ci::Matrix44f &view, const ci::Matrix44f &projection, FloatImage *result )
+{
+	const int w = currentAO.getWidth();
+	const int h = currentAO.getHeight();
+
+	const FloatImage &prev	= mHistory[mCurrent];
+	FloatImage &next		= mHistory[1 - mCurrent];
+	if ( prev.getWidth() != w || prev.getHeight() != h )
+		mValid = false;
+	if ( next.getWidth() != w || next.getHeight() != h || next.getChannels() != 3 )
+		next.allocate( w, h, 3 );
+	if ( result->getWidth() != w || result->getHeight() != h || result->getChannels() != 1 )
+		result->allocate( w, h, 1 );
+
+	const ci::Matrix44f viewToPrevView = mPrevView * view.inverted();
+	const float maxHistory = (float)std::max( mParams.maxHistory, 1 );
+
+	mRejected = 0;
+	for ( int y = 0; y < h; ++y ) {
+		const float v = ( y + 0.5f ) / h;
+		for ( int x = 0; x < w; ++x ) {
+			const float u = ( x + 0.5f ) / w;
+			float nd[4];
+			normalDepth.sampleBilinear( u, v, nd );
+			const float current = *currentAO.getPixel( x, y );
+
+			float ao	= current;
+			float count	= 1.0f;
+
+			float prevU, prevV, expectedDepth;
+			if ( mValid && reproject( u, v, nd[3], projection, viewToPrevView, mPrevProjection, &prevU, &prevV, &expectedDepth )
+				&& prevU >= 0.0f && prevU <= 1.0f && prevV >= 0.0f && prevV <= 1.0f ) {
+				float history[3];
+				prev.sampleBilinear( prevU, prevV, history );
+				if ( std::fabs( history[1] - expectedDepth ) <= mParams.depthTolerance * expectedDepth ) {
+					count	= std::min( history[2] + 1.0f, maxHistory );
+					ao		= history[0] + ( current - history[0] ) / count;
+				}
+				else
+					++mRejected;
+			}
+			else
+				++mRejected;
+
+			float *out = next.getPixel( x, y );
+			out[0] = ao;
+			out[1] = nd[3];
+			out[2] = count;
+			*result->getPixel( x, y ) = ao;
+		}
+	}
+
+	mCurrent		= 1 - mCurrent;
+	mPrevView		= view;
+	mPrevProjection	= projection;
+	mValid			= true;
+	++mFrameIndex;
+}
+
+} // namespace ssao
@@ -0,0 +1,399 @@
+/*
+ * FrameCapture.h / CaptureCodec.h with a synthetic ReadbackDevice instead of pixel buffer objects: codec and .cap round
+ * trips, CaptureRing scheduling, and what FrameCapture counts when readbacks come back late, the writers fall behind
+ * or a readback fails. Writes to a fresh directory under /tmp. From the repository root:
+ *
+ *	g++ -O2 -Iinclude -I$CINDER/include -I$CINDER/boost tests/FrameCaptureTest.cpp src/FrameCapture.cpp src/CaptureCodec.cpp <Cinder and boost_thread libs> -o FrameCaptureTest && ./FrameCaptureTest
+ */
+#include "FrameCapture.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ssao;
+
+//what a frame's target holds: smooth ramps, a flat band and some noise, different every frame
+static void fillPixels( int frame, int target, const CaptureTarget &desc, unsigned char *dst )
+{
+	if ( desc.bytesPerChannel == 4 ) {
+		float *values = (float*)dst;
+		for ( int i = 0, count = desc.width * desc.height * desc.channels; i < count; ++i )
+			values[i] = ( i / desc.channels % desc.width ) * 0.01f + frame * 0.5f + ( i % desc.channels ) - target;
+		return;
+	}
+	uint32_t noise = 2166136261u ^ (uint32_t)( frame * 16 + target );
+	for ( size_t i = 0; i < desc.getBytes(); ++i ) {
+		int x = (int)( i / desc.channels % desc.width ), y = (int)( i / desc.channels / desc.width );
+		noise = noise * 1664525u + 1013904223u;
+		if ( y < desc.height / 3 )
+			dst[i] = (unsigned char)( x + y + frame );
+		else if ( y < 2 * desc.height / 3 )
+			dst[i] = (unsigned char)target;
+		else
+			dst[i] = (unsigned char)( noise >> 24 );
+	}
+}
+
+static std::vector<unsigned char> makePixels( int frame, int target, const CaptureTarget &desc )
+{
+	std::vector<unsigned char> pixels( desc.getBytes() );
+	if ( !pixels.empty() )
+		fillPixels( frame, target, desc, &pixels[0] );
+	return pixels;
+}
+
+/*
+ * pixels are made up when finishReadback() asks for them, from the frame the slot was started for ( the test says
+ * which frame comes next, the device can't know about dropped ones ). stalled = no readback is ever done
+ */
+class SyntheticDevice : public ReadbackDevice
+{
+public:
+	SyntheticDevice() : nextFrame( 0 ), stalled( false ), failFrame( -1 ), mSlotFrames( 16, -1 ) {}
+
+	void startReadback( int slot, const std::vector<CaptureTarget> &targets )
+	{
+		mSlotFrames[slot]	= nextFrame;
+		mSlotTargets		= targets;
+		starts.push_back( slot );
+	}
+	bool isReadbackDone( int )	{ return !stalled; }
+	bool finishReadback( int slot, int target, unsigned char *dst )
+	{
+		if ( mSlotFrames[slot] == failFrame )
+			return false;
+		fillPixels( mSlotFrames[slot], target, mSlotTargets[target], dst );
+		return true;
+	}
+
+	int					nextFrame;
+	bool				stalled;
+	int					failFrame;
+	std::vector<int>	starts;		//slot of every startReadback()
+
+private:
+	std::vector<int>			mSlotFrames;
+	std::vector<CaptureTarget>	mSlotTargets;
+};
+
+static std::string getPath( const std::string &dir, const std::string &name, int frame )
+{
+	char number[16];
+	std::sprintf( number, "_%06d.cap", frame );
+	return dir + name + number;
+}
+
+static bool fileExists( const std::string &path )
+{
+	struct stat info;
+	return stat( path.c_str(), &info ) == 0;
+}
+
+//the file is there, says it is frame and decodes to what the device handed over for it
+static bool checkFile( const std::string &path, int frame, int target, const CaptureTarget &desc )
+{
+	CaptureTarget loaded;
+	int loadedFrame = -1;
+	std::vector<unsigned char> pixels;
+	return readCaptureFile( path, &loaded, &loadedFrame, &pixels ) && loadedFrame == frame && loaded.width == desc.width
+		&& loaded.height == desc.height && loaded.channels == desc.channels && loaded.bytesPerChannel == desc.bytesPerChannel
+		&& pixels == makePixels( frame, target, desc );
+}
+
+//until the writer threads have done count frames ( or 5 s went by )
+static void waitForWriters( FrameCapture *capture, int count )
+{
+	for ( int wait = 0; wait < 500; ++wait ) {
+		CaptureStats stats = capture->getStats();
+		if ( stats.written + stats.failed >= count )
+			return;
+		usleep( 10000 );
+	}
+}
+
+static void clearDirectory( const std::string &dir )
+{
+	DIR *handle = opendir( dir.c_str() );
+	if ( !handle )
+		return;
+	while ( dirent *entry = readdir( handle ) )
+		if ( entry->d_name[0] != '.' )
+			std::remove( ( dir + entry->d_name ).c_str() );
+	closedir( handle );
+}
+
+static void testCodec( const std::string &dir )
+{
+	const CaptureTarget targets[] = {
+		CaptureTarget( "color", 64, 48, 4, 1 ),
+		CaptureTarget( "odd", 7, 5, 3, 1 ),
+		CaptureTarget( "one", 1, 1, 1, 1 ),
+		CaptureTarget( "ao", 33, 17, 4, 4 )
+	};
+	for ( int t = 0; t < 4; ++t ) {
+		std::vector<unsigned char> pixels = makePixels( 3, t, targets[t] ), encoded, decoded;
+		encodeCapture( &pixels[0], targets[t], &encoded );
+		CHECK( decodeCapture( &encoded[0], encoded.size(), targets[t], &decoded ) );
+		CHECK( decoded == pixels );
+		//a byte short, or a different size than it was encoded for, fails instead of giving garbage
+		CHECK( !decodeCapture( &encoded[0], encoded.size() - 1, targets[t], &decoded ) );
+		CaptureTarget bigger = targets[t];
+		++bigger.height;
+		CHECK( !decodeCapture( &encoded[0], encoded.size(), bigger, &decoded ) );
+
+		std::string path = getPath( dir, targets[t].name, 3 );
+		CHECK( writeCaptureFile( path, targets[t], 3, encoded ) );
+		CHECK( checkFile( path, 3, t, targets[t] ) );
+	}
+
+	//flat areas collapse ( a run is at most 128 bytes ), noise grows by at most 1 byte in 128 ( plus the run headers of a plane )
+	CaptureTarget flat( "flat", 256, 256, 4, 1 );
+	std::vector<unsigned char> pixels( flat.getBytes(), 200 ), encoded;
+	encodeCapture( &pixels[0], flat, &encoded );
+	CHECK( encoded.size() * 50 < pixels.size() );
+	uint32_t noise = 1;
+	for ( size_t i = 0; i < pixels.size(); ++i ) {
+		noise = noise * 1664525u + 1013904223u;
+		pixels[i] = (unsigned char)( noise >> 24 );
+	}
+	encodeCapture( &pixels[0], flat, &encoded );
+	CHECK( encoded.size() <= pixels.size() + pixels.size() / 128 + 64 );
+
+	//not a .cap
+	{
+		std::ofstream junk( ( dir + "junk.cap" ).c_str(), std::ios::binary );
+		junk << "definitely not a capture file, but at least 32 bytes long";
+	}
+	CaptureTarget loaded;
+	int frame = -1;
+	std::vector<unsigned char> decoded;
+	CHECK( !readCaptureFile( dir + "junk.cap", &loaded, &frame, &decoded ) && frame == -1 );
+	CHECK( !readCaptureFile( dir + "missing.cap", &loaded, &frame, &decoded ) );
+
+	//bytes to [0,1], floats as they are
+	FloatImage image;
+	std::vector<unsigned char> color = makePixels( 0, 0, targets[0] );
+	captureToFloatImage( targets[0], color, &image );
+	CHECK( image.getWidth() == 64 && image.getHeight() == 48 && image.getChannels() == 4 );
+	CHECK_NEAR( image.getData()[5], color[5] / 255.0, 1e-7 );
+	std::vector<unsigned char> ao = makePixels( 0, 3, targets[3] );
+	captureToFloatImage( targets[3], ao, &image );
+	CHECK( std::memcmp( image.getData(), &ao[0], ao.size() ) == 0 );
+
+	clearDirectory( dir );
+}
+
+static void testRing()
+{
+	CaptureRing ring( 3, 1 );
+	CHECK( ring.getNumSlots() == 3 && ring.getLatency() == 1 );
+	CHECK( ring.getReady( 0 ) == -1 );
+
+	//slots go round in order, a slot is ready latency frames after it was started, oldest first
+	CHECK( ring.acquire( 0 ) == 0 );
+	CHECK( ring.getReady( 0 ) == -1 );
+	CHECK( ring.getReady( 0, true ) == 0 );
+	CHECK( ring.acquire( 1 ) == 1 );
+	CHECK( ring.getReady( 1 ) == 0 );
+	CHECK( ring.acquire( 2 ) == 2 );
+	//full: the frame is dropped
+	CHECK( ring.acquire( 3 ) == -1 );
+	CHECK( ring.getNumInFlight() == 3 );
+
+	//only the oldest can be released
+	ring.release( 1 );
+	CHECK( ring.getNumInFlight() == 3 && ring.getSlotFrame( 1 ) == 1 );
+	ring.release( 0 );
+	CHECK( ring.getNumInFlight() == 2 && ring.getSlotFrame( 0 ) == -1 );
+	CHECK( ring.getReady( 4 ) == 1 );
+	CHECK( ring.acquire( 4 ) == 0 );
+	ring.release( 1 );
+	ring.release( 2 );
+	//frame 4 was started this frame, not ready yet
+	CHECK( ring.getReady( 4 ) == -1 && ring.getReady( 5 ) == 0 );
+
+	ring.reset();
+	CHECK( ring.getNumInFlight() == 0 && ring.acquire( 9 ) == 0 );
+
+	//latency can't reach a slot that is reused before it is read
+	CHECK( CaptureRing( 2, 5 ).getLatency() == 1 );
+	CHECK( CaptureRing( 0, 2 ).getNumSlots() == 1 && CaptureRing( 0, 2 ).getLatency() == 0 );
+}
+
+/*
+ * a device that keeps up: every frame is read back latency frames later and written. The loop lets the writers finish
+ * what was collected before the next frame ( a render loop is that slow ), so none is dropped for the backlog
+ */
+static void testSteady( const std::string &dir, const std::vector<CaptureTarget> &targets )
+{
+	SyntheticDevice device;
+	FrameCapture capture( &device, 4, 2, 2, 8 );
+	capture.setTargets( targets );
+	capture.start( dir );
+	for ( int frame = 0; frame < 20; ++frame ) {
+		device.nextFrame = capture.getFrame();
+		capture.captureFrame();
+		waitForWriters( &capture, std::max( capture.getFrame() - 2, 0 ) );
+	}
+	capture.stop();
+
+	CaptureStats stats = capture.getStats();
+	CHECK( stats.started == 20 && stats.written == 20 );
+	CHECK( stats.droppedRing == 0 && stats.droppedBacklog == 0 && stats.failed == 0 );
+	CHECK( stats.rawBytes == 20 * ( targets[0].getBytes() + targets[1].getBytes() ) );
+	CHECK( stats.encodedBytes > 0 && stats.getRatio() > 1.0 );
+	//slots in ring order
+	bool inOrder = device.starts.size() == 20;
+	for ( size_t i = 0; i < device.starts.size(); ++i )
+		inOrder = inOrder && device.starts[i] == (int)i % 4;
+	CHECK( inOrder );
+
+	bool files = true;
+	for ( int frame = 0; frame < 20; ++frame )
+		for ( int t = 0; t < 2; ++t )
+			files = files && checkFile( getPath( dir, targets[t].name, frame ), frame, t, targets[t] );
+	CHECK( files );
+	clearDirectory( dir );
+}
+
+//readbacks that don't come back fill the ring, the frames after that are dropped, nothing waits
+static void testLateReadback( const std::string &dir, const std::vector<CaptureTarget> &targets )
+{
+	SyntheticDevice device;
+	FrameCapture capture( &device, 3, 1, 1, 8 );
+	capture.setTargets( targets );
+	capture.start( dir );
+
+	device.stalled = true;
+	for ( int frame = 0; frame < 5; ++frame ) {
+		device.nextFrame = capture.getFrame();
+		capture.captureFrame();
+	}
+	//0 1 2 in flight, 3 and 4 had no slot
+	CaptureStats stats = capture.getStats();
+	CHECK( stats.started == 3 && stats.droppedRing == 2 && stats.written == 0 );
+
+	//back: frame 5 collects 0 1 2 and takes a slot again
+	device.stalled = false;
+	device.nextFrame = capture.getFrame();
+	capture.captureFrame();
+	capture.stop();
+
+	stats = capture.getStats();
+	CHECK( stats.started == 4 && stats.droppedRing == 2 && stats.droppedBacklog == 0 && stats.written == 4 && stats.failed == 0 );
+	CHECK( stats.started + stats.droppedRing == capture.getFrame() );
+	const int written[] = { 0, 1, 2, 5 };
+	for ( int i = 0; i < 4; ++i )
+		CHECK( checkFile( getPath( dir, targets[0].name, written[i] ), written[i], 0, targets[0] ) );
+	CHECK( !fileExists( getPath( dir, targets[0].name, 3 ) ) && !fileExists( getPath( dir, targets[0].name, 4 ) ) );
+	clearDirectory( dir );
+}
+
+/*
+ * the writers fall behind: one writer, one frame of room, and frame 0's file is a FIFO so the writer blocks opening it
+ * until the test reads it. Frame 1 finds no free frame and is dropped, frame 2 goes through once the writer is back
+ */
+static void testBacklog( const std::string &dir, const std::vector<CaptureTarget> &targets )
+{
+	std::vector<CaptureTarget> one( 1, targets[0] );
+	std::string fifo = getPath( dir, one[0].name, 0 );
+	CHECK( mkfifo( fifo.c_str(), 0600 ) == 0 );
+
+	SyntheticDevice device;
+	FrameCapture capture( &device, 2, 0, 1, 1 );
+	capture.setTargets( one );
+	capture.start( dir );
+	for ( int frame = 0; frame < 3; ++frame ) {
+		device.nextFrame = capture.getFrame();
+		capture.captureFrame();
+	}
+	CaptureStats stats = capture.getStats();
+	CHECK( stats.started == 3 && stats.droppedBacklog == 1 && stats.written == 0 );
+
+	//let the writer through and keep what it wrote
+	std::vector<char> bytes;
+	{
+		std::ifstream in( fifo.c_str(), std::ios::binary );
+		bytes.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+	}
+	waitForWriters( &capture, 1 );
+	CHECK( capture.getStats().written == 1 );
+
+	device.nextFrame = capture.getFrame();
+	capture.captureFrame();
+	capture.stop();
+
+	stats = capture.getStats();
+	CHECK( stats.started == 4 && stats.written == 3 && stats.droppedBacklog == 1 && stats.droppedRing == 0 && stats.failed == 0 );
+	CHECK( stats.written + stats.droppedBacklog + stats.failed == stats.started );
+
+	std::remove( fifo.c_str() );
+	{
+		std::ofstream out( fifo.c_str(), std::ios::binary );
+		out.write( &bytes[0], bytes.size() );
+	}
+	CHECK( !bytes.empty() && checkFile( fifo, 0, 0, one[0] ) );
+	CHECK( !fileExists( getPath( dir, one[0].name, 1 ) ) );
+	CHECK( checkFile( getPath( dir, one[0].name, 2 ), 2, 0, one[0] ) && checkFile( getPath( dir, one[0].name, 3 ), 3, 0, one[0] ) );
+	clearDirectory( dir );
+}
+
+//a readback that fails and a directory that can't be written count as failed, the frames around them are fine
+static void testFailures( const std::string &dir, const std::vector<CaptureTarget> &targets )
+{
+	SyntheticDevice device;
+	device.failFrame = 2;
+	FrameCapture capture( &device, 4, 2, 2, 8 );
+	capture.setTargets( targets );
+	capture.start( dir );
+	for ( int frame = 0; frame < 6; ++frame ) {
+		device.nextFrame = capture.getFrame();
+		capture.captureFrame();
+	}
+	capture.stop();
+	CaptureStats stats = capture.getStats();
+	CHECK( stats.started == 6 && stats.written == 5 && stats.failed == 1 );
+	CHECK( !fileExists( getPath( dir, targets[0].name, 2 ) ) && checkFile( getPath( dir, targets[0].name, 3 ), 3, 0, targets[0] ) );
+	clearDirectory( dir );
+
+	capture.start( dir + "missing/" );
+	for ( int frame = 0; frame < 4; ++frame )
+		capture.captureFrame();
+	capture.stop();
+	stats = capture.getStats();
+	CHECK( stats.started == 4 && stats.written == 0 && stats.failed == 4 );
+}
+
+int main()
+{
+	char dir[] = "/tmp/ssao_capture_test_XXXXXX";
+	if ( !mkdtemp( dir ) ) {
+		std::printf( "can't create a directory under /tmp\n" );
+		return 1;
+	}
+	std::string path = std::string( dir ) + "/";
+
+	std::vector<CaptureTarget> targets;
+	targets.push_back( CaptureTarget( "scene", 40, 30, 4, 1 ) );
+	targets.push_back( CaptureTarget( "ssao", 20, 15, 4, 4 ) );
+
+	testCodec( path );
+	testRing();
+	testSteady( path, targets );
+	testLateReadback( path, targets );
+	testBacklog( path, targets );
+	testFailures( path, targets );
+
+	clearDirectory( path );
+	rmdir( dir );
+	return testResult( "FrameCaptureTest" );
+}
@@ -0,0 +1,250 @@
+/*
+ * FrameGraph::compile() without a GL context: culling, lifetimes, persistent resources, aliasing. From the repository root:
+ *
+ *	g++ -O2 -Iinclude -I$CINDER/include -I$CINDER/boost tests/FrameGraphTest.cpp src/FrameGraph.cpp -o FrameGraphTest && ./FrameGraphTest
+ */
+#include "FrameGraph.h"
+#include "UnitTest.h"
+
+#include <vector>
+
+using namespace ssao;
+
+//counts the passes execute() runs, in order
+class RecordingExecutor : public FrameGraph::Executor
+{
+public:
+	explicit RecordingExecutor( std::vector<FrameGraph::PassId> *log ) : mLog( log ) {}
+	void execute( const FrameGraph&, FrameGraph::PassId pass ) { mLog->push_back( pass ); }
+private:
+	std::vector<FrameGraph::PassId>	*mLog;
+};
+
+static const TextureDesc FULL( 720, 486, TextureDesc::FORMAT_RGBA8, 4 );
+static const TextureDesc HALF( 360, 243, TextureDesc::FORMAT_RGBA16F, 0, 1, false );
+
+//passes nobody reads from the outputs are culled, side effect passes never are
+static void testCulling()
+{
+	FrameGraph graph;
+	FrameGraph::ResourceId scene	= graph.createTexture( "scene", FULL );
+	FrameGraph::ResourceId normal	= graph.createTexture( "normal", FULL );
+	FrameGraph::ResourceId ao		= graph.createTexture( "ao", HALF );
+	FrameGraph::ResourceId window	= graph.importTexture( "window", FULL );
+
+	FrameGraph::PassId pScene	= graph.addPass( "scene" );
+	graph.write( pScene, scene );
+	FrameGraph::PassId pNormal	= graph.addPass( "normal" );
+	graph.write( pNormal, normal );
+	FrameGraph::PassId pAO		= graph.addPass( "ao" );
+	graph.read( pAO, normal );
+	graph.write( pAO, ao );
+	FrameGraph::PassId pShow	= graph.addPass( "show scene" );
+	graph.read( pShow, scene );
+	graph.write( pShow, window );
+	FrameGraph::PassId pUI		= graph.addPass( "ui" );
+	graph.setSideEffect( pUI );
+	graph.markOutput( window );
+
+	CHECK( graph.compile() );
+	CHECK( !graph.isPassCulled( pScene ) );
+	CHECK( graph.isPassCulled( pNormal ) );
+	CHECK( graph.isPassCulled( pAO ) );
+	CHECK( !graph.isPassCulled( pShow ) );
+	CHECK( !graph.isPassCulled( pUI ) );
+	CHECK( graph.getExecutionOrder().size() == 3 );
+	//culled passes' resources get no target
+	CHECK( graph.getPhysicalIndex( normal ) < 0 );
+	CHECK( graph.getPhysicalIndex( ao ) < 0 );
+	CHECK( graph.getPhysicalIndex( scene ) >= 0 );
+	CHECK( graph.getPhysicalIndex( window ) < 0 );	//imported
+
+	//the AO becomes needed once something that is output reads it
+	graph.read( pShow, ao );
+	CHECK( graph.compile() );
+	CHECK( !graph.isPassCulled( pNormal ) );
+	CHECK( !graph.isPassCulled( pAO ) );
+
+	std::vector<FrameGraph::PassId> log;
+	FrameGraph::ExecutorRef executor( new RecordingExecutor( &log ) );
+	FrameGraph ordered;
+	FrameGraph::ResourceId out = ordered.importTexture( "window", FULL );
+	FrameGraph::PassId a = ordered.addPass( "a", executor );
+	FrameGraph::PassId b = ordered.addPass( "b", executor );
+	ordered.write( b, out );
+	ordered.markOutput( out );
+	ordered.execute();
+	CHECK( ordered.isPassCulled( a ) );
+	CHECK( log.size() == 1 && log[0] == b );
+}
+
+static void testErrors()
+{
+	FrameGraph graph;
+	FrameGraph::ResourceId ao	= graph.createTexture( "ao", HALF );
+	FrameGraph::ResourceId out	= graph.importTexture( "window", FULL );
+	FrameGraph::PassId reader	= graph.addPass( "reader" );
+	graph.read( reader, ao );
+	graph.write( reader, out );
+	FrameGraph::PassId writer	= graph.addPass( "writer" );
+	graph.write( writer, ao );
+	graph.markOutput( out );
+	CHECK( !graph.compile() );
+	CHECK( graph.getErrors().size() == 1 );
+	CHECK( !graph.isCompiled() );
+}
+
+//first / last use are positions in the execution order, culled passes don't count
+static void testLifetimes()
+{
+	FrameGraph graph;
+	FrameGraph::ResourceId a	= graph.createTexture( "a", HALF );
+	FrameGraph::ResourceId b	= graph.createTexture( "b", HALF );
+	FrameGraph::ResourceId out	= graph.importTexture( "window", FULL );
+
+	FrameGraph::ResourceId unused = graph.createTexture( "unused", HALF );
+	FrameGraph::PassId culled = graph.addPass( "culled" );
+	graph.write( culled, unused );
+	FrameGraph::PassId p0 = graph.addPass( "write a" );
+	graph.write( p0, a );
+	FrameGraph::PassId p1 = graph.addPass( "a to b" );
+	graph.read( p1, a );
+	graph.write( p1, b );
+	FrameGraph::PassId p2 = graph.addPass( "b to window" );
+	graph.read( p2, b );
+	graph.write( p2, out );
+	graph.markOutput( out );
+
+	CHECK( graph.compile() );
+	CHECK( graph.isPassCulled( culled ) );
+	CHECK( graph.getFirstUse( a ) == 0 && graph.getLastUse( a ) == 1 );
+	CHECK( graph.getFirstUse( b ) == 1 && graph.getLastUse( b ) == 2 );
+	CHECK( graph.getFirstUse( out ) == 2 && graph.getLastUse( out ) == 2 );
+	CHECK( graph.getFirstUse( unused ) == -1 && graph.getPhysicalIndex( unused ) < 0 );
+	(void)p0;
+}
+
+/*
+ * greedy aliasing: a target is reused only by a resource of the same desc whose first use comes strictly after
+ * the target's last use ( reading and writing the same target in one pass would be a feedback loop )
+ */
+static void testAliasing()
+{
+	FrameGraph graph;
+	FrameGraph::ResourceId ao		= graph.createTexture( "ao", HALF );
+	FrameGraph::ResourceId blurH	= graph.createTexture( "blurH", HALF );
+	FrameGraph::ResourceId blurV	= graph.createTexture( "blurV", HALF );
+	FrameGraph::ResourceId other	= graph.createTexture( "other format", TextureDesc( 360, 243, TextureDesc::FORMAT_RGBA8, 0, 1, false ) );
+	FrameGraph::ResourceId out		= graph.importTexture( "window", FULL );
+
+	FrameGraph::PassId pAO = graph.addPass( "ao" );
+	graph.write( pAO, ao );
+	FrameGraph::PassId pH = graph.addPass( "blur h" );
+	graph.read( pH, ao );
+	graph.write( pH, blurH );
+	FrameGraph::PassId pV = graph.addPass( "blur v" );
+	graph.read( pV, blurH );
+	graph.write( pV, blurV );
+	FrameGraph::PassId pOther = graph.addPass( "other" );
+	graph.read( pOther, blurV );
+	graph.write( pOther, other );
+	FrameGraph::PassId pOut = graph.addPass( "composite" );
+	graph.read( pOut, other );
+	graph.write( pOut, out );
+	graph.markOutput( out );
+
+	CHECK( graph.compile() );
+	//ao dies at "blur h" ( 1 ), blurV starts at "blur v" ( 2 ): shares. blurH overlaps both neighbours
+	CHECK( graph.getPhysicalIndex( ao ) == graph.getPhysicalIndex( blurV ) );
+	CHECK( graph.getPhysicalIndex( ao ) != graph.getPhysicalIndex( blurH ) );
+	CHECK( graph.getPhysicalIndex( blurH ) != graph.getPhysicalIndex( blurV ) );
+	//a different desc never shares, even when the lifetimes would allow it
+	CHECK( graph.getPhysicalIndex( other ) != graph.getPhysicalIndex( ao ) );
+	CHECK( graph.getPhysicalIndex( other ) != graph.getPhysicalIndex( blurH ) );
+	CHECK( graph.getNumPhysical() == 3 );
+	CHECK( graph.getPhysicalDesc( graph.getPhysicalIndex( other ) ) == graph.getResourceDesc( other ) );
+
+	//last use == first use is not enough: b is written by the pass that reads a last
+	FrameGraph touching;
+	FrameGraph::ResourceId a	= touching.createTexture( "a", HALF );
+	FrameGraph::ResourceId b	= touching.createTexture( "b", HALF );
+	FrameGraph::ResourceId w	= touching.importTexture( "window", FULL );
+	FrameGraph::PassId p0 = touching.addPass( "write a" );
+	touching.write( p0, a );
+	FrameGraph::PassId p1 = touching.addPass( "a to b" );
+	touching.read( p1, a );
+	touching.write( p1, b );
+	FrameGraph::PassId p2 = touching.addPass( "b to window" );
+	touching.read( p2, b );
+	touching.write( p2, w );
+	touching.markOutput( w );
+	CHECK( touching.compile() );
+	CHECK( touching.getLastUse( a ) == touching.getFirstUse( b ) );
+	CHECK( touching.getPhysicalIndex( a ) != touching.getPhysicalIndex( b ) );
+	CHECK( touching.getNumPhysical() == 2 );
+}
+
+//a cacheable pass's output read by a pass that always runs must survive the frame: persistent, never shared
+static void testPersistent()
+{
+	FrameGraph graph;
+	FrameGraph::ResourceId normal	= graph.createTexture( "normal", HALF );
+	FrameGraph::ResourceId ao		= graph.createTexture( "ao", HALF );
+	FrameGraph::ResourceId late		= graph.createTexture( "late", HALF );
+	FrameGraph::ResourceId out		= graph.importTexture( "window", FULL );
+
+	FrameGraph::PassId pNormal = graph.addPass( "normal" );
+	graph.write( pNormal, normal );
+	graph.setCacheable( pNormal );
+	FrameGraph::PassId pAO = graph.addPass( "ao" );
+	graph.read( pAO, normal );
+	graph.write( pAO, ao );
+	graph.setCacheable( pAO );
+	FrameGraph::PassId pComposite = graph.addPass( "composite" );
+	graph.read( pComposite, ao );
+	graph.write( pComposite, late );
+	FrameGraph::PassId pOut = graph.addPass( "present" );
+	graph.read( pOut, late );
+	graph.write( pOut, out );
+	graph.markOutput( out );
+
+	CHECK( graph.compile() );
+	//normal goes cacheable -> cacheable, late always runs -> always runs: both transient
+	CHECK( !graph.isPersistent( normal ) );
+	CHECK( graph.isPersistent( ao ) );
+	CHECK( !graph.isPersistent( late ) );
+	CHECK( !graph.isPersistent( out ) );	//imported
+	//normal is dead before late is born and has the same desc, ao in between must not take either target
+	CHECK( graph.getPhysicalIndex( normal ) == graph.getPhysicalIndex( late ) );
+	CHECK( graph.getPhysicalIndex( ao ) != graph.getPhysicalIndex( normal ) );
+	CHECK( graph.getNumPhysical() == 2 );
+
+	//execute( true ) skips the cacheable passes
+	std::vector<FrameGraph::PassId> log;
+	FrameGraph::ExecutorRef executor( new RecordingExecutor( &log ) );
+	FrameGraph run;
+	FrameGraph::ResourceId r	= run.createTexture( "r", HALF );
+	FrameGraph::ResourceId w	= run.importTexture( "window", FULL );
+	FrameGraph::PassId cached	= run.addPass( "cached", executor );
+	run.write( cached, r );
+	run.setCacheable( cached );
+	FrameGraph::PassId always	= run.addPass( "always", executor );
+	run.read( always, r );
+	run.write( always, w );
+	run.markOutput( w );
+	run.execute( true );
+	CHECK( log.size() == 1 && log[0] == always );
+	log.clear();
+	run.execute( false );
+	CHECK( log.size() == 2 && log[0] == cached );
+}
+
+int main()
+{
+	testCulling();
+	testErrors();
+	testLifetimes();
+	testAliasing();
+	testPersistent();
+	return testResult( "FrameGraphTest" );
+}
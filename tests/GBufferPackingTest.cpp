@@ -0,0 +1,199 @@
+/*
+ * GBufferPacking.h on synthetic normals / depths and the edge cases of the format: the +-Z poles, the octahedral fold
+ * ( z = 0 and the axes of the folded half ), depth 0, the near and far planes. The packing runs on whatever path
+ * SimdFloat.h picked, so build and run it once per path, from the repository root:
+ *
+ *	g++ -O2 -DSSAO_DISABLE_SIMD	-Iinclude -I$CINDER/include -I$CINDER/boost tests/GBufferPackingTest.cpp src/GBufferPacking.cpp <Cinder lib> -o GBufferPackingTest && ./GBufferPackingTest
+ *	g++ -O2 -msse4.1			... ( same )
+ *	g++ -O2 -mavx2				... ( same )
+ *
+ * Every path must give the texels packTexel() / unpackTexel() give, bit for bit, and stay inside the same error bounds.
+ */
+#include "GBufferPacking.h"
+#include "SimdFloat.h"
+#include "UnitTest.h"
+
+#include <string>
+#include <vector>
+
+using namespace ssao;
+
+static const ClipPlanes CLIP( 1.0f, 50.0f );	//the app's camera
+
+/*
+ * 8 bit octahedral: a texel step is 2/255 of the [-1,1]^2 square, rounding both coordinates by half a step costs up to
+ * ~0.93 degrees where the mapping stretches most ( around the fold ), ~0.34 on average. Depth: 16 bits over far - near,
+ * half a step is 49 / 65535 / 2
+ */
+static const double MAX_NORMAL_DEGREES	= 1.0;
+static const double MEAN_NORMAL_DEGREES	= 0.4;
+static const double MAX_DEPTH_ERROR		= ( 50.0 - 1.0 ) / 65535.0 * 0.5 + 1e-5;	//view units
+
+static double angleDegrees( const float *a, const float *b )
+{
+	double d = (double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2];
+	return std::acos( std::min( std::max( d, -1.0 ), 1.0 ) ) * 180.0 / 3.14159265358979;
+}
+
+static void normalize( float *n )
+{
+	float len = std::sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+	n[0] /= len;
+	n[1] /= len;
+	n[2] /= len;
+}
+
+//the normals that sit on a seam of the mapping, each at a few depths
+static void addEdgeCases( std::vector<float> *texels )
+{
+	const float normals[][3] = {
+		{ 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },							//poles, -Z lands on the corners of the square
+		{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },	//the fold, z = 0
+		{ 0.7071068f, 0.7071068f, 0.0f }, { -0.7071068f, 0.7071068f, 0.0f }, { 0.7071068f, -0.7071068f, 0.0f }, { -0.7071068f, -0.7071068f, 0.0f },
+		{ 0.6f, 0.0f, -0.8f }, { -0.6f, 0.0f, -0.8f }, { 0.0f, 0.6f, -0.8f }, { 0.0f, -0.6f, -0.8f },	//x or y = 0 in the folded half, where the sign flips
+		{ -0.0f, 0.6f, -0.8f }, { 0.6f, -0.0f, -0.8f },
+		{ 0.6f, 0.8f, 1e-6f }, { 0.6f, 0.8f, -1e-6f }, { -0.8f, -0.6f, 1e-6f }, { -0.8f, -0.6f, -1e-6f }	//just either side of the fold
+	};
+	const float depths[] = { CLIP.nearClip, 0.5f * ( CLIP.nearClip + CLIP.farClip ), CLIP.farClip };
+
+	for ( size_t n = 0; n < sizeof( normals ) / sizeof( normals[0] ); ++n )
+		for ( size_t d = 0; d < sizeof( depths ) / sizeof( depths[0] ); ++d ) {
+			texels->insert( texels->end(), normals[n], normals[n] + 3 );
+			texels->push_back( depths[d] / DEPTH_UNIT );
+		}
+}
+
+//deterministic, evenly spread over the sphere ( fibonacci ) with depths sweeping the clip range
+static void addSphere( std::vector<float> *texels, int count )
+{
+	for ( int i = 0; i < count; ++i ) {
+		float z		= 1.0f - 2.0f * ( i + 0.5f ) / count;
+		float r		= std::sqrt( std::max( 1.0f - z * z, 0.0f ) );
+		float phi	= 2.39996323f * i;
+		float n[3]	= { r * std::cos( phi ), r * std::sin( phi ), z };
+		normalize( n );
+		texels->insert( texels->end(), n, n + 3 );
+		float t = ( i * 0.618034f ) - std::floor( i * 0.618034f );
+		texels->push_back( ( CLIP.nearClip + t * ( CLIP.farClip - CLIP.nearClip ) ) / DEPTH_UNIT );
+	}
+}
+
+static FloatImage toImage( const std::vector<float> &texels, int width )
+{
+	int count	= (int)texels.size() / 4;
+	int height	= ( count + width - 1 ) / width;
+	FloatImage image( width, height, 4 );
+	//the padding repeats the first texel
+	for ( int i = 0; i < width * height; ++i )
+		std::copy( &texels[( i < count ? i : 0 ) * 4], &texels[( i < count ? i : 0 ) * 4] + 4, image.getData() + i * 4 );
+	return image;
+}
+
+//the scalar reference on its own, texel by texel
+static void testReference()
+{
+	std::vector<float> texels;
+	addEdgeCases( &texels );
+	addSphere( &texels, 20000 );
+
+	double maxDegrees = 0.0, maxDepth = 0.0;
+	for ( size_t i = 0; i < texels.size(); i += 4 ) {
+		float out[4];
+		unpackTexel( packTexel( &texels[i], CLIP ), CLIP, out );
+		maxDegrees	= std::max( maxDegrees, angleDegrees( &texels[i], out ) );
+		maxDepth	= std::max( maxDepth, std::fabs( (double)texels[i + 3] - out[3] ) * DEPTH_UNIT );
+		CHECK_NEAR( out[0] * out[0] + out[1] * out[1] + out[2] * out[2], 1.0, 1e-5 );
+	}
+	CHECK( maxDegrees < MAX_NORMAL_DEGREES );
+	CHECK( maxDepth < MAX_DEPTH_ERROR );
+	std::printf( "reference: max normal error %.3f degrees, max depth error %.6f\n", maxDegrees, maxDepth );
+}
+
+static void testEdgeCases()
+{
+	float out[4];
+
+	//+Z is the center of the square, 255 levels have no exact middle so it comes back half a step off in x and y
+	const float up[4] = { 0.0f, 0.0f, 1.0f, 1.0f }, down[4] = { 0.0f, 0.0f, -1.0f, 1.0f };
+	unpackTexel( packTexel( up, CLIP ), CLIP, out );
+	CHECK( angleDegrees( up, out ) < 0.35 && out[2] > 0.0f );
+	//-Z comes back exactly
+	unpackTexel( packTexel( down, CLIP ), CLIP, out );
+	CHECK( angleDegrees( down, out ) < 1e-3 );
+	//-Z is a corner of the square, all four corners decode to it
+	const uint32_t corners[] = { 0x0000, 0x00FF, 0xFF00, 0xFFFF };
+	for ( int i = 0; i < 4; ++i ) {
+		unpackTexel( corners[i], CLIP, out );
+		CHECK( angleDegrees( down, out ) < 1e-3 );
+	}
+
+	//both sides of the fold decode to the same side they came from
+	const float above[4] = { 0.6f, 0.8f, 0.05f, 1.0f }, below[4] = { 0.6f, 0.8f, -0.05f, 1.0f };
+	unpackTexel( packTexel( above, CLIP ), CLIP, out );
+	CHECK( out[2] >= 0.0f );
+	unpackTexel( packTexel( below, CLIP ), CLIP, out );
+	CHECK( out[2] <= 0.0f );
+
+	//the clip planes are the ends of the 16 bit range and round trip exactly
+	float n[4] = { 0.0f, 0.0f, 1.0f, CLIP.nearClip / DEPTH_UNIT };
+	CHECK( ( packTexel( n, CLIP ) >> 16 ) == 0x0000 );
+	unpackTexel( packTexel( n, CLIP ), CLIP, out );
+	CHECK_NEAR( out[3], CLIP.nearClip / DEPTH_UNIT, 1e-6 );
+	n[3] = CLIP.farClip / DEPTH_UNIT;
+	CHECK( ( packTexel( n, CLIP ) >> 16 ) == 0xFFFF );
+	unpackTexel( packTexel( n, CLIP ), CLIP, out );
+	CHECK_NEAR( out[3], CLIP.farClip / DEPTH_UNIT, 1e-6 );
+
+	//depth 0 ( in front of the near plane, or a cleared texel ) clamps to the near plane, past the far plane to the far plane
+	n[3] = 0.0f;
+	CHECK( ( packTexel( n, CLIP ) >> 16 ) == 0x0000 );
+	n[3] = 2.0f * CLIP.farClip / DEPTH_UNIT;
+	CHECK( ( packTexel( n, CLIP ) >> 16 ) == 0xFFFF );
+}
+
+/*
+ * the image versions on the current simd path: widths that leave a scalar tail, both against the reference
+ * ( measurePacking() compares every texel both ways ) and against the bounds
+ */
+static void testImages()
+{
+	std::vector<float> texels;
+	addEdgeCases( &texels );
+	addSphere( &texels, 50000 );
+
+	const int widths[] = { 1, 7, 64, 333 };
+	for ( int w = 0; w < 4; ++w ) {
+		FloatImage image = toImage( texels, widths[w] );
+		PackingReport report = measurePacking( image, CLIP );
+		CHECK( report.simdMismatches == 0 );
+		CHECK( report.texels == image.getWidth() * image.getHeight() );
+		CHECK( report.maxNormalDegrees < MAX_NORMAL_DEGREES );
+		CHECK( report.meanNormalDegrees < MEAN_NORMAL_DEGREES );
+		CHECK( report.maxDepthError < MAX_DEPTH_ERROR );
+		CHECK( report.packedBytes * 2 == report.unpackedBytes );
+		if ( w == 3 )
+			std::printf( "%s: max normal error %.3f degrees ( mean %.3f ), max depth error %.6f, %d mismatches\n", simd::getPathName(),
+						 report.maxNormalDegrees, report.meanNormalDegrees, report.maxDepthError, report.simdMismatches );
+	}
+
+	//the clamped depths go through the simd path too
+	float clamped[8] = { 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 2.0f * CLIP.farClip / DEPTH_UNIT };
+	std::vector<float> edges;
+	for ( int i = 0; i < 16; ++i )
+		edges.insert( edges.end(), clamped + ( i & 1 ) * 4, clamped + ( i & 1 ) * 4 + 4 );
+	FloatImage image = toImage( edges, 16 );
+	std::vector<uint32_t> packed;
+	packNormalDepth( image, CLIP, &packed );
+	for ( int i = 0; i < 16; ++i ) {
+		CHECK( packed[i] == packTexel( image.getData() + i * 4, CLIP ) );
+		CHECK( ( packed[i] >> 16 ) == ( i & 1 ? 0xFFFFu : 0x0000u ) );
+	}
+}
+
+int main()
+{
+	testReference();
+	testEdgeCases();
+	testImages();
+	return testResult( ( std::string( "GBufferPackingTest ( " ) + simd::getPathName() + " )" ).c_str() );
+}
@@ -0,0 +1,198 @@
+/*
+ * MeshOptimizer.h: the FIFO cache model on hand worked index buffers, ACMR after optimizeMesh() on the scene's meshes
+ * and a shuffled torus, and that reordering / renumbering leaves the same triangles ( winding included ). From the
+ * repository root:
+ *
+ *	g++ -O2 -Iinclude -I$CINDER/include -I$CINDER/boost tests/MeshOptimizerTest.cpp src/MeshOptimizer.cpp src/SceneGeometry.cpp src/MeshCache.cpp src/ShaderCache.cpp <Cinder lib> -o MeshOptimizerTest && ./MeshOptimizerTest
+ */
+#include "MeshOptimizer.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ci;
+using namespace ssao;
+
+//a triangle as its three corners, rotated so the smallest comes first ( same triangle, same winding, same key )
+struct Triangle
+{
+	float v[9];
+
+	bool operator<( const Triangle &rhs ) const		{ return std::lexicographical_compare( v, v + 9, rhs.v, rhs.v + 9 ); }
+	bool operator==( const Triangle &rhs ) const	{ return std::equal( v, v + 9, rhs.v ); }
+};
+
+static bool lessCorner( const Vec3f &a, const Vec3f &b )
+{
+	return a.x != b.x ? a.x < b.x : ( a.y != b.y ? a.y < b.y : a.z < b.z );
+}
+
+//by position so the set survives optimizeVertexFetch() renumbering the vertices
+static std::vector<Triangle> getTriangles( const MeshData &mesh )
+{
+	std::vector<Triangle> triangles( mesh.getNumTriangles() );
+	for ( size_t t = 0; t < triangles.size(); ++t ) {
+		Vec3f corners[3];
+		for ( int c = 0; c < 3; ++c )
+			corners[c] = mesh.positions[mesh.indices[t * 3 + c]];
+		int first = 0;
+		for ( int c = 1; c < 3; ++c )
+			if ( lessCorner( corners[c], corners[first] ) )
+				first = c;
+		for ( int c = 0; c < 3; ++c ) {
+			const Vec3f &p = corners[( first + c ) % 3];
+			triangles[t].v[c * 3]		= p.x;
+			triangles[t].v[c * 3 + 1]	= p.y;
+			triangles[t].v[c * 3 + 2]	= p.z;
+		}
+	}
+	std::sort( triangles.begin(), triangles.end() );
+	return triangles;
+}
+
+//same shuffle every run
+static void shuffleTriangles( std::vector<uint32_t> *indices )
+{
+	uint32_t state = 12345;
+	for ( size_t t = indices->size() / 3; t > 1; --t ) {
+		state = state * 1664525u + 1013904223u;
+		size_t other = ( state >> 8 ) % t;
+		for ( int c = 0; c < 3; ++c )
+			std::swap( ( *indices )[( t - 1 ) * 3 + c], ( *indices )[other * 3 + c] );
+	}
+}
+
+static void testMeasure()
+{
+	//three triangles, cache of 3: 0 1 2 miss, 2 1 hit, 3 miss and pushes 0 out, 0 4 5 miss
+	const uint32_t strip[] = { 0, 1, 2, 2, 1, 3, 0, 4, 5 };
+	MeshStats stats = measureMesh( std::vector<uint32_t>( strip, strip + 9 ), 6, 3 );
+	CHECK( stats.triangles == 3 && stats.vertices == 6 );
+	CHECK_NEAR( stats.acmr, 7.0 / 3.0, 1e-6 );
+	CHECK_NEAR( stats.atvr, 7.0 / 6.0, 1e-6 );
+	//a larger cache keeps 0
+	CHECK_NEAR( measureMesh( std::vector<uint32_t>( strip, strip + 9 ), 6, 4 ).acmr, 2.0, 1e-6 );
+
+	//FIFO: a hit doesn't move a vertex to the front, 0 is loaded first and goes first even though every triangle uses it
+	const uint32_t fan[] = { 0, 1, 2, 0, 3, 4, 0, 5, 6 };
+	CHECK_NEAR( measureMesh( std::vector<uint32_t>( fan, fan + 9 ), 7, 3 ).acmr, 8.0 / 3.0, 1e-6 );
+
+	MeshStats empty = measureMesh( std::vector<uint32_t>(), 0 );
+	CHECK( empty.triangles == 0 && empty.acmr == 0.0f && empty.atvr == 0.0f );
+}
+
+/*
+ * a 32 entry cache: the torus goes from ~1.02 to ~0.68, the sphere from ~1.03 to ~0.67, the torus with its triangles
+ * shuffled from ~2.96 to ~0.67. The thresholds leave a few percent for compilers rounding the scores differently
+ */
+static void testACMR()
+{
+	MeshData torus;
+	buildTorus( &torus, 1.0f, 0.3f, 32, 64 );
+	float torusBefore = measureMesh( torus ).acmr;
+	CHECK( torusBefore > 0.95f );
+	std::vector<Triangle> triangles = getTriangles( torus );
+	optimizeMesh( &torus );
+	float torusAfter = measureMesh( torus ).acmr;
+	CHECK( torusAfter < 0.70f );
+	CHECK( getTriangles( torus ) == triangles );
+
+	MeshData sphere;
+	buildSphere( &sphere, Vec3f::zero(), 0.8f, 30 );
+	float sphereBefore = measureMesh( sphere ).acmr;
+	triangles = getTriangles( sphere );
+	optimizeMesh( &sphere );
+	float sphereAfter = measureMesh( sphere ).acmr;
+	CHECK( sphereAfter < 0.70f && sphereAfter < sphereBefore );
+	CHECK( getTriangles( sphere ) == triangles );
+
+	MeshData shuffled;
+	buildTorus( &shuffled, 1.0f, 0.3f, 32, 64 );
+	shuffleTriangles( &shuffled.indices );
+	float shuffledBefore = measureMesh( shuffled ).acmr;
+	CHECK( shuffledBefore > 2.5f );
+	triangles = getTriangles( shuffled );
+	optimizeMesh( &shuffled );
+	float shuffledAfter = measureMesh( shuffled ).acmr;
+	CHECK( shuffledAfter < 0.72f );
+	CHECK( getTriangles( shuffled ) == triangles );
+
+	//the cube has no shared vertices between faces, nothing to gain but nothing may get worse
+	MeshData cube;
+	buildCube( &cube, Vec3f::zero(), Vec3f( 1.0f, 1.0f, 1.0f ) );
+	float cubeBefore = measureMesh( cube ).acmr;
+	triangles = getTriangles( cube );
+	optimizeMesh( &cube );
+	CHECK( measureMesh( cube ).acmr <= cubeBefore );
+	CHECK( getTriangles( cube ) == triangles );
+
+	std::printf( "ACMR torus %.3f -> %.3f, sphere %.3f -> %.3f, shuffled torus %.3f -> %.3f\n",
+				 torusBefore, torusAfter, sphereBefore, sphereAfter, shuffledBefore, shuffledAfter );
+}
+
+//the index set itself, not just the positions: optimizeVertexCache() only moves whole triangles
+static void testIndexSet()
+{
+	MeshData torus;
+	buildTorus( &torus, 1.0f, 0.3f, 16, 24 );
+	shuffleTriangles( &torus.indices );
+	std::vector<uint32_t> indices = torus.indices;
+	optimizeVertexCache( &indices, torus.positions.size() );
+	CHECK( indices.size() == torus.indices.size() );
+
+	std::vector<std::vector<uint32_t> > before, after;
+	for ( size_t t = 0; t < indices.size(); t += 3 ) {
+		//no rotation either, the triangle is emitted as it was
+		before.push_back( std::vector<uint32_t>( torus.indices.begin() + t, torus.indices.begin() + t + 3 ) );
+		after.push_back( std::vector<uint32_t>( indices.begin() + t, indices.begin() + t + 3 ) );
+	}
+	std::sort( before.begin(), before.end() );
+	std::sort( after.begin(), after.end() );
+	CHECK( before == after );
+
+	//fewer than a triangle's worth of indices is left alone
+	std::vector<uint32_t> none;
+	optimizeVertexCache( &none, 0 );
+	CHECK( none.empty() );
+}
+
+//vertices end up in the order the indices first use them, the ones no index uses are dropped
+static void testVertexFetch()
+{
+	MeshData mesh;
+	buildTorus( &mesh, 1.0f, 0.3f, 16, 24 );
+	shuffleTriangles( &mesh.indices );
+	//an extra vertex nothing references
+	mesh.positions.push_back( Vec3f( 9.0f, 9.0f, 9.0f ) );
+	mesh.normals.push_back( Vec3f( 0.0f, 1.0f, 0.0f ) );
+	size_t used = mesh.positions.size() - 1;
+	std::vector<Triangle> triangles = getTriangles( mesh );
+
+	optimizeVertexFetch( &mesh );
+	CHECK( mesh.positions.size() == used && mesh.normals.size() == used );
+	CHECK( getTriangles( mesh ) == triangles );
+
+	uint32_t next = 0;
+	bool ordered = true;
+	for ( size_t i = 0; i < mesh.indices.size(); ++i ) {
+		if ( mesh.indices[i] > next )
+			ordered = false;
+		else if ( mesh.indices[i] == next )
+			++next;
+	}
+	CHECK( ordered && next == used );
+	//fetch order doesn't change the cache order
+	MeshData again = mesh;
+	optimizeVertexFetch( &again );
+	CHECK( again.indices == mesh.indices );
+}
+
+int main()
+{
+	testMeasure();
+	testACMR();
+	testIndexSet();
+	testVertexFetch();
+	return testResult( "MeshOptimizerTest" );
+}
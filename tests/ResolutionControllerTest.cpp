@@ -0,0 +1,238 @@
+/*
+ * ResolutionController.h fed with frame time sequences instead of a clock: the ladder, settling and the measuring
+ * window, stepping down straight to the rung that fits, stepping up below the headroom, the cooldown doubling when a
+ * step up is taken back, and a closed loop against a simulated GPU. From the repository root:
+ *
+ *	g++ -O2 -Iinclude -I$CINDER/include -I$CINDER/boost tests/ResolutionControllerTest.cpp src/ResolutionController.cpp src/FrameProfiler.cpp src/ShaderVariants.cpp src/SampleKernel.cpp -o ResolutionControllerTest && ./ResolutionControllerTest
+ */
+#include "ResolutionController.h"
+#include "UnitTest.h"
+
+using namespace ssao;
+
+/*
+ * the default ladder, cost = scale^2 * samples:
+ *	 0 0.25 x4 0.25		 1 0.375 x4 0.56	 2 0.375 x8 1.13	 3 0.5 x8 2.0		 4 0.5 x10 2.5		 5 0.625 x10 3.91
+ *	 6 0.75 x10 5.63	 7 0.75 x16 9.0		 8 0.875 x16 12.25	 9 0.875 x32 24.5	10 1.0 x32 32.0
+ */
+static ResolutionParams getParams()
+{
+	ResolutionParams params;
+	params.budgetMs				= 10.0f;
+	params.headroom				= 0.75f;	//step up below 7.5 ms
+	params.percentile			= 90.0f;
+	params.windowFrames			= 10;
+	params.settleFrames			= 3;
+	params.cooldownFrames		= 20;
+	params.maxCooldownFrames	= 80;
+	return params;
+}
+
+//frames of ms until update() reports a change, -1 if none within maxFrames
+static int feedUntilChange( ResolutionController *controller, float ms, int maxFrames = 1000 )
+{
+	for ( int frame = 1; frame <= maxFrames; ++frame )
+		if ( controller->update( ms ) )
+			return frame;
+	return -1;
+}
+
+//changes over a sequence
+static int feed( ResolutionController *controller, const float *ms, int count )
+{
+	int changes = 0;
+	for ( int i = 0; i < count; ++i )
+		changes += controller->update( ms[i] ) ? 1 : 0;
+	return changes;
+}
+
+static void testLadder()
+{
+	ResolutionController controller( getParams() );
+	CHECK( controller.getNumRungs() == 11 );
+	//starts at the top
+	CHECK( controller.getRung() == 10 && controller.getScale() == 1.0f && controller.getTier() == QUALITY_ULTRA );
+	CHECK( controller.getRungScale( 0 ) == 0.25f && controller.getRungTier( 0 ) == QUALITY_LOW );
+
+	//every rung costs more than the one below and moves exactly one of scale / tier one notch
+	bool climbs = true;
+	for ( int r = 1; r < controller.getNumRungs(); ++r ) {
+		float scale = controller.getRungScale( r ), lastScale = controller.getRungScale( r - 1 );
+		int tier = controller.getRungTier( r ), lastTier = controller.getRungTier( r - 1 );
+		bool scaleStep	= std::fabs( scale - lastScale - 0.125f ) < 1e-5f && tier == lastTier;
+		bool tierStep	= scale == lastScale && tier == lastTier + 1;
+		climbs = climbs && ( scaleStep != tierStep )
+			&& ResolutionController::getCost( scale, (QualityTier)tier ) > ResolutionController::getCost( lastScale, (QualityTier)lastTier );
+	}
+	CHECK( climbs );
+	CHECK_NEAR( ResolutionController::getCost( 0.5f, QUALITY_ORIGINAL ), 2.5, 1e-6 );
+
+	//reset() lands on the dearest rung that costs no more than asked for
+	controller.reset( 0.5f, QUALITY_HIGH );		//4.0: rung 5 ( 3.91 ), rung 6 is 5.63
+	CHECK( controller.getRung() == 5 );
+	controller.reset( 0.5f, QUALITY_MEDIUM );	//2.0 exactly
+	CHECK( controller.getRung() == 3 );
+	controller.reset( 0.1f, QUALITY_LOW );
+	CHECK( controller.getRung() == 0 );
+
+	//a narrower range keeps the rung nearest the current one
+	controller.reset( 0.75f, QUALITY_HIGH );
+	ResolutionParams narrow = getParams();
+	narrow.maxScale	= 0.75f;
+	narrow.maxTier	= QUALITY_HIGH;
+	controller.setParams( narrow );
+	CHECK( controller.getRung() == controller.getNumRungs() - 1 && controller.getScale() == 0.75f && controller.getTier() == QUALITY_HIGH );
+}
+
+//nothing is decided before a full window, the frames right after a change don't count, the percentile ignores a lone spike
+static void testWindow()
+{
+	ResolutionController controller( getParams() );
+
+	//nine frames over budget are not a window yet
+	const float slow[] = { 20, 20, 20, 20, 20, 20, 20, 20, 20 };
+	CHECK( feed( &controller, slow, 9 ) == 0 );
+	CHECK( controller.getMeasuredMs() == 0.0f );
+	CHECK( controller.update( 20.0f ) );
+	CHECK( controller.getMeasuredMs() == 20.0f && controller.getNumChanges() == 1 );
+	int rung = controller.getRung();
+
+	//settling: three frames, however bad, are ignored, then a fresh window of ten
+	const float settling[] = { 500, 500, 500, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9 };
+	CHECK( feed( &controller, settling, 13 ) == 0 );
+	CHECK( controller.getMeasuredMs() == 9.0f && controller.getRung() == rung );
+
+	//p90 of ten frames is the second slowest: one hitch is tolerated, two are not
+	ResolutionController spiky( getParams() );
+	const float oneSpike[] = { 9, 9, 9, 9, 30, 9, 9, 9, 9, 9 };
+	CHECK( feed( &spiky, oneSpike, 10 ) == 0 );
+	CHECK( spiky.getMeasuredMs() == 9.0f );
+	//the window slides: once the spike is joined by another in the last ten frames it steps down
+	const float twoSpikes[] = { 9, 9, 30 };
+	CHECK( feed( &spiky, twoSpikes, 3 ) == 1 );
+	CHECK( spiky.getMeasuredMs() == 30.0f );
+
+	//under budget but above the headroom: holds, whatever the cooldown
+	ResolutionController steady( getParams() );
+	steady.reset( 0.5f, QUALITY_ORIGINAL );
+	CHECK( feedUntilChange( &steady, 8.0f, 500 ) == -1 );
+	CHECK( steady.getRung() == 4 && steady.getNumChanges() == 0 );
+}
+
+//over budget goes straight to the rung the cost model says fits, at least one down, never below the bottom
+static void testStepDown()
+{
+	ResolutionController controller( getParams() );
+	//4x the budget at cost 32: fit = 8, the first rung at or under it is 6 ( 5.63 )
+	CHECK( feedUntilChange( &controller, 40.0f ) == 10 );
+	CHECK( controller.getRung() == 6 && controller.getScale() == 0.75f && controller.getTier() == QUALITY_ORIGINAL );
+
+	//a hair over still moves one rung
+	ResolutionController mild( getParams() );
+	CHECK( feedUntilChange( &mild, 10.5f ) == 10 );
+	CHECK( mild.getRung() == 9 );
+
+	//hopeless: down to the bottom, and it stays there
+	CHECK( feedUntilChange( &controller, 1000.0f ) == 13 );
+	CHECK( controller.getRung() == 0 );
+	CHECK( feedUntilChange( &controller, 1000.0f, 200 ) == -1 );
+	CHECK( controller.getRung() == 0 );
+}
+
+//below budget * headroom climbs one rung at a time, each after settling and a full window
+static void testStepUp()
+{
+	ResolutionController controller( getParams() );
+	controller.reset( 0.25f, QUALITY_LOW );
+	CHECK( controller.getCooldown() == 0 );
+	CHECK( feedUntilChange( &controller, 5.0f ) == 10 );
+	CHECK( controller.getRung() == 1 );
+	CHECK( feedUntilChange( &controller, 5.0f ) == 13 );
+	CHECK( controller.getRung() == 2 );
+	//just at the headroom is not below it
+	CHECK( feedUntilChange( &controller, 7.5f, 200 ) == -1 );
+	//the window is full of 7.5 ms frames: nine fast ones are enough to bring the p90 down, no settling this time
+	CHECK( feedUntilChange( &controller, 1.0f ) == 9 );
+	//all the way up, then nothing
+	while ( controller.getRung() + 1 < controller.getNumRungs() )
+		CHECK( feedUntilChange( &controller, 1.0f ) == 13 );
+	CHECK( feedUntilChange( &controller, 1.0f, 200 ) == -1 );
+}
+
+/*
+ * a step down holds the ladder for cooldownFrames. A step up taken back before it held that long doubles the
+ * cooldown ( up to maxCooldownFrames ), one that held resets it
+ */
+static void testCooldown()
+{
+	ResolutionController controller( getParams() );
+	CHECK( feedUntilChange( &controller, 40.0f ) == 10 );
+	CHECK( controller.getRung() == 6 && controller.getCooldown() == 20 );
+
+	//cheap frames, but no step up until the cooldown ran out ( it counts the settling frames too )
+	CHECK( feedUntilChange( &controller, 5.0f ) == 20 );
+	CHECK( controller.getRung() == 7 );
+
+	//rung 7 is over budget, taken back after 13 frames: cooldown 40, then 80, then still 80
+	const int expected[] = { 40, 80, 80 };
+	for ( int i = 0; i < 3; ++i ) {
+		CHECK( feedUntilChange( &controller, 12.0f ) == 13 );
+		CHECK( controller.getRung() == 6 && controller.getCooldown() == expected[i] );
+		CHECK( feedUntilChange( &controller, 5.0f ) == expected[i] );
+		CHECK( controller.getRung() == 7 );
+	}
+
+	//this time rung 7 holds past the 80 frames of probation, the next step down starts from the short cooldown again
+	//( the window is full by then, two slow frames make the p90 )
+	CHECK( feedUntilChange( &controller, 8.0f, 100 ) == -1 );
+	CHECK( feedUntilChange( &controller, 12.0f ) == 2 );
+	CHECK( controller.getCooldown() == 20 );
+}
+
+/*
+ * closed loop: a GPU whose frame is 3 ms + 0.3 ms per unit of cost, with some jitter. Rung 8 ( 12.25, ~6.7 ms ) is the
+ * dearest under the 10 ms budget, rung 9 ( 24.5, ~10.4 ms ) isn't. With the default params the controller finds
+ * rung 8 and only probes rung 9 ever less often
+ */
+static void testClosedLoop()
+{
+	ResolutionController controller;
+	controller.setBudget( 10.0f );
+	uint32_t noise = 1;
+	int changes = 0, lateChanges = 0, atRung8 = 0, overBudget = 0;
+	const int FRAMES = 6000;
+	for ( int frame = 0; frame < FRAMES; ++frame ) {
+		noise = noise * 1664525u + 1013904223u;
+		float jitter	= ( (float)( noise >> 8 ) / ( 1 << 24 ) - 0.5f ) * 0.6f;
+		float ms		= 3.0f + 0.3f * ResolutionController::getCost( controller.getScale(), controller.getTier() ) + jitter;
+		if ( ms > 10.0f )
+			++overBudget;
+		if ( controller.update( ms ) ) {
+			++changes;
+			if ( frame >= FRAMES / 2 )
+				++lateChanges;
+		}
+		if ( frame >= 200 && controller.getRung() == 8 )
+			++atRung8;
+	}
+	std::printf( "closed loop: %d changes ( %d in the second half ), %.1f%% of frames at rung 8, %.1f%% over budget\n",
+				 changes, lateChanges, 100.0 * atRung8 / ( FRAMES - 200 ), 100.0 * overBudget / FRAMES );
+	CHECK( controller.getRung() == 8 || controller.getRung() == 9 );
+	CHECK( atRung8 > ( FRAMES - 200 ) * 95 / 100 );
+	//the first window at rung 10 and 9, then the 13 frames of every probe of rung 9
+	CHECK( overBudget < FRAMES * 6 / 100 );
+	//probes at most every maxCooldownFrames ( 960 ) once backed off: up and down again is two changes
+	CHECK( lateChanges <= 2 * ( FRAMES / 2 / 960 + 1 ) );
+	CHECK( controller.getCooldown() <= controller.getParams().maxCooldownFrames );
+}
+
+int main()
+{
+	testLadder();
+	testWindow();
+	testStepDown();
+	testStepUp();
+	testCooldown();
+	testClosedLoop();
+	return testResult( "ResolutionControllerTest" );
+}
@@ -0,0 +1,199 @@
+/*
+ * ShaderCache.h without a driver: preprocessing, hashing / keys, lookup, rejection of bad entries, invalidation and
+ * least recently used trimming across sessions. Works in a fresh directory under /tmp. From the repository root:
+ *
+ *	g++ -O2 -Iinclude tests/ShaderCacheTest.cpp src/ShaderCache.cpp -o ShaderCacheTest && ./ShaderCacheTest
+ */
+#include "ShaderCache.h"
+#include "UnitTest.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace ssao;
+
+static std::vector<uint8_t> makeBlob( size_t size, uint8_t seed )
+{
+	std::vector<uint8_t> blob( size );
+	for ( size_t i = 0; i < size; ++i )
+		blob[i] = (uint8_t)( seed + i * 7 );
+	return blob;
+}
+
+static void testPreprocess()
+{
+	std::string source = "#version 120\r\n// a comment\r\nuniform float a;   \r\n\r\n/* block\n   comment */void main() { gl_FragColor = vec4( a ); } // tail\n\t\n";
+	std::string expected = "#version 120\nuniform float a;\n void main() { gl_FragColor = vec4( a ); }\n";
+	CHECK( preprocessShader( source ) == expected );
+	//formatting and comments don't matter, code does
+	CHECK( preprocessShader( "float x;\n\n// note\nfloat y;" ) == preprocessShader( "float x;   \r\nfloat y; // other note\n" ) );
+	CHECK( preprocessShader( "float x;" ) != preprocessShader( "float y;" ) );
+	CHECK( preprocessShader( "" ).empty() );
+	//an unterminated block comment swallows the rest
+	CHECK( preprocessShader( "a;\n/* open" ) == "a;\n" );
+}
+
+static void testHash()
+{
+	//published FNV-1a 64 test vectors
+	CHECK( hashFnv1a( "" ) == FNV_OFFSET_BASIS );
+	CHECK( keyToHex( hashFnv1a( "a" ) ) == "af63dc4c8601ec8c" );
+	CHECK( keyToHex( hashFnv1a( "foobar" ) ) == "85944171f73967e8" );
+	//chaining through the seed equals hashing the concatenation
+	//( a const char* with a seed would pick the ( data, size ) overload, hence the std::strings )
+	CHECK( hashFnv1a( std::string( "bar" ), hashFnv1a( std::string( "foo" ) ) ) == hashFnv1a( std::string( "foobar" ) ) );
+	CHECK( keyToHex( 1 ) == "0000000000000001" );
+
+	const std::string vs = "void main() { gl_Position = ftransform(); }\n";
+	const std::string fs = "void main() { gl_FragColor = vec4( 1.0 ); }\n";
+	uint64_t key = makeShaderKey( vs, fs, "vendor|renderer|2.1" );
+	CHECK( key == makeShaderKey( vs + "// edited comment\n", fs, "vendor|renderer|2.1" ) );
+	CHECK( key != makeShaderKey( vs, "#define SAMPLES 8\n" + fs, "vendor|renderer|2.1" ) );
+	CHECK( key != makeShaderKey( vs, fs, "vendor|renderer|2.1.1" ) );
+	CHECK( key != makeShaderKey( fs, vs, "vendor|renderer|2.1" ) );
+	//the stage separators keep moved text apart
+	CHECK( makeShaderKey( "ab", "c", "" ) != makeShaderKey( "a", "bc", "" ) );
+}
+
+static void testDisabled()
+{
+	ShaderCache cache( "" );
+	CHECK( !cache.isEnabled() );
+	CHECK( !cache.store( 1, 2, makeBlob( 16, 0 ) ) );
+	uint32_t format;
+	std::vector<uint8_t> blob;
+	CHECK( !cache.load( 1, &format, &blob ) );
+	CHECK( cache.getNumMisses() == 1 );
+}
+
+static void testLookup( const std::string &dir )
+{
+	std::vector<uint8_t> a = makeBlob( 1000, 1 ), b = makeBlob( 10, 2 );
+	uint32_t format = 0;
+	std::vector<uint8_t> blob;
+	{
+		ShaderCache cache( dir );
+		CHECK( cache.isEnabled() );
+		CHECK( cache.getKeys().empty() );
+		CHECK( !cache.load( 11, &format, &blob ) );
+		CHECK( cache.store( 11, 0x8e7b, a ) );
+		CHECK( cache.store( 22, 0x1234, b ) );
+		CHECK( cache.load( 11, &format, &blob ) && format == 0x8e7b && blob == a );
+		CHECK( cache.getNumHits() == 1 && cache.getNumMisses() == 1 );
+		//storing again replaces, no duplicate key
+		CHECK( cache.store( 22, 0x1234, a ) );
+		CHECK( cache.getKeys().size() == 2 );
+	}
+
+	//a new instance finds what the last one wrote
+	ShaderCache cache( dir );
+	CHECK( cache.getKeys().size() == 2 );
+	CHECK( cache.load( 22, &format, &blob ) && format == 0x1234 && blob == a );
+
+	//a corrupt payload is rejected and removed
+	{
+		std::fstream file( ( dir + keyToHex( 11 ) + ".bin" ).c_str(), std::ios::in | std::ios::out | std::ios::binary );
+		file.seekp( -1, std::ios::end );
+		file.put( 'x' );
+	}
+	CHECK( !cache.load( 11, &format, &blob ) );
+	CHECK( cache.getNumRejected() == 1 );
+	CHECK( !cache.contains( 11 ) );
+	CHECK( !std::ifstream( ( dir + keyToHex( 11 ) + ".bin" ).c_str() ) );
+
+	//so is a truncated one
+	CHECK( cache.store( 33, 7, a ) );
+	{
+		std::ofstream file( ( dir + keyToHex( 33 ) + ".bin" ).c_str(), std::ios::binary | std::ios::trunc );
+		file << "short";
+	}
+	CHECK( !cache.load( 33, &format, &blob ) );
+	CHECK( cache.getNumRejected() == 2 && !cache.contains( 33 ) );
+
+	cache.invalidate( 22 );
+	CHECK( !cache.contains( 22 ) );
+	CHECK( !cache.load( 22, &format, &blob ) );
+	CHECK( cache.store( 44, 1, b ) && cache.store( 55, 1, b ) );
+	cache.clear();
+	CHECK( cache.getKeys().empty() && cache.getBytes() == 0 );
+	CHECK( ShaderCache( dir ).getKeys().empty() );
+}
+
+//entries another session used stay until the budget forces them out, oldest first. This session's always stay
+static void testTrim( const std::string &dir )
+{
+	std::vector<uint8_t> blob = makeBlob( 1000, 3 );
+	uint32_t format;
+	std::vector<uint8_t> loaded;
+	uint32_t first;
+	{
+		ShaderCache cache( dir );
+		first = cache.getSession();
+		CHECK( cache.store( 1, 0, blob ) && cache.store( 2, 0, blob ) && cache.store( 3, 0, blob ) );
+		CHECK( cache.getLastUsed( 1 ) == first );
+		//nothing of this session goes, whatever the budget
+		cache.trim( 1 );
+		CHECK( cache.getKeys().size() == 3 );
+	}
+	size_t oneEntry;
+	{
+		//a later session only uses 1 and 3 ( e.g. the startup variants ): 2 isn't evicted just for that
+		ShaderCache cache( dir );
+		CHECK( cache.getSession() == first + 1 );
+		CHECK( cache.getLastUsed( 2 ) == first );
+		CHECK( cache.load( 1, &format, &loaded ) && cache.load( 3, &format, &loaded ) );
+		oneEntry = cache.getBytes() / 3;
+		cache.trim( 100 * oneEntry );
+		CHECK( cache.getKeys().size() == 3 );
+	}
+	{
+		//loads in the last session were remembered, 2 is the least recently used
+		ShaderCache cache( dir );
+		CHECK( cache.getLastUsed( 1 ) == first + 1 && cache.getLastUsed( 2 ) == first );
+		CHECK( cache.load( 3, &format, &loaded ) );
+		cache.trim( 2 * oneEntry );
+		CHECK( cache.getKeys().size() == 2 && !cache.contains( 2 ) && cache.contains( 1 ) && cache.contains( 3 ) );
+		CHECK( !std::ifstream( ( dir + keyToHex( 2 ) + ".bin" ).c_str() ) );
+		//count limit: 1 is older than 3 ( used this session ) and goes
+		cache.trim( 0, 1 );
+		CHECK( cache.getKeys().size() == 1 && cache.contains( 3 ) );
+		cache.clear();
+	}
+
+	//an index from before sessions ( bare keys ) loads, its entries count as oldest
+	{
+		ShaderCache cache( dir );
+		CHECK( cache.store( 9, 0, blob ) );
+	}
+	{
+		std::ofstream index( ( dir + "index.txt" ).c_str(), std::ios::trunc );
+		index << keyToHex( 9 ) << "\n";
+	}
+	ShaderCache cache( dir );
+	CHECK( cache.contains( 9 ) && cache.getLastUsed( 9 ) == 0 );
+	CHECK( cache.load( 9, &format, &loaded ) && loaded == blob );
+	cache.clear();
+}
+
+int main()
+{
+	char dir[] = "/tmp/ssao_shader_cache_test_XXXXXX";
+	if ( !mkdtemp( dir ) ) {
+		std::printf( "can't create a directory under /tmp\n" );
+		return 1;
+	}
+	std::string path = std::string( dir ) + "/";
+
+	testPreprocess();
+	testHash();
+	testDisabled();
+	testLookup( path );
+	testTrim( path );
+
+	std::remove( ( path + "index.txt" ).c_str() );
+	rmdir( dir );
+	return testResult( "ShaderCacheTest" );
+}
@@ -0,0 +1,172 @@
+/*
+ * TargetPlanner.h: measureTarget() against byte counts worked out by hand, and plan() totals for the final scene graph
+ * the app builds, before and after the AO targets lost their MSAA / depth. From the repository root:
+ *
+ *	g++ -O2 -Iinclude -I$CINDER/include -I$CINDER/boost tests/TargetPlannerTest.cpp src/TargetPlanner.cpp src/FrameGraph.cpp -o TargetPlannerTest && ./TargetPlannerTest
+ */
+#include "TargetPlanner.h"
+#include "UnitTest.h"
+
+using namespace ssao;
+
+static const size_t MB = 1024 * 1024;
+
+/*
+ * bytes per pixel: texture ( bpp x attachments ) + samples x ( color + 4 byte depth ) + 4 byte single sample depth
+ *	RGBA16F, 4x, depth	8 + 4 x ( 8 + 4 ) + 4	= 60
+ *	RGBA8, 4x, depth	4 + 4 x ( 4 + 4 ) + 4	= 40
+ *	RGBA16F, no depth	8
+ */
+static void testMeasureTarget()
+{
+	CHECK( getBytesPerTexel( TextureDesc::FORMAT_RGBA8 ) == 4 );
+	CHECK( getBytesPerTexel( TextureDesc::FORMAT_RGBA16F ) == 8 );
+	CHECK( getBytesPerTexel( TextureDesc::FORMAT_RGBA32F ) == 16 );
+
+	TargetFootprint scene = measureTarget( "scene", TextureDesc( 1920, 1080, TextureDesc::FORMAT_RGBA16F, 4 ) );
+	CHECK( scene.textureBytes == 1920 * 1080 * 8 );
+	CHECK( scene.multisampleBytes == 1920 * 1080 * 4 * ( 8 + 4 ) );
+	CHECK( scene.depthBytes == 1920 * 1080 * 4 );
+	CHECK( scene.getTotalBytes() == 124416000 );
+
+	TargetFootprint ldr = measureTarget( "scene", TextureDesc( 1920, 1080, TextureDesc::FORMAT_RGBA8, 4 ) );
+	CHECK( ldr.getTotalBytes() == 1920 * 1080 * 40 );
+
+	//a full screen quad target: the texture and nothing else
+	TargetFootprint ao = measureTarget( "ao", TextureDesc( 960, 540, TextureDesc::FORMAT_RGBA16F, 0, 1, false ) );
+	CHECK( ao.multisampleBytes == 0 && ao.depthBytes == 0 );
+	CHECK( ao.getTotalBytes() == 960 * 540 * 8 );
+
+	//no MSAA but a depth buffer
+	TargetFootprint depthOnly = measureTarget( "d", TextureDesc( 100, 10, TextureDesc::FORMAT_RGBA32F ) );
+	CHECK( depthOnly.multisampleBytes == 0 && depthOnly.getTotalBytes() == 100 * 10 * ( 16 + 4 ) );
+
+	//MRT: both attachments in the texture and in the samples, one depth buffer
+	TargetFootprint gbuffer = measureTarget( "gbuffer", TextureDesc( 1920, 1080, TextureDesc::FORMAT_RGBA8, 4, 2 ) );
+	CHECK( gbuffer.getTotalBytes() == 1920 * 1080 * ( 8 + 4 * ( 8 + 4 ) + 4 ) );
+
+	//a ping-pong pair is twice one
+	TargetFootprint history = measureTarget( "history", TextureDesc( 960, 540, TextureDesc::FORMAT_RGBA16F, 0, 1, false ), 2 );
+	CHECK( history.copies == 2 && history.getTotalBytes() == 2 * ao.getTotalBytes() );
+
+	//mips: every level half the last, stopping at 1x1 however many levels were asked for
+	TargetFootprint hiZ = measureTarget( "hiZ", TextureDesc( 1920, 1080, TextureDesc::FORMAT_RGBA16F, 0, 1, false ), 1, 4 );
+	CHECK( hiZ.getTotalBytes() == ( 1920 * 1080 + 960 * 540 + 480 * 270 + 240 * 135 ) * 8 );
+	TargetFootprint tiny = measureTarget( "tiny", TextureDesc( 4, 2, TextureDesc::FORMAT_RGBA8, 0, 1, false ), 1, 10 );
+	CHECK( tiny.getTotalBytes() == ( 4 * 2 + 2 * 1 + 1 * 1 ) * 4 );
+	CHECK( measureTarget( "none", TextureDesc( 4, 2, TextureDesc::FORMAT_RGBA8, 0, 1, false ), 1, 0 ).mipLevels == 1 );
+}
+
+//the final scene graph of buildFrameGraph() with the two pass geometry path, descs passed in so older versions can be rebuilt
+static void buildFinalScene( FrameGraph *graph, const TextureDesc &scene, const TextureDesc &normalDepth, const TextureDesc &ao )
+{
+	FrameGraph::ResourceId rScene		= graph->createTexture( "mScreenSpace1", scene );
+	FrameGraph::ResourceId rNormalDepth	= graph->createTexture( "mNormalDepthMap", normalDepth );
+	FrameGraph::ResourceId rSSAO		= graph->createTexture( "mSSAOMap", ao );
+	FrameGraph::ResourceId rBlurH		= graph->createTexture( "mPingPongBlurH", ao );
+	FrameGraph::ResourceId rBlurV		= graph->createTexture( "mPingPongBlurV", ao );
+	FrameGraph::ResourceId rWindow		= graph->importTexture( "window", TextureDesc( scene.width, scene.height, TextureDesc::FORMAT_RGBA8 ) );
+	graph->markOutput( rWindow );
+
+	FrameGraph::PassId pass = graph->addPass( "scene" );
+	graph->write( pass, rScene );
+	pass = graph->addPass( "normal/depth" );
+	graph->write( pass, rNormalDepth );
+	pass = graph->addPass( "SSAO" );
+	graph->read( pass, rNormalDepth );
+	graph->write( pass, rSSAO );
+	pass = graph->addPass( "blur H" );
+	graph->read( pass, rSSAO );
+	graph->write( pass, rBlurH );
+	pass = graph->addPass( "blur V" );
+	graph->read( pass, rBlurH );
+	graph->write( pass, rBlurV );
+	pass = graph->addPass( "composite" );
+	graph->read( pass, rBlurV );
+	graph->read( pass, rScene );
+	graph->write( pass, rWindow );
+}
+
+static TargetPlan planFinalScene( int width, int height, const TextureDesc &scene, const TextureDesc &normalDepth, const TextureDesc &ao, int planWidth, int planHeight )
+{
+	FrameGraph graph;
+	buildFinalScene( &graph, scene, normalDepth, ao );
+	CHECK( graph.compile() );
+	TargetPlanner planner( width, height );
+	planner.addFrameGraph( graph );
+	return planner.plan( planWidth, planHeight );
+}
+
+/*
+ * 1080p, AO at half res, bilateral upsample on ( full res normal/depth ): scene, normal/depth and two AO targets
+ * ( mSSAOMap and mPingPongBlurV share one ). Before, the AO targets were RGBA16F with 4x MSAA and depth like the scene:
+ *	124416000 + 82944000 + 2 x 31104000	= 269568000 ( 257 MB )
+ * now they are plain RGBA16F textures:
+ *	124416000 + 82944000 + 2 x 4147200	= 215654400 ( 206 MB ), 4 x that at 4K ( 1028 -> 823 MB )
+ * and with the scene in RGBA8 as well 82944000 + 82944000 + 2 x 4147200 = 174182400
+ */
+static void testKnownGraphs()
+{
+	const TextureDesc hdr( 1920, 1080, TextureDesc::FORMAT_RGBA16F, 4 ), ldr( 1920, 1080, TextureDesc::FORMAT_RGBA8, 4 );
+	const TextureDesc oldAO( 960, 540, TextureDesc::FORMAT_RGBA16F, 4 ), ao( 960, 540, TextureDesc::FORMAT_RGBA16F, 0, 1, false );
+
+	TargetPlan before = planFinalScene( 1920, 1080, hdr, ldr, oldAO, 1920, 1080 );
+	CHECK( before.targets.size() == 4 );
+	CHECK( before.totalBytes == 269568000 );
+	CHECK( before.totalBytes / MB == 257 );
+	CHECK( before.multisampleBytes == 1920 * 1080 * 4 * ( 12 + 8 ) + 2 * 960 * 540 * 4 * 12 );
+
+	TargetPlan after = planFinalScene( 1920, 1080, hdr, ldr, ao, 1920, 1080 );
+	CHECK( after.targets.size() == 4 );
+	CHECK( after.totalBytes == 215654400 );
+	CHECK( ( after.totalBytes + MB / 2 ) / MB == 206 );
+	CHECK( before.totalBytes - after.totalBytes == 2 * ( 31104000 - 4147200 ) );
+
+	CHECK( planFinalScene( 1920, 1080, hdr, ldr, oldAO, 3840, 2160 ).totalBytes == 4 * before.totalBytes );
+	CHECK( planFinalScene( 1920, 1080, hdr, ldr, ao, 3840, 2160 ).totalBytes == 4 * after.totalBytes );
+
+	CHECK( planFinalScene( 1920, 1080, ldr, ldr, ao, 1920, 1080 ).totalBytes == 174182400 );
+
+	//today's defaults ( no bilateral upsample ): normal/depth at the AO size, still with MSAA and depth
+	TargetPlan defaults = planFinalScene( 1920, 1080, ldr, TextureDesc( 960, 540, TextureDesc::FORMAT_RGBA8, 4 ), ao, 1920, 1080 );
+	CHECK( defaults.totalBytes == 82944000 + 960 * 540 * 40 + 2 * 4147200 );
+}
+
+//targets declared at the window size come out of plan() at the size asked for, a half res target stays half res
+static void testRescale()
+{
+	const TextureDesc hdr( 1920, 1080, TextureDesc::FORMAT_RGBA16F, 4 ), ldr( 1920, 1080, TextureDesc::FORMAT_RGBA8, 4 );
+	const TextureDesc ao( 960, 540, TextureDesc::FORMAT_RGBA16F, 0, 1, false );
+	TargetPlan native = planFinalScene( 1920, 1080, hdr, ldr, ao, 1920, 1080 );
+
+	TargetPlan scaled = planFinalScene( 1280, 720, TextureDesc( 1280, 720, TextureDesc::FORMAT_RGBA16F, 4 ), TextureDesc( 1280, 720, TextureDesc::FORMAT_RGBA8, 4 ),
+										TextureDesc( 640, 360, TextureDesc::FORMAT_RGBA16F, 0, 1, false ), 1920, 1080 );
+	CHECK( scaled.width == 1920 && scaled.height == 1080 );
+	CHECK( scaled.totalBytes == native.totalBytes );
+	for ( size_t t = 0; t < scaled.targets.size(); ++t )
+		CHECK( scaled.targets[t].desc == native.targets[t].desc );
+
+	//integer division, as allocateTargets() would size it
+	TargetPlanner planner( 1280, 720 );
+	planner.addTarget( "third", TextureDesc( 426, 240, TextureDesc::FORMAT_RGBA8, 0, 1, false ) );
+	planner.addTarget( "history", TextureDesc( 426, 240, TextureDesc::FORMAT_RGBA16F, 0, 1, false ), 2 );
+	TargetPlan plan = planner.plan( 1920, 1080 );
+	CHECK( plan.targets[0].desc.width == 639 && plan.targets[0].desc.height == 360 );
+	CHECK( plan.totalBytes == 639 * 360 * 4 + 2 * 639 * 360 * 8 );
+	CHECK( planner.plan().totalBytes == 426 * 240 * 4 + 2 * 426 * 240 * 8 );
+	//nothing is smaller than 1x1
+	CHECK( planner.plan( 1, 1 ).targets[0].desc.width == 1 );
+
+	//without a reference size the descs are taken as they are
+	TargetPlanner absolute;
+	absolute.addTarget( "ao", ao );
+	CHECK( absolute.plan( 3840, 2160 ).totalBytes == 960 * 540 * 8 );
+}
+
+int main()
+{
+	testMeasureTarget();
+	testKnownGraphs();
+	testRescale();
+	return testResult( "TargetPlannerTest" );
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+
+/*
+ * All the framework the tests in this directory use: every test is one .cpp with its own main(), CHECK() prints
+ * the failing expression with its line and counts it, main() ends with return testResult( "name" ) ( exit code 1
+ * if anything failed ). Nothing here touches GL, every test runs headless. The build line is at the top of each test.
+ */
+static int sTestChecks		= 0;
+static int sTestFailures	= 0;
+
+#define CHECK( cond ) \
+	do { \
+		++sTestChecks; \
+		if ( !( cond ) ) { \
+			++sTestFailures; \
+			std::printf( "FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond ); \
+		} \
+	} while ( 0 )
+
+#define CHECK_NEAR( a, b, eps ) \
+	do { \
+		++sTestChecks; \
+		double checkA_ = ( a ), checkB_ = ( b ); \
+		if ( !( std::fabs( checkA_ - checkB_ ) <= ( eps ) ) ) { \
+			++sTestFailures; \
+			std::printf( "FAILED %s:%d: %s = %g, %s = %g ( eps %g )\n", __FILE__, __LINE__, #a, checkA_, #b, checkB_, (double)( eps ) ); \
+		} \
+	} while ( 0 )
+
+static inline int testResult( const char *name )
+{
+	std::printf( "%s: %d checks, %d failed\n", name, sTestChecks, sTestFailures );
+	return sTestFailures ? 1 : 0;
+}
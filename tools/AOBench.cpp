@@ -0,0 +1,413 @@
+/*
+ * headless benchmark and regression gate of the CPU AO chain ( SSAOEngine -> blur -> composite, PostChain.h ),
+ * run from the repository root. Needs Cinder for ci::Timer and the threads behind TaskPool:
+ *
+ *	g++ -O2 -Iinclude -I$CINDER/include -I$CINDER/boost tools/AOBench.cpp <every src .cpp but the app and the Gl ones> <Cinder and boost_thread libs> -o AOBench
+ *
+ *	./AOBench									throughput of every stage, test scene at 720p / 1080p / 4K, 1 thread and all of them
+ *	./AOBench --res 720p --threads 1,2,4		just those
+ *	./AOBench --gbuffer capture.fimg			a captured 4 channel normal/depth ( ImageFile.h ) as well, at its own size
+ *	./AOBench --csv out.csv						the table as CSV too
+ *	./AOBench --write-baseline base.csv			store the throughput to compare later runs against
+ *	./AOBench --baseline base.csv [--slack 0.15]	fail if any stage got more than slack slower than the baseline
+ *	./AOBench --update-golden					rewrite tools/golden/ from this build ( after an intended change to the output )
+ *	./AOBench --golden-only						only the image check
+ *
+ * every run first checks the output of the test scene at 640x360 ( AO at half size, default SSAOParams, like
+ * the app ) against the 16 bit PGMs in tools/golden/: ssao, blur, composite and the horizon AO. An image fails
+ * when its RMS error is over --tolerance ( 0.004 ) or more than 0.2% of its pixels are off by over 0.05, so
+ * SIMD paths and compilers rounding differently still pass. Exit code: 0 pass, 1 golden failed, 2 slower than
+ * the baseline ( 3 both ), 4 bad arguments or files. For CI: --write-baseline on the target branch, then
+ * --baseline on the change, on the same machine.
+ */
+#include "SoftRasterizer.h"
+#include "SSAOEngine.h"
+#include "PostChain.h"
+#include "ImageFile.h"
+#include "GBufferPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ssao;
+
+static const int EXIT_GOLDEN	= 1;
+static const int EXIT_SLOWER	= 2;
+static const int EXIT_USAGE		= 4;
+
+static const int	GOLDEN_WIDTH		= 640;
+static const int	GOLDEN_HEIGHT		= 360;
+static const float	GOLDEN_BAD_ERROR	= 0.05f;
+static const float	GOLDEN_BAD_SHARE	= 0.002f;
+
+static const ClipPlanes	CAMERA_CLIP( 1.0f, 50.0f );
+
+//the app's camera: CameraPersp( 45 degrees, window aspect, 1, 50 ) at ( 0, 0, -8 ) looking at the origin
+static ci::Matrix44f lookAt( const ci::Vec3f &eye, const ci::Vec3f &center, const ci::Vec3f &up )
+{
+	ci::Vec3f f = ( center - eye ).normalized();
+	ci::Vec3f s = f.cross( up ).normalized();
+	ci::Vec3f u = s.cross( f );
+
+	ci::Matrix44f m;
+	m.at( 0, 0 ) = s.x;		m.at( 0, 1 ) = s.y;		m.at( 0, 2 ) = s.z;		m.at( 0, 3 ) = -s.dot( eye );
+	m.at( 1, 0 ) = u.x;		m.at( 1, 1 ) = u.y;		m.at( 1, 2 ) = u.z;		m.at( 1, 3 ) = -u.dot( eye );
+	m.at( 2, 0 ) = -f.x;	m.at( 2, 1 ) = -f.y;	m.at( 2, 2 ) = -f.z;	m.at( 2, 3 ) = f.dot( eye );
+	return m;
+}
+
+static ci::Matrix44f perspective( float fovDegrees, float aspect, float nearClip, float farClip )
+{
+	float t = 1.0f / std::tan( fovDegrees * 3.14159265f / 360.0f );
+	ci::Matrix44f m;
+	m.at( 0, 0 ) = t / aspect;
+	m.at( 1, 1 ) = t;
+	m.at( 2, 2 ) = ( farClip + nearClip ) / ( nearClip - farClip );
+	m.at( 2, 3 ) = 2.0f * farClip * nearClip / ( nearClip - farClip );
+	m.at( 3, 2 ) = -1.0f;
+	m.at( 3, 3 ) = 0.0f;
+	return m;
+}
+
+//one G-buffer to run the chain on, with the lit color the composite darkens
+struct BenchInput
+{
+	std::string		name;
+	FloatImage		normalDepth;
+	FloatImage		base;
+	ci::Matrix44f	projection;
+};
+
+static void renderTestScene( TaskPool *pool, const TestScene &scene, int width, int height, BenchInput *input )
+{
+	input->projection = perspective( 45.0f, (float)width / height, CAMERA_CLIP.nearClip, CAMERA_CLIP.farClip );
+	input->normalDepth.allocate( width, height, 4 );
+	SoftRasterizer rasterizer( pool );
+	rasterizer.render( scene.getObjects(), lookAt( ci::Vec3f( 0.0f, 0.0f, -8.0f ), ci::Vec3f::zero(), ci::Vec3f::yAxis() ), input->projection, &input->normalDepth );
+}
+
+//stand-in for mScreenSpace1: lambert from the view space normal, the clear color where nothing was drawn ( the far plane )
+static void buildBase( BenchInput *input )
+{
+	const FloatImage &nd = input->normalDepth;
+	input->base.allocate( nd.getWidth(), nd.getHeight(), 4 );
+	for ( int y = 0; y < nd.getHeight(); ++y ) {
+		for ( int x = 0; x < nd.getWidth(); ++x ) {
+			const float *n	= nd.getPixel( x, y );
+			float *out		= input->base.getPixel( x, y );
+			float shade		= n[3] >= CAMERA_CLIP.farClip / DEPTH_UNIT ? 0.5f : 0.2f + 0.8f * std::max( 0.3f * n[0] + 0.5f * n[1] + 0.8f * n[2], 0.0f );
+			out[0] = out[1] = out[2] = std::min( shade, 1.0f );
+			out[3] = 1.0f;
+		}
+	}
+}
+
+//throughput of one stage of one run
+struct StageResult
+{
+	std::string		input;
+	int				width, height, threads;
+	std::string		stage;
+	double			ms;
+	double			mpps;		//megapixels a second of what the stage writes ( AO texels, output pixels for composite / chain )
+
+	std::string key() const
+	{
+		std::ostringstream ss;
+		ss << input << "," << width << "," << height << "," << threads << "," << stage;
+		return ss.str();
+	}
+};
+
+//fastest run: timing noise ( other processes, frequency ramps ) only ever adds time, so the minimum is what repeats between runs
+static double best( const std::vector<double> &values )
+{
+	return values.empty() ? 0.0 : *std::min_element( values.begin(), values.end() );
+}
+
+static void addResult( const BenchInput &input, int threads, const std::string &stage, double ms, int pixels, std::vector<StageResult> *results )
+{
+	StageResult r;
+	r.input		= input.name;
+	r.width		= input.normalDepth.getWidth();
+	r.height	= input.normalDepth.getHeight();
+	r.threads	= threads;
+	r.stage		= stage;
+	r.ms		= ms;
+	r.mpps		= ms > 0.0 ? pixels / ( ms * 1000.0 ) : 0.0;
+	results->push_back( r );
+}
+
+/*
+ * the unfused chain for its per pass timings ( PostChain::getTimings() ), then the fused chain, best of iterations runs each
+ */
+static void benchInput( const BenchInput &input, int threads, int iterations, std::vector<StageResult> *results )
+{
+	TaskPool pool( threads );
+	SSAOEngine engine;
+	PostChain chain( &pool, &engine );
+	const int aoW = input.normalDepth.getWidth() / 2, aoH = input.normalDepth.getHeight() / 2;
+	const int aoPixels = aoW * aoH, outPixels = input.normalDepth.getWidth() * input.normalDepth.getHeight();
+
+	FloatImage result;
+	std::vector<double> ssao, blur, composite, unfused, fused;
+	for ( int i = -1; i < iterations; ++i ) {
+		chain.runUnfused( input.normalDepth, input.base, aoW, aoH, &result );
+		ChainTimings t = chain.getTimings();
+		chain.runFused( input.normalDepth, input.base, aoW, aoH, &result );
+		//the first run only warms up caches and threads
+		if ( i < 0 )
+			continue;
+		ssao.push_back( t.ssao );
+		blur.push_back( t.blurH + t.blurV );
+		composite.push_back( t.composite );
+		unfused.push_back( t.total );
+		fused.push_back( chain.getTimings().total );
+	}
+
+	addResult( input, pool.getNumThreads(), "ssao", best( ssao ), aoPixels, results );
+	addResult( input, pool.getNumThreads(), "blur", best( blur ), aoPixels, results );
+	addResult( input, pool.getNumThreads(), "composite", best( composite ), outPixels, results );
+	addResult( input, pool.getNumThreads(), "chain", best( unfused ), outPixels, results );
+	addResult( input, pool.getNumThreads(), "fused chain", best( fused ), outPixels, results );
+}
+
+static void writeCsv( std::ostream &os, const std::vector<StageResult> &results )
+{
+	os << "input,width,height,threads,stage,ms,mpps" << std::endl;
+	for ( size_t i = 0; i < results.size(); ++i ) {
+		char numbers[64];
+		std::sprintf( numbers, "%.3f,%.2f", results[i].ms, results[i].mpps );
+		os << results[i].key() << "," << numbers << std::endl;
+	}
+}
+
+//key -> megapixels a second of a CSV written by writeCsv()
+static bool readBaseline( const std::string &path, std::map<std::string, double> *baseline )
+{
+	std::ifstream in( path.c_str() );
+	if ( !in )
+		return false;
+
+	std::string line;
+	std::getline( in, line );
+	while ( std::getline( in, line ) ) {
+		//the key is everything up to the ms column, mpps is the last one
+		size_t mppsComma = line.rfind( ',' );
+		size_t msComma = mppsComma == std::string::npos || mppsComma == 0 ? std::string::npos : line.rfind( ',', mppsComma - 1 );
+		if ( msComma == std::string::npos )
+			continue;
+		( *baseline )[line.substr( 0, msComma )] = std::atof( line.c_str() + mppsComma + 1 );
+	}
+	return true;
+}
+
+//what a PGM can hold: horizon AO goes over 1 ( see HorizonAO_frag.glsl ), the composite below 0
+static FloatImage clampToUnit( const FloatImage &image )
+{
+	FloatImage clamped( image );
+	float *data = clamped.getData();
+	for ( size_t i = 0; i < clamped.getRowStride() * clamped.getHeight(); ++i )
+		data[i] = std::min( std::max( data[i], 0.0f ), 1.0f );
+	return clamped;
+}
+
+/*
+ * the golden images: every output of the 640x360 test scene next to its PGM, or written as the new PGM
+ */
+static bool checkGolden( const std::string &directory, bool update, float tolerance )
+{
+	TaskPool pool( 0 );
+	TestScene scene;
+	BenchInput input;
+	renderTestScene( &pool, scene, GOLDEN_WIDTH, GOLDEN_HEIGHT, &input );
+	buildBase( &input );
+	const int aoW = GOLDEN_WIDTH / 2, aoH = GOLDEN_HEIGHT / 2;
+
+	SSAOEngine engine;
+	PostChain chain( &pool, &engine );
+	FloatImage composite, fused;
+	chain.runUnfused( input.normalDepth, input.base, aoW, aoH, &composite );
+	chain.runFused( input.normalDepth, input.base, aoW, aoH, &fused );
+
+	SSAOEngine horizonEngine;
+	SSAOParams params;
+	params.method			= AO_HORIZON;
+	params.projection[0]	= input.projection.at( 0, 0 );
+	params.projection[1]	= input.projection.at( 1, 1 );
+	horizonEngine.setParams( params );
+	FloatImage horizon( aoW, aoH, 1 );
+	horizonEngine.compute( input.normalDepth, &horizon );
+
+	struct Output { const char *name; const FloatImage *image; };
+	Output outputs[5] = { { "ssao", &chain.getSSAOMap() }, { "blur", &chain.getBlurV() }, { "composite", &composite },
+						  { "fused_composite", &fused }, { "horizon", &horizon } };
+	bool passed = true;
+	for ( int i = 0; i < 5; ++i ) {
+		//the fused chain has to give the unfused pixels, it is checked against the same golden
+		std::string golden = directory + ( std::strcmp( outputs[i].name, "fused_composite" ) == 0 ? "composite" : outputs[i].name ) + ".pgm";
+		if ( update ) {
+			if ( std::strcmp( outputs[i].name, "fused_composite" ) == 0 )
+				continue;
+			bool written = writePgm16( golden, *outputs[i].image );
+			std::printf( "golden %-16s %s %s\n", outputs[i].name, written ? "written to" : "FAILED writing", golden.c_str() );
+			passed = passed && written;
+			continue;
+		}
+
+		FloatImage expected;
+		if ( !readPgm16( golden, &expected ) ) {
+			std::printf( "golden %-16s FAIL ( can't read %s )\n", outputs[i].name, golden.c_str() );
+			passed = false;
+			continue;
+		}
+		ImageDiff diff = compareImages( clampToUnit( *outputs[i].image ), 0, expected, 0, GOLDEN_BAD_ERROR );
+		bool ok = !diff.sizeMismatch && diff.rms <= tolerance && diff.badFraction <= GOLDEN_BAD_SHARE;
+		if ( diff.sizeMismatch )
+			std::printf( "golden %-16s FAIL ( size differs from %s )\n", outputs[i].name, golden.c_str() );
+		else
+			std::printf( "golden %-16s %s  rms %.5f  max %.4f  off by > %.2f: %.3f%%\n", outputs[i].name, ok ? "pass" : "FAIL",
+						 diff.rms, diff.maxError, GOLDEN_BAD_ERROR, diff.badFraction * 100.0f );
+		passed = passed && ok;
+	}
+	return passed;
+}
+
+static std::vector<std::string> split( const std::string &list )
+{
+	std::vector<std::string> items;
+	std::stringstream ss( list );
+	std::string item;
+	while ( std::getline( ss, item, ',' ) )
+		if ( !item.empty() )
+			items.push_back( item );
+	return items;
+}
+
+int main( int argc, char **argv )
+{
+	std::vector<std::string> resolutions = split( "720p,1080p,4k" );
+	std::vector<int> threadCounts;
+	threadCounts.push_back( 1 );
+	if ( TaskPool::getHardwareThreads() > 1 )
+		threadCounts.push_back( TaskPool::getHardwareThreads() );
+	std::vector<std::string> captures;
+	std::string csvPath, baselinePath, writeBaselinePath, goldenDir = "tools/golden/";
+	int iterations		= 5;
+	float slack			= 0.15f;
+	float tolerance		= 0.004f;
+	bool updateGolden	= false;
+	bool goldenOnly		= false;
+
+	for ( int i = 1; i < argc; ++i ) {
+		std::string arg = argv[i];
+		bool hasValue	= i + 1 < argc;
+		if ( arg == "--res" && hasValue )						resolutions = split( argv[++i] );
+		else if ( arg == "--threads" && hasValue ) {
+			std::vector<std::string> counts = split( argv[++i] );
+			threadCounts.clear();
+			for ( size_t c = 0; c < counts.size(); ++c )
+				threadCounts.push_back( std::max( std::atoi( counts[c].c_str() ), 1 ) );
+		}
+		else if ( arg == "--iterations" && hasValue )			iterations = std::max( std::atoi( argv[++i] ), 1 );
+		else if ( arg == "--gbuffer" && hasValue )				captures.push_back( argv[++i] );
+		else if ( arg == "--csv" && hasValue )					csvPath = argv[++i];
+		else if ( arg == "--baseline" && hasValue )				baselinePath = argv[++i];
+		else if ( arg == "--write-baseline" && hasValue )		writeBaselinePath = argv[++i];
+		else if ( arg == "--slack" && hasValue )				slack = (float)std::atof( argv[++i] );
+		else if ( arg == "--tolerance" && hasValue )			tolerance = (float)std::atof( argv[++i] );
+		else if ( arg == "--golden-dir" && hasValue )			goldenDir = std::string( argv[++i] ) + "/";
+		else if ( arg == "--update-golden" )					updateGolden = true;
+		else if ( arg == "--golden-only" )						goldenOnly = true;
+		else {
+			std::fprintf( stderr, "unknown argument %s ( see the top of tools/AOBench.cpp )\n", arg.c_str() );
+			return EXIT_USAGE;
+		}
+	}
+
+	std::printf( "SSAOEngine simd path: %s, %d hardware threads\n", SSAOEngine::getSimdPathName(), TaskPool::getHardwareThreads() );
+	int status = checkGolden( goldenDir, updateGolden, tolerance ) ? 0 : EXIT_GOLDEN;
+	if ( goldenOnly || updateGolden )
+		return status;
+
+	//synthetic inputs first, then the captures at their own size. One at a time, a 4K input is a few hundred MB
+	TaskPool rasterPool( 0 );
+	TestScene scene;
+	std::vector<StageResult> results;
+	std::printf( "%-24s %-10s %7s  %-12s %9s %9s\n", "input", "size", "threads", "stage", "ms", "MP/s" );
+	for ( size_t i = 0; i < resolutions.size() + captures.size(); ++i ) {
+		BenchInput input;
+		if ( i < resolutions.size() ) {
+			int w = 0, h = 0;
+			if ( resolutions[i] == "720p" )			{ w = 1280; h = 720; }
+			else if ( resolutions[i] == "1080p" )	{ w = 1920; h = 1080; }
+			else if ( resolutions[i] == "4k" )		{ w = 3840; h = 2160; }
+			else if ( std::sscanf( resolutions[i].c_str(), "%dx%d", &w, &h ) != 2 || w < 2 || h < 2 ) {
+				std::fprintf( stderr, "unknown resolution %s ( 720p, 1080p, 4k or WxH )\n", resolutions[i].c_str() );
+				return status | EXIT_USAGE;
+			}
+			input.name = "scene";
+			renderTestScene( &rasterPool, scene, w, h, &input );
+		}
+		else {
+			input.name = captures[i - resolutions.size()];
+			if ( !readFloatImage( input.name, &input.normalDepth ) || input.normalDepth.getChannels() != 4 ) {
+				std::fprintf( stderr, "%s is not a 4 channel .fimg G-buffer\n", input.name.c_str() );
+				return status | EXIT_USAGE;
+			}
+		}
+		buildBase( &input );
+
+		for ( size_t t = 0; t < threadCounts.size(); ++t ) {
+			size_t first = results.size();
+			benchInput( input, threadCounts[t], iterations, &results );
+			for ( size_t r = first; r < results.size(); ++r ) {
+				char size[32];
+				std::sprintf( size, "%dx%d", results[r].width, results[r].height );
+				std::printf( "%-24s %-10s %7d  %-12s %9.2f %9.2f\n", results[r].input.c_str(), size, results[r].threads, results[r].stage.c_str(), results[r].ms, results[r].mpps );
+			}
+		}
+	}
+
+	if ( !csvPath.empty() ) {
+		std::ofstream csv( csvPath.c_str() );
+		writeCsv( csv, results );
+	}
+	if ( !writeBaselinePath.empty() ) {
+		std::ofstream csv( writeBaselinePath.c_str() );
+		writeCsv( csv, results );
+		std::printf( "baseline written to %s\n", writeBaselinePath.c_str() );
+	}
+
+	if ( !baselinePath.empty() ) {
+		std::map<std::string, double> baseline;
+		if ( !readBaseline( baselinePath, &baseline ) ) {
+			std::fprintf( stderr, "can't read baseline %s\n", baselinePath.c_str() );
+			return status | EXIT_USAGE;
+		}
+		int compared = 0, slower = 0;
+		for ( size_t r = 0; r < results.size(); ++r ) {
+			std::map<std::string, double>::const_iterator it = baseline.find( results[r].key() );
+			if ( it == baseline.end() || it->second <= 0.0 )
+				continue;
+			++compared;
+			double ratio = results[r].mpps / it->second;
+			if ( ratio < 1.0 - slack ) {
+				std::printf( "SLOWER %s: %.2f MP/s, baseline %.2f ( %.0f%% )\n", results[r].key().c_str(), results[r].mpps, it->second, ratio * 100.0 );
+				++slower;
+			}
+		}
+		std::printf( "baseline: %d of %d stages compared slower than %.0f%% of %s\n", slower, compared, ( 1.0f - slack ) * 100.0f, baselinePath.c_str() );
+		if ( slower )
+			status |= EXIT_SLOWER;
+	}
+	return status;
+}
@@ -0,0 +1,182 @@
+/*
+ * offline AO over G-buffer sequences ( GBufferSequence.h ) with BatchAOProcessor, no window. Needs Cinder for
+ * ci::Timer and the threads, built like tools/AOBench.cpp:
+ *
+ *	g++ -O2 -Iinclude -I$CINDER/include -I$CINDER/boost tools/BatchAO.cpp <every src .cpp but the app and the Gl ones> <Cinder and boost_thread libs> -o BatchAO
+ *
+ *	./BatchAO in.gbseq out.gbseq					AO of every frame: half size, blurred, default SSAOParams like the app
+ *		--scale 0.5 --no-blur --depth-aware			AO size relative to the input, skip the blur, depth aware blur
+ *		--method ssao|horizon --samples 10			which AO ( horizon uses the projection in the input header )
+ *		--frames 100,50 --threads 8 --queue 2		frames 100 - 149 only, pool size, frames waiting between stages
+ *	./BatchAO --pack out.gbseq [--projection 1.63,2.41] a.fimg b.fimg ...	4 channel .fimg captures ( ImageFile.h ) into a sequence
+ *	./BatchAO --pgm in.gbseq prefix					channel 0 of every frame as prefix0000.pgm, prefix0001.pgm ... to look at
+ *
+ * exit code 0, 1 if processing failed, 4 bad arguments or files
+ */
+#include "BatchAOProcessor.h"
+#include "ImageFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace ssao;
+
+static const int EXIT_FAILED	= 1;
+static const int EXIT_USAGE		= 4;
+
+static int pack( const std::string &outputPath, const float *projection, const std::vector<std::string> &inputs )
+{
+	GBufferSequenceWriter writer;
+	for ( size_t i = 0; i < inputs.size(); ++i ) {
+		FloatImage frame;
+		if ( !readFloatImage( inputs[i], &frame ) || frame.getChannels() != 4 ) {
+			std::fprintf( stderr, "%s is not a 4 channel .fimg G-buffer\n", inputs[i].c_str() );
+			return EXIT_USAGE;
+		}
+		if ( !writer.isOpen() ) {
+			GBufferSequenceInfo info;
+			info.width			= frame.getWidth();
+			info.height			= frame.getHeight();
+			info.channels		= 4;
+			info.projection[0]	= projection[0];
+			info.projection[1]	= projection[1];
+			if ( !writer.open( outputPath, info ) ) {
+				std::fprintf( stderr, "can't write %s\n", outputPath.c_str() );
+				return EXIT_USAGE;
+			}
+		}
+		if ( !writer.append( frame ) ) {
+			std::fprintf( stderr, "%s is not %dx%d like the first frame, or the write failed\n", inputs[i].c_str(), writer.getInfo().width, writer.getInfo().height );
+			return EXIT_FAILED;
+		}
+	}
+	int frames = writer.getFrameCount();
+	if ( !writer.close() ) {
+		std::fprintf( stderr, "nothing written to %s\n", outputPath.c_str() );
+		return EXIT_FAILED;
+	}
+	std::printf( "%d frames packed into %s\n", frames, outputPath.c_str() );
+	return 0;
+}
+
+static int toPgm( const std::string &inputPath, const std::string &prefix )
+{
+	GBufferSequenceReader reader;
+	if ( !reader.open( inputPath ) ) {
+		std::fprintf( stderr, "can't read %s as a G-buffer sequence\n", inputPath.c_str() );
+		return EXIT_USAGE;
+	}
+	FloatImage frame;
+	for ( int i = 0; i < reader.getFrameCount(); ++i ) {
+		char name[16];
+		std::sprintf( name, "%04d.pgm", i );
+		if ( !reader.readFrame( i, &frame ) || !writePgm16( prefix + name, frame ) ) {
+			std::fprintf( stderr, "frame %d failed\n", i );
+			return EXIT_FAILED;
+		}
+	}
+	std::printf( "%d frames written to %s*.pgm\n", reader.getFrameCount(), prefix.c_str() );
+	return 0;
+}
+
+int main( int argc, char **argv )
+{
+	std::vector<std::string> paths;
+	BatchSettings settings;
+	SSAOParams params;
+	std::string mode;
+	float projection[2]	= { params.projection[0], params.projection[1] };
+	int threads			= 0;
+
+	for ( int i = 1; i < argc; ++i ) {
+		std::string arg = argv[i];
+		bool hasValue	= i + 1 < argc;
+		if ( arg == "--pack" || arg == "--pgm" )				mode = arg;
+		else if ( arg == "--scale" && hasValue )				settings.aoScale = std::max( (float)std::atof( argv[++i] ), 0.01f );
+		else if ( arg == "--no-blur" )							settings.blur = false;
+		else if ( arg == "--depth-aware" )						settings.blurParams.depthAware = true;
+		else if ( arg == "--samples" && hasValue )				params.samples = std::atoi( argv[++i] );
+		else if ( arg == "--threads" && hasValue )				threads = std::max( std::atoi( argv[++i] ), 1 );
+		else if ( arg == "--queue" && hasValue )				settings.queueDepth = std::max( std::atoi( argv[++i] ), 1 );
+		else if ( arg == "--method" && hasValue ) {
+			std::string method = argv[++i];
+			if ( method != "ssao" && method != "horizon" ) {
+				std::fprintf( stderr, "unknown method %s ( ssao or horizon )\n", method.c_str() );
+				return EXIT_USAGE;
+			}
+			params.method = method == "horizon" ? AO_HORIZON : AO_SSAO;
+		}
+		else if ( arg == "--frames" && hasValue ) {
+			if ( std::sscanf( argv[++i], "%d,%d", &settings.firstFrame, &settings.frameCount ) < 1 ) {
+				std::fprintf( stderr, "--frames takes first[,count]\n" );
+				return EXIT_USAGE;
+			}
+		}
+		else if ( arg == "--projection" && hasValue ) {
+			if ( std::sscanf( argv[++i], "%f,%f", &projection[0], &projection[1] ) != 2 ) {
+				std::fprintf( stderr, "--projection takes the ( 0, 0 ) and ( 1, 1 ) entries as x,y\n" );
+				return EXIT_USAGE;
+			}
+		}
+		else if ( arg.compare( 0, 2, "--" ) == 0 ) {
+			std::fprintf( stderr, "unknown argument %s ( see the top of tools/BatchAO.cpp )\n", arg.c_str() );
+			return EXIT_USAGE;
+		}
+		else
+			paths.push_back( arg );
+	}
+
+	if ( mode == "--pack" ) {
+		if ( paths.size() < 2 ) {
+			std::fprintf( stderr, "--pack takes the output and at least one .fimg\n" );
+			return EXIT_USAGE;
+		}
+		return pack( paths[0], projection, std::vector<std::string>( paths.begin() + 1, paths.end() ) );
+	}
+	if ( paths.size() != 2 ) {
+		std::fprintf( stderr, "takes an input and an output path ( see the top of tools/BatchAO.cpp )\n" );
+		return EXIT_USAGE;
+	}
+	if ( mode == "--pgm" )
+		return toPgm( paths[0], paths[1] );
+
+	GBufferSequenceReader input;
+	if ( !input.open( paths[0] ) || input.getInfo().channels != 4 ) {
+		std::fprintf( stderr, "%s is not a 4 channel G-buffer sequence\n", paths[0].c_str() );
+		return EXIT_USAGE;
+	}
+	//the header knows what the frames were rendered with, the app's camera otherwise
+	if ( input.getInfo().projection[0] > 0.0f && input.getInfo().projection[1] > 0.0f ) {
+		params.projection[0] = input.getInfo().projection[0];
+		params.projection[1] = input.getInfo().projection[1];
+	}
+
+	TaskPool pool( threads );
+	SSAOEngine engine;
+	engine.setParams( params );
+	BatchAOProcessor processor( &pool, &engine );
+	processor.setSettings( settings );
+
+	GBufferSequenceWriter output;
+	if ( !output.open( paths[1], processor.getOutputInfo( input.getInfo() ) ) ) {
+		std::fprintf( stderr, "can't write %s\n", paths[1].c_str() );
+		return EXIT_USAGE;
+	}
+	std::printf( "%s: %d frames %dx%d%s, AO %dx%d ( %s ), %d threads\n", paths[0].c_str(), input.getFrameCount(), input.getInfo().width, input.getInfo().height,
+				 input.isMapped() ? " mapped" : "", output.getInfo().width, output.getInfo().height, getAOMethodName( params.method ), pool.getNumThreads() );
+
+	bool ok = processor.process( input, output );
+	ok = output.close() && ok;
+	const BatchStats &stats = processor.getStats();
+	std::printf( "%d frames in %.1f ms ( %.2f frames/s ), per frame: read %.2f ms, AO %.2f ms, write %.2f ms, overlap %.2fx\n",
+				 stats.frames, stats.wallMs, stats.getFramesPerSecond(), stats.frames ? stats.readMs / stats.frames : 0.0,
+				 stats.frames ? stats.computeMs / stats.frames : 0.0, stats.frames ? stats.writeMs / stats.frames : 0.0, stats.getOverlap() );
+	if ( !ok ) {
+		std::fprintf( stderr, "failed: %s\n", processor.getError().empty() ? "can't finish the output" : processor.getError().c_str() );
+		return EXIT_FAILED;
+	}
+	return 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * writes src/BlueNoiseTile.cpp ( BLUE_NOISE_TILE of BlueNoise.h ), run from the repository root:
+ *
+ *	g++ -O2 -Iinclude tools/BlueNoiseGen.cpp src/BlueNoise.cpp -o BlueNoiseGen && ./BlueNoiseGen > src/BlueNoiseTile.cpp
+ *
+ * only needs rerunning when BLUE_NOISE_SIZE or the generator changes
+ */
+#include "BlueNoise.h"
+
+#include <cstdio>
+
+using namespace ssao;
+
+int main()
+{
+	const int size = BLUE_NOISE_SIZE;
+	std::vector<int> ranks;
+	generateBlueNoise( size, 1.5f, &ranks );
+
+	std::printf( "//generated by tools/BlueNoiseGen.cpp, do not edit ( see BlueNoise.h )\n" );
+	std::printf( "#include \"BlueNoise.h\"\n\nnamespace ssao {\n\n" );
+	std::printf( "const unsigned char BLUE_NOISE_TILE[BLUE_NOISE_SIZE * BLUE_NOISE_SIZE] = {\n" );
+	for ( int y = 0; y < size; ++y ) {
+		std::printf( "\t" );
+		for ( int x = 0; x < size; ++x )
+			std::printf( "%d%s", ranks[y * size + x] * 256 / ( size * size ), ( y == size - 1 && x == size - 1 ) ? "" : "," );
+		std::printf( "\n" );
+	}
+	std::printf( "};\n\n} // namespace ssao\n" );
+	return 0;
+}
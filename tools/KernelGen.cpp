@@ -0,0 +1,69 @@
+/*
+ * sample kernels of SampleKernel.h for SSAOL_frag.glsl and the CPU engine, run from the repository root:
+ *
+ *	g++ -O2 -Iinclude tools/KernelGen.cpp src/SampleKernel.cpp src/ShaderVariants.cpp -o KernelGen
+ *	./KernelGen							metrics of every kernel type at 4 / 8 / 10 / 16 / 32 samples
+ *	./KernelGen hammersley 8 [uniform]	that kernel as the SSAO_KERNEL define and as C++ rows ( uniform = no remap toward the center )
+ *
+ * the app generates its kernels at load time, this is for looking at them or pasting one in somewhere else
+ */
+#include "SampleKernel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace ssao;
+
+static void printMetrics( const KernelParams &params, int size )
+{
+	std::vector<float> kernel;
+	generateKernel( params, size, &kernel );
+	KernelMetrics metrics = measureKernel( kernel );
+	std::printf( "%-10s %-8s %2d   %.3f        %.4f      %.3f    %.3f\n", getKernelTypeName( params.type ),
+				 params.type == KERNEL_ORIGINAL ? "-" : ( params.towardCenter ? "center" : "uniform" ),
+				 metrics.size, metrics.discrepancy, metrics.occlusionVariance, metrics.minDistance, metrics.meanLength );
+}
+
+int main( int argc, char **argv )
+{
+	if ( argc < 3 ) {
+		const int SIZES[5] = { 4, 8, 10, 16, 32 };
+		std::printf( "kernel     lengths  n    discrepancy  variance    min dist  mean length\n" );
+		for ( int t = 0; t < NUM_KERNEL_TYPES; ++t ) {
+			for ( int center = 1; center >= 0; --center ) {
+				KernelParams params;
+				params.type			= (KernelType)t;
+				params.towardCenter	= center != 0;
+				if ( params.type == KERNEL_ORIGINAL && !params.towardCenter )
+					continue;
+				for ( int s = 0; s < 5; ++s )
+					printMetrics( params, SIZES[s] );
+			}
+		}
+		return 0;
+	}
+
+	KernelParams params;
+	params.type = NUM_KERNEL_TYPES;
+	for ( int t = 0; t < NUM_KERNEL_TYPES; ++t ) {
+		std::string name = getKernelTypeName( (KernelType)t );
+		std::transform( name.begin(), name.end(), name.begin(), ::tolower );
+		if ( name == argv[1] )
+			params.type = (KernelType)t;
+	}
+	if ( params.type == NUM_KERNEL_TYPES ) {
+		std::fprintf( stderr, "unknown kernel %s ( original, poisson, hammersley or cosine )\n", argv[1] );
+		return 1;
+	}
+	params.towardCenter = !( argc > 3 && std::strcmp( argv[3], "uniform" ) == 0 );
+
+	std::vector<float> kernel;
+	generateKernel( params, std::atoi( argv[2] ), &kernel );
+	std::printf( "%s\n%s", buildKernelGlsl( kernel ).c_str(), buildKernelCpp( kernel ).c_str() );
+	printMetrics( params, (int)kernel.size() / 3 );
+	return 0;
+}